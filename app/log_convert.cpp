@@ -0,0 +1,81 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file log_convert.cpp
+ * @brief Converts a binary detection log written with --log to CSV or JSON
+ * Lines, or prints its block index.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <opencv2/core/utility.hpp>
+#include <stdexcept>
+#include <string>
+
+#include "detection_log.hpp"
+
+/**< Command line options understood by the program */
+static const char* kCommandLineKeys =
+    "{help h       |      | print this message}"
+    "{@log         |      | detection log to read}"
+    "{format       | csv  | output format: csv or json (JSON Lines)}"
+    "{output o     |      | output file; standard output if empty}"
+    "{info         |      | print the block index instead of the rows}";
+
+/**
+ * @brief Prints the row count and the frame range of every block.
+ * @param reader The log.
+ */
+static void printInfo(const Storage::LogReader& reader) {
+  std::cout << reader.rows() << " rows in " << reader.blockCount()
+            << " blocks"
+            << (reader.recovered() ? " (footer missing, index rebuilt)" : "")
+            << std::endl;
+  const std::vector<Storage::BlockIndexEntry>& index = reader.blockIndex();
+  for (size_t i = 0; i < index.size(); ++i) {
+    std::cout << "block " << i << ": " << index[i].rows << " rows, frames "
+              << index[i].firstFrame << "-" << index[i].lastFrame
+              << ", time " << index[i].firstTimestampUs << "-"
+              << index[i].lastTimestampUs << " us" << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  cv::CommandLineParser parser(argc, argv, kCommandLineKeys);
+  parser.about("ACME detection log converter");
+  std::string path = parser.get<std::string>("@log");
+  if (parser.has("help") || path.empty()) {
+    parser.printMessage();
+    return path.empty() && !parser.has("help") ? -1 : 0;
+  }
+
+  try {
+    Storage::LogReader reader(path);
+    if (parser.has("info")) {
+      printInfo(reader);
+      return 0;
+    }
+
+    std::ofstream file;
+    std::string outputPath = parser.get<std::string>("output");
+    if (!outputPath.empty()) {
+      file.open(outputPath);
+      if (!file.good()) {
+        throw std::runtime_error("Cannot write " + outputPath);
+      }
+    }
+    std::ostream& out = outputPath.empty() ? std::cout : file;
+    std::string format = parser.get<std::string>("format");
+    if (format == "csv") {
+      Storage::exportCsv(reader, out);
+    } else if (format == "json") {
+      Storage::exportJson(reader, out);
+    } else {
+      throw std::runtime_error("Unknown format " + format);
+    }
+  } catch (const std::runtime_error& e) {
+    std::cerr << "Runtime Error: " << e.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
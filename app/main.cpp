@@ -6,23 +6,679 @@
  * stream.
  *
  * This program checks for the existence of YOLO configuration, weights, and
- * labels files. If the required files are found, it initializes the
- * YOLODetector and starts the video stream for object detection. It handles any
- * runtime or OpenCV exceptions that occur during initialization.
+ * labels files, loads the detector and runs one of the modes below on
+ * --source. It handles any runtime or OpenCV exceptions that occur.
+ *
+ * | Mode                   | Selected by         | Mode options              |
+ * |------------------------|---------------------|---------------------------|
+ * | Threaded pipeline      | (default)           | --policy, --queue,        |
+ * |                        |                     | --budget, --log,          |
+ * |                        |                     | --publish[-frames]        |
+ * | Single thread          | --sequential        |                           |
+ * | Batched multi-camera   | several --source    | --batch, --wait           |
+ * | Asynchronous workers   | --async=N           | --in-flight, --deadline   |
+ * | Tiled detection        | --tile=SIDE         | --tile-roi                |
+ * | Ground positions       | --camera=FILE       |                           |
+ * | Motion-gated detection | --motion-gate       |                           |
+ * | Keyframe detection     | --keyframe=K        | --no-reanchor             |
+ * | Recording for replay   | --record=FILE       | --frames                  |
+ * | Offline, every frame   | --offline           | --workers, --output, --log|
+ *
+ * Only one mode may be selected, and a mode option given to another mode
+ * is an error rather than ignored. --pin, --numa and --cpus pin the
+ * --async and --offline workers. The model options (--size, --classes,
+ * --nms, --backend, --onnx, --model-cache, --warmup, --threads) and the
+ * metrics options (--profile, --metrics-port, --metrics-file) apply to
+ * every mode.
  */
 
+#include <chrono>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "async_detector.hpp"
+#include "detection_log.hpp"
 #include "detector.hpp"
+#include "exporter.hpp"
+#include "keyframe.hpp"
+#include "localizer.hpp"
+#include "motion_gate.hpp"
+#include "multi_stream.hpp"
+#include "offline.hpp"
+#include "pipeline.hpp"
+#include "replay.hpp"
+#include "shared_detector.hpp"
+#include "tiling.hpp"
+
+#ifndef ACME_HEADLESS
+#include <opencv2/highgui.hpp>
+#endif
+
+/**< Command line options understood by the program */
+static const char* kCommandLineKeys =
+    "{help h       |      | print this message}"
+    "{config       | ./config/yolov3.cfg | Darknet network configuration,"
+    " e.g. ./config/yolov3-tiny.cfg}"
+    "{weights      | ./model/yolov3.weights | Darknet weights}"
+    "{labels       | ./labels/coco.names | class names, one per line}"
+    "{classes      | person | comma list of class names to detect, e.g."
+    " person,truck; all = every class in --labels}"
+    "{nms          | greedy | overlap suppression: greedy, opencv, soft"
+    " (Gaussian Soft-NMS) or matrix (parallel Matrix NMS)}"
+    "{size         | 0    | network input side (multiple of 32, e.g. 320,"
+    " 416, 608); 0 uses the width and height in the config}"
+    "{budget       | 0    | inference latency budget in ms; switches between"
+    " 320, 416 and 608 inputs to meet it; 0 = fixed size}"
+    "{source       | 0    | camera index, video file or URL; separate several"
+    " with commas for batched multi-camera inference}"
+    "{sequential   |      | run every stage on the main thread}"
+    "{policy       | drop | queue overflow policy: drop (oldest) or block}"
+    "{queue        | 4    | capacity of each inter-stage queue}"
+    "{batch        | 4    | frames per forward pass with several sources}"
+    "{wait         | 20   | max milliseconds a partial batch waits}"
+    "{keyframe     | 0    | run the detector every K frames, or sooner on"
+    " tracker uncertainty or scene motion, and track in between; 0 = off}"
+    "{no-reanchor  |      | with --keyframe, coast on the Kalman prediction"
+    " between keyframes instead of re-anchoring on each target's appearance}"
+    "{tile         | 0    | detect on overlapping tiles of this side (in"
+    " frame pixels, e.g. 832) to find small, distant people; 0 = off}"
+    "{tile-roi     |      | with --tile, only detect the tiles near recent"
+    " tracks, scanning every tile every 10th frame}"
+    "{motion-gate  |      | skip the network on frames that did not change"
+    " and detect only the changed regions of those that did, carrying"
+    " detections and tracks forward}"
+    "{camera       |      | camera calibration (OpenCV YAML, e.g."
+    " config/camera.yml); reports and tracks people in meters in the robot"
+    " frame}"
+    "{backend      | opencv | inference backend, or a comma list such as"
+    " opencv,opencv-fp16,opencv-int8,openvino,onnxruntime,onnxruntime-int8"
+    " timed at startup to keep the fastest; auto times every available"
+    " one. Use --model-cache to time them only once}"
+    "{onnx         |      | FP32 ONNX export of the network}"
+    "{onnx-int8    |      | INT8-quantized ONNX export of the network}"
+    "{model-cache  |      | directory that keeps the backend choice and"
+    " optimized ONNX Runtime models between runs, keyed by the model"
+    " files' sizes and modification times, so restarts skip the backend"
+    " benchmark}"
+    "{warmup       | 1    | forward passes run on a blank frame before the"
+    " first one, to take the first-pass setup off the first frame}"
+    "{async        | 0    | detect on this many worker threads, each with"
+    " its own network, while capture and display never wait; 0 = off}"
+    "{in-flight    | 4    | most frames --async holds at once; the oldest"
+    " waiting frame is dropped for a new one}"
+    "{deadline     | 0    | milliseconds an --async frame may wait for a"
+    " worker before it is dropped; 0 = no deadline}"
+    "{offline      |      | detect every frame of each --source (video"
+    " files, image directories or URLs) as fast as possible, in parallel}"
+    "{workers      | 0    | offline worker threads, each with its own"
+    " network; 0 = one per core}"
+    "{threads      | 0    | threads OpenCV may use inside one forward pass;"
+    " 0 = OpenCV's default. 1 scales best with --async or --offline workers}"
+    "{pin          |      | pin each --async or --offline worker to its own"
+    " CPU}"
+    "{numa         | -1   | pin the workers to the CPUs of this NUMA node}"
+    "{cpus         |      | pin the workers to these CPUs, e.g. 0-15,32-47}"
+    "{output       | detections.csv | CSV file written by --offline}"
+    "{log          |      | binary detection log written by the default"
+    " pipeline or --offline; convert it with acme_log}"
+    "{publish      |      | publish the default pipeline's detections and"
+    " tracks, frame by frame, to a ring in this POSIX shared memory name,"
+    " e.g. /acme_pm, for local readers such as acme_subscribe}"
+    "{publish-frames |    | with --publish, also publish the annotated"
+    " frames}"
+    "{record       |      | record the frames and raw network outputs to"
+    " this file for acme_replay}"
+    "{frames       | 0    | with --record, stop after this many frames;"
+    " 0 = until the source ends}"
+    "{metrics-port | -1   | serve Prometheus metrics on"
+    " http://127.0.0.1:PORT/metrics; -1 = off}"
+    "{metrics-file |      | rewrite this file with Prometheus metrics"
+    " every --metrics-interval seconds}"
+    "{metrics-interval | 10 | seconds between --metrics-file writes; must be"
+    " positive}"
+    "{profile      |      | print per-stage latency percentiles and the"
+    " slowest network layers on exit}";
+
+/**
+ * @enum Mode
+ * @brief How the sources are processed; see the table at the top.
+ */
+enum class Mode {
+  kPipeline,     /**< Threaded pipeline, the default */
+  kSequential,   /**< Every stage on the main thread */
+  kMultiStream,  /**< Several sources batched into one forward pass */
+  kAsync,        /**< Asynchronous inference workers */
+  kTiled,        /**< Detection on overlapping tiles */
+  kLocalized,    /**< Ground positions from a camera calibration */
+  kGated,        /**< Detection gated by scene motion */
+  kAdaptive,     /**< Detection on keyframes only */
+  kRecord,       /**< Recording for acme_replay */
+  kOffline       /**< Every frame of recorded footage, in parallel */
+};
+
+/**
+ * @brief Throws if an option was given to a mode that does not use it.
+ * @param parser Parsed command line.
+ * @param key The option.
+ * @param unset Its value when not given.
+ * @param used True if the selected mode uses the option.
+ * @param mode The selected mode, for the message.
+ * @throws std::runtime_error if the option is set but not used.
+ */
+static void checkOption(const cv::CommandLineParser& parser,
+                        const std::string& key, const std::string& unset,
+                        bool used, const std::string& mode) {
+  if (!used && parser.get<std::string>(key) != unset) {
+    throw std::runtime_error("--" + key + " does not apply to " + mode);
+  }
+}
+
+/**
+ * @brief Gets the mode selected on the command line and checks that every
+ * mode option given belongs to it.
+ * @param parser Parsed command line.
+ * @param sourceCount Number of --source values.
+ * @return The mode.
+ * @throws std::runtime_error if several modes are selected or an option
+ * would be ignored by the selected one.
+ */
+static Mode selectMode(const cv::CommandLineParser& parser,
+                       size_t sourceCount) {
+  std::vector<std::pair<Mode, std::string>> selected;
+  if (parser.has("offline")) {
+    selected.emplace_back(Mode::kOffline, "--offline");
+  } else if (sourceCount > 1) {
+    selected.emplace_back(Mode::kMultiStream, "several --source values");
+  }
+  if (parser.has("record")) {
+    selected.emplace_back(Mode::kRecord, "--record");
+  }
+  if (parser.has("sequential")) {
+    selected.emplace_back(Mode::kSequential, "--sequential");
+  }
+  if (parser.get<int>("async") > 0) {
+    selected.emplace_back(Mode::kAsync, "--async");
+  }
+  if (parser.get<int>("tile") > 0) {
+    selected.emplace_back(Mode::kTiled, "--tile");
+  }
+  if (parser.has("camera")) {
+    selected.emplace_back(Mode::kLocalized, "--camera");
+  }
+  if (parser.has("motion-gate")) {
+    selected.emplace_back(Mode::kGated, "--motion-gate");
+  }
+  if (parser.get<int>("keyframe") > 0) {
+    selected.emplace_back(Mode::kAdaptive, "--keyframe");
+  }
+  if (selected.size() > 1) {
+    throw std::runtime_error(selected[0].second + " cannot be combined with " +
+                             selected[1].second);
+  }
+  const Mode mode = selected.empty() ? Mode::kPipeline : selected[0].first;
+  const std::string name =
+      selected.empty() ? "the default pipeline" : selected[0].second;
+
+  const bool pipeline = mode == Mode::kPipeline;
+  checkOption(parser, "policy", "drop", pipeline, name);
+  checkOption(parser, "queue", "4", pipeline, name);
+  checkOption(parser, "budget", "0", pipeline, name);
+  checkOption(parser, "publish", "", pipeline, name);
+  checkOption(parser, "publish-frames", "", pipeline, name);
+  checkOption(parser, "log", "", pipeline || mode == Mode::kOffline, name);
+  checkOption(parser, "batch", "4", mode == Mode::kMultiStream, name);
+  checkOption(parser, "wait", "20", mode == Mode::kMultiStream, name);
+  checkOption(parser, "in-flight", "4", mode == Mode::kAsync, name);
+  checkOption(parser, "deadline", "0", mode == Mode::kAsync, name);
+  checkOption(parser, "tile-roi", "", mode == Mode::kTiled, name);
+  checkOption(parser, "no-reanchor", "", mode == Mode::kAdaptive, name);
+  checkOption(parser, "frames", "0", mode == Mode::kRecord, name);
+  checkOption(parser, "workers", "0", mode == Mode::kOffline, name);
+  checkOption(parser, "output", "detections.csv", mode == Mode::kOffline,
+              name);
+  const bool workers = mode == Mode::kAsync || mode == Mode::kOffline;
+  checkOption(parser, "pin", "", workers, name);
+  checkOption(parser, "numa", "-1", workers, name);
+  checkOption(parser, "cpus", "", workers, name);
+  if (parser.has("publish-frames") && !parser.has("publish")) {
+    throw std::runtime_error("--publish-frames needs --publish");
+  }
+  return mode;
+}
+
+/**
+ * @brief Splits a comma-separated list.
+ * @param list The list to split.
+ * @return The non-empty items.
+ */
+static std::vector<std::string> splitList(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+/**
+ * @brief Picks the inference backend named on the command line, timing the
+ * candidates when there is more than one, and prints the choice. The
+ * default, OpenCV's own FP32 backend, is what the detector already runs.
+ * @param detector The initialized detector.
+ * @param parser Parsed command line.
+ */
+static void chooseBackend(Detector::YOLODetector& detector,
+                          const cv::CommandLineParser& parser) {
+  std::vector<Detector::BackendOption> candidates;
+  std::string backends = parser.get<std::string>("backend");
+  if (backends != "auto") {
+    for (const std::string& name : splitList(backends)) {
+      candidates.push_back(Detector::parseBackendOption(name));
+    }
+  }
+  if (candidates.size() == 1 && candidates[0] == Detector::BackendOption()) {
+    std::cout << "Inference backend: " << candidates[0].name() << std::endl;
+    return;
+  }
+  Detector::BackendReport report = detector.selectBackend(
+      candidates, parser.get<std::string>("onnx"),
+      parser.get<std::string>("onnx-int8"));
+  std::cout << report.summary() << std::endl;
+}
+
+/**
+ * @brief Runs one source through the threaded detection pipeline.
+ * @param detector The initialized detector.
+ * @param parser Parsed command line.
+ * @param source The video source to open.
+ * @param metrics Receives the capture and render latencies, or null.
+ */
+static void runPipeline(Detector::YOLODetector& detector,
+                        const cv::CommandLineParser& parser,
+                        const std::string& source,
+                        Metrics::Registry* metrics) {
+  const int queue = parser.get<int>("queue");
+  if (queue < 1) {
+    throw std::runtime_error("--queue must be at least 1");
+  }
+  Pipeline::PipelineConfig config;
+  config.queueCapacity = static_cast<size_t>(queue);
+  config.overflowPolicy = parser.get<std::string>("policy") == "block"
+                              ? Pipeline::OverflowPolicy::kBlock
+                              : Pipeline::OverflowPolicy::kDropOldest;
+  config.resolution.budgetMs = parser.get<double>("budget");
+  config.logPath = parser.get<std::string>("log");
+  config.publish.name = parser.get<std::string>("publish");
+  config.publishFrames = parser.has("publish-frames");
+  config.metrics = metrics;
+
+  cv::VideoCapture cap = Pipeline::openCapture(source);
+  Pipeline::DetectionPipeline pipeline(detector, config);
+  pipeline.run(cap);
+
+  Pipeline::PipelineStats stats = pipeline.stats();
+  std::cout << "Frames rendered: " << stats.processed[Pipeline::kRender]
+            << ", dropped per queue:";
+  for (uint64_t count : stats.dropped) {
+    std::cout << " " << count;
+  }
+  std::cout << std::endl;
+  if (stats.inputSide > 0) {
+    std::cout << "Input size for the latency budget: " << stats.inputSide
+              << "x" << stats.inputSide << std::endl;
+  }
+}
+
+/**
+ * @brief Runs several sources through one batched forward pass per step.
+ * @param detector The initialized detector shared by every stream.
+ * @param parser Parsed command line.
+ * @param sources The video sources to open.
+ */
+static void runMultiStream(Detector::YOLODetector& detector,
+                           const cv::CommandLineParser& parser,
+                           const std::vector<std::string>& sources) {
+  Pipeline::MultiStreamConfig config;
+  config.batchSize = static_cast<size_t>(parser.get<int>("batch"));
+  config.maxWait = std::chrono::milliseconds(parser.get<int>("wait"));
+
+  std::vector<cv::VideoCapture> captures;
+  for (const std::string& source : sources) {
+    captures.push_back(Pipeline::openCapture(source));
+  }
+
+  Pipeline::MultiStreamDetector multiStream(detector, config);
+  multiStream.run(captures, [&](size_t stream, Pipeline::FramePacket& packet) {
+#ifndef ACME_HEADLESS
+    detector.render(packet.frame, packet.detections);
+    cv::imshow("YOLO Detection " + std::to_string(stream), packet.frame);
+    if (cv::waitKey(1) == 113) {  // Press 'q' to exit
+      multiStream.stop();
+    }
+#else
+    std::cout << "stream " << stream << " frame " << packet.index << ": "
+              << packet.detections.size() << " detections" << std::endl;
+#endif
+  });
+#ifndef ACME_HEADLESS
+  cv::destroyAllWindows();
+#endif
+
+  Pipeline::MultiStreamStats stats = multiStream.stats();
+  std::cout << "Frames detected: " << stats.frames << " in " << stats.batches
+            << " batches (mean batch " << stats.meanBatchSize()
+            << "), dropped: " << stats.dropped << std::endl;
+}
+
+/**
+ * @brief Runs one source with detection on keyframes only.
+ * @param detector The initialized detector.
+ * @param parser Parsed command line.
+ * @param source The video source to open.
+ */
+static void runAdaptive(Detector::YOLODetector& detector,
+                        const cv::CommandLineParser& parser,
+                        const std::string& source) {
+  Pipeline::KeyframeConfig config;
+  config.interval = parser.get<int>("keyframe");
+  config.reanchor = !parser.has("no-reanchor");
+
+  cv::VideoCapture cap = Pipeline::openCapture(source);
+  Pipeline::AdaptiveDetector adaptive(detector, config);
+  adaptive.run(cap);
+
+  const Pipeline::KeyframeStats& stats = adaptive.stats();
+  std::cout << "Frames: " << stats.frames
+            << ", keyframes: " << stats.keyframes() << " (interval "
+            << stats.triggers[Pipeline::kInterval] << ", uncertainty "
+            << stats.triggers[Pipeline::kUncertainty] << ", motion "
+            << stats.triggers[Pipeline::kMotion]
+            << "), frames per inference: " << stats.savings() << std::endl;
+  if (config.reanchor) {
+    const Tracker::CorrelationStats& correlation = adaptive.correlationStats();
+    std::cout << "Re-anchored: " << correlation.anchored << " of "
+              << correlation.searches << " searches" << std::endl;
+  }
+}
+
+/**
+ * @brief Runs one source with detection gated by scene motion.
+ * @param detector The initialized detector.
+ * @param source The video source to open.
+ */
+static void runGated(Detector::YOLODetector& detector,
+                     const std::string& source) {
+  cv::VideoCapture cap = Pipeline::openCapture(source);
+  Pipeline::GatedDetector gated(detector);
+  gated.run(cap);
+
+  const Pipeline::MotionStats& stats = gated.stats();
+  std::cout << "Frames: " << stats.frames << ", skipped: " << stats.skipped
+            << " (" << 100.0 * stats.skipRatio() << "%), region frames: "
+            << stats.regionFrames << " (" << stats.regions
+            << " regions), full frames: " << stats.fullFrames << std::endl;
+}
+
+/**
+ * @brief Runs one source with people located and tracked on the ground.
+ * @param detector The initialized detector.
+ * @param parser Parsed command line.
+ * @param source The video source to open.
+ */
+static void runLocalized(Detector::YOLODetector& detector,
+                         const cv::CommandLineParser& parser,
+                         const std::string& source) {
+  Projection::CameraModel camera =
+      Projection::readCameraModel(parser.get<std::string>("camera"));
+  cv::VideoCapture cap = Pipeline::openCapture(source);
+  Pipeline::Localizer localizer(detector, camera);
+  const uint64_t frames = localizer.run(cap);
+  std::cout << "Frames: " << frames << ", ground tracks at exit: "
+            << localizer.groundTracks().size() << std::endl;
+}
+
+/**
+ * @brief Runs one source with detection on overlapping tiles.
+ * @param detector The initialized detector.
+ * @param parser Parsed command line.
+ * @param source The video source to open.
+ */
+static void runTiled(Detector::YOLODetector& detector,
+                     const cv::CommandLineParser& parser,
+                     const std::string& source) {
+  Pipeline::TilingConfig config;
+  config.tileSide = parser.get<int>("tile");
+
+  cv::VideoCapture cap = Pipeline::openCapture(source);
+  Pipeline::TiledDetector tiled(detector, config);
+  tiled.run(cap, parser.has("tile-roi"));
+
+  const Pipeline::TilingStats& stats = tiled.stats();
+  std::cout << "Frames: " << stats.frames << ", tiles per frame: "
+            << stats.meanTiles() << ", forward passes: " << stats.batches
+            << std::endl;
+}
+
+/**
+ * @brief Records one source's frames, network outputs and detections.
+ * @param detector The initialized detector.
+ * @param parser Parsed command line.
+ * @param source The video source to open.
+ */
+static void runRecord(Detector::YOLODetector& detector,
+                      const cv::CommandLineParser& parser,
+                      const std::string& source) {
+  cv::VideoCapture cap = Pipeline::openCapture(source);
+  if (!cap.isOpened()) {
+    throw std::runtime_error("Cannot open " + source);
+  }
+  const std::string path = parser.get<std::string>("record");
+  const uint64_t frames = Pipeline::recordStream(
+      detector, cap, path, static_cast<uint64_t>(parser.get<int>("frames")));
+  std::cout << frames << " frames recorded to " << path << std::endl;
+}
+
+/**
+ * @brief Reads the intra-op thread count and the pinning options.
+ * @param parser Parsed command line.
+ * @return The threading settings of the inference workers.
+ */
+static Detector::ThreadingConfig threadingConfig(
+    const cv::CommandLineParser& parser) {
+  Detector::ThreadingConfig threading;
+  threading.intraOpThreads = parser.get<int>("threads");
+  threading.cpus = Detector::parseCpuList(parser.get<std::string>("cpus"));
+  threading.numaNode = parser.get<int>("numa");
+  threading.pin = parser.has("pin") || !threading.cpus.empty() ||
+                  threading.numaNode >= 0;
+  return threading;
+}
+
+/**
+ * @brief Builds a factory of detectors set up like the given one, for
+ * worker threads that each need a network of their own.
+ * @param detector The initialized detector; its input size, backend, class
+ * filter and NMS settings are copied to every worker.
+ * @param parser Parsed command line.
+ * @param metrics Receives every worker's stage latencies, or null.
+ * @return The factory.
+ */
+static std::function<std::unique_ptr<Detector::YOLODetector>()>
+workerFactory(const Detector::YOLODetector& detector,
+              const cv::CommandLineParser& parser,
+              Metrics::Registry* metrics) {
+  Detector::ModelFiles files;
+  files.config = parser.get<std::string>("config");
+  files.weights = parser.get<std::string>("weights");
+  files.onnx = parser.get<std::string>("onnx");
+  files.onnxInt8 = parser.get<std::string>("onnx-int8");
+  files.cacheDir = parser.get<std::string>("model-cache");
+  const std::string labels = parser.get<std::string>("labels");
+  const cv::Size inputSize = detector.getInputSize();
+  const Detector::BackendOption option = detector.getBackendOption();
+  const std::vector<int> classFilter = detector.getClassFilter();
+  const Detector::NmsConfig nms = detector.getNms();
+  const int warmupPasses = parser.get<int>("warmup");
+
+  // The class names are read once; every worker loads its own network
+  std::shared_ptr<Detector::SharedDetector> shared =
+      std::make_shared<Detector::SharedDetector>(files, labels,
+                                                 threadingConfig(parser));
+  shared->configure([=](Detector::YOLODetector& worker) {
+    worker.setInputSize(inputSize);
+    worker.setClassFilter(classFilter);
+    worker.setNms(nms);
+    worker.setMetrics(metrics);
+    worker.setModelCache(files.cacheDir);
+    if (!(option == Detector::BackendOption())) {
+      // Configures the worker's network; ONNX options load their export
+      worker.setBackend(option);
+    }
+    if (warmupPasses > 0) {
+      worker.warmup(warmupPasses);
+    }
+  });
+  return [shared]() { return shared->createContext(); };
+}
+
+/**
+ * @brief Runs one source through a pool of asynchronous inference workers
+ * while the main loop keeps capturing and drawing the newest detections.
+ * @param detector The initialized detector, used to draw. Workers run
+ * networks of their own built with its settings; see workerFactory().
+ * @param parser Parsed command line.
+ * @param source The video source to open.
+ * @param metrics Receives every worker's stage latencies, or null.
+ */
+static void runAsync(Detector::YOLODetector& detector,
+                     const cv::CommandLineParser& parser,
+                     const std::string& source, Metrics::Registry* metrics) {
+  Pipeline::AsyncConfig config;
+  config.workers = static_cast<size_t>(parser.get<int>("async"));
+  config.maxInFlight = static_cast<size_t>(parser.get<int>("in-flight"));
+  config.deadline = std::chrono::milliseconds(parser.get<int>("deadline"));
+  config.cpus = Detector::pinningCpus(threadingConfig(parser));
+  Pipeline::AsyncDetector async(workerFactory(detector, parser, metrics),
+                                config);
+
+  cv::VideoCapture cap = Pipeline::openCapture(source);
+  if (!cap.isOpened()) {
+    throw std::runtime_error("Cannot open " + source);
+  }
+  std::deque<std::future<Detector::Detections>> pending;
+  Detector::Detections latest;
+  while (true) {
+    cv::Mat frame;  // A new buffer each time; workers may still read the last
+    if (!cap.read(frame) || frame.empty()) {
+      break;
+    }
+    pending.push_back(async.submit(frame));
+    // Collect whatever has finished without waiting for the rest
+    while (!pending.empty() &&
+           pending.front().wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready) {
+      try {
+        latest = pending.front().get();
+      } catch (const Pipeline::FrameDropped&) {
+        // Superseded or late; the next result replaces it anyway
+      }
+      pending.pop_front();
+    }
+#ifndef ACME_HEADLESS
+    cv::Mat view = frame.clone();  // Workers read the frame; draw on a copy
+    detector.render(view, latest);
+    cv::imshow("YOLO Detection", view);
+    if (cv::waitKey(1) == 113) {  // Press 'q' to exit
+      break;
+    }
+#endif
+  }
+  async.stop();
+
+  Pipeline::AsyncStats stats = async.stats();
+  std::cout << "Submitted: " << stats.submitted
+            << ", detected: " << stats.completed
+            << ", expired: " << stats.expired
+            << ", dropped: " << stats.dropped << std::endl;
+}
+
+/**
+ * @brief Detects every frame of the sources across worker threads and
+ * writes the detections in frame order.
+ * @param detector The initialized detector. Workers run networks of their
+ * own built with its settings; see workerFactory().
+ * @param parser Parsed command line.
+ * @param sources The video files, image directories or URLs to process.
+ * @param metrics Receives every worker's stage latencies, or null.
+ */
+static void runOffline(const Detector::YOLODetector& detector,
+                       const cv::CommandLineParser& parser,
+                       const std::vector<std::string>& sources,
+                       Metrics::Registry* metrics) {
+  Pipeline::OfflineConfig config;
+  config.workers = static_cast<size_t>(parser.get<int>("workers"));
+  config.cpus = Detector::pinningCpus(threadingConfig(parser));
+  Pipeline::OfflineProcessor processor(
+      workerFactory(detector, parser, metrics), config);
+
+  const std::string outputPath = parser.get<std::string>("output");
+  std::ofstream output(outputPath);
+  if (!output.good()) {
+    throw std::runtime_error("Cannot write " + outputPath);
+  }
+  std::unique_ptr<Storage::LogWriter> log;
+  if (!parser.get<std::string>("log").empty()) {
+    log.reset(new Storage::LogWriter(parser.get<std::string>("log")));
+  }
+  Pipeline::writeCsvHeader(output);
+  uint64_t firstFrame = 0;  // Log frames run on across sources
+  for (const std::string& source : sources) {
+    uint64_t frames =
+        processor.run(source, [&](const Pipeline::FrameResult& result) {
+          Pipeline::writeCsv(output, source, result);
+          if (log) {
+            log->appendFrame(firstFrame + result.index, result.timestampUs,
+                             result.detections);
+          }
+        });
+    firstFrame += frames;
+    Pipeline::OfflineStats stats = processor.stats();
+    std::cout << source << ": " << stats.frames << " frames in "
+              << stats.chunks << " chunks on " << stats.workers
+              << " workers, " << stats.fps() << " FPS" << std::endl;
+  }
+  std::cout << "Detections written to " << outputPath << std::endl;
+  if (log) {
+    log->close();
+    std::cout << log->rows() << " rows logged" << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  cv::CommandLineParser parser(argc, argv, kCommandLineKeys);
+  parser.about("ACME perception module");
+  if (parser.has("help")) {
+    parser.printMessage();
+    return 0;
+  }
 
-int main() {
   /**< Path to YOLO configuration file */
-  std::string configPath = "./config/yolov3.cfg";
+  std::string configPath = parser.get<std::string>("config");
   /**< Path to YOLO weights file */
-  std::string weightsPath = "./model/yolov3.weights";
+  std::string weightsPath = parser.get<std::string>("weights");
   /**< Path to labels file containing class names */
-  std::string labelsPath = "./labels/coco.names";
+  std::string labelsPath = parser.get<std::string>("labels");
 
   // Check if configuration file exists
   std::ifstream configFile(configPath);
@@ -52,8 +708,103 @@ int main() {
      * @brief Initializes the YOLODetector with the given configuration,
      * weights, and labels files. Starts the video stream for object detection.
      */
+    std::vector<std::string> sources =
+        splitList(parser.get<std::string>("source"));
+    if (sources.empty()) {
+      sources.push_back("0");
+    }
+    // Before loading the model, so a mistyped command line fails at once
+    const Mode mode = selectMode(parser, sources.size());
+
+    Metrics::Registry registry;
+    Metrics::ExporterConfig exporterConfig;
+    exporterConfig.port = parser.get<int>("metrics-port");
+    exporterConfig.filePath = parser.get<std::string>("metrics-file");
+    exporterConfig.intervalSeconds = parser.get<double>("metrics-interval");
+    const bool exportMetrics =
+        exporterConfig.port >= 0 || !exporterConfig.filePath.empty();
+    Metrics::Registry* metrics =
+        exportMetrics || parser.has("profile") ? &registry : nullptr;
+
+    // Before the backend benchmark, so it times the threads used later
+    if (parser.get<int>("threads") > 0) {
+      cv::setNumThreads(parser.get<int>("threads"));
+    }
+    auto loadStart = std::chrono::steady_clock::now();
     Detector::YOLODetector detector(configPath, weightsPath, labelsPath);
-    detector.videoStream();
+    std::cout << "Model loaded in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - loadStart)
+                     .count()
+              << " ms" << std::endl;
+    detector.setModelCache(parser.get<std::string>("model-cache"));
+    if (parser.get<int>("size") > 0) {
+      int side = parser.get<int>("size");
+      detector.setInputSize(cv::Size(side, side));
+    }
+    const std::string classes = parser.get<std::string>("classes");
+    detector.setClasses(classes == "all" ? std::vector<std::string>()
+                                         : splitList(classes));
+    Detector::NmsConfig nms = detector.getNms();
+    nms.method = Detector::parseNmsMethod(parser.get<std::string>("nms"));
+    detector.setNms(nms);
+    chooseBackend(detector, parser);
+    if (parser.get<int>("warmup") > 0) {
+      std::cout << "Warmup: " << detector.warmup(parser.get<int>("warmup"))
+                << " ms" << std::endl;
+    }
+    // Attached after the backend benchmark so it does not skew the numbers
+    detector.setMetrics(metrics);
+    std::unique_ptr<Metrics::Exporter> exporter;
+    if (exportMetrics) {
+      exporter.reset(new Metrics::Exporter(registry, exporterConfig));
+      if (exporter->port() >= 0) {
+        std::cout << "Metrics at http://127.0.0.1:" << exporter->port()
+                  << "/metrics" << std::endl;
+      }
+    }
+
+    switch (mode) {
+      case Mode::kOffline:
+        runOffline(detector, parser, sources, metrics);
+        break;
+      case Mode::kRecord:
+        runRecord(detector, parser, sources[0]);
+        break;
+      case Mode::kSequential: {
+        cv::VideoCapture cap = Pipeline::openCapture(sources[0]);
+        detector.videoStream(cap);
+        break;
+      }
+      case Mode::kMultiStream:
+        runMultiStream(detector, parser, sources);
+        break;
+      case Mode::kAsync:
+        runAsync(detector, parser, sources[0], metrics);
+        break;
+      case Mode::kTiled:
+        runTiled(detector, parser, sources[0]);
+        break;
+      case Mode::kLocalized:
+        runLocalized(detector, parser, sources[0]);
+        break;
+      case Mode::kGated:
+        runGated(detector, sources[0]);
+        break;
+      case Mode::kAdaptive:
+        runAdaptive(detector, parser, sources[0]);
+        break;
+      case Mode::kPipeline:
+        runPipeline(detector, parser, sources[0], metrics);
+        break;
+    }
+
+    if (exporter) {
+      exporter->stop();
+    }
+    if (parser.has("profile")) {
+      std::cout << Metrics::toTable(registry.snapshot());
+    }
   } catch (const cv::Exception& e) {
     std::cerr << "OpenCV Error: " << e.what() << std::endl;
     return -1;
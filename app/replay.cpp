@@ -0,0 +1,78 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file replay.cpp
+ * @brief Replays a recording made with acme_pm --record through everything
+ * but inference and reports the throughput, the per-stage latencies and
+ * any difference from the recorded detections.
+ *
+ * Exits with a non-zero status when an output differs, so it can gate
+ * changes to preprocessing, decoding, suppression or tracking.
+ */
+
+#include <iostream>
+#include <opencv2/core/utility.hpp>
+#include <stdexcept>
+#include <string>
+
+#include "replay.hpp"
+
+/**< Command line options understood by the program */
+static const char* kCommandLineKeys =
+    "{help h       |      | print this message}"
+    "{@recording   |      | recording written with acme_pm --record}"
+    "{repeat       | 1    | passes over the recording}"
+    "{no-track     |      | stop after suppression}"
+    "{log          |      | write the replayed detections and tracks to this"
+    " detection log}"
+    "{reference    |      | compare --log row by row with this log of an"
+    " earlier replay}";
+
+int main(int argc, char** argv) {
+  cv::CommandLineParser parser(argc, argv, kCommandLineKeys);
+  parser.about("ACME pipeline replay");
+  std::string path = parser.get<std::string>("@recording");
+  if (parser.has("help") || path.empty()) {
+    parser.printMessage();
+    return path.empty() && !parser.has("help") ? -1 : 0;
+  }
+
+  try {
+    Pipeline::ReplayConfig config;
+    config.repeat = parser.get<int>("repeat");
+    config.track = !parser.has("no-track");
+    config.logPath = parser.get<std::string>("log");
+    config.referencePath = parser.get<std::string>("reference");
+
+    Storage::RecordingReader reader(path);
+    Pipeline::ReplayReport report = Pipeline::replayRecording(reader, config);
+    std::cout << report.frames << " frames in " << report.seconds * 1000
+              << " ms, " << report.fps() << " FPS" << std::endl;
+    std::cout << Metrics::toTable(report.latencies);
+    std::cout << "Frames differing from the recording: "
+              << report.detectionMismatches;
+    if (report.firstMismatch >= 0) {
+      std::cout << " (first: frame " << report.firstMismatch << ")";
+    }
+    std::cout << std::endl;
+    if (!config.referencePath.empty()) {
+      std::cout << "Rows differing from the reference: "
+                << report.referenceMismatches;
+      if (report.firstReferenceMismatch >= 0) {
+        std::cout << " (first: frame " << report.firstReferenceMismatch
+                  << ")";
+      }
+      std::cout << std::endl;
+    }
+    if (report.detectionMismatches > 0 || report.referenceMismatches > 0) {
+      return 1;
+    }
+  } catch (const cv::Exception& e) {
+    std::cerr << "OpenCV Error: " << e.what() << std::endl;
+    return -1;
+  } catch (const std::runtime_error& e) {
+    std::cerr << "Runtime Error: " << e.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,129 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file subscribe.cpp
+ * @brief Follows the detection ring of acme_pm --publish from another
+ * process, printing each frame's results and the delivery latency.
+ *
+ * Doubles as the reference reader for planner and logger processes: it
+ * uses nothing but the Transport client library.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <opencv2/core/utility.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "metrics.hpp"
+#include "subscriber.hpp"
+
+#ifndef ACME_HEADLESS
+#include <opencv2/highgui.hpp>
+#endif
+
+/**< Command line options understood by the program */
+static const char* kCommandLineKeys =
+    "{help h       |      | print this message}"
+    "{@name        | /acme_pm | shared memory name given to acme_pm"
+    " --publish}"
+    "{latest       |      | skip to the newest message instead of reading"
+    " every one}"
+    "{messages     | 0    | stop after this many messages; 0 = until the"
+    " publisher exits}"
+    "{wait         | 10   | seconds to wait for the publisher to start}"
+    "{quiet        |      | print only the summary}"
+    "{show         |      | show the published frames}";
+
+/**
+ * @brief Opens the ring, retrying while the publisher starts up.
+ * @param name The shared memory name.
+ * @param seconds How long to keep trying.
+ * @return The subscriber.
+ * @throws std::runtime_error if the ring does not appear in time.
+ */
+static std::unique_ptr<Transport::Subscriber> attach(const std::string& name,
+                                                     double seconds) {
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::duration<double>(seconds);
+  while (true) {
+    try {
+      return std::unique_ptr<Transport::Subscriber>(
+          new Transport::Subscriber(name));
+    } catch (const std::runtime_error&) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        throw;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+}
+
+int main(int argc, char** argv) {
+  cv::CommandLineParser parser(argc, argv, kCommandLineKeys);
+  parser.about("ACME detection ring reader");
+  if (parser.has("help")) {
+    parser.printMessage();
+    return 0;
+  }
+
+  try {
+    const std::string name = parser.get<std::string>("@name");
+    std::unique_ptr<Transport::Subscriber> subscriber =
+        attach(name, parser.get<double>("wait"));
+    const uint64_t limit = static_cast<uint64_t>(parser.get<int>("messages"));
+    Metrics::Registry registry;
+    Metrics::LatencyHistogram& delivery = registry.stage("delivery");
+    Metrics::LatencyHistogram& endToEnd = registry.stage("capture-to-read");
+
+    Transport::Message message;
+    while (limit == 0 || subscriber->received() < limit) {
+      if (parser.has("latest")) {
+        subscriber->seekLatest();
+      }
+      if (!subscriber->wait(&message, std::chrono::seconds(1))) {
+        if (subscriber->closed()) {
+          break;
+        }
+        continue;
+      }
+      const int64_t now =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::system_clock::now().time_since_epoch())
+              .count();
+      const int64_t deliveryUs =
+          std::max<int64_t>(0, now - message.publishedUs);
+      delivery.record(static_cast<uint64_t>(deliveryUs));
+      endToEnd.record(static_cast<uint64_t>(
+          std::max<int64_t>(0, now - message.timestampUs)));
+      if (!parser.has("quiet")) {
+        std::cout << "#" << message.sequence << " frame " << message.frame
+                  << ": " << message.detections.size() << " detections, "
+                  << message.tracks.size() << " tracks, " << deliveryUs
+                  << " us" << std::endl;
+      }
+#ifndef ACME_HEADLESS
+      if (parser.has("show") && !message.image.empty()) {
+        cv::imshow(name, message.image);
+        if (cv::waitKey(1) == 113) {  // Press 'q' to exit
+          break;
+        }
+      }
+#endif
+    }
+
+    std::cout << "Received: " << subscriber->received()
+              << ", missed: " << subscriber->missed() << std::endl;
+    std::cout << Metrics::toTable(registry.snapshot());
+  } catch (const cv::Exception& e) {
+    std::cerr << "OpenCV Error: " << e.what() << std::endl;
+    return -1;
+  } catch (const std::runtime_error& e) {
+    std::cerr << "Runtime Error: " << e.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file bench_util.hpp
+ * @brief Helpers shared by the micro-benchmarks: timing and recorded network
+ * outputs.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+/**
+ * @brief Times a callable and prints the mean latency per iteration.
+ * @param name Label printed next to the result.
+ * @param iterations Number of timed iterations (after one warmup call).
+ * @param fn The callable to time.
+ * @return The mean latency in microseconds.
+ */
+template <typename Fn>
+double measure(const std::string& name, int iterations, Fn fn) {
+  fn();  // Warmup
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    fn();
+  }
+  auto stop = std::chrono::steady_clock::now();
+  double micros =
+      std::chrono::duration<double, std::micro>(stop - start).count() /
+      iterations;
+  std::printf("%-32s %10.2f us/iter\n", name.c_str(), micros);
+  return micros;
+}
+
+/**
+ * @brief Saves network outputs so benchmarks can replay them without weights.
+ * @param path Destination file (.yml, .yml.gz, .xml, ...).
+ * @param outputs The outputs of a forward pass.
+ */
+inline void saveOutputs(const std::string& path,
+                        const std::vector<cv::Mat>& outputs) {
+  cv::FileStorage fs(path, cv::FileStorage::WRITE);
+  fs << "outputs" << "[";
+  for (const cv::Mat& output : outputs) {
+    fs << output;
+  }
+  fs << "]";
+}
+
+/**
+ * @brief Loads network outputs written by saveOutputs().
+ * @param path Source file.
+ * @return The recorded outputs, or an empty vector if the file is missing.
+ */
+inline std::vector<cv::Mat> loadOutputs(const std::string& path) {
+  std::vector<cv::Mat> outputs;
+  cv::FileStorage fs(path, cv::FileStorage::READ);
+  if (!fs.isOpened()) {
+    return outputs;
+  }
+  cv::FileNode node = fs["outputs"];
+  for (size_t i = 0; i < node.size(); ++i) {
+    cv::Mat output;
+    cv::read(node[static_cast<int>(i)], output);
+    outputs.push_back(output);
+  }
+  return outputs;
+}
+
+/**
+ * @brief Builds outputs shaped like the three YOLOv3 heads at 416x416.
+ *
+ * Objectness is low for almost every anchor, as it is on real footage, with
+ * a few confident rows scattered through each head.
+ *
+ * @param seed Random seed.
+ * @return Three CV_32F matrices of 507, 2028 and 8112 rows by 85 columns.
+ */
+inline std::vector<cv::Mat> syntheticOutputs(uint64_t seed = 7) {
+  cv::RNG rng(seed);
+  std::vector<cv::Mat> outputs;
+  for (int rows : {507, 2028, 8112}) {
+    cv::Mat head(rows, 85, CV_32F, cv::Scalar(0));
+    for (int j = 0; j < rows; ++j) {
+      float* row = head.ptr<float>(j);
+      row[0] = rng.uniform(0.f, 1.f);
+      row[1] = rng.uniform(0.f, 1.f);
+      row[2] = rng.uniform(0.f, 0.3f);
+      row[3] = rng.uniform(0.f, 0.6f);
+      float objectness = rng.uniform(0, 200) == 0 ? rng.uniform(0.5f, 1.f)
+                                                  : rng.uniform(0.f, 0.05f);
+      row[4] = objectness;
+      for (int c = 5; c < 85; ++c) {
+        row[c] = objectness * rng.uniform(0.f, 1.f);
+      }
+    }
+    outputs.push_back(head);
+  }
+  return outputs;
+}
+
+}  // namespace Bench
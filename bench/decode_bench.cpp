@@ -0,0 +1,103 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file decode_bench.cpp
+ * @brief Micro-benchmark of YOLO output decoding.
+ *
+ * Compares the per-row cv::minMaxLoc decoding with the raw-buffer kernel in
+ * decode.hpp. Usage:
+ *
+ *   decode-bench                          synthetic YOLOv3-shaped outputs
+ *   decode-bench outputs.yml.gz           outputs recorded from net.forward
+ *   decode-bench --record img out.yml.gz  record outputs (needs the weights)
+ */
+
+#include <iostream>
+#include <opencv2/imgcodecs.hpp>
+#include <string>
+
+#include "bench_util.hpp"
+#include "decode.hpp"
+#include "detector.hpp"
+
+namespace {
+
+/**
+ * @brief The decoding loop postprocess used before the kernel existed.
+ * @param outputs Network outputs.
+ * @param frameSize Frame size used to scale boxes.
+ * @param threshold Confidence threshold.
+ * @param candidates Receives the person candidates.
+ */
+void legacyDecode(const std::vector<cv::Mat>& outputs,
+                  const cv::Size& frameSize, float threshold,
+                  Detector::Candidates& candidates) {
+  candidates.clear();
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    auto* data = reinterpret_cast<float*>(outputs[i].data);
+    for (int j = 0; j < outputs[i].rows; ++j, data += outputs[i].cols) {
+      cv::Mat scores = outputs[i].row(j).colRange(5, outputs[i].cols);
+      cv::Point classIdPoint;
+      double confidence;
+      cv::minMaxLoc(scores, nullptr, &confidence, nullptr, &classIdPoint);
+      if (confidence > threshold && classIdPoint.x == 0) {
+        int centerX = static_cast<int>(data[0] * frameSize.width);
+        int centerY = static_cast<int>(data[1] * frameSize.height);
+        int width = static_cast<int>(data[2] * frameSize.width);
+        int height = static_cast<int>(data[3] * frameSize.height);
+        candidates.boxes.emplace_back(centerX - width / 2,
+                                      centerY - height / 2, width, height);
+        candidates.scores.push_back(static_cast<float>(confidence));
+        candidates.classIds.push_back(classIdPoint.x);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 4 && std::string(argv[1]) == "--record") {
+    Detector::YOLODetector detector("./config/yolov3.cfg",
+                                    "./model/yolov3.weights",
+                                    "./labels/coco.names");
+    cv::Mat image = cv::imread(argv[2]);
+    if (image.empty()) {
+      std::cerr << "Failed to read " << argv[2] << std::endl;
+      return -1;
+    }
+    Bench::saveOutputs(argv[3], detector.infer(detector.preprocess(image)));
+    std::cout << "Recorded outputs to " << argv[3] << std::endl;
+    return 0;
+  }
+
+  std::vector<cv::Mat> outputs =
+      argc > 1 ? Bench::loadOutputs(argv[1]) : Bench::syntheticOutputs();
+  if (outputs.empty()) {
+    std::cerr << "No outputs loaded from " << argv[1] << std::endl;
+    return -1;
+  }
+
+  const cv::Size frameSize(640, 480);
+  const int iterations = 200;
+  Detector::Candidates candidates;
+
+  double legacy = Bench::measure("legacy minMaxLoc", iterations, [&]() {
+    legacyDecode(outputs, frameSize, 0.5f, candidates);
+  });
+
+  Detector::DecodeConfig personOnly;
+  double single = Bench::measure("kernel person-only", iterations, [&]() {
+    Detector::decodeYoloOutputs(outputs, frameSize, personOnly, candidates);
+  });
+
+  Detector::DecodeConfig allClasses;
+  allClasses.multiClass = true;
+  double multi = Bench::measure("kernel multi-class", iterations, [&]() {
+    Detector::decodeYoloOutputs(outputs, frameSize, allClasses, candidates);
+  });
+
+  std::cout << "speedup person-only: " << legacy / single
+            << "x, multi-class: " << legacy / multi << "x" << std::endl;
+  return 0;
+}
@@ -0,0 +1,328 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file perf_bench.cpp
+ * @brief Google Benchmark suite of the detector and tracker hot paths.
+ *
+ * Run from the repository root so the model files resolve; benchmarks that
+ * need the YOLOv3 weights are skipped without them. Set
+ * ACME_BENCH_OUTPUTS to a file written by "decode-bench --record" to
+ * postprocess recorded network outputs instead of synthetic ones. Write
+ * JSON with --benchmark_out=run.json --benchmark_out_format=json and
+ * compare it to a baseline with scripts/compare_bench.py.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <opencv2/dnn.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "decode.hpp"
+#include "detector.hpp"
+#include "letterbox.hpp"
+#include "multi_tracker.hpp"
+#include "nms.hpp"
+#include "tracker.hpp"
+
+namespace {
+
+/**< Frame size of the benchmarks, a common camera mode */
+const cv::Size kFrameSize(1280, 720);
+
+/**
+ * @brief Gets the detector shared by the benchmarks that need weights.
+ * @return The detector, or null if the model files are missing.
+ */
+Detector::YOLODetector* sharedDetector() {
+  static std::unique_ptr<Detector::YOLODetector> detector = []() {
+    std::unique_ptr<Detector::YOLODetector> loaded;
+    if (std::ifstream("model/yolov3.weights").good()) {
+      loaded.reset(new Detector::YOLODetector(
+          "config/yolov3.cfg", "model/yolov3.weights", "labels/coco.names"));
+    }
+    return loaded;
+  }();
+  return detector.get();
+}
+
+/**
+ * @brief Gets the network outputs the decoding benchmarks replay.
+ * @return Outputs recorded to $ACME_BENCH_OUTPUTS if set and readable,
+ * otherwise synthetic YOLOv3-shaped outputs.
+ */
+const std::vector<cv::Mat>& benchOutputs() {
+  static const std::vector<cv::Mat> outputs = []() {
+    const char* path = std::getenv("ACME_BENCH_OUTPUTS");
+    std::vector<cv::Mat> recorded;
+    if (path != nullptr) {
+      recorded = Bench::loadOutputs(path);
+    }
+    return recorded.empty() ? Bench::syntheticOutputs() : recorded;
+  }();
+  return outputs;
+}
+
+/**
+ * @brief Builds a camera-sized frame with some texture.
+ * @return A BGR frame of kFrameSize.
+ */
+cv::Mat makeFrame() {
+  cv::Mat frame(kFrameSize, CV_8UC3);
+  cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+  return frame;
+}
+
+/**
+ * @brief Builds overlapping candidate boxes, clustered like the raw
+ * detections around real objects in a crowded scene: mostly people, with a
+ * truck every fourth object.
+ * @param count Number of boxes.
+ * @param candidates Receives the boxes, scores and class ids.
+ */
+void makeCandidates(int count, Detector::Candidates* candidates) {
+  std::mt19937 rng(count);
+  std::uniform_int_distribution<int> jitter(-8, 8);
+  std::uniform_real_distribution<float> score(0.5f, 1.f);
+  candidates->clear();
+  for (int i = 0; i < count; ++i) {
+    int cluster = i / 10;  // About ten raw boxes per object
+    int x = (cluster * 97) % (kFrameSize.width - 80);
+    int y = (cluster * 53) % (kFrameSize.height - 160);
+    candidates->boxes.emplace_back(x + jitter(rng), y + jitter(rng),
+                                   80 + jitter(rng), 160 + jitter(rng));
+    candidates->scores.push_back(score(rng));
+    candidates->classIds.push_back(cluster % 4 == 3 ? 7 : 0);
+  }
+}
+
+}  // namespace
+
+/**
+ * @brief YOLODetector::postprocess (decode and NMS) on replayed outputs.
+ * @param state Benchmark state.
+ */
+static void BM_Postprocess(benchmark::State& state) {
+  Detector::YOLODetector* detector = sharedDetector();
+  if (detector == nullptr) {
+    state.SkipWithError("model/yolov3.weights not found");
+    return;
+  }
+  const std::vector<cv::Mat>& outputs = benchOutputs();
+  Detector::BoxTransform transform =
+      Detector::letterboxTransform(kFrameSize, detector->getInputSize());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(detector->postprocess(transform, outputs));
+  }
+}
+BENCHMARK(BM_Postprocess)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief The decoding kernel alone, which needs no weights.
+ * @param state Benchmark state; range(0) = 1 decodes every class.
+ */
+static void BM_DecodeOutputs(benchmark::State& state) {
+  const std::vector<cv::Mat>& outputs = benchOutputs();
+  Detector::DecodeConfig config;
+  config.multiClass = state.range(0) != 0;
+  Detector::Candidates candidates;
+  for (auto _ : state) {
+    Detector::decodeYoloOutputs(outputs, kFrameSize, config, candidates);
+    benchmark::DoNotOptimize(candidates.boxes.data());
+  }
+}
+BENCHMARK(BM_DecodeOutputs)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief cv::dnn::NMSBoxes over a growing number of candidates.
+ * @param state Benchmark state; range(0) = candidate count.
+ */
+static void BM_NMSBoxes(benchmark::State& state) {
+  Detector::Candidates candidates;
+  makeCandidates(static_cast<int>(state.range(0)), &candidates);
+  std::vector<int> indices;
+  for (auto _ : state) {
+    cv::dnn::NMSBoxes(candidates.boxes, candidates.scores, 0.5f, 0.4f,
+                      indices);
+    benchmark::DoNotOptimize(indices.data());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_NMSBoxes)
+    ->RangeMultiplier(4)
+    ->Range(16, 4096)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Class-aware nonMaxSuppression() on the same candidates as
+ * BM_NMSBoxes, per method.
+ * @param state Benchmark state; range(0) = candidate count, range(1) =
+ * Detector::NmsMethod.
+ */
+static void BM_Nms(benchmark::State& state) {
+  Detector::Candidates candidates;
+  makeCandidates(static_cast<int>(state.range(0)), &candidates);
+  Detector::NmsConfig config;
+  config.method = static_cast<Detector::NmsMethod>(state.range(1));
+  std::vector<int> indices;
+  for (auto _ : state) {
+    Detector::nonMaxSuppression(candidates, config, indices);
+    benchmark::DoNotOptimize(indices.data());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_Nms)
+    ->ArgsProduct({benchmark::CreateRange(16, 4096, 4),
+                   {static_cast<int>(Detector::NmsMethod::kOpenCv),
+                    static_cast<int>(Detector::NmsMethod::kGreedy),
+                    static_cast<int>(Detector::NmsMethod::kSoft),
+                    static_cast<int>(Detector::NmsMethod::kMatrix)}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+/**
+ * @brief cv::dnn::blobFromImage, the stretch-resize reference.
+ * @param state Benchmark state; range(0) = input side.
+ */
+static void BM_BlobFromImage(benchmark::State& state) {
+  cv::Mat frame = makeFrame();
+  const int side = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cv::dnn::blobFromImage(
+        frame, 1 / 255.0, cv::Size(side, side), cv::Scalar(), true, false));
+  }
+}
+BENCHMARK(BM_BlobFromImage)
+    ->Arg(320)
+    ->Arg(416)
+    ->Arg(608)
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief The letterbox preprocessor the detector actually uses.
+ * @param state Benchmark state; range(0) = input side.
+ */
+static void BM_Letterbox(benchmark::State& state) {
+  cv::Mat frame = makeFrame();
+  const int side = static_cast<int>(state.range(0));
+  Detector::LetterboxPreprocessor letterbox;
+  for (auto _ : state) {
+    // Dropping the blob each time lets the pool hand the buffer back
+    benchmark::DoNotOptimize(
+        letterbox.process(frame, cv::Size(side, side)).data);
+  }
+}
+BENCHMARK(BM_Letterbox)
+    ->Arg(320)
+    ->Arg(416)
+    ->Arg(608)
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief A full forward pass of the network.
+ * @param state Benchmark state; range(0) = input side.
+ */
+static void BM_Forward(benchmark::State& state) {
+  Detector::YOLODetector* detector = sharedDetector();
+  if (detector == nullptr) {
+    state.SkipWithError("model/yolov3.weights not found");
+    return;
+  }
+  const int side = static_cast<int>(state.range(0));
+  const cv::Size original = detector->getInputSize();
+  detector->setInputSize(cv::Size(side, side));
+  cv::Mat blob = detector->preprocess(makeFrame());
+  detector->infer(blob);  // The first pass allocates the layer buffers
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(detector->infer(blob));
+  }
+  detector->setInputSize(original);
+}
+BENCHMARK(BM_Forward)
+    ->Arg(320)
+    ->Arg(416)
+    ->Arg(608)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * @brief YOLODetector::drawPred for a frame's worth of boxes.
+ * @param state Benchmark state.
+ */
+static void BM_DrawPred(benchmark::State& state) {
+  Detector::YOLODetector* detector = sharedDetector();
+  if (detector == nullptr) {
+    state.SkipWithError("model/yolov3.weights not found");
+    return;
+  }
+  cv::Mat frame = makeFrame();
+  for (auto _ : state) {
+    for (int i = 0; i < 10; ++i) {
+      detector->drawPred(0, 0.9f, 100 * i, 50, 100 * i + 80, 210, frame);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 10);
+}
+BENCHMARK(BM_DrawPred)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Tracker::track on one Kalman tracker per target.
+ * @param state Benchmark state; range(0) = target count.
+ */
+static void BM_TrackerTrack(benchmark::State& state) {
+  const int count = static_cast<int>(state.range(0));
+  std::vector<Tracker::Tracker> trackers(count);
+  for (int i = 0; i < count; ++i) {
+    trackers[i].initialize(cv::Point2f(i, i));
+  }
+  float step = 0;
+  for (auto _ : state) {
+    step += 1;
+    for (int i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(
+          trackers[i].track(cv::Point2f(i + step, i + step)));
+    }
+  }
+  state.SetComplexityN(count);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_TrackerTrack)
+    ->RangeMultiplier(10)
+    ->Range(1, 1000)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief MultiTracker::update with association, per assignment solver.
+ * @param state Benchmark state; range(0) = target count, range(1) = 1 for
+ * the Hungarian solver, 0 for greedy.
+ */
+static void BM_MultiTrackerUpdate(benchmark::State& state) {
+  const int count = static_cast<int>(state.range(0));
+  Tracker::MultiTrackerConfig config;
+  config.solver = state.range(1) ? Tracker::AssignmentSolver::kHungarian
+                                 : Tracker::AssignmentSolver::kGreedy;
+  Tracker::MultiTracker tracker(config);
+  std::vector<cv::Rect2f> boxes;
+  for (int i = 0; i < count; ++i) {
+    boxes.emplace_back((i % 100) * 60.f, (i / 100) * 120.f, 40.f, 100.f);
+  }
+  for (auto _ : state) {
+    for (cv::Rect2f& box : boxes) {
+      box.x += 1.f;
+    }
+    benchmark::DoNotOptimize(tracker.update(boxes).data());
+  }
+  state.SetComplexityN(count);
+}
+BENCHMARK(BM_MultiTrackerUpdate)
+    ->ArgsProduct({{1, 10, 100, 1000}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,87 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file tracker_bench.cpp
+ * @brief Micro-benchmarks of the Kalman filter bank and of MultiTracker
+ * association cost per frame.
+ *
+ * First times one predict/correct step for N targets with a cv::KalmanFilter
+ * per target (Tracker::Tracker) and with the KalmanBank. Then moves N
+ * synthetic targets on a grid and times one update() per frame for both
+ * assignment solvers, so the growth with N can be read off directly.
+ * Usage: tracker-bench [maxTargets]
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "kalman_bank.hpp"
+#include "multi_tracker.hpp"
+#include "tracker.hpp"
+
+int main(int argc, char** argv) {
+  int maxTargets = argc > 1 ? std::atoi(argv[1]) : 4000;
+  const int iterations = 50;
+
+  for (int count = 250; count <= maxTargets; count *= 2) {
+    std::vector<Tracker::Tracker> filters(count);
+    Tracker::KalmanBank bank;
+    for (int i = 0; i < count; ++i) {
+      filters[i].initialize(cv::Point2f(i, i));
+      bank.add(cv::Point2f(i, i));
+    }
+    double perTrack = Bench::measure(
+        "cv::KalmanFilter N=" + std::to_string(count), iterations, [&]() {
+          for (int i = 0; i < count; ++i) {
+            filters[i].predict();
+            filters[i].correct(cv::Point2f(i, i));
+          }
+        });
+    double batched = Bench::measure(
+        "KalmanBank N=" + std::to_string(count), iterations, [&]() {
+          bank.predict();
+          for (int i = 0; i < count; ++i) {
+            bank.setMeasurement(i, cv::Point2f(i, i));
+          }
+          bank.correct();
+        });
+    std::cout << "  speedup: " << perTrack / batched << "x" << std::endl;
+  }
+
+  for (Tracker::AssignmentSolver solver :
+       {Tracker::AssignmentSolver::kGreedy,
+        Tracker::AssignmentSolver::kHungarian}) {
+    std::string solverName =
+        solver == Tracker::AssignmentSolver::kGreedy ? "greedy" : "hungarian";
+    for (int count = 250; count <= maxTargets; count *= 2) {
+      Tracker::MultiTrackerConfig config;
+      config.solver = solver;
+      Tracker::MultiTracker tracker(config);
+
+      std::mt19937 rng(count);
+      std::uniform_real_distribution<float> speed(-2.f, 2.f);
+      std::vector<cv::Rect2f> boxes;
+      std::vector<cv::Point2f> velocities;
+      for (int i = 0; i < count; ++i) {
+        boxes.emplace_back((i % 100) * 60.f, (i / 100) * 120.f, 40.f, 100.f);
+        velocities.emplace_back(speed(rng), speed(rng));
+      }
+
+      double micros = Bench::measure(
+          solverName + " N=" + std::to_string(count), iterations, [&]() {
+            for (int i = 0; i < count; ++i) {
+              boxes[i].x += velocities[i].x;
+              boxes[i].y += velocities[i].y;
+            }
+            tracker.update(boxes);
+          });
+      std::cout << "  per target: " << micros / count << " us, tracks: "
+                << tracker.getConfirmedTracks().size() << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,602 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "backend.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/dnn.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "decode.hpp"
+#include "model_cache.hpp"
+
+#ifdef ACME_WITH_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+
+// DNN_TARGET_CPU_FP16 first shipped with OpenCV 4.9
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 9)
+#define ACME_HAVE_CPU_FP16 1
+#else
+#define ACME_HAVE_CPU_FP16 0
+#endif
+
+namespace Detector {
+
+namespace {
+
+/**
+ * @brief Throws unless a model file path is set.
+ * @param path The path.
+ * @param what Description used in the error.
+ */
+void requireFile(const std::string& path, const std::string& what) {
+  if (path.empty()) {
+    throw std::runtime_error("No " + what + " given");
+  }
+}
+
+#ifdef ACME_WITH_ONNXRUNTIME
+/**
+ * @brief Gets where the graph-optimized form of an ONNX model is cached.
+ * @param files Model files; cacheDir selects the cache.
+ * @param model Path to the ONNX model.
+ * @param option Engine and precision the model runs with.
+ * @return The cache path, or empty if caching is off.
+ */
+std::string optimizedModelPath(const ModelFiles& files,
+                               const std::string& model,
+                               const BackendOption& option) {
+  if (files.cacheDir.empty()) {
+    return "";
+  }
+  // A model optimized by one runtime version may not load in another
+  const std::string engine =
+      option.name() + "-api" + std::to_string(ORT_API_VERSION);
+  return ModelCache(files.cacheDir)
+      .path(hexKey(fingerprintFile(model)), "-" + engine + ".onnx");
+}
+#endif
+
+/**
+ * @brief Builds the model cache key of a backend choice.
+ * @param options The candidates, in order.
+ * @param files Model files the candidates load.
+ * @param sample The input blob the candidates are timed on.
+ * @return The key; it changes with any model file's size or modification
+ * time, the candidates, the input shape, the OpenCV build or the CPU.
+ */
+std::string choiceKey(const std::vector<BackendOption>& options,
+                      const ModelFiles& files, const cv::Mat& sample) {
+  uint64_t hash = 0;
+  for (const std::string& path :
+       {files.config, files.weights, files.onnx, files.onnxInt8}) {
+    if (!path.empty()) {
+      hash = fingerprintFile(path, hash);
+    }
+  }
+  std::ostringstream context;
+  for (const BackendOption& option : options) {
+    context << option.name() << ',';
+  }
+  for (int i = 0; i < sample.dims; ++i) {
+    context << sample.size[i] << 'x';
+  }
+  context << cv::getNumThreads() << ' ' << std::thread::hardware_concurrency()
+          << ' ' << cv::getCPUFeaturesLine() << '\n'
+          << cv::getBuildInformation();
+  const std::string text = context.str();
+  return hexKey(hashBytes(text.data(), text.size(), hash));
+}
+
+/**
+ * @brief Checks whether an option runs the Darknet model itself rather
+ * than an ONNX export.
+ * @param option The option.
+ * @return True for the OpenCV fp32 and fp16 and the OpenVINO options.
+ */
+bool runsDarknet(const BackendOption& option) {
+  return option.kind == BackendKind::kOpenVino ||
+         (option.kind == BackendKind::kOpenCv &&
+          option.precision != Precision::kINT8);
+}
+
+/**
+ * @class OpenCvBackend
+ * @brief Runs a cv::dnn::Net on a chosen DNN backend and target.
+ */
+class OpenCvBackend : public InferenceBackend {
+ public:
+  /**
+   * @brief Configures a loaded network.
+   * @param network The loaded network; a handle, so a network shared with
+   * a detector is configured in place rather than copied.
+   * @param option Engine and precision, reported by option().
+   * @param backendId cv::dnn::Backend to run on.
+   * @param targetId cv::dnn::Target to run on.
+   */
+  OpenCvBackend(cv::dnn::Net network, const BackendOption& option,
+                int backendId, int targetId)
+      : net(network), selected(option) {
+    if (net.empty()) {
+      throw std::runtime_error("Failed to load network for " + option.name());
+    }
+    net.setPreferableBackend(backendId);
+    net.setPreferableTarget(targetId);
+    outputNames = net.getUnconnectedOutLayersNames();
+  }
+
+  /**
+   * @brief Runs a forward pass.
+   * @param blob The NCHW input blob.
+   * @return One 2D matrix per output head; may alias the network's buffers
+   * until the next call.
+   */
+  std::vector<cv::Mat> infer(const cv::Mat& blob) override {
+    net.setInput(blob);
+    std::vector<cv::Mat> outputs;
+    net.forward(outputs, outputNames);
+    for (cv::Mat& output : outputs) {
+      output = asRows(output);
+    }
+    return outputs;
+  }
+
+  /**
+   * @brief Gets the engine and precision this backend runs.
+   * @return The backend option.
+   */
+  BackendOption option() const override { return selected; }
+
+  /**
+   * @brief Gets the time each layer took in the last forward pass.
+   * @return Per-layer times in network order.
+   */
+  std::vector<Metrics::LayerTiming> layerTimings() override {
+    return readLayerTimings(net);
+  }
+
+ private:
+  cv::dnn::Net net;                     /**< The configured network */
+  BackendOption selected;               /**< Engine and precision */
+  std::vector<std::string> outputNames; /**< Output layers to fetch */
+};
+
+#ifdef ACME_WITH_ONNXRUNTIME
+/**
+ * @class OnnxRuntimeBackend
+ * @brief Runs an ONNX export of the network with ONNX Runtime on the CPU.
+ */
+class OnnxRuntimeBackend : public InferenceBackend {
+ public:
+  /**
+   * @brief Creates a session for a model.
+   * @param model Path to the ONNX model.
+   * @param option Engine and precision, reported by option().
+   * @param optimizedPath Where the graph-optimized model is cached; it is
+   * loaded from there if present and saved there otherwise. Empty always
+   * optimizes the model afresh.
+   */
+  OnnxRuntimeBackend(const std::string& model, const BackendOption& option,
+                     const std::string& optimizedPath)
+      : env(ORT_LOGGING_LEVEL_WARNING, "acme"),
+        session(nullptr),
+        memory(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator,
+                                          OrtMemTypeDefault)),
+        selected(option) {
+    Ort::SessionOptions options;
+    if (!optimizedPath.empty() && std::ifstream(optimizedPath).good()) {
+      // Fusions are already applied; running them again only costs time
+      options.SetGraphOptimizationLevel(
+          GraphOptimizationLevel::ORT_DISABLE_ALL);
+      session = Ort::Session(env, optimizedPath.c_str(), options);
+    } else {
+      options.SetGraphOptimizationLevel(
+          GraphOptimizationLevel::ORT_ENABLE_ALL);
+      std::string staging;
+      if (!optimizedPath.empty()) {
+        staging = stagingPath(optimizedPath) + ".onnx";
+        options.SetOptimizedModelFilePath(staging.c_str());
+      }
+      session = Ort::Session(env, model.c_str(), options);
+      if (!staging.empty() &&
+          std::rename(staging.c_str(), optimizedPath.c_str()) != 0) {
+        std::remove(staging.c_str());
+      }
+    }
+
+    Ort::AllocatorWithDefaultOptions allocator;
+    for (size_t i = 0; i < session.GetInputCount(); ++i) {
+      inputNames.push_back(session.GetInputNameAllocated(i, allocator).get());
+    }
+    for (size_t i = 0; i < session.GetOutputCount(); ++i) {
+      outputNames.push_back(
+          session.GetOutputNameAllocated(i, allocator).get());
+    }
+    for (const std::string& name : inputNames) {
+      inputPointers.push_back(name.c_str());
+    }
+    for (const std::string& name : outputNames) {
+      outputPointers.push_back(name.c_str());
+    }
+  }
+
+  /**
+   * @brief Runs a forward pass.
+   * @param blob The NCHW CV_32F input blob.
+   * @return One 2D matrix per output head, owned by the caller.
+   */
+  std::vector<cv::Mat> infer(const cv::Mat& blob) override {
+    std::vector<int64_t> shape(blob.size.p, blob.size.p + blob.dims);
+    Ort::Value input = Ort::Value::CreateTensor<float>(
+        memory, const_cast<float*>(blob.ptr<float>()), blob.total(),
+        shape.data(), shape.size());
+    std::vector<Ort::Value> values =
+        session.Run(Ort::RunOptions{nullptr}, inputPointers.data(), &input, 1,
+                    outputPointers.data(), outputPointers.size());
+
+    std::vector<cv::Mat> outputs;
+    for (Ort::Value& value : values) {
+      Ort::TensorTypeAndShapeInfo info = value.GetTensorTypeAndShapeInfo();
+      std::vector<int64_t> dims = info.GetShape();
+      int cols = static_cast<int>(dims.back());
+      int rows = static_cast<int>(info.GetElementCount() / cols);
+      outputs.push_back(
+          cv::Mat(rows, cols, CV_32F, value.GetTensorMutableData<float>())
+              .clone());
+    }
+    return outputs;
+  }
+
+  /**
+   * @brief Gets the engine and precision this backend runs.
+   * @return The backend option.
+   */
+  BackendOption option() const override { return selected; }
+
+ private:
+  Ort::Env env;                            /**< Runtime environment */
+  Ort::Session session;                    /**< The loaded model */
+  Ort::MemoryInfo memory;                  /**< CPU memory descriptor */
+  BackendOption selected;                  /**< Engine and precision */
+  std::vector<std::string> inputNames;     /**< Model input names */
+  std::vector<std::string> outputNames;    /**< Model output names */
+  std::vector<const char*> inputPointers;  /**< inputNames as C strings */
+  std::vector<const char*> outputPointers; /**< outputNames as C strings */
+};
+#endif
+
+/**
+ * @brief Checks whether OpenCV was built with the OpenVINO backend.
+ * @return True if OpenVINO can run on the CPU.
+ */
+bool haveOpenVino() {
+  std::vector<cv::dnn::Target> targets =
+      cv::dnn::getAvailableTargets(cv::dnn::DNN_BACKEND_INFERENCE_ENGINE);
+  return std::find(targets.begin(), targets.end(), cv::dnn::DNN_TARGET_CPU) !=
+         targets.end();
+}
+
+}  // namespace
+
+/**
+ * @brief Reads the per-layer times of a network's last forward pass.
+ * @param net A network that has run at least once.
+ * @return One entry per layer, the input layer excluded, in network order.
+ */
+std::vector<Metrics::LayerTiming> readLayerTimings(cv::dnn::Net& net) {
+  std::vector<double> ticks;
+  net.getPerfProfile(ticks);
+  std::vector<std::string> names = net.getLayerNames();
+  // Both skip the input layer, so entry i is layer i + 1 in each
+  const double msPerTick = 1000.0 / cv::getTickFrequency();
+  std::vector<Metrics::LayerTiming> layers(
+      std::min(ticks.size(), names.size()));
+  for (size_t i = 0; i < layers.size(); ++i) {
+    layers[i].name = names[i];
+    layers[i].ms = ticks[i] * msPerTick;
+  }
+  return layers;
+}
+
+/**
+ * @brief Gets the option's name, e.g. "openvino-fp32".
+ * @return The name understood by parseBackendOption().
+ */
+std::string BackendOption::name() const {
+  std::string engine = kind == BackendKind::kOpenVino      ? "openvino"
+                       : kind == BackendKind::kOnnxRuntime ? "onnxruntime"
+                                                           : "opencv";
+  std::string bits = precision == Precision::kFP16   ? "fp16"
+                     : precision == Precision::kINT8 ? "int8"
+                                                     : "fp32";
+  return engine + "-" + bits;
+}
+
+/**
+ * @brief Parses an option name such as "opencv", "opencv-fp16" or
+ * "onnxruntime-int8". The precision defaults to fp32.
+ * @param name The option name.
+ * @return The parsed option.
+ * @throws std::runtime_error if the name is not recognized.
+ */
+BackendOption parseBackendOption(const std::string& name) {
+  std::string lower(name);
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  });
+  size_t dash = lower.find('-');
+  std::string engine = lower.substr(0, dash);
+  std::string bits =
+      dash == std::string::npos ? "fp32" : lower.substr(dash + 1);
+
+  BackendOption option;
+  if (engine == "opencv") {
+    option.kind = BackendKind::kOpenCv;
+  } else if (engine == "openvino") {
+    option.kind = BackendKind::kOpenVino;
+  } else if (engine == "onnxruntime" || engine == "ort") {
+    option.kind = BackendKind::kOnnxRuntime;
+  } else {
+    throw std::runtime_error("Unknown inference backend: " + name);
+  }
+  if (bits == "fp32") {
+    option.precision = Precision::kFP32;
+  } else if (bits == "fp16") {
+    option.precision = Precision::kFP16;
+  } else if (bits == "int8") {
+    option.precision = Precision::kINT8;
+  } else {
+    throw std::runtime_error("Unknown precision in backend: " + name);
+  }
+  return option;
+}
+
+/**
+ * @brief Lists the options this build and machine can run with the given
+ * model files.
+ * @param files The available model files.
+ * @return The runnable options.
+ */
+std::vector<BackendOption> availableBackends(const ModelFiles& files) {
+  std::vector<BackendOption> options;
+  bool darknet = !files.config.empty() && !files.weights.empty();
+  if (darknet) {
+    options.push_back({BackendKind::kOpenCv, Precision::kFP32});
+#if ACME_HAVE_CPU_FP16
+    options.push_back({BackendKind::kOpenCv, Precision::kFP16});
+#endif
+    if (haveOpenVino()) {
+      options.push_back({BackendKind::kOpenVino, Precision::kFP32});
+    }
+  }
+  if (!files.onnxInt8.empty()) {
+    options.push_back({BackendKind::kOpenCv, Precision::kINT8});
+  }
+#ifdef ACME_WITH_ONNXRUNTIME
+  if (!files.onnx.empty()) {
+    options.push_back({BackendKind::kOnnxRuntime, Precision::kFP32});
+  }
+  if (!files.onnxInt8.empty()) {
+    options.push_back({BackendKind::kOnnxRuntime, Precision::kINT8});
+  }
+#endif
+  return options;
+}
+
+/**
+ * @brief Creates a backend.
+ * @param option Engine and precision.
+ * @param files Model files to load.
+ * @param darknet The Darknet network already loaded from files, or empty.
+ * The options that run it configure this network in place instead of
+ * reading the files again; the ONNX options ignore it.
+ * @return The backend.
+ * @throws std::runtime_error if the option is unavailable or loading fails.
+ */
+std::unique_ptr<InferenceBackend> createBackend(const BackendOption& option,
+                                                const ModelFiles& files,
+                                                cv::dnn::Net darknet) {
+  try {
+    if (darknet.empty() && runsDarknet(option)) {
+      requireFile(files.weights, "Darknet weights");
+    }
+    auto network = [&]() {
+      return darknet.empty()
+                 ? cv::dnn::readNetFromDarknet(files.config, files.weights)
+                 : darknet;
+    };
+    switch (option.kind) {
+      case BackendKind::kOpenCv:
+        if (option.precision == Precision::kINT8) {
+          requireFile(files.onnxInt8, "INT8 ONNX model");
+          return std::unique_ptr<InferenceBackend>(new OpenCvBackend(
+              cv::dnn::readNetFromONNX(files.onnxInt8), option,
+              cv::dnn::DNN_BACKEND_OPENCV, cv::dnn::DNN_TARGET_CPU));
+        }
+        if (option.precision == Precision::kFP16) {
+#if ACME_HAVE_CPU_FP16
+          return std::unique_ptr<InferenceBackend>(new OpenCvBackend(
+              network(), option,
+              cv::dnn::DNN_BACKEND_OPENCV, cv::dnn::DNN_TARGET_CPU_FP16));
+#else
+          throw std::runtime_error("OpenCV " CV_VERSION
+                                   " has no FP16 CPU target");
+#endif
+        }
+        return std::unique_ptr<InferenceBackend>(new OpenCvBackend(
+            network(), option, cv::dnn::DNN_BACKEND_OPENCV,
+            cv::dnn::DNN_TARGET_CPU));
+
+      case BackendKind::kOpenVino:
+        if (option.precision != Precision::kFP32) {
+          throw std::runtime_error(option.name() + " is not supported");
+        }
+        if (!haveOpenVino()) {
+          throw std::runtime_error("OpenCV was built without OpenVINO");
+        }
+        return std::unique_ptr<InferenceBackend>(new OpenCvBackend(
+            network(), option, cv::dnn::DNN_BACKEND_INFERENCE_ENGINE,
+            cv::dnn::DNN_TARGET_CPU));
+
+      case BackendKind::kOnnxRuntime:
+#ifdef ACME_WITH_ONNXRUNTIME
+        if (option.precision == Precision::kFP16) {
+          throw std::runtime_error(option.name() + " is not supported");
+        }
+        if (option.precision == Precision::kINT8) {
+          requireFile(files.onnxInt8, "INT8 ONNX model");
+          return std::unique_ptr<InferenceBackend>(new OnnxRuntimeBackend(
+              files.onnxInt8, option,
+              optimizedModelPath(files, files.onnxInt8, option)));
+        }
+        requireFile(files.onnx, "ONNX model");
+        return std::unique_ptr<InferenceBackend>(new OnnxRuntimeBackend(
+            files.onnx, option, optimizedModelPath(files, files.onnx, option)));
+#else
+        throw std::runtime_error("Built without ONNX Runtime");
+#endif
+    }
+  } catch (const cv::Exception& e) {
+    throw std::runtime_error("Failed to create " + option.name() + ": " +
+                             e.what());
+  }
+  throw std::runtime_error("Unknown inference backend");
+}
+
+/**
+ * @brief Formats the report for logging.
+ * @return One line per option and a line naming the choice.
+ */
+std::string BackendReport::summary() const {
+  std::ostringstream out;
+  for (const BackendTiming& timing : timings) {
+    out << "  " << timing.option.name() << ": ";
+    if (timing.error.empty()) {
+      out << timing.latencyMs << " ms\n";
+    } else {
+      out << "unavailable (" << timing.error << ")\n";
+    }
+  }
+  out << "Inference backend: " << chosen.name();
+  if (cached) {
+    out << " (from the model cache)";
+  }
+  return out.str();
+}
+
+/**
+ * @brief Times each candidate on a sample blob and keeps the fastest.
+ *
+ * With a cache directory in files, the choice is recorded under a key
+ * covering the model files' sizes and modification times, the candidates,
+ * the sample shape, the OpenCV build and the CPU, and a later call with
+ * the same key creates the recorded backend without timing anything.
+ *
+ * @param candidates Options to try, in order; empty tries every available
+ * option.
+ * @param files Model files to load.
+ * @param sample An input blob of the size used at run time.
+ * @param runs Timed forward passes per option, after two warmup passes.
+ * @param report Receives the timings and the choice.
+ * @param darknet The Darknet network already loaded from files, or empty;
+ * the Darknet candidates take turns configuring it rather than each
+ * loading a copy.
+ * @return The fastest backend.
+ * @throws std::runtime_error if no candidate runs.
+ */
+std::unique_ptr<InferenceBackend> selectFastestBackend(
+    const std::vector<BackendOption>& candidates, const ModelFiles& files,
+    const cv::Mat& sample, int runs, BackendReport* report,
+    cv::dnn::Net darknet) {
+  std::vector<BackendOption> options =
+      candidates.empty() ? availableBackends(files) : candidates;
+  runs = std::max(1, runs);
+
+  std::string key;
+  if (!files.cacheDir.empty()) {
+    key = choiceKey(options, files, sample);
+    BackendTiming timing;
+    std::string name;
+    if (ModelCache(files.cacheDir).readChoice(key, &name, &timing.latencyMs)) {
+      try {
+        timing.option = parseBackendOption(name);
+        std::unique_ptr<InferenceBackend> backend =
+            createBackend(timing.option, files, darknet);
+        if (report != nullptr) {
+          report->chosen = timing.option;
+          report->timings.assign(1, timing);
+          report->cached = true;
+        }
+        return backend;
+      } catch (const std::exception& e) {
+        std::cerr << "Ignoring cached backend " << name << ": " << e.what()
+                  << std::endl;
+      }
+    }
+  }
+
+  BackendReport local;
+  std::unique_ptr<InferenceBackend> best;
+  double bestLatency = 0;
+  for (const BackendOption& option : options) {
+    BackendTiming timing;
+    timing.option = option;
+    try {
+      std::unique_ptr<InferenceBackend> backend =
+          createBackend(option, files, darknet);
+      for (int i = 0; i < 2; ++i) {  // First passes include lazy setup
+        backend->infer(sample);
+      }
+      std::vector<double> latencies;
+      for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        backend->infer(sample);
+        auto stop = std::chrono::steady_clock::now();
+        latencies.push_back(
+            std::chrono::duration<double, std::milli>(stop - start).count());
+      }
+      std::nth_element(latencies.begin(),
+                       latencies.begin() + latencies.size() / 2,
+                       latencies.end());
+      timing.latencyMs = latencies[latencies.size() / 2];
+      if (!best || timing.latencyMs < bestLatency) {
+        best = std::move(backend);
+        bestLatency = timing.latencyMs;
+        local.chosen = option;
+      }
+    } catch (const std::exception& e) {
+      timing.error = e.what();
+    }
+    local.timings.push_back(timing);
+  }
+
+  if (!best) {
+    std::string reasons;
+    for (const BackendTiming& timing : local.timings) {
+      reasons += "\n  " + timing.option.name() + ": " + timing.error;
+    }
+    throw std::runtime_error("No inference backend could run:" + reasons);
+  }
+  if (!darknet.empty() && runsDarknet(local.chosen)) {
+    // Later candidates reconfigured the shared network; point it back
+    best = createBackend(local.chosen, files, darknet);
+  }
+  if (!key.empty() && !ModelCache(files.cacheDir).writeChoice(
+                          key, local.chosen.name(), bestLatency)) {
+    std::cerr << "Cannot write the backend choice to the model cache "
+              << files.cacheDir << std::endl;
+  }
+  if (report != nullptr) {
+    *report = local;
+  }
+  return best;
+}
+
+}  // namespace Detector
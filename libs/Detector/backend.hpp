@@ -0,0 +1,207 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file backend.hpp
+ * @brief Inference backends (OpenCV DNN, OpenVINO, ONNX Runtime) and the
+ * startup self-benchmark that picks the fastest one.
+ */
+
+#include <memory>
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+#include <string>
+#include <vector>
+
+#include "metrics.hpp"
+
+namespace Detector {
+
+/**
+ * @enum BackendKind
+ * @brief Engine that runs the network. All of them run on the CPU.
+ */
+enum class BackendKind {
+  kOpenCv,      /**< OpenCV DNN's own CPU implementation */
+  kOpenVino,    /**< OpenCV DNN through the OpenVINO Inference Engine */
+  kOnnxRuntime  /**< ONNX Runtime, when built WITH_ONNXRUNTIME */
+};
+
+/**
+ * @enum Precision
+ * @brief Numeric precision of the model variant.
+ */
+enum class Precision {
+  kFP32, /**< The Darknet weights as trained */
+  kFP16, /**< Half-precision compute where the CPU supports it */
+  kINT8  /**< A pre-quantized ONNX model */
+};
+
+/**
+ * @struct BackendOption
+ * @brief One engine and precision pair that can run the detector.
+ */
+struct BackendOption {
+  BackendKind kind = BackendKind::kOpenCv;  /**< Engine */
+  Precision precision = Precision::kFP32;   /**< Model precision */
+
+  /**
+   * @brief Gets the option's name, e.g. "openvino-fp32".
+   * @return The name understood by parseBackendOption().
+   */
+  std::string name() const;
+
+  /**
+   * @brief Compares two options.
+   * @param other The option to compare with.
+   * @return True if engine and precision match.
+   */
+  bool operator==(const BackendOption& other) const {
+    return kind == other.kind && precision == other.precision;
+  }
+};
+
+/**
+ * @brief Parses an option name such as "opencv", "opencv-fp16" or
+ * "onnxruntime-int8". The precision defaults to fp32.
+ * @param name The option name.
+ * @return The parsed option.
+ * @throws std::runtime_error if the name is not recognized.
+ */
+BackendOption parseBackendOption(const std::string& name);
+
+/**
+ * @struct ModelFiles
+ * @brief Model files the backends can load.
+ *
+ * ONNX models must be exported from the same Darknet network, so their
+ * output rows keep the [cx, cy, w, h, objectness, class scores...] layout
+ * with coordinates normalized to the input size.
+ */
+struct ModelFiles {
+  std::string config;   /**< Darknet .cfg */
+  std::string weights;  /**< Darknet .weights */
+  std::string onnx;     /**< FP32 ONNX export, for ONNX Runtime */
+  std::string onnxInt8; /**< INT8-quantized ONNX export */
+  /**< ModelCache directory for optimized models and the backend choice;
+   * empty disables caching */
+  std::string cacheDir;
+};
+
+/**
+ * @class InferenceBackend
+ * @brief Runs the YOLO network on a preprocessed input blob.
+ */
+class InferenceBackend {
+ public:
+  /**
+   * @brief Destroys the backend.
+   */
+  virtual ~InferenceBackend() = default;
+
+  /**
+   * @brief Runs a forward pass.
+   * @param blob The NCHW input blob.
+   * @return One 2D CV_32F matrix per output head, one row per anchor.
+   * The matrices may alias the backend's buffers and are valid only until
+   * the next infer(); copy them to keep them longer.
+   */
+  virtual std::vector<cv::Mat> infer(const cv::Mat& blob) = 0;
+
+  /**
+   * @brief Gets the engine and precision this backend runs.
+   * @return The backend option.
+   */
+  virtual BackendOption option() const = 0;
+
+  /**
+   * @brief Gets the time each layer took in the last forward pass.
+   * @return Per-layer times in network order; empty if the engine does not
+   * report them.
+   */
+  virtual std::vector<Metrics::LayerTiming> layerTimings() { return {}; }
+};
+
+/**
+ * @brief Reads the per-layer times of a network's last forward pass.
+ * @param net A network that has run at least once.
+ * @return One entry per layer, the input layer excluded, in network order.
+ */
+std::vector<Metrics::LayerTiming> readLayerTimings(cv::dnn::Net& net);
+
+/**
+ * @brief Lists the options this build and machine can run with the given
+ * model files, fastest-first by expectation.
+ * @param files The available model files.
+ * @return The runnable options.
+ */
+std::vector<BackendOption> availableBackends(const ModelFiles& files);
+
+/**
+ * @brief Creates a backend.
+ * @param option Engine and precision.
+ * @param files Model files to load.
+ * @param darknet The Darknet network already loaded from files, or empty.
+ * The options that run it configure this network in place instead of
+ * reading the files again; the ONNX options ignore it.
+ * @return The backend.
+ * @throws std::runtime_error if the option is unavailable or loading fails.
+ */
+std::unique_ptr<InferenceBackend> createBackend(
+    const BackendOption& option, const ModelFiles& files,
+    cv::dnn::Net darknet = cv::dnn::Net());
+
+/**
+ * @struct BackendTiming
+ * @brief Self-benchmark result of one option.
+ */
+struct BackendTiming {
+  BackendOption option;  /**< The option measured */
+  double latencyMs = 0;  /**< Median forward latency, if it ran */
+  std::string error;     /**< Why the option failed, empty if it ran */
+};
+
+/**
+ * @struct BackendReport
+ * @brief Outcome of the startup self-benchmark.
+ */
+struct BackendReport {
+  BackendOption chosen;               /**< The option selected */
+  std::vector<BackendTiming> timings; /**< Every option tried */
+  /**< The choice was read from the model cache, not measured; timings
+   * then holds the latency recorded when it was measured */
+  bool cached = false;
+
+  /**
+   * @brief Formats the report for logging.
+   * @return One line per option and a line naming the choice.
+   */
+  std::string summary() const;
+};
+
+/**
+ * @brief Times each candidate on a sample blob and keeps the fastest.
+ *
+ * With a cache directory in files, the choice is recorded under a key
+ * covering the model files' sizes and modification times, the candidates,
+ * the sample shape, the OpenCV build and the CPU, and a later call with
+ * the same key creates the recorded backend without timing anything.
+ *
+ * @param candidates Options to try, in order; empty tries every available
+ * option.
+ * @param files Model files to load.
+ * @param sample An input blob of the size used at run time.
+ * @param runs Timed forward passes per option, after two warmup passes.
+ * @param report Receives the timings and the choice.
+ * @param darknet The Darknet network already loaded from files, or empty;
+ * the Darknet candidates take turns configuring it rather than each
+ * loading a copy.
+ * @return The fastest backend.
+ * @throws std::runtime_error if no candidate runs.
+ */
+std::unique_ptr<InferenceBackend> selectFastestBackend(
+    const std::vector<BackendOption>& candidates, const ModelFiles& files,
+    const cv::Mat& sample, int runs, BackendReport* report,
+    cv::dnn::Net darknet = cv::dnn::Net());
+
+}  // namespace Detector
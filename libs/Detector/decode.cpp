@@ -0,0 +1,273 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+#include "decode.hpp"
+
+#include <algorithm>
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace Detector {
+
+namespace {
+
+/**
+ * @brief Converts normalized [cx, cy, w, h] boxes to pixel rectangles.
+ *
+ * Matches the scalar conversion used before the kernel existed: the center
+ * and size are truncated to int separately and the left/top edge is the
+ * center minus half the size, rounded toward zero.
+ *
+ * @param raw Interleaved normalized boxes, four floats per box.
+ * @param count Number of boxes.
+ * @param transform Maps normalized coordinates to frame pixels.
+ * @param boxes Receives the converted boxes; appended to.
+ */
+void convertBoxes(const float* raw, size_t count,
+                  const BoxTransform& transform,
+                  std::vector<cv::Rect>* boxes) {
+  const float scaleX = transform.scaleX;
+  const float scaleY = transform.scaleY;
+  const float offsetX = transform.offsetX;
+  const float offsetY = transform.offsetY;
+  size_t i = 0;
+
+#if CV_SIMD
+  const size_t step = cv::v_float32::nlanes;
+  const cv::v_float32 vScaleX = cv::vx_setall_f32(scaleX);
+  const cv::v_float32 vScaleY = cv::vx_setall_f32(scaleY);
+  const cv::v_float32 vOffsetX = cv::vx_setall_f32(offsetX);
+  const cv::v_float32 vOffsetY = cv::vx_setall_f32(offsetY);
+  int packed[4 * cv::v_float32::nlanes];
+  for (; i + step <= count; i += step) {
+    cv::v_float32 cx, cy, w, h;
+    cv::v_load_deinterleave(raw + 4 * i, cx, cy, w, h);
+    // Multiply then subtract rather than fma, to round like the scalar tail
+    cv::v_int32 centerX = cv::v_trunc(cx * vScaleX - vOffsetX);
+    cv::v_int32 centerY = cv::v_trunc(cy * vScaleY - vOffsetY);
+    cv::v_int32 width = cv::v_trunc(w * vScaleX);
+    cv::v_int32 height = cv::v_trunc(h * vScaleY);
+    // x / 2 rounded toward zero: add one before the shift when x < 0
+    cv::v_int32 left = centerX - cv::v_shr<1>(width - cv::v_shr<31>(width));
+    cv::v_int32 top = centerY - cv::v_shr<1>(height - cv::v_shr<31>(height));
+    cv::v_store_interleave(packed, left, top, width, height);
+    for (size_t k = 0; k < step; ++k) {
+      boxes->emplace_back(packed[4 * k], packed[4 * k + 1], packed[4 * k + 2],
+                          packed[4 * k + 3]);
+    }
+  }
+  cv::v_cleanup();
+#endif
+
+  for (; i < count; ++i) {
+    const float* box = raw + 4 * i;
+    int centerX = static_cast<int>(box[0] * scaleX - offsetX);
+    int centerY = static_cast<int>(box[1] * scaleY - offsetY);
+    int width = static_cast<int>(box[2] * scaleX);
+    int height = static_cast<int>(box[3] * scaleY);
+    boxes->emplace_back(centerX - width / 2, centerY - height / 2, width,
+                        height);
+  }
+}
+
+}  // namespace
+
+/**
+ * @brief Removes all candidates while keeping the allocated capacity.
+ */
+void Candidates::clear() {
+  boxes.clear();
+  scores.clear();
+  classIds.clear();
+  normalized.clear();
+}
+
+/**
+ * @brief Finds the highest score in a contiguous array.
+ * @param scores Pointer to the scores.
+ * @param count Number of scores.
+ * @param index Receives the index of the first maximum.
+ * @return The maximum score.
+ */
+float argmaxScore(const float* scores, int count, int* index) {
+  *index = 0;
+  if (count <= 0) {
+    return 0.f;
+  }
+  float best = scores[0];
+  int i = 0;
+
+#if CV_SIMD
+  const int step = cv::v_float32::nlanes;
+  if (count >= step) {
+    cv::v_float32 vBest = cv::vx_load(scores);
+    for (i = step; i + step <= count; i += step) {
+      vBest = cv::v_max(vBest, cv::vx_load(scores + i));
+    }
+    best = cv::v_reduce_max(vBest);
+    for (; i < count; ++i) {
+      best = std::max(best, scores[i]);
+    }
+
+    // Second pass finds the first lane holding the maximum, which keeps
+    // the tie-breaking of cv::minMaxLoc
+    vBest = cv::vx_setall_f32(best);
+    for (i = 0; i + step <= count; i += step) {
+      int mask = cv::v_signmask(cv::vx_load(scores + i) == vBest);
+      if (mask != 0) {
+        int lane = 0;
+        while ((mask & 1) == 0) {
+          mask >>= 1;
+          ++lane;
+        }
+        *index = i + lane;
+        cv::v_cleanup();
+        return best;
+      }
+    }
+    for (; i < count; ++i) {
+      if (scores[i] == best) {
+        *index = i;
+        break;
+      }
+    }
+    cv::v_cleanup();
+    return best;
+  }
+#endif
+
+  for (i = 1; i < count; ++i) {
+    if (scores[i] > best) {
+      best = scores[i];
+      *index = i;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Decodes one YOLO output head held in a raw float buffer.
+ * @param data Pointer to the first row.
+ * @param rows Number of rows (anchor positions).
+ * @param cols Row stride in floats (5 + number of classes).
+ * @param frameSize Size of the frame the boxes are scaled to.
+ * @param config Thresholds and class selection.
+ * @param candidates Receives the decoded candidates; appended to.
+ */
+void decodeYoloOutput(const float* data, int rows, int cols,
+                      const cv::Size& frameSize, const DecodeConfig& config,
+                      Candidates& candidates) {
+  decodeYoloOutput(data, rows, cols, BoxTransform(frameSize), config,
+                   candidates);
+}
+
+/**
+ * @brief Decodes one YOLO output head, mapping boxes through a transform.
+ * @param data Pointer to the first row.
+ * @param rows Number of rows (anchor positions).
+ * @param cols Row stride in floats (5 + number of classes).
+ * @param transform Maps normalized coordinates to frame pixels.
+ * @param config Thresholds and class selection.
+ * @param candidates Receives the decoded candidates; appended to.
+ */
+void decodeYoloOutput(const float* data, int rows, int cols,
+                      const BoxTransform& transform,
+                      const DecodeConfig& config, Candidates& candidates) {
+  const int numClasses = cols - 5;
+  if (numClasses <= 0 || config.classId < 0 ||
+      (!config.multiClass && config.classId >= numClasses)) {
+    return;
+  }
+  for (int classId : config.classes) {
+    if (classId < 0 || classId >= numClasses) {
+      return;
+    }
+  }
+  const std::vector<int>& classes = config.classes;
+  const float threshold = config.confThreshold;
+
+  // Accepted rows are staged and converted to pixels in one pass at the end
+  const size_t first = candidates.size();
+  for (int j = 0; j < rows; ++j, data += cols) {
+    // Class scores never exceed objectness, so most rows stop here
+    if (!(data[4] > threshold)) {
+      continue;
+    }
+
+    int classId = config.classId;
+    float score;
+    if (!classes.empty()) {
+      // A filtered subset is short, so a plain loop beats the SIMD argmax
+      score = data[5 + classes[0]];
+      classId = classes[0];
+      for (size_t c = 1; c < classes.size(); ++c) {
+        if (data[5 + classes[c]] > score) {
+          score = data[5 + classes[c]];
+          classId = classes[c];
+        }
+      }
+    } else if (config.multiClass) {
+      score = argmaxScore(data + 5, numClasses, &classId);
+    } else {
+      score = data[5 + classId];
+    }
+    if (!(score > threshold)) {
+      continue;
+    }
+
+    candidates.normalized.insert(candidates.normalized.end(), data, data + 4);
+    candidates.scores.push_back(score);
+    candidates.classIds.push_back(classId);
+  }
+
+  convertBoxes(candidates.normalized.data() + 4 * first,
+               candidates.size() - first, transform, &candidates.boxes);
+}
+
+/**
+ * @brief Decodes all output heads of a YOLO forward pass.
+ * @param outputs The 2D CV_32F output matrices of the network.
+ * @param frameSize Size of the frame the boxes are scaled to.
+ * @param config Thresholds and class selection.
+ * @param candidates Receives the decoded candidates; cleared first.
+ */
+void decodeYoloOutputs(const std::vector<cv::Mat>& outputs,
+                       const cv::Size& frameSize, const DecodeConfig& config,
+                       Candidates& candidates) {
+  decodeYoloOutputs(outputs, BoxTransform(frameSize), config, candidates);
+}
+
+/**
+ * @brief Decodes all output heads, mapping boxes through a transform.
+ * @param outputs The 2D CV_32F output matrices of the network.
+ * @param transform Maps normalized coordinates to frame pixels.
+ * @param config Thresholds and class selection.
+ * @param candidates Receives the decoded candidates; cleared first.
+ */
+void decodeYoloOutputs(const std::vector<cv::Mat>& outputs,
+                       const BoxTransform& transform,
+                       const DecodeConfig& config, Candidates& candidates) {
+  candidates.clear();
+  for (const cv::Mat& output : outputs) {
+    if (output.empty()) {
+      continue;
+    }
+    CV_Assert(output.type() == CV_32F && output.isContinuous());
+    decodeYoloOutput(output.ptr<float>(0), output.rows, output.cols,
+                     transform, config, candidates);
+  }
+}
+
+/**
+ * @brief Views an output tensor as rows of anchors. A batched forward pass
+ * returns [N, rows, cols] tensors; their rows come out image by image.
+ * @param output An output of shape [..., rows, cols].
+ * @return A 2D rows x cols header over the same data.
+ */
+cv::Mat asRows(const cv::Mat& output) {
+  if (output.dims <= 2) {
+    return output;
+  }
+  int cols = output.size[output.dims - 1];
+  return output.reshape(1, static_cast<int>(output.total() / cols));
+}
+
+}  // namespace Detector
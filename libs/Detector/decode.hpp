@@ -0,0 +1,155 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file decode.hpp
+ * @brief Decoding kernel that turns raw YOLO output rows into candidate boxes.
+ */
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace Detector {
+
+/**
+ * @struct DecodeConfig
+ * @brief Parameters controlling which YOLO output rows become candidates.
+ */
+struct DecodeConfig {
+  float confThreshold = 0.5f; /**< Minimum class score for a candidate */
+  int classId = 0; /**< Class scored in single-class mode (0 = person) */
+  /**< Score every class and keep the best one instead of only classId */
+  bool multiClass = false;
+  /**< Classes scored when not empty, keeping the best of them; overrides
+   * classId and multiClass */
+  std::vector<int> classes;
+};
+
+/**
+ * @struct BoxTransform
+ * @brief Maps normalized network coordinates back to frame pixels.
+ *
+ * A point maps to (nx * scaleX - offsetX, ny * scaleY - offsetY) and a size
+ * to (nw * scaleX, nh * scaleY). Stretching the frame to the input size is
+ * the identity offset with the frame size as scale; letterboxing divides out
+ * the resize ratio and removes the padding (see letterboxTransform()).
+ */
+struct BoxTransform {
+  float scaleX = 1;  /**< Frame pixels per normalized unit along x */
+  float scaleY = 1;  /**< Frame pixels per normalized unit along y */
+  float offsetX = 0; /**< Left padding, in frame pixels */
+  float offsetY = 0; /**< Top padding, in frame pixels */
+
+  /**
+   * @brief Constructs the identity transform.
+   */
+  BoxTransform() = default;
+
+  /**
+   * @brief Constructs the transform for a frame stretched to the input.
+   * @param frameSize Size of the frame the boxes are scaled to.
+   */
+  explicit BoxTransform(const cv::Size& frameSize)
+      : scaleX(static_cast<float>(frameSize.width)),
+        scaleY(static_cast<float>(frameSize.height)) {}
+};
+
+/**
+ * @struct Candidates
+ * @brief Candidate boxes produced by the decoder, in frame pixels.
+ *
+ * Kept as parallel arrays so they can be handed straight to NMS; the
+ * vectors keep their capacity across clear() so a reused instance does not
+ * allocate once it has warmed up.
+ */
+struct Candidates {
+  std::vector<cv::Rect> boxes; /**< Candidate boxes */
+  std::vector<float> scores;   /**< Candidate class scores */
+  std::vector<int> classIds;   /**< Candidate class ids */
+  /**< Normalized [cx, cy, w, h] of each candidate, four floats per box */
+  std::vector<float> normalized;
+
+  /**
+   * @brief Removes all candidates while keeping the allocated capacity.
+   */
+  void clear();
+
+  /**
+   * @brief Gets the number of candidates.
+   * @return The candidate count.
+   */
+  size_t size() const { return scores.size(); }
+};
+
+/**
+ * @brief Decodes one YOLO output head held in a raw float buffer.
+ *
+ * Each row is laid out as [cx, cy, w, h, objectness, class scores...] with
+ * coordinates normalized to the input size. Darknet's region layer scales
+ * class scores by objectness, so a row whose objectness does not pass the
+ * threshold is rejected before any class score is read.
+ *
+ * @param data Pointer to the first row.
+ * @param rows Number of rows (anchor positions).
+ * @param cols Row stride in floats (5 + number of classes).
+ * @param frameSize Size of the frame the boxes are scaled to.
+ * @param config Thresholds and class selection.
+ * @param candidates Receives the decoded candidates; appended to.
+ */
+void decodeYoloOutput(const float* data, int rows, int cols,
+                      const cv::Size& frameSize, const DecodeConfig& config,
+                      Candidates& candidates);
+
+/**
+ * @brief Decodes one YOLO output head, mapping boxes through a transform.
+ * @param data Pointer to the first row.
+ * @param rows Number of rows (anchor positions).
+ * @param cols Row stride in floats (5 + number of classes).
+ * @param transform Maps normalized coordinates to frame pixels.
+ * @param config Thresholds and class selection.
+ * @param candidates Receives the decoded candidates; appended to.
+ */
+void decodeYoloOutput(const float* data, int rows, int cols,
+                      const BoxTransform& transform,
+                      const DecodeConfig& config, Candidates& candidates);
+
+/**
+ * @brief Decodes all output heads of a YOLO forward pass.
+ * @param outputs The 2D CV_32F output matrices of the network.
+ * @param frameSize Size of the frame the boxes are scaled to.
+ * @param config Thresholds and class selection.
+ * @param candidates Receives the decoded candidates; cleared first.
+ */
+void decodeYoloOutputs(const std::vector<cv::Mat>& outputs,
+                       const cv::Size& frameSize, const DecodeConfig& config,
+                       Candidates& candidates);
+
+/**
+ * @brief Decodes all output heads, mapping boxes through a transform.
+ * @param outputs The 2D CV_32F output matrices of the network.
+ * @param transform Maps normalized coordinates to frame pixels.
+ * @param config Thresholds and class selection.
+ * @param candidates Receives the decoded candidates; cleared first.
+ */
+void decodeYoloOutputs(const std::vector<cv::Mat>& outputs,
+                       const BoxTransform& transform,
+                       const DecodeConfig& config, Candidates& candidates);
+
+/**
+ * @brief Views an output tensor as rows of anchors. A batched forward pass
+ * returns [N, rows, cols] tensors; their rows come out image by image.
+ * @param output An output of shape [..., rows, cols].
+ * @return A 2D rows x cols header over the same data.
+ */
+cv::Mat asRows(const cv::Mat& output);
+
+/**
+ * @brief Finds the highest score in a contiguous array.
+ * @param scores Pointer to the scores.
+ * @param count Number of scores.
+ * @param index Receives the index of the first maximum.
+ * @return The maximum score.
+ */
+float argmaxScore(const float* scores, int count, int* index);
+
+}  // namespace Detector
@@ -0,0 +1,32 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file detection.hpp
+ * @brief Structured detection result returned by the YOLODetector.
+ *
+ * Only depends on OpenCV core so headless consumers can use detections
+ * without pulling in any rendering or GUI headers.
+ */
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace Detector {
+
+/**
+ * @struct Detection
+ * @brief A single object detection in frame pixel coordinates.
+ */
+struct Detection {
+  cv::Rect box;     /**< Bounding box in frame pixels */
+  float score = 0;  /**< Class confidence score */
+  int classId = -1; /**< Index into the class names list */
+};
+
+/**
+ * @brief A list of detections for one frame.
+ */
+using Detections = std::vector<Detection>;
+
+}  // namespace Detector
@@ -8,23 +8,59 @@
  */
 
 #include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <opencv2/core/types.hpp>
 #include <opencv2/core/utility.hpp>
 #include <opencv2/dnn.hpp>
 #include <opencv2/dnn/all_layers.hpp>
-#include <opencv2/highgui.hpp>
-#include <opencv2/opencv.hpp>
+#include <opencv2/imgproc.hpp>
 #include <opencv2/videoio.hpp>
 #include <string>
 #include <vector>
 
+#include "backend.hpp"
+#include "decode.hpp"
+#include "detection.hpp"
+#include "letterbox.hpp"
+#include "metrics.hpp"
+#include "model_cache.hpp"
+#include "nms.hpp"
+#include "postprocessor.hpp"
+
 namespace Detector {
 
+/**
+ * @brief Reads the network input size from the [net] section of a Darknet
+ * configuration file.
+ * @param configPath Path to the .cfg file.
+ * @return The width and height, or 416x416 if the section does not set them.
+ * @throws std::runtime_error if the file cannot be read or the width or
+ * height is not a number.
+ */
+cv::Size readDarknetInputSize(const std::string& configPath);
+
+/**
+ * @brief Reads class names, one per line.
+ * @param classesPath Path to the file.
+ * @return The names, empty lines skipped; empty if the file is missing.
+ */
+std::vector<std::string> readClassNames(const std::string& classesPath);
+
 /**
  * @class YOLODetector
  * @brief A class for performing object detection using YOLOv3.
+ *
+ * Any Darknet YOLO model works, yolov3-tiny included: the input size comes
+ * from the cfg and every output head is decoded, however many there are.
+ *
+ * Postprocessing goes through a Postprocessor that reuses its scratch
+ * memory, so once warmed up it makes no heap allocation besides the
+ * returned detections. It is therefore not reentrant: postprocess one
+ * frame at a time per detector, as the pipeline's single postprocess stage
+ * does.
  */
 class YOLODetector {
  public:
@@ -38,11 +74,179 @@ class YOLODetector {
                const std::string& classesPath);
 
   /**
-   * @brief Starts the video stream for object detection.
+   * @brief Constructs a YOLODetector around a network that is already
+   * loaded, e.g. by a SharedDetector context.
+   * @param network The network; it must not be used by anything else.
+   * @param files The files it was loaded from, for backends and the cache.
+   * @param classNames The class names.
+   * @throws std::runtime_error if the network or the class list is empty.
+   */
+  YOLODetector(cv::dnn::Net network, const ModelFiles& files,
+               const std::vector<std::string>& classNames);
+
+  /**
+   * @brief Starts the video stream for object detection on camera 0.
    * @param testMode If true, enables test mode for the video stream.
    */
   void videoStream(bool testMode = false);
 
+  /**
+   * @brief Runs object detection on every frame of an opened capture.
+   * @param cap The capture to read, e.g. from Pipeline::openCapture().
+   * @param testMode If true, stops after the first frame.
+   */
+  void videoStream(cv::VideoCapture& cap, bool testMode = false);
+
+  /**
+   * @brief Converts a captured frame into the network's input blob.
+   *
+   * The frame is letterboxed: scaled to fit the input size with its aspect
+   * ratio kept and padded with gray. The blob's buffer is reused once every
+   * copy of it has been released.
+   *
+   * @param image The BGR frame to be converted.
+   * @param transform If not null, receives the transform that maps the
+   * network's boxes back to this frame, for postprocess().
+   * @return The NCHW input blob for the YOLO network.
+   */
+  cv::Mat preprocess(const cv::Mat& image, BoxTransform* transform = nullptr);
+
+  /**
+   * @brief Sets the network input size used by preprocess().
+   *
+   * Darknet networks accept any multiple of 32 without reloading, and
+   * decoding works on normalized coordinates, so the size can change between
+   * frames. Call it from the thread that calls preprocess().
+   *
+   * @param size The new input size, e.g. 320x320, 416x416 or 608x608.
+   * @throws std::runtime_error if a side is not a positive multiple of 32.
+   */
+  void setInputSize(const cv::Size& size);
+
+  /**
+   * @brief Gets the network input size used by preprocess().
+   * @return The input size.
+   */
+  cv::Size getInputSize() const;
+
+  /**
+   * @brief Converts several frames into one batched NCHW input blob.
+   * @param images The BGR frames to be converted; sizes may differ.
+   * @param transforms If not null, receives one box transform per frame.
+   * @return An N x 3 x H x W blob with one plane set per frame.
+   */
+  cv::Mat preprocessBatch(const std::vector<cv::Mat>& images,
+                          std::vector<BoxTransform>* transforms = nullptr);
+
+  /**
+   * @brief Runs a forward pass of the YOLO network on an input blob.
+   * @param blob The NCHW input blob produced by preprocess().
+   * @return One 2D rows x cols matrix per output head; a batch's rows come
+   * image by image.
+   * The matrices may alias the network's buffers and are valid only until
+   * the next infer().
+   */
+  std::vector<cv::Mat> infer(const cv::Mat& blob);
+
+  /**
+   * @brief Benchmarks candidate inference backends on a blank frame and runs
+   * every later forward pass on the fastest.
+   * @param candidates Options to try; empty tries every available one.
+   * @param onnxPath FP32 ONNX export of the network, or empty.
+   * @param onnxInt8Path INT8-quantized ONNX export, or empty.
+   * @param runs Timed forward passes per option.
+   * @return The timings and the chosen option.
+   * @throws std::runtime_error if no candidate runs.
+   */
+  BackendReport selectBackend(const std::vector<BackendOption>& candidates,
+                              const std::string& onnxPath = "",
+                              const std::string& onnxInt8Path = "",
+                              int runs = 5);
+
+  /**
+   * @brief Runs every later forward pass on the given backend.
+   * @param backend The backend; null restores the built-in OpenCV network.
+   */
+  void setBackend(std::unique_ptr<InferenceBackend> backend);
+
+  /**
+   * @brief Runs every later forward pass on an engine and precision.
+   *
+   * The options that run the Darknet model configure this detector's own
+   * network rather than loading a second copy of it.
+   *
+   * @param option Engine and precision.
+   * @throws std::runtime_error if the option is unavailable or loading fails.
+   */
+  void setBackend(const BackendOption& option);
+
+  /**
+   * @brief Gets the engine and precision forward passes run on.
+   * @return The active backend option.
+   */
+  BackendOption getBackendOption() const;
+
+  /**
+   * @brief Keeps optimized models and the selectBackend() choice in a
+   * directory, so a restarted process skips the work that produced them.
+   * @param directory The ModelCache directory; empty disables caching.
+   */
+  void setModelCache(const std::string& directory);
+
+  /**
+   * @brief Runs forward passes on a blank frame at the current input size.
+   *
+   * The first pass of a network fuses layers and allocates its buffers,
+   * which takes several times as long as a later one. Warming up before
+   * the first frame keeps that cost out of the frame latency. The passes
+   * are not recorded in the metrics registry.
+   *
+   * @param passes Forward passes to run.
+   * @return The time the passes took in milliseconds.
+   */
+  double warmup(int passes = 1);
+
+  /**
+   * @brief Records the latency of preprocess(), infer() and postprocess() in
+   * a registry, under the stages "preprocess", "inference" and
+   * "postprocess", and samples the per-layer times every few passes.
+   * videoStream() adds "capture", "render" and "frame".
+   * @param registry The registry; null stops recording. Must outlive the
+   * detector or be unset first.
+   */
+  void setMetrics(Metrics::Registry* registry);
+
+  /**
+   * @brief Gets the time each layer took in the last forward pass.
+   *
+   * Call it from the thread that runs infer().
+   *
+   * @return Per-layer times in network order; empty before the first pass or
+   * if the backend does not report them.
+   */
+  std::vector<Metrics::LayerTiming> getLayerTimings();
+
+  /**
+   * @brief Runs the full detection pass on a frame without drawing on it.
+   * @param image The BGR frame to run detection on.
+   * @return The detections that survive thresholding and NMS.
+   */
+  Detections detect(const cv::Mat& image);
+
+  /**
+   * @brief Runs one batched detection pass over several frames.
+   * @param images The BGR frames to run detection on.
+   * @return The detections of each frame, in input order.
+   */
+  std::vector<Detections> detectBatch(const std::vector<cv::Mat>& images);
+
+  /**
+   * @brief Draws a set of detections on a frame.
+   * @param frame The frame to annotate.
+   * @param detections The detections to draw.
+   */
+  void render(const cv::Mat& frame, const Detections& detections);
+
   /**
    * @brief Gets the YOLO network object.
    * @return A constant reference to the cv::dnn::Net object.
@@ -65,10 +269,119 @@ class YOLODetector {
   /**
    * @brief Processes the output of the YOLO network and identifies detected
    * objects.
-   * @param image The image/frame to be processed for detection.
+   * @param image The image/frame the network output was computed on. Only its
+   * size is used; nothing is drawn. The boxes are mapped back through the
+   * letterbox at the current input size.
    * @param output The network's output containing detection information.
+   * @return The detections that survive thresholding and NMS.
+   */
+  Detections postprocess(const cv::Mat& image,
+                         const std::vector<cv::Mat>& output) const;
+
+  /**
+   * @brief Processes the output of the YOLO network using the transform
+   * preprocess() returned for the frame.
+   *
+   * Use this when the input size may have changed since preprocess(), as in
+   * the pipeline.
+   *
+   * @param transform Maps the network's boxes back to the frame.
+   * @param output The network's output containing detection information.
+   * @return The detections that survive thresholding and NMS.
+   */
+  Detections postprocess(const BoxTransform& transform,
+                         const std::vector<cv::Mat>& output) const;
+
+  /**
+   * @brief Processes the output of the YOLO network into caller-owned
+   * storage, so a vector kept across frames stops allocating once it has
+   * grown to the busiest frame.
+   * @param transform Maps the network's boxes back to the frame.
+   * @param output The network's output containing detection information.
+   * @param detections Receives the detections that survive thresholding and
+   * NMS.
+   */
+  void postprocess(const BoxTransform& transform,
+                   const std::vector<cv::Mat>& output,
+                   Detections* detections) const;
+
+  /**
+   * @brief Splits the output of a batched forward pass into per-frame
+   * detections.
+   *
+   * Darknet output heads stack the rows of every image in the batch, so
+   * image b owns rows [b * rows / N, (b + 1) * rows / N) of each head.
+   *
+   * @param frameSizes Size of each frame in the batch, in batch order.
+   * @param output The network's output for the whole batch.
+   * @return The detections of each frame, in batch order.
+   */
+  std::vector<Detections> postprocessBatch(
+      const std::vector<cv::Size>& frameSizes,
+      const std::vector<cv::Mat>& output) const;
+
+  /**
+   * @brief Splits the output of a batched forward pass into per-frame
+   * detections using the transforms preprocessBatch() returned.
+   * @param transforms Box transform of each frame, in batch order.
+   * @param output The network's output for the whole batch.
+   * @return The detections of each frame, in batch order.
    */
-  void postprocess(const cv::Mat& image, const std::vector<cv::Mat>& output);
+  std::vector<Detections> postprocessBatch(
+      const std::vector<BoxTransform>& transforms,
+      const std::vector<cv::Mat>& output) const;
+
+  /**
+   * @brief Selects between person-only and multi-class decoding.
+   * @param enabled If true, every class is scored and the best one kept;
+   * otherwise only the person class is read from each row.
+   */
+  void setMultiClass(bool enabled);
+
+  /**
+   * @brief Restricts detection to a subset of the classes.
+   *
+   * Only the listed class scores are read from each output row, so a short
+   * filter also makes decoding cheaper than scoring every class.
+   *
+   * @param classIds Indices into the class names; empty detects every
+   * class.
+   * @throws std::runtime_error if an index is out of range.
+   */
+  void setClassFilter(const std::vector<int>& classIds);
+
+  /**
+   * @brief Restricts detection to the named classes.
+   * @param names Names as listed in the class names file, e.g. "person" and
+   * "truck"; empty detects every class.
+   * @throws std::runtime_error if a name is not in the class names file.
+   */
+  void setClasses(const std::vector<std::string>& names);
+
+  /**
+   * @brief Gets the classes detection is restricted to.
+   * @return Sorted class indices; empty if every class is detected.
+   */
+  std::vector<int> getClassFilter() const;
+
+  /**
+   * @brief Sets how overlapping candidates are suppressed.
+   * @param config Method and thresholds; boxes of different classes are
+   * only suppressed against each other if classAware is off.
+   */
+  void setNms(const NmsConfig& config);
+
+  /**
+   * @brief Gets how overlapping candidates are suppressed.
+   * @return The suppression method and thresholds.
+   */
+  NmsConfig getNms() const;
+
+  /**
+   * @brief Gets the score threshold and classes read from each output row.
+   * @return The decoding parameters.
+   */
+  DecodeConfig getDecodeConfig() const;
 
   /**
    * @brief Gets the class names for the detected objects.
@@ -77,11 +390,37 @@ class YOLODetector {
   const std::vector<std::string> get_className() const;
 
  private:
+  /**
+   * @brief Decodes network output for one frame and applies NMS.
+   * @param transform Maps the network's boxes back to the frame.
+   * @param output The network's output for that frame.
+   * @return The detections that survive thresholding and NMS.
+   */
+  Detections decodeFrame(const BoxTransform& transform,
+                         const std::vector<cv::Mat>& output) const;
+
+  /**< Decoding and NMS with scratch reused across frames */
+  mutable Postprocessor postprocessor;
+
   cv::dnn::Net net; /**< YOLO network for object detection */
+  ModelFiles modelFiles; /**< Model files backends are loaded from */
+  cv::Size inputSize;    /**< Network input size */
+  LetterboxPreprocessor letterbox; /**< Builds and recycles input blobs */
+  /**< Backend chosen by selectBackend(); null runs net directly */
+  std::unique_ptr<InferenceBackend> backend;
+  /**< Names of the output layers read by each forward pass */
+  std::vector<std::string> outputLayerNames;
   /**< Vector of class names for detected objects */
   std::vector<std::string> classNames;
-  float minConfidenceScore; /**< Min confidence score for detections */
-  float nmsThreshold;       /**< NMS threshold for filtering detections */
+  /**< Score threshold and classes read from each output row */
+  DecodeConfig decodeConfig;
+  NmsConfig nmsConfig; /**< Suppression of overlapping candidates */
+  Metrics::Registry* metrics; /**< Receives stage latencies, or null */
+  /**< Stage histograms of metrics, cached to keep lookups off the hot path */
+  Metrics::LatencyHistogram* preprocessLatency;
+  Metrics::LatencyHistogram* inferenceLatency;   /**< See preprocessLatency */
+  Metrics::LatencyHistogram* postprocessLatency; /**< See preprocessLatency */
+  uint64_t inferences; /**< Forward passes run, for layer sampling */
 };
 
 }  // namespace Detector
@@ -0,0 +1,230 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "frame_memory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+namespace Detector {
+
+namespace {
+
+std::atomic<uint64_t> heapAllocations(0); /**< See recordAllocation() */
+std::atomic<uint64_t> heapBytes(0);       /**< See recordAllocation() */
+
+}  // namespace
+
+/**
+ * @brief Records one heap allocation made on behalf of the hot loop.
+ * @param bytes Size of the allocation.
+ */
+void recordAllocation(size_t bytes) {
+  heapAllocations.fetch_add(1, std::memory_order_relaxed);
+  heapBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Reads the process-wide allocation counter.
+ * @return The allocations recorded so far.
+ */
+AllocationCount allocationCount() {
+  AllocationCount count;
+  count.allocations = heapAllocations.load(std::memory_order_relaxed);
+  count.bytes = heapBytes.load(std::memory_order_relaxed);
+  return count;
+}
+
+/**
+ * @brief Constructs an empty pool.
+ * @param maxPooled Most free buffers kept; more are freed, which bounds
+ * the memory left behind when the frame size changes.
+ */
+FramePool::FramePool(size_t maxPooled) : maxPooled(maxPooled) {
+  free.reserve(maxPooled);
+}
+
+/**
+ * @brief Frees the pooled buffers.
+ */
+FramePool::~FramePool() {
+  for (cv::UMatData* u : free) {
+    cv::fastFree(u->origdata);
+    delete u;
+  }
+}
+
+/**
+ * @brief Gets an empty matrix whose buffer will come from the pool.
+ * @return An empty matrix bound to this pool.
+ */
+cv::Mat FramePool::acquire() {
+  cv::Mat mat;
+  mat.allocator = this;
+  return mat;
+}
+
+/**
+ * @brief Gets the pool's counters.
+ * @return A snapshot of the counters.
+ */
+PoolStats FramePool::stats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  PoolStats snapshot = counters;
+  snapshot.pooled = free.size();
+  return snapshot;
+}
+
+/**
+ * @brief Allocates a buffer, or reuses a pooled one of the same size.
+ * @param dims Number of dimensions.
+ * @param sizes Size of each dimension.
+ * @param type Element type.
+ * @param data User data to wrap instead, or null.
+ * @param step Receives the step of each dimension.
+ * @param flags Access flags, unused.
+ * @param usageFlags Usage flags, unused.
+ * @return The buffer's header.
+ */
+cv::UMatData* FramePool::allocate(int dims, const int* sizes, int type,
+                                  void* data, size_t* step,
+                                  cv::AccessFlag flags,
+                                  cv::UMatUsageFlags usageFlags) const {
+  (void)flags;
+  (void)usageFlags;
+  // Dense layout, as cv::Mat's standard allocator computes it
+  size_t total = CV_ELEM_SIZE(type);
+  for (int i = dims - 1; i >= 0; --i) {
+    if (step != nullptr) {
+      if (data != nullptr && step[i] != CV_AUTOSTEP) {
+        total = step[i];
+      } else {
+        step[i] = total;
+      }
+    }
+    total *= sizes[i];
+  }
+
+  if (data != nullptr) {
+    // Wrapping caller memory: nothing to pool
+    cv::UMatData* u = new cv::UMatData(this);
+    u->data = u->origdata = static_cast<uchar*>(data);
+    u->size = total;
+    u->flags |= cv::UMatData::USER_ALLOCATED;
+    return u;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < free.size(); ++i) {
+    cv::UMatData* u = free[i];
+    if (u->size == total) {
+      free[i] = free.back();
+      free.pop_back();
+      uchar* buffer = u->origdata;
+      // Back to a freshly constructed header around the same buffer
+      u->~UMatData();
+      new (u) cv::UMatData(this);
+      u->data = u->origdata = buffer;
+      u->size = total;
+      ++counters.reuses;
+      ++counters.outstanding;
+      return u;
+    }
+  }
+
+  cv::UMatData* u = new cv::UMatData(this);
+  u->data = u->origdata = static_cast<uchar*>(cv::fastMalloc(total));
+  u->size = total;
+  ++counters.allocations;
+  ++counters.outstanding;
+  recordAllocation(total);
+  return u;
+}
+
+/**
+ * @brief Accepts an existing header; host memory needs no work.
+ * @param data The header.
+ * @param accessFlags Access flags, unused.
+ * @param usageFlags Usage flags, unused.
+ * @return True if the header exists.
+ */
+bool FramePool::allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                         cv::UMatUsageFlags usageFlags) const {
+  (void)accessFlags;
+  (void)usageFlags;
+  return data != nullptr;
+}
+
+/**
+ * @brief Returns a released buffer to the pool.
+ * @param data The header of the buffer; its reference counts are zero.
+ */
+void FramePool::deallocate(cv::UMatData* data) const {
+  if (data == nullptr) {
+    return;
+  }
+  CV_Assert(data->refcount == 0 && data->urefcount == 0);
+  if (data->flags & cv::UMatData::USER_ALLOCATED) {
+    delete data;
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  --counters.outstanding;
+  if (free.size() < maxPooled) {
+    free.push_back(data);
+    return;
+  }
+  lock.unlock();
+  cv::fastFree(data->origdata);
+  delete data;
+}
+
+/**
+ * @brief Constructs an arena.
+ * @param capacity Size of the first block in bytes.
+ */
+FrameArena::FrameArena(size_t capacity)
+    : block(new unsigned char[std::max<size_t>(capacity, 1)]),
+      size(std::max<size_t>(capacity, 1)),
+      offset(0),
+      spilled(0) {
+  recordAllocation(size);
+}
+
+/**
+ * @brief Takes a slice of the current block.
+ * @param bytes Size of the slice.
+ * @param alignment Alignment of the slice, a power of two.
+ * @return The slice, valid until the next reset().
+ */
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+  const uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+  const size_t start =
+      ((base + offset + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base;
+  if (start + bytes <= size) {
+    offset = start + bytes;
+    return block.get() + start;
+  }
+  // Out of room: new[] aligns for any fundamental type
+  extra.emplace_back(new unsigned char[std::max<size_t>(bytes, 1)]);
+  spilled += bytes + alignment;
+  recordAllocation(bytes);
+  return extra.back().get();
+}
+
+/**
+ * @brief Releases every slice; call it at the end of each frame.
+ */
+void FrameArena::reset() {
+  if (!extra.empty()) {
+    // Size the block for the busiest frame so far, with room to spare
+    size = std::max(2 * size, offset + spilled);
+    block.reset(new unsigned char[size]);
+    recordAllocation(size);
+    extra.clear();
+  }
+  offset = 0;
+  spilled = 0;
+}
+
+}  // namespace Detector
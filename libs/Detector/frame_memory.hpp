@@ -0,0 +1,285 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file frame_memory.hpp
+ * @brief Allocators that keep the per-frame hot loop off the heap: a pool of
+ * reused cv::Mat buffers and a per-frame arena for scratch vectors.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace Detector {
+
+/**
+ * @struct AllocationCount
+ * @brief Heap allocations made by the frame allocators since startup.
+ */
+struct AllocationCount {
+  uint64_t allocations = 0; /**< Buffers taken from the heap */
+  uint64_t bytes = 0;       /**< Their total size */
+};
+
+/**
+ * @brief Records one heap allocation made on behalf of the hot loop.
+ *
+ * FramePool, FrameArena and the letterbox blob pool call it whenever they
+ * cannot reuse memory, so a count that stops moving once the first frames
+ * have gone through shows those pools have stopped growing. It does not
+ * see other allocations, such as OpenCV's inside the forward pass.
+ *
+ * @param bytes Size of the allocation.
+ */
+void recordAllocation(size_t bytes);
+
+/**
+ * @brief Reads the process-wide allocation counter.
+ * @return The allocations recorded so far.
+ */
+AllocationCount allocationCount();
+
+/**
+ * @struct PoolStats
+ * @brief Counters of a FramePool.
+ */
+struct PoolStats {
+  uint64_t allocations = 0; /**< Buffers taken from the heap */
+  uint64_t reuses = 0;      /**< Buffers handed out again */
+  size_t pooled = 0;        /**< Free buffers waiting for reuse */
+  size_t outstanding = 0;   /**< Buffers held by live cv::Mat instances */
+};
+
+/**
+ * @class FramePool
+ * @brief cv::MatAllocator that recycles buffers instead of freeing them.
+ *
+ * When the last cv::Mat referencing a buffer releases it, the buffer and
+ * its header go to a free list keyed by size, and the next matrix of the
+ * same size gets them back. Frames of one camera, their network outputs and
+ * other fixed-size per-frame matrices therefore stop touching the heap once
+ * every buffer in flight has been allocated once. Thread-safe, so frames
+ * can be released by any pipeline stage.
+ *
+ * The pool must outlive every matrix allocated from it.
+ */
+class FramePool : public cv::MatAllocator {
+ public:
+  /**
+   * @brief Constructs an empty pool.
+   * @param maxPooled Most free buffers kept; more are freed, which bounds
+   * the memory left behind when the frame size changes.
+   */
+  explicit FramePool(size_t maxPooled = 16);
+
+  /**
+   * @brief Frees the pooled buffers.
+   */
+  ~FramePool() override;
+
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  /**
+   * @brief Gets an empty matrix whose buffer will come from the pool.
+   *
+   * Pass it to cv::VideoCapture::read(), cv::Mat::copyTo() or create():
+   * anything that creates the matrix in place draws on the pool.
+   *
+   * @return An empty matrix bound to this pool.
+   */
+  cv::Mat acquire();
+
+  /**
+   * @brief Gets the pool's counters.
+   * @return A snapshot of the counters.
+   */
+  PoolStats stats() const;
+
+  /**
+   * @brief Allocates a buffer, or reuses a pooled one of the same size.
+   * @param dims Number of dimensions.
+   * @param sizes Size of each dimension.
+   * @param type Element type.
+   * @param data User data to wrap instead, or null.
+   * @param step Receives the step of each dimension.
+   * @param flags Access flags, unused.
+   * @param usageFlags Usage flags, unused.
+   * @return The buffer's header.
+   */
+  cv::UMatData* allocate(int dims, const int* sizes, int type, void* data,
+                         size_t* step, cv::AccessFlag flags,
+                         cv::UMatUsageFlags usageFlags) const override;
+
+  /**
+   * @brief Accepts an existing header; host memory needs no work.
+   * @param data The header.
+   * @param accessFlags Access flags, unused.
+   * @param usageFlags Usage flags, unused.
+   * @return True if the header exists.
+   */
+  bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                cv::UMatUsageFlags usageFlags) const override;
+
+  /**
+   * @brief Returns a released buffer to the pool.
+   * @param data The header of the buffer; its reference counts are zero.
+   */
+  void deallocate(cv::UMatData* data) const override;
+
+ private:
+  size_t maxPooled;           /**< Most free buffers kept */
+  mutable std::mutex mutex;   /**< Guards the members below */
+  /**< Released headers with their buffers still attached */
+  mutable std::vector<cv::UMatData*> free;
+  mutable PoolStats counters; /**< Counters, pooled excluded */
+};
+
+/**
+ * @class FrameArena
+ * @brief Bump allocator for scratch memory that lives for one frame.
+ *
+ * allocate() hands out consecutive slices of one block and reset() takes
+ * them all back at once at the end of the frame. A frame that outgrows the
+ * block spills into extra blocks, and the next reset() replaces them with a
+ * single block large enough for that frame, so after a few frames every
+ * allocation is a pointer bump. Not thread-safe: one arena per thread.
+ */
+class FrameArena {
+ public:
+  /**
+   * @brief Constructs an arena.
+   * @param capacity Size of the first block in bytes.
+   */
+  explicit FrameArena(size_t capacity = 64 * 1024);
+
+  /**
+   * @brief Takes a slice of the current block.
+   * @param bytes Size of the slice.
+   * @param alignment Alignment of the slice, a power of two.
+   * @return The slice, valid until the next reset().
+   */
+  void* allocate(size_t bytes, size_t alignment);
+
+  /**
+   * @brief Releases every slice; call it at the end of each frame.
+   *
+   * Nothing allocated from the arena may be used afterwards.
+   */
+  void reset();
+
+  /**
+   * @brief Gets the size of the main block.
+   * @return The capacity in bytes.
+   */
+  size_t capacity() const { return size; }
+
+  /**
+   * @brief Gets the bytes handed out since the last reset().
+   * @return The bytes in use, padding included.
+   */
+  size_t used() const { return offset + spilled; }
+
+ private:
+  std::unique_ptr<unsigned char[]> block; /**< The main block */
+  size_t size;    /**< Size of the main block */
+  size_t offset;  /**< Bytes of the main block in use */
+  size_t spilled; /**< Bytes in use in the extra blocks */
+  /**< Blocks that took the allocations the main block had no room for */
+  std::vector<std::unique_ptr<unsigned char[]>> extra;
+};
+
+/**
+ * @class ArenaAllocator
+ * @brief Standard allocator that draws on a FrameArena.
+ *
+ * deallocate() does nothing: the memory comes back when the arena is reset.
+ * Without an arena it falls back to the heap, so code written against it
+ * also runs where no arena is set up.
+ *
+ * @tparam T The element type.
+ */
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T; /**< Element type */
+
+  /**
+   * @brief Constructs an allocator.
+   * @param arena The arena to draw on, or null for the heap.
+   */
+  explicit ArenaAllocator(FrameArena* arena = nullptr) : arena(arena) {}
+
+  /**
+   * @brief Converts from an allocator of another element type.
+   * @param other The allocator to copy the arena from.
+   */
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other)  // NOLINT(runtime/explicit)
+      : arena(other.getArena()) {}
+
+  /**
+   * @brief Allocates storage for elements.
+   * @param count Number of elements.
+   * @return Uninitialized storage.
+   */
+  T* allocate(size_t count) {
+    if (arena == nullptr) {
+      return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+    return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  /**
+   * @brief Releases storage; a no-op inside an arena.
+   * @param pointer The storage.
+   * @param count Number of elements, unused.
+   */
+  void deallocate(T* pointer, size_t count) {
+    (void)count;
+    if (arena == nullptr) {
+      ::operator delete(pointer);
+    }
+  }
+
+  /**
+   * @brief Gets the arena.
+   * @return The arena, or null for the heap.
+   */
+  FrameArena* getArena() const { return arena; }
+
+ private:
+  FrameArena* arena; /**< Where the storage comes from, or null */
+};
+
+/**
+ * @brief Compares two allocators.
+ * @param a The first allocator.
+ * @param b The second allocator.
+ * @return True if storage from one can be released by the other.
+ */
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.getArena() == b.getArena();
+}
+
+/**
+ * @brief Compares two allocators.
+ * @param a The first allocator.
+ * @param b The second allocator.
+ * @return True if storage from one cannot be released by the other.
+ */
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return !(a == b);
+}
+
+/** A vector whose storage lives in a FrameArena */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}  // namespace Detector
@@ -2,8 +2,137 @@
 
 #include "detector.hpp"
 
+#ifndef ACME_HEADLESS
+#include <opencv2/highgui.hpp>
+#endif
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <opencv2/videoio.hpp>
+#include <stdexcept>
+#include <utility>
+
+#include "frame_memory.hpp"
+
 namespace Detector {
 
+namespace {
+
+/**< Forward passes between reads of the per-layer times */
+constexpr uint64_t kLayerSampleInterval = 30;
+
+/**
+ * @brief Parses the value of an integer key of a Darknet configuration.
+ * @param value The text after the '='.
+ * @param key The key, for the error message.
+ * @param configPath Path to the .cfg file, for the error message.
+ * @return The value.
+ * @throws std::runtime_error if the value is not a number.
+ */
+int parseCfgInt(const std::string& value, const std::string& key,
+                const std::string& configPath) {
+  try {
+    return std::stoi(value);
+  } catch (const std::logic_error&) {
+    // std::invalid_argument or std::out_of_range
+    throw std::runtime_error("Bad " + key + " in network config " +
+                             configPath + ": " + value);
+  }
+}
+
+/**
+ * @class MetricsPause
+ * @brief Stops a detector recording metrics for as long as it lives, and
+ * restores its registry however the scope is left.
+ */
+class MetricsPause {
+ public:
+  /**
+   * @brief Stops recording.
+   * @param detector The detector.
+   * @param registry The registry to restore, or null.
+   */
+  MetricsPause(YOLODetector& detector, Metrics::Registry* registry)
+      : detector(detector), registry(registry) {
+    detector.setMetrics(nullptr);
+  }
+
+  /**
+   * @brief Restores the registry.
+   */
+  ~MetricsPause() { detector.setMetrics(registry); }
+
+  MetricsPause(const MetricsPause&) = delete;
+  MetricsPause& operator=(const MetricsPause&) = delete;
+
+ private:
+  YOLODetector& detector;       /**< The paused detector */
+  Metrics::Registry* registry;  /**< Registry to restore */
+};
+
+}  // namespace
+
+/**
+ * @brief Reads the network input size from the [net] section of a Darknet
+ * configuration file.
+ * @param configPath Path to the .cfg file.
+ * @return The width and height, or 416x416 if the section does not set them.
+ * @throws std::runtime_error if the file cannot be read or the width or
+ * height is not a number.
+ */
+cv::Size readDarknetInputSize(const std::string& configPath) {
+  std::ifstream cfg(configPath.c_str());
+  if (!cfg.good()) {
+    throw std::runtime_error("Cannot read network config " + configPath);
+  }
+  cv::Size size(416, 416);
+  bool inNet = false;
+  std::string line;
+  while (std::getline(cfg, line)) {
+    line.erase(std::remove_if(line.begin(), line.end(),
+                              [](unsigned char c) { return std::isspace(c); }),
+               line.end());
+    if (line.empty() || line[0] == '#' || line[0] == ';') {
+      continue;
+    }
+    if (line[0] == '[') {
+      if (inNet) {
+        break;  // [net] always comes first
+      }
+      inNet = line == "[net]" || line == "[network]";
+      continue;
+    }
+    size_t eq = line.find('=');
+    if (!inNet || eq == std::string::npos) {
+      continue;
+    }
+    std::string key = line.substr(0, eq);
+    if (key == "width") {
+      size.width = parseCfgInt(line.substr(eq + 1), key, configPath);
+    } else if (key == "height") {
+      size.height = parseCfgInt(line.substr(eq + 1), key, configPath);
+    }
+  }
+  return size;
+}
+
+/**
+ * @brief Reads class names, one per line.
+ * @param classesPath Path to the file.
+ * @return The names, empty lines skipped; empty if the file is missing.
+ */
+std::vector<std::string> readClassNames(const std::string& classesPath) {
+  std::vector<std::string> names;
+  std::ifstream ifs(classesPath.c_str());
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (!line.empty()) {  // Avoid adding empty lines
+      names.push_back(line);
+    }
+  }
+  return names;
+}
+
 /**
  * @brief Constructs a YOLODetector object, loads the YOLO model and class
  * names.
@@ -14,7 +143,11 @@ namespace Detector {
 YOLODetector::YOLODetector(const std::string& configPath,
                            const std::string& weightsPath,
                            const std::string& classesPath)
-    : minConfidenceScore(0.5), nmsThreshold(0.4) {
+    : metrics(nullptr),
+      preprocessLatency(nullptr),
+      inferenceLatency(nullptr),
+      postprocessLatency(nullptr),
+      inferences(0) {
   // Load model
   try {
     net = cv::dnn::readNetFromDarknet(configPath, weightsPath);
@@ -28,20 +161,43 @@ YOLODetector::YOLODetector(const std::string& configPath,
     std::cerr << "Failed to load network!" << std::endl;
     throw std::runtime_error("Failed to load network");
   }
+  outputLayerNames = net.getUnconnectedOutLayersNames();
+  modelFiles.config = configPath;
+  modelFiles.weights = weightsPath;
+  setInputSize(readDarknetInputSize(configPath));
 
-  // Load class names from file
-  std::ifstream ifs(classesPath.c_str());
-  std::string line;
-  while (std::getline(ifs, line)) {
-    if (!line.empty()) {  // Avoid adding empty lines
-      classNames.push_back(line);
-    }
+  classNames = readClassNames(classesPath);
+  if (classNames.empty()) {
+    std::cerr << "Failed to load class names!" << std::endl;
+    throw std::runtime_error("Failed to load class names");
   }
+}
 
+/**
+ * @brief Constructs a YOLODetector around a network that is already
+ * loaded, e.g. by a SharedDetector context.
+ * @param network The network; it must not be used by anything else.
+ * @param files The files it was loaded from, for backends and the cache.
+ * @param classNames The class names.
+ */
+YOLODetector::YOLODetector(cv::dnn::Net network, const ModelFiles& files,
+                           const std::vector<std::string>& classNames)
+    : net(network),
+      modelFiles(files),
+      classNames(classNames),
+      metrics(nullptr),
+      preprocessLatency(nullptr),
+      inferenceLatency(nullptr),
+      postprocessLatency(nullptr),
+      inferences(0) {
+  if (net.empty()) {
+    throw std::runtime_error("Failed to load network");
+  }
   if (classNames.empty()) {
-    std::cerr << "Failed to load class names!" << std::endl;
     throw std::runtime_error("Failed to load class names");
   }
+  outputLayerNames = net.getUnconnectedOutLayersNames();
+  setInputSize(readDarknetInputSize(files.config));
 }
 
 /**
@@ -79,100 +235,490 @@ void YOLODetector::drawPred(int classId, float conf, int left, int top,
 /**
  * @brief Processes the output of the YOLO network and identifies detected
  * objects.
- * @param image The image/frame to be processed for detection.
+ * @param image The image/frame the network output was computed on. Only its
+ * size is used; nothing is drawn.
  * @param output The network's output containing detection information.
+ * @return The detections that survive thresholding and NMS.
  */
-void YOLODetector::postprocess(const cv::Mat& image,
-                               const std::vector<cv::Mat>& output) {
-  int personClassId = 0;
-  std::vector<int> classIds;
-  std::vector<float> confidences;
-  std::vector<cv::Rect> boxes;
+Detections YOLODetector::postprocess(const cv::Mat& image,
+                                     const std::vector<cv::Mat>& output) const {
+  return postprocess(letterboxTransform(image.size(), inputSize), output);
+}
+
+/**
+ * @brief Processes the output of the YOLO network using the transform
+ * preprocess() returned for the frame.
+ * @param transform Maps the network's boxes back to the frame.
+ * @param output The network's output containing detection information.
+ * @return The detections that survive thresholding and NMS.
+ */
+Detections YOLODetector::postprocess(const BoxTransform& transform,
+                                     const std::vector<cv::Mat>& output) const {
+  Metrics::ScopedTimer timer(postprocessLatency);
+  return decodeFrame(transform, output);
+}
 
+/**
+ * @brief Processes the output of the YOLO network into caller-owned
+ * storage.
+ * @param transform Maps the network's boxes back to the frame.
+ * @param output The network's output containing detection information.
+ * @param detections Receives the detections that survive thresholding and
+ * NMS.
+ */
+void YOLODetector::postprocess(const BoxTransform& transform,
+                               const std::vector<cv::Mat>& output,
+                               Detections* detections) const {
+  Metrics::ScopedTimer timer(postprocessLatency);
+  postprocessor.run(transform, output, decodeConfig, nmsConfig, detections);
+}
+
+/**
+ * @brief Splits the output of a batched forward pass into per-frame
+ * detections.
+ * @param frameSizes Size of each frame in the batch, in batch order.
+ * @param output The network's output for the whole batch.
+ * @return The detections of each frame, in batch order.
+ */
+std::vector<Detections> YOLODetector::postprocessBatch(
+    const std::vector<cv::Size>& frameSizes,
+    const std::vector<cv::Mat>& output) const {
+  std::vector<BoxTransform> transforms;
+  transforms.reserve(frameSizes.size());
+  for (const cv::Size& frameSize : frameSizes) {
+    transforms.push_back(letterboxTransform(frameSize, inputSize));
+  }
+  return postprocessBatch(transforms, output);
+}
+
+/**
+ * @brief Splits the output of a batched forward pass into per-frame
+ * detections using the transforms preprocessBatch() returned.
+ * @param transforms Box transform of each frame, in batch order.
+ * @param output The network's output for the whole batch.
+ * @return The detections of each frame, in batch order.
+ */
+std::vector<Detections> YOLODetector::postprocessBatch(
+    const std::vector<BoxTransform>& transforms,
+    const std::vector<cv::Mat>& output) const {
+  Metrics::ScopedTimer timer(postprocessLatency);
+  const int batch = static_cast<int>(transforms.size());
+  std::vector<Detections> results(transforms.size());
+  if (batch == 0) {
+    return results;
+  }
+
+  // Outputs straight from the network are [N, rows, cols]
+  std::vector<cv::Mat> heads(output.size());
   for (size_t i = 0; i < output.size(); ++i) {
-    auto* data = reinterpret_cast<float*>(output[i].data);
-
-    for (int j = 0; j < output[i].rows; ++j, data += output[i].cols) {
-      cv::Mat scores = output[i].row(j).colRange(5, output[i].cols);
-      cv::Point classIdPoint;
-      double confidence;
-
-      cv::minMaxLoc(scores, nullptr, &confidence, nullptr, &classIdPoint);
-      if (confidence > minConfidenceScore && classIdPoint.x == personClassId) {
-        int centerX = static_cast<int>(data[0] * image.cols);
-        int centerY = static_cast<int>(data[1] * image.rows);
-        int width = static_cast<int>(data[2] * image.cols);
-        int height = static_cast<int>(data[3] * image.rows);
-        int left = centerX - width / 2;
-        int top = centerY - height / 2;
-
-        classIds.push_back(classIdPoint.x);
-        confidences.push_back(static_cast<float>(confidence));
-        boxes.push_back(cv::Rect(left, top, width, height));
-      }
+    heads[i] = asRows(output[i]);
+    if (heads[i].rows % batch != 0) {
+      throw std::runtime_error("Output rows do not split across the batch");
+    }
+  }
+  std::vector<cv::Mat> slices(output.size());
+  for (int b = 0; b < batch; ++b) {
+    for (size_t i = 0; i < heads.size(); ++i) {
+      int rowsPerImage = heads[i].rows / batch;
+      slices[i] = heads[i].rowRange(b * rowsPerImage, (b + 1) * rowsPerImage);
+    }
+    results[b] = decodeFrame(transforms[b], slices);
+  }
+  return results;
+}
+
+/**
+ * @brief Decodes network output for one frame and applies NMS.
+ * @param transform Maps the network's boxes back to the frame.
+ * @param output The network's output for that frame.
+ * @return The detections that survive thresholding and NMS.
+ */
+Detections YOLODetector::decodeFrame(const BoxTransform& transform,
+                                     const std::vector<cv::Mat>& output) const {
+  return postprocessor.run(transform, output, decodeConfig, nmsConfig);
+}
+
+/**
+ * @brief Runs the full detection pass on a frame without drawing on it.
+ * @param image The BGR frame to run detection on.
+ * @return The detections that survive thresholding and NMS.
+ */
+Detections YOLODetector::detect(const cv::Mat& image) {
+  BoxTransform transform;
+  std::vector<cv::Mat> output = infer(preprocess(image, &transform));
+  return postprocess(transform, output);
+}
+
+/**
+ * @brief Runs one batched detection pass over several frames.
+ * @param images The BGR frames to run detection on.
+ * @return The detections of each frame, in input order.
+ */
+std::vector<Detections> YOLODetector::detectBatch(
+    const std::vector<cv::Mat>& images) {
+  std::vector<BoxTransform> transforms;
+  std::vector<cv::Mat> output = infer(preprocessBatch(images, &transforms));
+  return postprocessBatch(transforms, output);
+}
+
+/**
+ * @brief Draws a set of detections on a frame.
+ * @param frame The frame to annotate.
+ * @param detections The detections to draw.
+ */
+void YOLODetector::render(const cv::Mat& frame, const Detections& detections) {
+  for (const Detection& detection : detections) {
+    const cv::Rect& box = detection.box;
+    drawPred(detection.classId, detection.score, box.x, box.y,
+             box.x + box.width, box.y + box.height, frame);
+  }
+}
+
+/**
+ * @brief Converts a captured frame into the network's input blob.
+ * @param image The BGR frame to be converted.
+ * @param transform If not null, receives the transform that maps the
+ * network's boxes back to this frame, for postprocess().
+ * @return The NCHW input blob for the YOLO network.
+ */
+cv::Mat YOLODetector::preprocess(const cv::Mat& image,
+                                 BoxTransform* transform) {
+  Metrics::ScopedTimer timer(preprocessLatency);
+  return letterbox.process(image, inputSize, transform);
+}
+
+/**
+ * @brief Sets the network input size used by preprocess().
+ * @param size The new input size, e.g. 320x320, 416x416 or 608x608.
+ * @throws std::runtime_error if a side is not a positive multiple of 32.
+ */
+void YOLODetector::setInputSize(const cv::Size& size) {
+  if (size.width <= 0 || size.height <= 0 || size.width % 32 != 0 ||
+      size.height % 32 != 0) {
+    throw std::runtime_error("Input size must be a positive multiple of 32");
+  }
+  inputSize = size;
+}
+
+/**
+ * @brief Gets the network input size used by preprocess().
+ * @return The input size.
+ */
+cv::Size YOLODetector::getInputSize() const { return inputSize; }
+
+/**
+ * @brief Converts several frames into one batched NCHW input blob.
+ * @param images The BGR frames to be converted; sizes may differ.
+ * @param transforms If not null, receives one box transform per frame.
+ * @return An N x 3 x H x W blob with one plane set per frame.
+ */
+cv::Mat YOLODetector::preprocessBatch(const std::vector<cv::Mat>& images,
+                                      std::vector<BoxTransform>* transforms) {
+  Metrics::ScopedTimer timer(preprocessLatency);
+  return letterbox.processBatch(images, inputSize, transforms);
+}
+
+/**
+ * @brief Runs a forward pass of the YOLO network on an input blob.
+ * @param blob The NCHW input blob produced by preprocess().
+ * @return One 2D rows x cols matrix per output head; a batch's rows come
+ * image by image.
+ * The matrices may alias the network's buffers and are valid only until
+ * the next infer().
+ */
+std::vector<cv::Mat> YOLODetector::infer(const cv::Mat& blob) {
+  Metrics::ScopedTimer timer(inferenceLatency);
+  std::vector<cv::Mat> output;
+  if (backend) {
+    output = backend->infer(blob);
+  } else {
+    net.setInput(blob);
+    net.forward(output, outputLayerNames);
+    for (cv::Mat& head : output) {
+      head = asRows(head);
     }
   }
+  timer.stop();
+
+  // Reading the profile walks every layer, so only sample it now and then
+  if (metrics != nullptr && inferences++ % kLayerSampleInterval == 0) {
+    metrics->setLayerTimings(getLayerTimings());
+  }
+  return output;
+}
+
+/**
+ * @brief Benchmarks candidate inference backends on a blank frame and runs
+ * every later forward pass on the fastest.
+ * @param candidates Options to try; empty tries every available one.
+ * @param onnxPath FP32 ONNX export of the network, or empty.
+ * @param onnxInt8Path INT8-quantized ONNX export, or empty.
+ * @param runs Timed forward passes per option.
+ * @return The timings and the chosen option.
+ * @throws std::runtime_error if no candidate runs.
+ */
+BackendReport YOLODetector::selectBackend(
+    const std::vector<BackendOption>& candidates, const std::string& onnxPath,
+    const std::string& onnxInt8Path, int runs) {
+  modelFiles.onnx = onnxPath;
+  modelFiles.onnxInt8 = onnxInt8Path;
+  cv::Mat blank(480, 640, CV_8UC3, cv::Scalar::all(127));
+  BackendReport report;
+  backend = selectFastestBackend(candidates, modelFiles, preprocess(blank),
+                                 runs, &report, net);
+  return report;
+}
+
+/**
+ * @brief Runs every later forward pass on the given backend.
+ * @param backend The backend; null restores the built-in OpenCV network.
+ */
+void YOLODetector::setBackend(std::unique_ptr<InferenceBackend> backend) {
+  this->backend = std::move(backend);
+  if (!this->backend) {
+    // A Darknet backend may have configured net for another engine
+    net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+  }
+}
+
+/**
+ * @brief Runs every later forward pass on an engine and precision.
+ *
+ * The options that run the Darknet model configure this detector's own
+ * network rather than loading a second copy of it.
+ *
+ * @param option Engine and precision.
+ * @throws std::runtime_error if the option is unavailable or loading fails.
+ */
+void YOLODetector::setBackend(const BackendOption& option) {
+  backend = createBackend(option, modelFiles, net);
+}
+
+/**
+ * @brief Records the latency of preprocess(), infer() and postprocess() in
+ * a registry, under the stages "preprocess", "inference" and
+ * "postprocess", and samples the per-layer times every few passes.
+ * videoStream() adds "capture", "render" and "frame".
+ * @param registry The registry; null stops recording. Must outlive the
+ * detector or be unset first.
+ */
+void YOLODetector::setMetrics(Metrics::Registry* registry) {
+  metrics = registry;
+  preprocessLatency = registry ? &registry->stage("preprocess") : nullptr;
+  inferenceLatency = registry ? &registry->stage("inference") : nullptr;
+  postprocessLatency = registry ? &registry->stage("postprocess") : nullptr;
+}
+
+/**
+ * @brief Gets the time each layer took in the last forward pass.
+ *
+ * Call it from the thread that runs infer().
+ *
+ * @return Per-layer times in network order; empty before the first pass or
+ * if the backend does not report them.
+ */
+std::vector<Metrics::LayerTiming> YOLODetector::getLayerTimings() {
+  return backend ? backend->layerTimings() : readLayerTimings(net);
+}
+
+/**
+ * @brief Gets the engine and precision forward passes run on.
+ * @return The active backend option.
+ */
+BackendOption YOLODetector::getBackendOption() const {
+  return backend ? backend->option() : BackendOption();
+}
 
-  std::vector<int> indices;
-  cv::dnn::NMSBoxes(boxes, confidences, minConfidenceScore, nmsThreshold,
-                    indices);
-  for (size_t i = 0; i < indices.size(); ++i) {
-    int idx = indices[i];
-    cv::Rect box = boxes[idx];
-    drawPred(classIds[idx], confidences[idx], box.x, box.y, box.x + box.width,
-             box.y + box.height, image);
+/**
+ * @brief Keeps optimized models and the selectBackend() choice in a
+ * directory, so a restarted process skips the work that produced them.
+ * @param directory The ModelCache directory; empty disables caching.
+ */
+void YOLODetector::setModelCache(const std::string& directory) {
+  modelFiles.cacheDir = directory;
+}
+
+/**
+ * @brief Runs forward passes on a blank frame at the current input size.
+ *
+ * The first pass of a network fuses layers and allocates its buffers,
+ * which takes several times as long as a later one. Warming up before the
+ * first frame keeps that cost out of the frame latency. The passes are not
+ * recorded in the metrics registry.
+ *
+ * @param passes Forward passes to run.
+ * @return The time the passes took in milliseconds.
+ */
+double YOLODetector::warmup(int passes) {
+  MetricsPause pause(*this, metrics);
+  cv::Mat blank(inputSize, CV_8UC3, cv::Scalar::all(127));
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < std::max(1, passes); ++i) {
+    infer(preprocess(blank));
   }
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
 }
 
 /**
- * @brief Starts the video stream for object detection.
+ * @brief Starts the video stream for object detection on camera 0.
  * @param testMode If true, enables test mode for the video stream.
  */
 void YOLODetector::videoStream(bool testMode) {
-  std::vector<std::string> outputLayerNames =
-      net.getUnconnectedOutLayersNames();
-
   cv::VideoCapture cap(0);
+  videoStream(cap, testMode);
+}
+
+/**
+ * @brief Runs object detection on every frame of an opened capture.
+ * @param cap The capture to read, e.g. from Pipeline::openCapture().
+ * @param testMode If true, stops after the first frame.
+ */
+void YOLODetector::videoStream(cv::VideoCapture& cap, bool testMode) {
   if (!cap.isOpened()) {
     std::cerr << "Error opening video stream or file" << std::endl;
     return;
   }
 
   int frameCount = 0;
+  // The frame is read into the same pooled buffer every time
+  FramePool frames(1);
+  cv::Mat image = frames.acquire();
+  Metrics::LatencyHistogram* captureLatency =
+      metrics ? &metrics->stage("capture") : nullptr;
+  Metrics::LatencyHistogram* renderLatency =
+      metrics ? &metrics->stage("render") : nullptr;
+  Metrics::LatencyHistogram* frameLatency =
+      metrics ? &metrics->stage("frame") : nullptr;
 
   while (cap.isOpened()) {
-    cv::Mat image;
+    Metrics::ScopedTimer frameTimer(frameLatency);
+    Metrics::ScopedTimer captureTimer(captureLatency);
     bool isSuccess = cap.read(image);
     if (!isSuccess) {
       std::cerr << "Failed to load frame!" << std::endl;
       break;
     }
+    captureTimer.stop();
 
-    cv::Mat blob = cv::dnn::blobFromImage(image, 1 / 255.0, cv::Size(416, 416),
-                                          cv::Scalar(0, 0, 0), true, false);
-    net.setInput(blob);
-
-    std::vector<cv::Mat> output;
-    net.forward(output, outputLayerNames);
-
-    postprocess(image, output);
+    Detections detections = detect(image);
+#ifndef ACME_HEADLESS
+    Metrics::ScopedTimer renderTimer(renderLatency);
+    render(image, detections);
     cv::imshow("YOLO Detection", image);
+    renderTimer.stop();
+#endif
 
     frameCount++;
     if (testMode && frameCount >= 1) {  // Exit after one frame in test mode
       break;
     }
 
+#ifndef ACME_HEADLESS
     int k = cv::waitKey(10);
     if (k == 113) {  // Press 'q' to exit
       break;
     }
+#endif
   }
 
   cap.release();
+#ifndef ACME_HEADLESS
   cv::destroyAllWindows();
+#endif
+}
+
+/**
+ * @brief Selects between person-only and multi-class decoding.
+ * @param enabled If true, every class is scored and the best one kept;
+ * otherwise only the person class is read from each row.
+ */
+void YOLODetector::setMultiClass(bool enabled) {
+  decodeConfig.classId = 0;
+  decodeConfig.multiClass = enabled;
+  decodeConfig.classes.clear();
 }
 
+/**
+ * @brief Restricts detection to a subset of the classes.
+ * @param classIds Indices into the class names; empty detects every
+ * class.
+ * @throws std::runtime_error if an index is out of range.
+ */
+void YOLODetector::setClassFilter(const std::vector<int>& classIds) {
+  std::vector<int> classes(classIds);
+  std::sort(classes.begin(), classes.end());
+  classes.erase(std::unique(classes.begin(), classes.end()), classes.end());
+  for (int classId : classes) {
+    if (classId < 0 || classId >= static_cast<int>(classNames.size())) {
+      throw std::runtime_error("Class index " + std::to_string(classId) +
+                               " is not in the class names");
+    }
+  }
+  if (classes.size() == 1) {
+    // One class reads one score per row, like the person-only mode
+    decodeConfig.classId = classes[0];
+    decodeConfig.multiClass = false;
+    decodeConfig.classes.clear();
+  } else {
+    decodeConfig.classId = 0;
+    decodeConfig.multiClass = classes.empty();
+    decodeConfig.classes = classes;
+  }
+}
+
+/**
+ * @brief Restricts detection to the named classes.
+ * @param names Names as listed in the class names file, e.g. "person" and
+ * "truck"; empty detects every class.
+ * @throws std::runtime_error if a name is not in the class names file.
+ */
+void YOLODetector::setClasses(const std::vector<std::string>& names) {
+  std::vector<int> classIds;
+  for (const std::string& name : names) {
+    auto found = std::find(classNames.begin(), classNames.end(), name);
+    if (found == classNames.end()) {
+      throw std::runtime_error("Unknown class " + name);
+    }
+    classIds.push_back(static_cast<int>(found - classNames.begin()));
+  }
+  setClassFilter(classIds);
+}
+
+/**
+ * @brief Gets the classes detection is restricted to.
+ * @return Sorted class indices; empty if every class is detected.
+ */
+std::vector<int> YOLODetector::getClassFilter() const {
+  if (!decodeConfig.classes.empty()) {
+    return decodeConfig.classes;
+  }
+  if (decodeConfig.multiClass) {
+    return std::vector<int>();
+  }
+  return std::vector<int>(1, decodeConfig.classId);
+}
+
+/**
+ * @brief Sets how overlapping candidates are suppressed.
+ * @param config Method and thresholds; boxes of different classes are
+ * only suppressed against each other if classAware is off.
+ */
+void YOLODetector::setNms(const NmsConfig& config) { nmsConfig = config; }
+
+/**
+ * @brief Gets how overlapping candidates are suppressed.
+ * @return The suppression method and thresholds.
+ */
+NmsConfig YOLODetector::getNms() const { return nmsConfig; }
+
+/**
+ * @brief Gets the score threshold and classes read from each output row.
+ * @return The decoding parameters.
+ */
+DecodeConfig YOLODetector::getDecodeConfig() const { return decodeConfig; }
+
 /**
  * @brief Gets the YOLO network object.
  * @return A constant reference to the cv::dnn::Net object.
@@ -0,0 +1,265 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "letterbox.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <stdexcept>
+
+#include "frame_memory.hpp"
+
+namespace Detector {
+
+namespace {
+
+#if CV_SIMD
+/**
+ * @brief Widens sixteen bytes to floats, scales them and stores them.
+ * @param bytes One channel of v_uint8::nlanes pixels.
+ * @param scale Scale factor in every lane.
+ * @param dst Receives v_uint8::nlanes floats.
+ */
+void storeScaled(const cv::v_uint8& bytes, const cv::v_float32& scale,
+                 float* dst) {
+  const int lanes = cv::v_float32::nlanes;
+  cv::v_uint16 low, high;
+  cv::v_expand(bytes, low, high);
+  cv::v_uint32 a, b;
+  cv::v_expand(low, a, b);
+  cv::v_store(dst, cv::v_cvt_f32(cv::v_reinterpret_as_s32(a)) * scale);
+  cv::v_store(dst + lanes,
+              cv::v_cvt_f32(cv::v_reinterpret_as_s32(b)) * scale);
+  cv::v_expand(high, a, b);
+  cv::v_store(dst + 2 * lanes,
+              cv::v_cvt_f32(cv::v_reinterpret_as_s32(a)) * scale);
+  cv::v_store(dst + 3 * lanes,
+              cv::v_cvt_f32(cv::v_reinterpret_as_s32(b)) * scale);
+}
+#endif
+
+/**
+ * @brief Converts one row of BGR bytes to scaled RGB planes.
+ * @param bgr Interleaved BGR pixels.
+ * @param width Number of pixels.
+ * @param r Receives the red values in [0, 1].
+ * @param g Receives the green values in [0, 1].
+ * @param b Receives the blue values in [0, 1].
+ */
+void convertRow(const uchar* bgr, int width, float* r, float* g, float* b) {
+  const float scale = 1.f / 255;
+  int x = 0;
+
+#if CV_SIMD
+  const int step = cv::v_uint8::nlanes;
+  const cv::v_float32 vScale = cv::vx_setall_f32(scale);
+  for (; x + step <= width; x += step) {
+    cv::v_uint8 blue, green, red;
+    cv::v_load_deinterleave(bgr + 3 * x, blue, green, red);
+    storeScaled(red, vScale, r + x);
+    storeScaled(green, vScale, g + x);
+    storeScaled(blue, vScale, b + x);
+  }
+  cv::v_cleanup();
+#endif
+
+  for (; x < width; ++x) {
+    const uchar* pixel = bgr + 3 * x;
+    r[x] = pixel[2] * scale;
+    g[x] = pixel[1] * scale;
+    b[x] = pixel[0] * scale;
+  }
+}
+
+/**
+ * @brief Fills the part of a plane outside a rectangle.
+ * @param plane The H x W plane.
+ * @param size Size of the plane.
+ * @param content The rectangle left untouched.
+ * @param value The fill value.
+ */
+void fillBorder(float* plane, const cv::Size& size, const cv::Rect& content,
+                float value) {
+  const int width = size.width;
+  std::fill(plane, plane + content.y * width, value);
+  std::fill(plane + content.br().y * width, plane + size.area(), value);
+  for (int y = content.y; y < content.br().y; ++y) {
+    float* row = plane + y * width;
+    std::fill(row, row + content.x, value);
+    std::fill(row + content.br().x, row + width, value);
+  }
+}
+
+}  // namespace
+
+/**
+ * @brief Finds where a letterboxed frame lands inside the network input.
+ * @param frameSize Size of the frame.
+ * @param inputSize Network input size.
+ * @return The rectangle of the input covered by the scaled frame.
+ */
+cv::Rect letterboxRect(const cv::Size& frameSize, const cv::Size& inputSize) {
+  double scale =
+      std::min(static_cast<double>(inputSize.width) / frameSize.width,
+               static_cast<double>(inputSize.height) / frameSize.height);
+  int width = static_cast<int>(std::lround(frameSize.width * scale));
+  int height = static_cast<int>(std::lround(frameSize.height * scale));
+  width = std::min(std::max(width, 1), inputSize.width);
+  height = std::min(std::max(height, 1), inputSize.height);
+  return cv::Rect((inputSize.width - width) / 2,
+                  (inputSize.height - height) / 2, width, height);
+}
+
+/**
+ * @brief Builds the inverse of the letterbox, from normalized network
+ * coordinates back to frame pixels.
+ * @param frameSize Size of the frame.
+ * @param inputSize Network input size.
+ * @return The transform for decodeYoloOutputs().
+ */
+BoxTransform letterboxTransform(const cv::Size& frameSize,
+                                const cv::Size& inputSize) {
+  cv::Rect content = letterboxRect(frameSize, inputSize);
+  // Per-axis ratios of the actual resize, so rounding of the scaled size
+  // does not skew the inverse
+  double ratioX = static_cast<double>(content.width) / frameSize.width;
+  double ratioY = static_cast<double>(content.height) / frameSize.height;
+  BoxTransform transform;
+  transform.scaleX = static_cast<float>(inputSize.width / ratioX);
+  transform.scaleY = static_cast<float>(inputSize.height / ratioY);
+  transform.offsetX = static_cast<float>(content.x / ratioX);
+  transform.offsetY = static_cast<float>(content.y / ratioY);
+  return transform;
+}
+
+/**
+ * @brief Constructs a preprocessor.
+ * @param padValue Value of the padding, in [0, 1]; Darknet pads with 0.5.
+ */
+LetterboxPreprocessor::LetterboxPreprocessor(float padValue)
+    : padValue(padValue) {}
+
+/**
+ * @brief Letterboxes one frame.
+ * @param image The frame; CV_8UC3 BGR, or CV_8UC1/CV_8UC4 converted first.
+ * @param inputSize Network input size.
+ * @param transform If not null, receives the inverse transform.
+ * @return A 1 x 3 x H x W CV_32F blob.
+ * @throws std::runtime_error if the frame is empty or not 8-bit.
+ */
+cv::Mat LetterboxPreprocessor::process(const cv::Mat& image,
+                                       const cv::Size& inputSize,
+                                       BoxTransform* transform) {
+  cv::Mat blob = acquire(1, inputSize);
+  BoxTransform inverse = fill(image, inputSize, blob.ptr<float>());
+  if (transform != nullptr) {
+    *transform = inverse;
+  }
+  return blob;
+}
+
+/**
+ * @brief Letterboxes several frames into one batched blob.
+ * @param images The frames; sizes may differ.
+ * @param inputSize Network input size.
+ * @param transforms If not null, receives one inverse transform per frame.
+ * @return An N x 3 x H x W CV_32F blob.
+ * @throws std::runtime_error if a frame is empty or not 8-bit.
+ */
+cv::Mat LetterboxPreprocessor::processBatch(
+    const std::vector<cv::Mat>& images, const cv::Size& inputSize,
+    std::vector<BoxTransform>* transforms) {
+  if (transforms != nullptr) {
+    transforms->clear();
+  }
+  if (images.empty()) {
+    return cv::Mat();
+  }
+  const int batch = static_cast<int>(images.size());
+  cv::Mat blob = acquire(batch, inputSize);
+  const size_t imageStride = 3 * static_cast<size_t>(inputSize.area());
+  for (int n = 0; n < batch; ++n) {
+    BoxTransform inverse =
+        fill(images[n], inputSize, blob.ptr<float>() + n * imageStride);
+    if (transforms != nullptr) {
+      transforms->push_back(inverse);
+    }
+  }
+  return blob;
+}
+
+/**
+ * @brief Gets a blob no caller holds any more, shaped as requested.
+ * @param batch Number of images.
+ * @param inputSize Network input size.
+ * @return The blob.
+ */
+cv::Mat LetterboxPreprocessor::acquire(int batch, const cv::Size& inputSize) {
+  const int shape[] = {batch, 3, inputSize.height, inputSize.width};
+  for (cv::Mat& blob : pool) {
+    // A reference count of one means only the pool still holds the data.
+    // A net that keeps its last input alive just holds one blob back.
+    if (blob.u != nullptr && blob.u->refcount == 1) {
+      const cv::UMatData* before = blob.u;
+      blob.create(4, shape, CV_32F);  // Reallocates if the shape changed
+      if (blob.u != before) {
+        recordAllocation(blob.total() * blob.elemSize());
+      }
+      return blob;
+    }
+  }
+  cv::Mat blob(4, shape, CV_32F);
+  recordAllocation(blob.total() * blob.elemSize());
+  if (pool.size() < kPoolSize) {
+    pool.push_back(blob);
+  }
+  return blob;
+}
+
+/**
+ * @brief Writes one letterboxed frame into its three channel planes.
+ * @param image The frame.
+ * @param inputSize Network input size.
+ * @param planes The first of three contiguous H x W float planes.
+ * @return The inverse transform.
+ */
+BoxTransform LetterboxPreprocessor::fill(const cv::Mat& image,
+                                         const cv::Size& inputSize,
+                                         float* planes) {
+  if (image.empty() || image.depth() != CV_8U) {
+    throw std::runtime_error("Letterbox needs a non-empty 8-bit image");
+  }
+  const cv::Mat* source = &image;
+  if (image.channels() == 1) {
+    cv::cvtColor(image, converted, cv::COLOR_GRAY2BGR);
+    source = &converted;
+  } else if (image.channels() == 4) {
+    cv::cvtColor(image, converted, cv::COLOR_BGRA2BGR);
+    source = &converted;
+  } else if (image.channels() != 3) {
+    throw std::runtime_error("Letterbox needs 1, 3 or 4 channels");
+  }
+
+  cv::Rect content = letterboxRect(source->size(), inputSize);
+  if (content.size() != source->size()) {
+    cv::resize(*source, resized, content.size(), 0, 0, cv::INTER_LINEAR);
+    source = &resized;
+  }
+
+  const size_t area = static_cast<size_t>(inputSize.area());
+  float* red = planes;
+  float* green = planes + area;
+  float* blue = planes + 2 * area;
+  for (float* plane : {red, green, blue}) {
+    fillBorder(plane, inputSize, content, padValue);
+  }
+  for (int y = 0; y < content.height; ++y) {
+    size_t offset =
+        static_cast<size_t>(content.y + y) * inputSize.width + content.x;
+    convertRow(source->ptr<uchar>(y), content.width, red + offset,
+               green + offset, blue + offset);
+  }
+  return letterboxTransform(image.size(), inputSize);
+}
+
+}  // namespace Detector
@@ -0,0 +1,112 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file letterbox.hpp
+ * @brief Aspect-preserving preprocessing into reused NCHW input blobs.
+ */
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "decode.hpp"
+
+namespace Detector {
+
+/**
+ * @brief Finds where a letterboxed frame lands inside the network input.
+ *
+ * The frame is scaled by the largest factor that fits both sides and
+ * centered; the rest of the input is padding.
+ *
+ * @param frameSize Size of the frame.
+ * @param inputSize Network input size.
+ * @return The rectangle of the input covered by the scaled frame.
+ */
+cv::Rect letterboxRect(const cv::Size& frameSize, const cv::Size& inputSize);
+
+/**
+ * @brief Builds the inverse of the letterbox, from normalized network
+ * coordinates back to frame pixels.
+ * @param frameSize Size of the frame.
+ * @param inputSize Network input size.
+ * @return The transform for decodeYoloOutputs().
+ */
+BoxTransform letterboxTransform(const cv::Size& frameSize,
+                                const cv::Size& inputSize);
+
+/**
+ * @class LetterboxPreprocessor
+ * @brief Letterboxes BGR frames into NCHW float blobs without per-frame
+ * allocations.
+ *
+ * The frame is resized into a reused buffer (or used as is when it already
+ * has the scaled size), then one SIMD pass swaps BGR to RGB, scales to
+ * [0, 1] and scatters the pixels into the channel planes of the blob. Only
+ * the padding border is filled separately.
+ *
+ * Blobs come from a small pool. A pooled blob is handed out again once every
+ * copy returned to callers has been released, so a caller that keeps a blob
+ * (a pipeline queue, say) never sees it overwritten. Not thread-safe: call
+ * it from one thread.
+ */
+class LetterboxPreprocessor {
+ public:
+  /**
+   * @brief Constructs a preprocessor.
+   * @param padValue Value of the padding, in [0, 1]; Darknet pads with 0.5.
+   */
+  explicit LetterboxPreprocessor(float padValue = 0.5f);
+
+  /**
+   * @brief Letterboxes one frame.
+   * @param image The frame; CV_8UC3 BGR, or CV_8UC1/CV_8UC4 converted first.
+   * @param inputSize Network input size.
+   * @param transform If not null, receives the inverse transform.
+   * @return A 1 x 3 x H x W CV_32F blob.
+   * @throws std::runtime_error if the frame is empty or not 8-bit.
+   */
+  cv::Mat process(const cv::Mat& image, const cv::Size& inputSize,
+                  BoxTransform* transform = nullptr);
+
+  /**
+   * @brief Letterboxes several frames into one batched blob.
+   * @param images The frames; sizes may differ.
+   * @param inputSize Network input size.
+   * @param transforms If not null, receives one inverse transform per frame.
+   * @return An N x 3 x H x W CV_32F blob.
+   * @throws std::runtime_error if a frame is empty or not 8-bit.
+   */
+  cv::Mat processBatch(const std::vector<cv::Mat>& images,
+                       const cv::Size& inputSize,
+                       std::vector<BoxTransform>* transforms = nullptr);
+
+ private:
+  /**
+   * @brief Gets a blob no caller holds any more, shaped as requested.
+   * @param batch Number of images.
+   * @param inputSize Network input size.
+   * @return The blob.
+   */
+  cv::Mat acquire(int batch, const cv::Size& inputSize);
+
+  /**
+   * @brief Writes one letterboxed frame into its three channel planes.
+   * @param image The frame.
+   * @param inputSize Network input size.
+   * @param planes The first of three contiguous H x W float planes.
+   * @return The inverse transform.
+   */
+  BoxTransform fill(const cv::Mat& image, const cv::Size& inputSize,
+                    float* planes);
+
+  /**< Most blobs kept for reuse; more are allocated while all are held */
+  static constexpr size_t kPoolSize = 4;
+
+  float padValue;            /**< Value written to the padding */
+  cv::Mat converted;         /**< Reused BGR copy of non-BGR frames */
+  cv::Mat resized;           /**< Reused resize target */
+  std::vector<cv::Mat> pool; /**< Blobs that may be handed out again */
+};
+
+}  // namespace Detector
@@ -0,0 +1,282 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "model_cache.hpp"
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <opencv2/core.hpp>
+#include <stdexcept>
+
+namespace Detector {
+
+namespace {
+
+/**< XXH64 primes */
+constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+
+/**
+ * @brief Rotates a word left.
+ * @param value The word.
+ * @param bits Bits to rotate by, in (0, 64).
+ * @return The rotated word.
+ */
+inline uint64_t rotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+/**
+ * @brief Reads an unaligned 64-bit word.
+ * @param p Address of the word.
+ * @return The word in host byte order.
+ */
+inline uint64_t read64(const unsigned char* p) {
+  uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/**
+ * @brief Reads an unaligned 32-bit word.
+ * @param p Address of the word.
+ * @return The word in host byte order.
+ */
+inline uint64_t read32(const unsigned char* p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/**
+ * @brief Mixes one input word into an accumulator.
+ * @param acc The accumulator.
+ * @param input The word.
+ * @return The new accumulator.
+ */
+inline uint64_t mixRound(uint64_t acc, uint64_t input) {
+  acc += input * kPrime2;
+  return rotateLeft(acc, 31) * kPrime1;
+}
+
+/**
+ * @brief Folds an accumulator into the hash.
+ * @param hash The hash.
+ * @param acc The accumulator.
+ * @return The new hash.
+ */
+inline uint64_t mergeRound(uint64_t hash, uint64_t acc) {
+  hash ^= mixRound(0, acc);
+  return hash * kPrime1 + kPrime4;
+}
+
+/**
+ * @brief Creates a directory and its missing parents.
+ * @param path The directory.
+ * @return True if the directory exists afterwards.
+ */
+bool makeDirectories(const std::string& path) {
+  for (size_t slash = path.find('/', 1); slash != std::string::npos;
+       slash = path.find('/', slash + 1)) {
+    ::mkdir(path.substr(0, slash).c_str(), 0755);
+  }
+  if (::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+    return false;
+  }
+  struct stat info;
+  return ::stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+}  // namespace
+
+/**
+ * @brief Hashes a buffer with XXH64, a fast non-cryptographic hash.
+ * @param data The buffer.
+ * @param size Bytes in the buffer.
+ * @param seed Seed, e.g. the hash of a previous buffer to chain them.
+ * @return The 64-bit hash.
+ */
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  const unsigned char* const end = p + size;
+  uint64_t hash;
+  if (size >= 32) {
+    uint64_t acc1 = seed + kPrime1 + kPrime2;
+    uint64_t acc2 = seed + kPrime2;
+    uint64_t acc3 = seed;
+    uint64_t acc4 = seed - kPrime1;
+    for (; p + 32 <= end; p += 32) {
+      acc1 = mixRound(acc1, read64(p));
+      acc2 = mixRound(acc2, read64(p + 8));
+      acc3 = mixRound(acc3, read64(p + 16));
+      acc4 = mixRound(acc4, read64(p + 24));
+    }
+    hash = rotateLeft(acc1, 1) + rotateLeft(acc2, 7) + rotateLeft(acc3, 12) +
+           rotateLeft(acc4, 18);
+    hash = mergeRound(hash, acc1);
+    hash = mergeRound(hash, acc2);
+    hash = mergeRound(hash, acc3);
+    hash = mergeRound(hash, acc4);
+  } else {
+    hash = seed + kPrime5;
+  }
+  hash += static_cast<uint64_t>(size);
+
+  for (; p + 8 <= end; p += 8) {
+    hash ^= mixRound(0, read64(p));
+    hash = rotateLeft(hash, 27) * kPrime1 + kPrime4;
+  }
+  if (p + 4 <= end) {
+    hash ^= read32(p) * kPrime1;
+    hash = rotateLeft(hash, 23) * kPrime2 + kPrime3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    hash ^= *p * kPrime5;
+    hash = rotateLeft(hash, 11) * kPrime1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+/**
+ * @brief Hashes a file's path, size and modification time.
+ * @param path Path to the file.
+ * @param seed Seed, e.g. the fingerprint of a previous file to chain them.
+ * @return The 64-bit hash.
+ * @throws std::runtime_error if the file does not exist.
+ */
+uint64_t fingerprintFile(const std::string& path, uint64_t seed) {
+  struct stat info;
+  if (::stat(path.c_str(), &info) != 0) {
+    throw std::runtime_error("Cannot stat " + path + ": " +
+                             std::strerror(errno));
+  }
+  const int64_t fields[] = {static_cast<int64_t>(info.st_size),
+                            static_cast<int64_t>(info.st_mtim.tv_sec),
+                            static_cast<int64_t>(info.st_mtim.tv_nsec)};
+  return hashBytes(fields, sizeof(fields),
+                   hashBytes(path.data(), path.size(), seed));
+}
+
+/**
+ * @brief Formats a hash as a cache key.
+ * @param hash The hash.
+ * @return 16 lowercase hex digits.
+ */
+std::string hexKey(uint64_t hash) {
+  char text[17];
+  std::snprintf(text, sizeof(text), "%016" PRIx64, hash);
+  return text;
+}
+
+/**
+ * @brief Opens a cache directory, creating it if needed.
+ * @param directory Path to the directory.
+ * @throws std::runtime_error if the directory cannot be created.
+ */
+ModelCache::ModelCache(const std::string& directory) : root(directory) {
+  while (root.size() > 1 && root.back() == '/') {
+    root.pop_back();
+  }
+  if (root.empty() || !makeDirectories(root)) {
+    throw std::runtime_error("Cannot create model cache directory " +
+                             directory);
+  }
+}
+
+/**
+ * @brief Gets the path of an entry.
+ * @param key The entry's key, e.g. from hexKey().
+ * @param suffix Appended to the key, e.g. "-onnxruntime-fp32.onnx".
+ * @return The path inside the cache directory.
+ */
+std::string ModelCache::path(const std::string& key,
+                             const std::string& suffix) const {
+  return root + "/" + key + suffix;
+}
+
+/**
+ * @brief Reads a recorded inference backend choice.
+ * @param key The entry's key.
+ * @param option Receives the backend option name.
+ * @param latencyMs Receives the latency measured when it was chosen.
+ * @return True if the entry exists and is readable.
+ */
+bool ModelCache::readChoice(const std::string& key, std::string* option,
+                            double* latencyMs) const {
+  const std::string file = path(key, "-backend.yml");
+  struct stat info;
+  if (::stat(file.c_str(), &info) != 0) {
+    return false;
+  }
+  try {
+    cv::FileStorage storage(file, cv::FileStorage::READ);
+    if (!storage.isOpened() || storage["backend"].empty()) {
+      return false;
+    }
+    *option = storage["backend"].string();
+    *latencyMs = storage["latency_ms"].real();
+  } catch (const cv::Exception&) {
+    return false;  // Written by an incompatible version; choose again
+  }
+  return !option->empty();
+}
+
+/**
+ * @brief Records an inference backend choice.
+ * @param key The entry's key.
+ * @param option The backend option name.
+ * @param latencyMs The latency measured for it.
+ * @return True if the entry was written.
+ */
+bool ModelCache::writeChoice(const std::string& key, const std::string& option,
+                             double latencyMs) const {
+  const std::string file = path(key, "-backend.yml");
+  // FileStorage picks the format from the extension
+  const std::string staging = stagingPath(file) + ".yml";
+  try {
+    cv::FileStorage storage(staging, cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+      return false;
+    }
+    storage.write("backend", option);
+    storage.write("latency_ms", latencyMs);
+    storage.write("opencv", std::string(CV_VERSION));
+    storage.release();
+  } catch (const cv::Exception&) {
+    std::remove(staging.c_str());
+    return false;
+  }
+  if (std::rename(staging.c_str(), file.c_str()) != 0) {
+    std::remove(staging.c_str());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Makes a unique name to write a file under before renaming it to
+ * its final path.
+ * @param path The final path.
+ * @return A path in the same directory, unique to this process and call.
+ */
+std::string stagingPath(const std::string& path) {
+  static std::atomic<unsigned> counter(0);
+  return path + ".tmp" + std::to_string(::getpid()) + "." +
+         std::to_string(counter++);
+}
+
+}  // namespace Detector
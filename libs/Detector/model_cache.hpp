@@ -0,0 +1,102 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file model_cache.hpp
+ * @brief Model file fingerprints and the on-disk cache that lets a
+ * restarted process skip its startup work.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Detector {
+
+/**
+ * @brief Hashes a buffer with XXH64, a fast non-cryptographic hash.
+ * @param data The buffer.
+ * @param size Bytes in the buffer.
+ * @param seed Seed, e.g. the hash of a previous buffer to chain them.
+ * @return The 64-bit hash.
+ */
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+/**
+ * @brief Hashes a file's path, size and modification time.
+ *
+ * Tells a replaced model file apart without reading it, so cache keys cost
+ * a stat() rather than a pass over a 240 MB weights file.
+ *
+ * @param path Path to the file.
+ * @param seed Seed, e.g. the fingerprint of a previous file to chain them.
+ * @return The 64-bit hash.
+ * @throws std::runtime_error if the file does not exist.
+ */
+uint64_t fingerprintFile(const std::string& path, uint64_t seed = 0);
+
+/**
+ * @brief Formats a hash as a cache key.
+ * @param hash The hash.
+ * @return 16 lowercase hex digits.
+ */
+std::string hexKey(uint64_t hash);
+
+/**
+ * @class ModelCache
+ * @brief A directory of compiled models and startup decisions, keyed by
+ * fingerprints of the model files they were derived from.
+ *
+ * Entries are written to a staging file and renamed into place, so
+ * processes sharing the directory never read a partial entry.
+ */
+class ModelCache {
+ public:
+  /**
+   * @brief Opens a cache directory, creating it if needed.
+   * @param directory Path to the directory.
+   * @throws std::runtime_error if the directory cannot be created.
+   */
+  explicit ModelCache(const std::string& directory);
+
+  /**
+   * @brief Gets the path of an entry.
+   * @param key The entry's key, e.g. from hexKey().
+   * @param suffix Appended to the key, e.g. "-onnxruntime-fp32.onnx".
+   * @return The path inside the cache directory.
+   */
+  std::string path(const std::string& key, const std::string& suffix) const;
+
+  /**
+   * @brief Reads a recorded inference backend choice.
+   * @param key The entry's key.
+   * @param option Receives the backend option name.
+   * @param latencyMs Receives the latency measured when it was chosen.
+   * @return True if the entry exists and is readable.
+   */
+  bool readChoice(const std::string& key, std::string* option,
+                  double* latencyMs) const;
+
+  /**
+   * @brief Records an inference backend choice.
+   * @param key The entry's key.
+   * @param option The backend option name.
+   * @param latencyMs The latency measured for it.
+   * @return True if the entry was written.
+   */
+  bool writeChoice(const std::string& key, const std::string& option,
+                   double latencyMs) const;
+
+ private:
+  std::string root; /**< The cache directory */
+};
+
+/**
+ * @brief Makes a unique name to write a file under before renaming it to
+ * its final path.
+ * @param path The final path.
+ * @return A path in the same directory, unique to this process and call.
+ */
+std::string stagingPath(const std::string& path);
+
+}  // namespace Detector
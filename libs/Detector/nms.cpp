@@ -0,0 +1,402 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+#include "nms.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <opencv2/dnn.hpp>
+#include <stdexcept>
+
+namespace Detector {
+
+namespace {
+
+/**
+ * @struct SortedBoxes
+ * @brief The candidates that pass the score threshold, grouped by class and
+ * sorted by descending score within each class.
+ *
+ * Corners and areas are kept as separate float arrays so the overlap loops
+ * read contiguous memory instead of converting cv::Rect each time. The
+ * arrays live in the caller's arena, if any.
+ */
+struct SortedBoxes {
+  ArenaVector<int> order;    /**< Candidate index of each entry */
+  ArenaVector<size_t> first; /**< First entry of each entry's class group */
+  ArenaVector<float> x1;     /**< Left edges */
+  ArenaVector<float> y1;     /**< Top edges */
+  ArenaVector<float> x2;     /**< Right edges */
+  ArenaVector<float> y2;     /**< Bottom edges */
+  ArenaVector<float> area;   /**< Box areas */
+  ArenaVector<float> score;  /**< Scores before any decay */
+
+  /**
+   * @brief Constructs empty arrays.
+   * @param arena Arena the arrays are allocated from, or null.
+   */
+  explicit SortedBoxes(FrameArena* arena)
+      : order(ArenaAllocator<int>(arena)),
+        first(ArenaAllocator<size_t>(arena)),
+        x1(ArenaAllocator<float>(arena)),
+        y1(ArenaAllocator<float>(arena)),
+        x2(ArenaAllocator<float>(arena)),
+        y2(ArenaAllocator<float>(arena)),
+        area(ArenaAllocator<float>(arena)),
+        score(ArenaAllocator<float>(arena)) {}
+
+  /**
+   * @brief Gets the number of entries.
+   * @return The entry count.
+   */
+  size_t size() const { return order.size(); }
+
+  /**
+   * @brief Computes the overlap of two entries.
+   * @param i The first entry.
+   * @param j The second entry.
+   * @return Intersection over union.
+   */
+  float iou(size_t i, size_t j) const {
+    float width = std::min(x2[i], x2[j]) - std::max(x1[i], x1[j]);
+    float height = std::min(y2[i], y2[j]) - std::max(y1[i], y1[j]);
+    if (width <= 0 || height <= 0) {
+      return 0.f;
+    }
+    float intersection = width * height;
+    return intersection / (area[i] + area[j] - intersection);
+  }
+};
+
+/**
+ * @brief Sorts the candidates above the score threshold.
+ * @param candidates The decoded candidates.
+ * @param config Score threshold and class awareness.
+ * @param sorted Receives the sorted entries; one group if classAware is
+ * off.
+ */
+void sortCandidates(const Candidates& candidates, const NmsConfig& config,
+                    SortedBoxes* sorted) {
+  sorted->order.reserve(candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (candidates.scores[i] > config.scoreThreshold) {
+      sorted->order.push_back(static_cast<int>(i));
+    }
+  }
+  // Equal scores keep their input order as in NMSBoxes. Breaking ties on
+  // the index gives std::stable_sort's order without its heap buffer.
+  const std::vector<float>& scores = candidates.scores;
+  const std::vector<int>& classIds = candidates.classIds;
+  const bool classAware = config.classAware;
+  std::sort(sorted->order.begin(), sorted->order.end(), [&](int a, int b) {
+    if (classAware && classIds[a] != classIds[b]) {
+      return classIds[a] < classIds[b];
+    }
+    if (scores[a] != scores[b]) {
+      return scores[a] > scores[b];
+    }
+    return a < b;
+  });
+
+  SortedBoxes& out = *sorted;
+  const size_t count = out.order.size();
+  out.first.resize(count);
+  out.x1.resize(count);
+  out.y1.resize(count);
+  out.x2.resize(count);
+  out.y2.resize(count);
+  out.area.resize(count);
+  out.score.resize(count);
+  for (size_t k = 0; k < count; ++k) {
+    const int index = out.order[k];
+    const cv::Rect& box = candidates.boxes[index];
+    out.first[k] =
+        k > 0 && (!classAware || classIds[out.order[k - 1]] == classIds[index])
+            ? out.first[k - 1]
+            : k;
+    out.x1[k] = static_cast<float>(box.x);
+    out.y1[k] = static_cast<float>(box.y);
+    out.x2[k] = static_cast<float>(box.x + box.width);
+    out.y2[k] = static_cast<float>(box.y + box.height);
+    out.area[k] = static_cast<float>(box.area());
+    out.score[k] = scores[index];
+  }
+}
+
+/**
+ * @brief Orders kept entries by score and converts them to candidate
+ * indices.
+ * @param sorted The sorted entries.
+ * @param kept The kept entries.
+ * @param decayed Score of every entry after any decay.
+ * @param topK Most entries returned; 0 = no limit.
+ * @param indices Receives the candidate indices, best first.
+ * @param scores If not null, receives the matching scores.
+ */
+void emitKept(const SortedBoxes& sorted, ArenaVector<size_t>* kept,
+              const ArenaVector<float>& decayed, int topK,
+              std::vector<int>& indices, std::vector<float>* scores) {
+  std::sort(kept->begin(), kept->end(), [&](size_t a, size_t b) {
+    if (decayed[a] != decayed[b]) {
+      return decayed[a] > decayed[b];
+    }
+    return a < b;
+  });
+  if (topK > 0 && kept->size() > static_cast<size_t>(topK)) {
+    kept->resize(topK);
+  }
+  indices.clear();
+  if (scores != nullptr) {
+    scores->clear();
+  }
+  for (size_t entry : *kept) {
+    indices.push_back(sorted.order[entry]);
+    if (scores != nullptr) {
+      scores->push_back(decayed[entry]);
+    }
+  }
+}
+
+/**
+ * @brief Greedy NMS: each entry is compared with the entries already kept
+ * in its group and dropped at the first overlap.
+ * @param sorted The sorted entries.
+ * @param config Overlap threshold and limit.
+ * @param kept Receives the kept entries.
+ */
+void greedyNms(const SortedBoxes& sorted, const NmsConfig& config,
+               ArenaVector<size_t>* kept) {
+  size_t groupKept = 0;  // Entries kept in the current group
+  for (size_t k = 0; k < sorted.size(); ++k) {
+    if (sorted.first[k] == k) {
+      groupKept = 0;
+    } else if (config.topK > 0 &&
+               groupKept >= static_cast<size_t>(config.topK)) {
+      continue;  // A class never contributes more than topK boxes
+    }
+    bool keep = true;
+    for (size_t i = kept->size() - groupKept; i < kept->size(); ++i) {
+      if (sorted.iou((*kept)[i], k) > config.iouThreshold) {
+        keep = false;
+        break;
+      }
+    }
+    if (keep) {
+      kept->push_back(k);
+      ++groupKept;
+    }
+  }
+}
+
+/**
+ * @brief Gaussian Soft-NMS: the best remaining entry of a group is kept and
+ * the others decay by their overlap with it until none passes the score
+ * threshold.
+ * @param sorted The sorted entries.
+ * @param config Decay, score threshold and limit.
+ * @param decayed Receives the score of every entry after decay.
+ * @param kept Receives the kept entries.
+ */
+void softNms(const SortedBoxes& sorted, const NmsConfig& config,
+             ArenaVector<float>* decayed, ArenaVector<size_t>* kept) {
+  decayed->assign(sorted.score.begin(), sorted.score.end());
+  ArenaVector<float>& score = *decayed;
+  ArenaVector<size_t> alive(kept->get_allocator());
+  alive.reserve(sorted.size());
+  for (size_t begin = 0; begin < sorted.size();) {
+    size_t end = begin + 1;
+    while (end < sorted.size() && sorted.first[end] == begin) {
+      ++end;
+    }
+    alive.resize(end - begin);
+    std::iota(alive.begin(), alive.end(), begin);
+    size_t groupKept = 0;
+    const size_t limit =
+        config.topK > 0 ? static_cast<size_t>(config.topK) : alive.size();
+    while (!alive.empty() && groupKept < limit) {
+      // Decay reorders the scores, so find the best by a linear scan
+      size_t best = 0;
+      for (size_t i = 1; i < alive.size(); ++i) {
+        if (score[alive[i]] > score[alive[best]]) {
+          best = i;
+        }
+      }
+      const size_t top = alive[best];
+      kept->push_back(top);
+      ++groupKept;
+      alive[best] = alive.back();
+      alive.pop_back();
+
+      size_t remaining = 0;
+      for (size_t entry : alive) {
+        float overlap = sorted.iou(top, entry);
+        score[entry] *= std::exp(-overlap * overlap / config.sigma);
+        if (score[entry] > config.scoreThreshold) {
+          alive[remaining++] = entry;
+        }
+      }
+      alive.resize(remaining);
+    }
+    begin = end;
+  }
+}
+
+/**
+ * @brief Matrix NMS: every entry decays by its worst overlap with a
+ * higher-scoring entry of its group, compensated by how suppressed that
+ * entry is itself, all in parallel.
+ * @param sorted The sorted entries.
+ * @param config Decay and score threshold.
+ * @param decayed Receives the score of every entry after decay.
+ * @param kept Receives the kept entries.
+ */
+void matrixNms(const SortedBoxes& sorted, const NmsConfig& config,
+               ArenaVector<float>* decayed, ArenaVector<size_t>* kept) {
+  const int count = static_cast<int>(sorted.size());
+  // Largest overlap of each entry with a better one; the IoU matrix is
+  // recomputed in the second pass rather than stored, which keeps memory
+  // linear in crowds with thousands of candidates
+  ArenaVector<float> compensation(count, 0.f, decayed->get_allocator());
+  cv::parallel_for_(cv::Range(0, count), [&](const cv::Range& range) {
+    for (int j = range.start; j < range.end; ++j) {
+      float worst = 0;
+      for (size_t i = sorted.first[j]; i < static_cast<size_t>(j); ++i) {
+        worst = std::max(worst, sorted.iou(i, j));
+      }
+      compensation[j] = worst;
+    }
+  });
+
+  decayed->resize(count);
+  cv::parallel_for_(cv::Range(0, count), [&](const cv::Range& range) {
+    for (int j = range.start; j < range.end; ++j) {
+      // min over i of exp(-iou^2 / s) / exp(-comp_i^2 / s), as one exponent
+      float exponent = 0;
+      for (size_t i = sorted.first[j]; i < static_cast<size_t>(j); ++i) {
+        float overlap = sorted.iou(i, j);
+        exponent = std::max(
+            exponent, overlap * overlap - compensation[i] * compensation[i]);
+      }
+      (*decayed)[j] = sorted.score[j] * std::exp(-exponent / config.sigma);
+    }
+  });
+
+  for (int j = 0; j < count; ++j) {
+    if ((*decayed)[j] > config.scoreThreshold) {
+      kept->push_back(j);
+    }
+  }
+}
+
+/**
+ * @brief cv::dnn::NMSBoxes over all classes in one call: each class is
+ * shifted clear of the others so boxes of different classes never overlap.
+ * @param candidates The decoded candidates.
+ * @param config Thresholds, limit and class awareness.
+ * @param indices Receives the kept candidate indices, best first.
+ */
+void openCvNms(const Candidates& candidates, const NmsConfig& config,
+               std::vector<int>& indices) {
+  if (!config.classAware || candidates.size() == 0) {
+    cv::dnn::NMSBoxes(candidates.boxes, candidates.scores,
+                      config.scoreThreshold, config.iouThreshold, indices,
+                      1.f, config.topK);
+    return;
+  }
+  int low = candidates.boxes[0].x;
+  int high = low;
+  for (const cv::Rect& box : candidates.boxes) {
+    low = std::min({low, box.x, box.y});
+    high = std::max({high, box.x + box.width, box.y + box.height});
+  }
+  const int span = high - low + 1;
+  std::vector<cv::Rect> shifted(candidates.boxes);
+  for (size_t i = 0; i < shifted.size(); ++i) {
+    const int offset = candidates.classIds[i] * span;
+    shifted[i].x += offset;
+    shifted[i].y += offset;
+  }
+  cv::dnn::NMSBoxes(shifted, candidates.scores, config.scoreThreshold,
+                    config.iouThreshold, indices, 1.f, config.topK);
+}
+
+}  // namespace
+
+/**
+ * @brief Computes the overlap of two boxes the way cv::dnn::NMSBoxes does.
+ * @param a The first box.
+ * @param b The second box.
+ * @return Intersection over union, 0 for empty boxes.
+ */
+float intersectionOverUnion(const cv::Rect& a, const cv::Rect& b) {
+  const double intersection = (a & b).area();
+  const double unionArea = a.area() + b.area() - intersection;
+  return unionArea > 0 ? static_cast<float>(intersection / unionArea) : 0.f;
+}
+
+/**
+ * @brief Suppresses overlapping candidates.
+ * @param candidates The decoded candidates.
+ * @param config Method and thresholds.
+ * @param indices Receives the indices of the kept candidates, best first.
+ * @param scores If not null, receives the score of each kept candidate after
+ * any decay, parallel to indices.
+ * @param arena If not null, holds the sorting and suppression scratch; the
+ * caller resets it once the frame is done.
+ */
+void nonMaxSuppression(const Candidates& candidates, const NmsConfig& config,
+                       std::vector<int>& indices, std::vector<float>* scores,
+                       FrameArena* arena) {
+  if (config.method == NmsMethod::kOpenCv) {
+    openCvNms(candidates, config, indices);
+    if (scores != nullptr) {
+      scores->clear();
+      for (int index : indices) {
+        scores->push_back(candidates.scores[index]);
+      }
+    }
+    return;
+  }
+
+  SortedBoxes sorted(arena);
+  sortCandidates(candidates, config, &sorted);
+  ArenaVector<float> decayed{ArenaAllocator<float>(arena)};
+  ArenaVector<size_t> kept{ArenaAllocator<size_t>(arena)};
+  kept.reserve(sorted.size());
+  switch (config.method) {
+    case NmsMethod::kSoft:
+      softNms(sorted, config, &decayed, &kept);
+      emitKept(sorted, &kept, decayed, config.topK, indices, scores);
+      break;
+    case NmsMethod::kMatrix:
+      matrixNms(sorted, config, &decayed, &kept);
+      emitKept(sorted, &kept, decayed, config.topK, indices, scores);
+      break;
+    default:
+      greedyNms(sorted, config, &kept);
+      emitKept(sorted, &kept, sorted.score, config.topK, indices, scores);
+      break;
+  }
+}
+
+/**
+ * @brief Parses a method name as given on the command line.
+ * @param name One of "opencv", "greedy", "soft" or "matrix".
+ * @return The method.
+ * @throws std::runtime_error if the name is unknown.
+ */
+NmsMethod parseNmsMethod(const std::string& name) {
+  if (name == "opencv") {
+    return NmsMethod::kOpenCv;
+  } else if (name == "greedy") {
+    return NmsMethod::kGreedy;
+  } else if (name == "soft") {
+    return NmsMethod::kSoft;
+  } else if (name == "matrix") {
+    return NmsMethod::kMatrix;
+  }
+  throw std::runtime_error("Unknown NMS method " + name +
+                           " (expected opencv, greedy, soft or matrix)");
+}
+
+}  // namespace Detector
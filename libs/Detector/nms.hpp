@@ -0,0 +1,88 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file nms.hpp
+ * @brief Class-aware non-maximum suppression of decoded candidates.
+ *
+ * Every method suppresses a box only against boxes of its own class unless
+ * classAware is off, so a person standing next to a cart keeps both
+ * detections. All classes are handled in one call rather than one call per
+ * class.
+ */
+
+#include <string>
+#include <vector>
+
+#include "decode.hpp"
+#include "frame_memory.hpp"
+
+namespace Detector {
+
+/**
+ * @enum NmsMethod
+ * @brief Suppression algorithm used by nonMaxSuppression().
+ */
+enum class NmsMethod {
+  kOpenCv, /**< cv::dnn::NMSBoxes, with classes offset apart */
+  kGreedy, /**< Sorted, early-exit greedy NMS; same result as kOpenCv */
+  kSoft,   /**< Gaussian Soft-NMS: overlapping scores decay */
+  kMatrix  /**< Matrix NMS: every decay computed at once, in parallel */
+};
+
+/**
+ * @struct NmsConfig
+ * @brief Parameters of nonMaxSuppression().
+ */
+struct NmsConfig {
+  NmsMethod method = NmsMethod::kGreedy; /**< Suppression algorithm */
+  /**< Overlap (IoU) above which kOpenCv and kGreedy drop the weaker box */
+  float iouThreshold = 0.4f;
+  /**< Boxes must score above this, after any decay, to be kept */
+  float scoreThreshold = 0.5f;
+  /**< Gaussian decay exp(-iou^2 / sigma) of kSoft and kMatrix */
+  float sigma = 0.5f;
+  bool classAware = true; /**< Only suppress boxes of the same class */
+  int topK = 0;           /**< Most boxes kept, best first; 0 = no limit */
+};
+
+/**
+ * @brief Computes the overlap of two boxes the way cv::dnn::NMSBoxes does.
+ * @param a The first box.
+ * @param b The second box.
+ * @return Intersection over union, 0 for empty boxes.
+ */
+float intersectionOverUnion(const cv::Rect& a, const cv::Rect& b);
+
+/**
+ * @brief Suppresses overlapping candidates.
+ *
+ * kGreedy sorts once and compares each box only with the boxes already kept
+ * in its class, stopping at the first overlap; it gives the same result as
+ * cv::dnn::NMSBoxes. kSoft and kMatrix lower the score of overlapping boxes
+ * instead of dropping them, which keeps people in dense crowds; kMatrix
+ * computes all decays in parallel, without the sequential dependency of
+ * kSoft.
+ *
+ * @param candidates The decoded candidates.
+ * @param config Method and thresholds.
+ * @param indices Receives the indices of the kept candidates, best first.
+ * @param scores If not null, receives the score of each kept candidate after
+ * any decay, parallel to indices.
+ * @param arena If not null, holds the sorting and suppression scratch; the
+ * caller resets it once the frame is done.
+ */
+void nonMaxSuppression(const Candidates& candidates, const NmsConfig& config,
+                       std::vector<int>& indices,
+                       std::vector<float>* scores = nullptr,
+                       FrameArena* arena = nullptr);
+
+/**
+ * @brief Parses a method name as given on the command line.
+ * @param name One of "opencv", "greedy", "soft" or "matrix".
+ * @return The method.
+ * @throws std::runtime_error if the name is unknown.
+ */
+NmsMethod parseNmsMethod(const std::string& name);
+
+}  // namespace Detector
@@ -0,0 +1,53 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "postprocessor.hpp"
+
+namespace Detector {
+
+/**
+ * @brief Decodes one frame and applies NMS.
+ * @param transform Maps the network's boxes back to the frame.
+ * @param output The network's output for that frame.
+ * @param decodeConfig Score threshold and classes read from each row.
+ * @param nmsConfig Suppression of overlapping candidates.
+ * @return The detections that survive thresholding and NMS.
+ */
+Detections Postprocessor::run(const BoxTransform& transform,
+                              const std::vector<cv::Mat>& output,
+                              const DecodeConfig& decodeConfig,
+                              const NmsConfig& nmsConfig) {
+  Detections detections;
+  run(transform, output, decodeConfig, nmsConfig, &detections);
+  return detections;
+}
+
+/**
+ * @brief Decodes one frame and applies NMS into caller-owned storage.
+ * @param transform Maps the network's boxes back to the frame.
+ * @param output The network's output for that frame.
+ * @param decodeConfig Score threshold and classes read from each row.
+ * @param nmsConfig Suppression of overlapping candidates.
+ * @param detections Receives the detections that survive thresholding and
+ * NMS; its capacity is reused.
+ */
+void Postprocessor::run(const BoxTransform& transform,
+                        const std::vector<cv::Mat>& output,
+                        const DecodeConfig& decodeConfig,
+                        const NmsConfig& nmsConfig, Detections* detections) {
+  decodeYoloOutputs(output, transform, decodeConfig, candidates);
+  // Soft and matrix NMS lower the scores
+  nonMaxSuppression(candidates, nmsConfig, keptIndices, &keptScores, &arena);
+  arena.reset();
+
+  detections->clear();
+  detections->reserve(keptIndices.size());
+  for (size_t i = 0; i < keptIndices.size(); ++i) {
+    int idx = keptIndices[i];
+    Detection detection;
+    detection.box = candidates.boxes[idx];
+    detection.score = keptScores[i];
+    detection.classId = candidates.classIds[idx];
+    detections->push_back(detection);
+  }
+}
+
+}  // namespace Detector
@@ -0,0 +1,66 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file postprocessor.hpp
+ * @brief Decoding and suppression of one frame's network output, with the
+ * scratch memory reused across frames.
+ */
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "decode.hpp"
+#include "detection.hpp"
+#include "frame_memory.hpp"
+#include "nms.hpp"
+
+namespace Detector {
+
+/**
+ * @class Postprocessor
+ * @brief Turns one frame's network output into detections.
+ *
+ * Decodes into reused candidate arrays and suppresses with scratch from a
+ * FrameArena reset after every frame, so once warmed up it makes no heap
+ * allocation besides the returned detections, and none at all when it
+ * writes into a vector the caller reuses. YOLODetector and the replay
+ * harness both use it, so a replay runs exactly the live code. Not
+ * thread-safe: one instance per thread.
+ */
+class Postprocessor {
+ public:
+  /**
+   * @brief Decodes one frame and applies NMS.
+   * @param transform Maps the network's boxes back to the frame.
+   * @param output The network's output for that frame.
+   * @param decodeConfig Score threshold and classes read from each row.
+   * @param nmsConfig Suppression of overlapping candidates.
+   * @return The detections that survive thresholding and NMS.
+   */
+  Detections run(const BoxTransform& transform,
+                 const std::vector<cv::Mat>& output,
+                 const DecodeConfig& decodeConfig,
+                 const NmsConfig& nmsConfig);
+
+  /**
+   * @brief Decodes one frame and applies NMS into caller-owned storage.
+   * @param transform Maps the network's boxes back to the frame.
+   * @param output The network's output for that frame.
+   * @param decodeConfig Score threshold and classes read from each row.
+   * @param nmsConfig Suppression of overlapping candidates.
+   * @param detections Receives the detections that survive thresholding and
+   * NMS; its capacity is reused.
+   */
+  void run(const BoxTransform& transform, const std::vector<cv::Mat>& output,
+           const DecodeConfig& decodeConfig, const NmsConfig& nmsConfig,
+           Detections* detections);
+
+ private:
+  FrameArena arena;              /**< NMS scratch, reset after each frame */
+  Candidates candidates;         /**< Reused decoder output */
+  std::vector<int> keptIndices;  /**< Reused NMS output */
+  std::vector<float> keptScores; /**< Scores after NMS decay */
+};
+
+}  // namespace Detector
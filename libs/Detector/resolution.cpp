@@ -0,0 +1,83 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "resolution.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace Detector {
+
+/**
+ * @brief Constructs a controller.
+ * @param config Tunables.
+ * @param initial The size in use now; the nearest configured side is taken
+ * as the starting point.
+ */
+ResolutionController::ResolutionController(const ResolutionConfig& config,
+                                           const cv::Size& initial)
+    : config(config), index(0), average(0), wait(0), switchCount(0) {
+  if (this->config.sides.empty()) {
+    throw std::runtime_error("ResolutionController needs at least one size");
+  }
+  std::sort(this->config.sides.begin(), this->config.sides.end());
+  for (size_t i = 1; i < this->config.sides.size(); ++i) {
+    if (std::abs(this->config.sides[i] - initial.width) <
+        std::abs(this->config.sides[index] - initial.width)) {
+      index = i;
+    }
+  }
+}
+
+/**
+ * @brief Feeds the latency of one inference and picks the next size.
+ * @param latencyMs Latency of the last inference in milliseconds.
+ * @return The input size to use from now on.
+ */
+cv::Size ResolutionController::update(double latencyMs) {
+  average = average == 0
+                ? latencyMs
+                : config.smoothing * latencyMs +
+                      (1 - config.smoothing) * average;
+  if (config.budgetMs <= 0) {
+    return current();
+  }
+  if (wait > 0) {
+    --wait;
+    return current();
+  }
+
+  if (average > config.budgetMs && index > 0) {
+    switchTo(index - 1);
+  } else if (index + 1 < config.sides.size()) {
+    double ratio = static_cast<double>(config.sides[index + 1]) /
+                   config.sides[index];
+    if (average * ratio * ratio < config.headroom * config.budgetMs) {
+      switchTo(index + 1);
+    }
+  }
+  return current();
+}
+
+/**
+ * @brief Gets the size currently chosen.
+ * @return The input size.
+ */
+cv::Size ResolutionController::current() const {
+  return cv::Size(config.sides[index], config.sides[index]);
+}
+
+/**
+ * @brief Moves to another configured side.
+ * @param next Index of the new side.
+ */
+void ResolutionController::switchTo(size_t next) {
+  // Latency scales with the pixel count, so rescale the average rather than
+  // waiting for it to relearn from scratch
+  double ratio = static_cast<double>(config.sides[next]) / config.sides[index];
+  average *= ratio * ratio;
+  index = next;
+  wait = config.cooldown;
+  ++switchCount;
+}
+
+}  // namespace Detector
@@ -0,0 +1,88 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file resolution.hpp
+ * @brief Header file for the latency-budget input resolution controller.
+ */
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace Detector {
+
+/**
+ * @struct ResolutionConfig
+ * @brief Tunables for switching the network input size at run time.
+ */
+struct ResolutionConfig {
+  /**< Square input sides to choose from, smallest first */
+  std::vector<int> sides = {320, 416, 608};
+  double budgetMs = 0;     /**< Target inference latency; 0 disables */
+  double smoothing = 0.2;  /**< Weight of each new sample in the average */
+  /**< Step up only if the predicted latency at the next size stays under
+   * this fraction of the budget */
+  double headroom = 0.8;
+  int cooldown = 15;       /**< Frames to wait after a switch */
+};
+
+/**
+ * @class ResolutionController
+ * @brief Picks the largest input size whose inference latency fits a budget.
+ *
+ * Latency is smoothed with an exponential moving average. When the average
+ * exceeds the budget the controller steps down one size; when the average
+ * scaled by the pixel ratio to the next size up stays under the headroom,
+ * it steps up. A cooldown after each switch lets the average settle.
+ */
+class ResolutionController {
+ public:
+  /**
+   * @brief Constructs a controller.
+   * @param config Tunables.
+   * @param initial The size in use now; the nearest configured side is
+   * taken as the starting point.
+   */
+  ResolutionController(const ResolutionConfig& config,
+                       const cv::Size& initial);
+
+  /**
+   * @brief Feeds the latency of one inference and picks the next size.
+   * @param latencyMs Latency of the last inference in milliseconds.
+   * @return The input size to use from now on.
+   */
+  cv::Size update(double latencyMs);
+
+  /**
+   * @brief Gets the size currently chosen.
+   * @return The input size.
+   */
+  cv::Size current() const;
+
+  /**
+   * @brief Gets the smoothed latency.
+   * @return The moving average in milliseconds, 0 before any sample.
+   */
+  double smoothedLatency() const { return average; }
+
+  /**
+   * @brief Gets the number of size changes so far.
+   * @return The switch count.
+   */
+  int switches() const { return switchCount; }
+
+ private:
+  /**
+   * @brief Moves to another configured side.
+   * @param next Index of the new side.
+   */
+  void switchTo(size_t next);
+
+  ResolutionConfig config; /**< Tunables */
+  size_t index;            /**< Index of the current side */
+  double average;          /**< Smoothed latency in milliseconds */
+  int wait;                /**< Frames left in the cooldown */
+  int switchCount;         /**< Number of size changes */
+};
+
+}  // namespace Detector
@@ -0,0 +1,201 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "shared_detector.hpp"
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace Detector {
+
+/**
+ * @struct SharedDetector::ContextTable
+ * @brief The contexts of the threads using one SharedDetector.
+ */
+struct SharedDetector::ContextTable {
+  std::mutex mutex;   /**< Guards contexts and nextCpu */
+  size_t nextCpu = 0; /**< Next entry of cpus to hand out */
+  /**< Context of each thread that has detected */
+  std::map<std::thread::id, std::unique_ptr<YOLODetector>> contexts;
+
+  /**
+   * @brief Frees a thread's context, outside the lock.
+   * @param thread The thread.
+   */
+  void release(std::thread::id thread) {
+    std::unique_ptr<YOLODetector> released;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = contexts.find(thread);
+    if (found != contexts.end()) {
+      released = std::move(found->second);
+      contexts.erase(found);
+    }
+  }
+};
+
+namespace {
+
+/**
+ * @class ThreadExitHooks
+ * @brief Runs a thread's registered callbacks when the thread exits.
+ */
+class ThreadExitHooks {
+ public:
+  /**
+   * @brief Registers a callback once per owner.
+   * @param owner Identifies the callback; expired owners are forgotten.
+   * @param hook The callback.
+   */
+  void add(const std::weak_ptr<void>& owner, std::function<void()> hook) {
+    for (size_t i = 0; i < hooks.size();) {
+      if (hooks[i].first.expired()) {
+        hooks.erase(hooks.begin() + i);
+      } else if (!hooks[i].first.owner_before(owner) &&
+                 !owner.owner_before(hooks[i].first)) {
+        return;
+      } else {
+        ++i;
+      }
+    }
+    hooks.emplace_back(owner, std::move(hook));
+  }
+
+  /**
+   * @brief Runs the callbacks.
+   */
+  ~ThreadExitHooks() {
+    for (auto& hook : hooks) {
+      hook.second();
+    }
+  }
+
+ private:
+  /**< Callbacks and their owners */
+  std::vector<std::pair<std::weak_ptr<void>, std::function<void()>>> hooks;
+};
+
+/**< Hooks of the calling thread */
+thread_local ThreadExitHooks exitHooks;
+
+}  // namespace
+
+/**
+ * @brief Reads the class names and applies the thread settings.
+ * @param files Darknet configuration and weights; the other fields are
+ * handed to the contexts for their backends and cache.
+ * @param classesPath Path to the file containing class names.
+ * @param threading Intra-op threads and pinning. intraOpThreads is set
+ * for the whole process.
+ */
+SharedDetector::SharedDetector(const ModelFiles& files,
+                               const std::string& classesPath,
+                               const ThreadingConfig& threading)
+    : files(files),
+      classNames(readClassNames(classesPath)),
+      cpus(pinningCpus(threading)),
+      table(std::make_shared<ContextTable>()) {
+  if (classNames.empty()) {
+    throw std::runtime_error("Failed to load class names from " +
+                             classesPath);
+  }
+  if (threading.intraOpThreads > 0) {
+    cv::setNumThreads(threading.intraOpThreads);
+  }
+}
+
+/**
+ * @brief Sets the callback that configures every context built from now
+ * on. Call it before the first detect().
+ * @param setup The callback; it runs on the context's own thread.
+ */
+void SharedDetector::configure(Setup setup) { this->setup = std::move(setup); }
+
+/**
+ * @brief Detects objects in a frame on the calling thread's context.
+ * @param frame The BGR frame.
+ * @return The detections after NMS.
+ */
+Detections SharedDetector::detect(const cv::Mat& frame) {
+  return context().detect(frame);
+}
+
+/**
+ * @brief Gets the calling thread's context, building it on first use.
+ * @return The context; use it from this thread only.
+ */
+YOLODetector& SharedDetector::context() {
+  const std::thread::id self = std::this_thread::get_id();
+  int cpu = -1;
+  {
+    std::lock_guard<std::mutex> lock(table->mutex);
+    auto found = table->contexts.find(self);
+    if (found != table->contexts.end()) {
+      return *found->second;
+    }
+    if (!cpus.empty()) {
+      cpu = cpus[table->nextCpu++ % cpus.size()];
+    }
+  }
+  // Pinned before loading so the weights are first touched, and therefore
+  // allocated, on this CPU's NUMA node. Built outside the lock so the
+  // other threads keep detecting meanwhile.
+  if (cpu >= 0) {
+    pinCurrentThread(cpu);
+  }
+  std::unique_ptr<YOLODetector> built = createContext();
+  std::weak_ptr<ContextTable> weak = table;
+  exitHooks.add(weak, [weak, self]() {
+    if (std::shared_ptr<ContextTable> owner = weak.lock()) {
+      owner->release(self);
+    }
+  });
+  std::lock_guard<std::mutex> lock(table->mutex);
+  std::unique_ptr<YOLODetector>& slot = table->contexts[self];
+  slot = std::move(built);
+  return *slot;
+}
+
+/**
+ * @brief Builds a context that is not tied to a thread, for worker pools
+ * that own their detectors.
+ * @return A configured detector loaded from the model files.
+ */
+std::unique_ptr<YOLODetector> SharedDetector::createContext() const {
+  // Loaded by path: OpenCV streams the weights straight into the layers,
+  // while its buffer overload would copy them twice first
+  cv::dnn::Net net;
+  try {
+    net = cv::dnn::readNetFromDarknet(files.config, files.weights);
+  } catch (const cv::Exception& e) {
+    throw std::runtime_error("Failed to load network: " +
+                             std::string(e.what()));
+  }
+  std::unique_ptr<YOLODetector> detector(
+      new YOLODetector(net, files, classNames));
+  if (setup) {
+    setup(*detector);
+  }
+  return detector;
+}
+
+/**
+ * @brief Frees the calling thread's context before the thread exits,
+ * which does it anyway. The next detect() on the thread builds a new
+ * one.
+ */
+void SharedDetector::releaseContext() {
+  table->release(std::this_thread::get_id());
+}
+
+/**
+ * @brief Gets the number of threads holding a context.
+ * @return The context count.
+ */
+size_t SharedDetector::contextCount() const {
+  std::lock_guard<std::mutex> lock(table->mutex);
+  return table->contexts.size();
+}
+
+}  // namespace Detector
@@ -0,0 +1,117 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file shared_detector.hpp
+ * @brief A detector that many threads can call at once, each through an
+ * execution context of its own.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+#include "backend.hpp"
+#include "detector.hpp"
+#include "thread_affinity.hpp"
+
+namespace Detector {
+
+/**
+ * @class SharedDetector
+ * @brief Thread-safe front of per-thread YOLODetector contexts.
+ *
+ * cv::dnn::Net keeps the state of a forward pass inside the network, so a
+ * network cannot run two frames at once. The class names are read once;
+ * the model files are parsed into a separate context for every thread
+ * that detects. A context is built on its thread the first time that
+ * thread calls detect(), after pinning the thread when
+ * ThreadingConfig::pin is set, so on a NUMA machine its weights land in
+ * the memory next to the cores that read them, and it is freed when the
+ * thread exits. The calls of different threads never wait on each other
+ * beyond a short lookup.
+ */
+class SharedDetector {
+ public:
+  /**
+   * @brief Callback that configures every new context, e.g. its input
+   * size, classes, NMS and backend.
+   */
+  using Setup = std::function<void(YOLODetector&)>;
+
+  /**
+   * @brief Reads the class names and applies the thread settings.
+   * @param files Darknet configuration and weights; the other fields are
+   * handed to the contexts for their backends and cache.
+   * @param classesPath Path to the file containing class names.
+   * @param threading Intra-op threads and pinning. intraOpThreads is set
+   * for the whole process.
+   * @throws std::runtime_error if a file cannot be read or the NUMA node
+   * does not exist.
+   */
+  SharedDetector(const ModelFiles& files, const std::string& classesPath,
+                 const ThreadingConfig& threading = ThreadingConfig());
+
+  /**
+   * @brief Sets the callback that configures every context built from now
+   * on. Call it before the first detect().
+   * @param setup The callback; it runs on the context's own thread.
+   */
+  void configure(Setup setup);
+
+  /**
+   * @brief Detects objects in a frame on the calling thread's context.
+   * @param frame The BGR frame.
+   * @return The detections after NMS.
+   */
+  Detections detect(const cv::Mat& frame);
+
+  /**
+   * @brief Gets the calling thread's context, building it on first use.
+   * @return The context; use it from this thread only.
+   */
+  YOLODetector& context();
+
+  /**
+   * @brief Builds a context that is not tied to a thread, for worker pools
+   * that own their detectors.
+   * @return A configured detector loaded from the model files.
+   */
+  std::unique_ptr<YOLODetector> createContext() const;
+
+  /**
+   * @brief Frees the calling thread's context before the thread exits,
+   * which does it anyway. The next detect() on the thread builds a new
+   * one.
+   */
+  void releaseContext();
+
+  /**
+   * @brief Gets the number of threads holding a context.
+   * @return The context count.
+   */
+  size_t contextCount() const;
+
+  /**
+   * @brief Gets the CPUs threads are pinned to, in the order they are
+   * handed out.
+   * @return The CPUs; empty when pinning is off.
+   */
+  const std::vector<int>& getPinningCpus() const { return cpus; }
+
+ private:
+  struct ContextTable;
+
+  ModelFiles files;                    /**< Paths of the model files */
+  std::vector<std::string> classNames; /**< Read once */
+  Setup setup;                         /**< Configures new contexts */
+  std::vector<int> cpus;               /**< CPUs handed to new threads */
+  /**< Context of each thread that has detected; shared with the threads
+   * so they can free theirs on exit, even after this object is gone */
+  std::shared_ptr<ContextTable> table;
+};
+
+}  // namespace Detector
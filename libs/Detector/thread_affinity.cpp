@@ -0,0 +1,160 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "thread_affinity.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace Detector {
+
+namespace {
+
+/**
+ * @brief Reads the first line of a small system file.
+ * @param path Path of the file.
+ * @param line Receives the line.
+ * @return False if the file cannot be read.
+ */
+bool readLine(const std::string& path, std::string* line) {
+  std::ifstream in(path.c_str());
+  return in.good() && static_cast<bool>(std::getline(in, *line));
+}
+
+/**
+ * @brief Parses a non-negative CPU index.
+ * @param text The digits.
+ * @param list The whole list, for the error message.
+ * @return The index.
+ * @throws std::runtime_error if the text is not a number.
+ */
+int parseCpu(const std::string& text, const std::string& list) {
+  if (text.empty() ||
+      text.find_first_not_of("0123456789") != std::string::npos) {
+    throw std::runtime_error("Bad CPU list " + list);
+  }
+  return std::stoi(text);
+}
+
+}  // namespace
+
+/**
+ * @brief Parses a Linux CPU list such as "0-3,8,10-11".
+ * @param list The list.
+ * @return The CPUs in the order listed.
+ */
+std::vector<int> parseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream items(list);
+  std::string item;
+  while (std::getline(items, item, ',')) {
+    item.erase(0, item.find_first_not_of(" \t\n"));
+    item.erase(item.find_last_not_of(" \t\n") + 1);
+    if (item.empty()) {
+      continue;
+    }
+    size_t dash = item.find('-');
+    int first = parseCpu(item.substr(0, dash), list);
+    int last = dash == std::string::npos
+                   ? first
+                   : parseCpu(item.substr(dash + 1), list);
+    if (last < first) {
+      throw std::runtime_error("Bad CPU list " + list);
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+/**
+ * @brief Gets the CPUs that are online.
+ * @return Their indices, or 0 .. hardware_concurrency - 1 where the system
+ * does not report them.
+ */
+std::vector<int> onlineCpus() {
+  std::string line;
+  if (readLine("/sys/devices/system/cpu/online", &line)) {
+    std::vector<int> cpus = parseCpuList(line);
+    if (!cpus.empty()) {
+      return cpus;
+    }
+  }
+  std::vector<int> cpus;
+  for (unsigned i = 0; i < std::max(1u, std::thread::hardware_concurrency());
+       ++i) {
+    cpus.push_back(static_cast<int>(i));
+  }
+  return cpus;
+}
+
+/**
+ * @brief Gets the CPUs of one NUMA node.
+ * @param node The node index.
+ * @return Their indices.
+ */
+std::vector<int> numaNodeCpus(int node) {
+  std::string line;
+  const std::string path = "/sys/devices/system/node/node" +
+                           std::to_string(node) + "/cpulist";
+  if (node < 0 || !readLine(path, &line)) {
+    throw std::runtime_error("No NUMA node " + std::to_string(node));
+  }
+  return parseCpuList(line);
+}
+
+/**
+ * @brief Resolves the CPUs inference threads are pinned to, in the order
+ * they are handed out.
+ * @param config Threading settings.
+ * @return The CPUs; empty if config.pin is false.
+ */
+std::vector<int> pinningCpus(const ThreadingConfig& config) {
+  if (!config.pin) {
+    return std::vector<int>();
+  }
+  if (!config.cpus.empty()) {
+    return config.cpus;
+  }
+  return config.numaNode >= 0 ? numaNodeCpus(config.numaNode) : onlineCpus();
+}
+
+/**
+ * @brief Pins the calling thread to one CPU.
+ * @param cpu The CPU index.
+ * @return False, after logging why, if pinning failed or is not supported
+ * on this platform.
+ */
+bool pinCurrentThread(int cpu) {
+#ifdef __linux__
+  if (cpu < 0 || cpu >= CPU_SETSIZE) {
+    std::cerr << "Cannot pin to CPU " << cpu << ": out of range" << std::endl;
+    return false;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  const int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (error != 0) {
+    std::cerr << "Cannot pin to CPU " << cpu << ": " << std::strerror(error)
+              << std::endl;
+    return false;
+  }
+  return true;
+#else
+  std::cerr << "Cannot pin to CPU " << cpu
+            << ": not supported on this platform" << std::endl;
+  return false;
+#endif
+}
+
+}  // namespace Detector
@@ -0,0 +1,76 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file thread_affinity.hpp
+ * @brief Thread counts and CPU pinning for inference threads, with the CPU
+ * sets of the machine's NUMA nodes.
+ */
+
+#include <string>
+#include <vector>
+
+namespace Detector {
+
+/**
+ * @struct ThreadingConfig
+ * @brief How inference threads share the machine's cores.
+ */
+struct ThreadingConfig {
+  /**< Threads OpenCV's pool may use inside one forward pass, set with
+   * cv::setNumThreads for the whole process; 0 keeps OpenCV's default.
+   * With one network per stream, 1 avoids oversubscribing the cores */
+  int intraOpThreads = 0;
+  bool pin = false;  /**< Pin each inference thread to its own CPU */
+  /**< NUMA node whose CPUs the threads are pinned to; -1 uses every
+   * online CPU */
+  int numaNode = -1;
+  /**< CPUs to pin to, in order; overrides numaNode when not empty */
+  std::vector<int> cpus;
+};
+
+/**
+ * @brief Parses a Linux CPU list such as "0-3,8,10-11".
+ * @param list The list.
+ * @return The CPUs in the order listed.
+ * @throws std::runtime_error if the list is malformed.
+ */
+std::vector<int> parseCpuList(const std::string& list);
+
+/**
+ * @brief Gets the CPUs that are online.
+ * @return Their indices, or 0 .. hardware_concurrency - 1 where the system
+ * does not report them.
+ */
+std::vector<int> onlineCpus();
+
+/**
+ * @brief Gets the CPUs of one NUMA node.
+ * @param node The node index.
+ * @return Their indices.
+ * @throws std::runtime_error if the node does not exist.
+ */
+std::vector<int> numaNodeCpus(int node);
+
+/**
+ * @brief Resolves the CPUs inference threads are pinned to, in the order
+ * they are handed out.
+ * @param config Threading settings.
+ * @return The CPUs; empty if config.pin is false.
+ * @throws std::runtime_error if the NUMA node does not exist.
+ */
+std::vector<int> pinningCpus(const ThreadingConfig& config);
+
+/**
+ * @brief Pins the calling thread to one CPU.
+ *
+ * Memory the thread touches first afterwards, such as the weights of a
+ * network it loads, is then allocated on that CPU's NUMA node.
+ *
+ * @param cpu The CPU index.
+ * @return False, after logging why, if pinning failed or is not supported
+ * on this platform.
+ */
+bool pinCurrentThread(int cpu);
+
+}  // namespace Detector
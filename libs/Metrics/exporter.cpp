@@ -0,0 +1,190 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "exporter.hpp"
+
+namespace Metrics {
+
+namespace {
+
+/**< How long the loop waits for a connection before checking the clock */
+constexpr int kPollMs = 100;
+
+/**
+ * @brief Sends a whole buffer.
+ * @param socket The connected socket.
+ * @param data The bytes to send.
+ * @return False if the peer went away.
+ */
+bool sendAll(int socket, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n =
+        ::send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return false;
+    }
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+ * @brief Starts publishing.
+ * @param registry The metrics to publish; must outlive the exporter.
+ * @param config Port, file and interval.
+ * @throws std::runtime_error if the port cannot be bound, or if a file is
+ * given with an interval that is not positive.
+ */
+Exporter::Exporter(Registry& registry, const ExporterConfig& config)
+    : registry(registry),
+      config(config),
+      listener(-1),
+      boundPort(-1),
+      running(true) {
+  // A zero interval would rewrite the file on every poll of the loop
+  if (!config.filePath.empty() && !(config.intervalSeconds > 0)) {
+    throw std::runtime_error("Metrics file interval must be positive");
+  }
+  if (config.port >= 0) {
+    listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(config.port));
+    socklen_t length = sizeof(address);
+    if (listener < 0 ||
+        ::bind(listener, reinterpret_cast<sockaddr*>(&address), length) !=
+            0 ||
+        ::listen(listener, 8) != 0 ||
+        ::getsockname(listener, reinterpret_cast<sockaddr*>(&address),
+                      &length) != 0) {
+      if (listener >= 0) {
+        ::close(listener);
+      }
+      throw std::runtime_error("Cannot serve metrics on port " +
+                               std::to_string(config.port));
+    }
+    boundPort = ntohs(address.sin_port);
+  }
+  worker = std::thread(&Exporter::loop, this);
+}
+
+/**
+ * @brief Stops publishing; see stop().
+ */
+Exporter::~Exporter() { stop(); }
+
+/**
+ * @brief Stops the background thread after a last file write.
+ */
+void Exporter::stop() {
+  if (!running.exchange(false)) {
+    return;
+  }
+  worker.join();
+  if (listener >= 0) {
+    ::close(listener);
+    listener = -1;
+  }
+  if (!config.filePath.empty()) {
+    writeFile();  // Short runs still leave their final numbers behind
+  }
+}
+
+/**
+ * @brief Background loop: answers requests and writes the file.
+ */
+void Exporter::loop() {
+  auto nextWrite = std::chrono::steady_clock::now();
+  while (running.load()) {
+    if (!config.filePath.empty() &&
+        std::chrono::steady_clock::now() >= nextWrite) {
+      writeFile();
+      nextWrite += std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::duration<double>(config.intervalSeconds));
+    }
+    if (listener < 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(kPollMs));
+      continue;
+    }
+    pollfd entry = {listener, POLLIN, 0};
+    if (::poll(&entry, 1, kPollMs) > 0 && (entry.revents & POLLIN)) {
+      int client = ::accept(listener, nullptr, nullptr);
+      if (client >= 0) {
+        serve(client);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Answers one HTTP connection.
+ * @param client The accepted socket; closed before returning.
+ */
+void Exporter::serve(int client) {
+  // Read the request head; a slow client must not stall the loop for long
+  timeval timeout = {1, 0};
+  ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  std::string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == std::string::npos &&
+         request.size() < 8192) {
+    ssize_t n = ::recv(client, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+      break;
+    }
+    request.append(buffer, static_cast<size_t>(n));
+  }
+
+  std::string status = "200 OK";
+  std::string body;
+  if (request.compare(0, 13, "GET /metrics ") == 0 ||
+      request.compare(0, 6, "GET / ") == 0) {
+    body = toPrometheusText(registry.snapshot());
+  } else {
+    status = "404 Not Found";
+    body = "Try GET /metrics\n";
+  }
+  sendAll(client, "HTTP/1.0 " + status +
+                      "\r\nContent-Type: text/plain; version=0.0.4"
+                      "\r\nContent-Length: " +
+                      std::to_string(body.size()) +
+                      "\r\nConnection: close\r\n\r\n" + body);
+  ::close(client);
+}
+
+/**
+ * @brief Writes the exposition text to the file.
+ */
+void Exporter::writeFile() {
+  const std::string temporary = config.filePath + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::trunc);
+    file << toPrometheusText(registry.snapshot());
+    if (!file.good()) {
+      std::cerr << "Cannot write metrics to " << temporary << std::endl;
+      return;
+    }
+  }
+  if (std::rename(temporary.c_str(), config.filePath.c_str()) != 0) {
+    std::cerr << "Cannot replace " << config.filePath << std::endl;
+  }
+}
+
+}  // namespace Metrics
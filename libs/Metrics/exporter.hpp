@@ -0,0 +1,96 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file exporter.hpp
+ * @brief Header file for publishing a metrics registry over HTTP or to a
+ * file.
+ */
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "metrics.hpp"
+
+namespace Metrics {
+
+/**
+ * @struct ExporterConfig
+ * @brief Where and how often metrics are published.
+ */
+struct ExporterConfig {
+  /**< TCP port serving /metrics on 127.0.0.1; -1 = off, 0 = any free port */
+  int port = -1;
+  /**< File rewritten with the exposition text; empty = off. Suits the
+   * node_exporter textfile collector */
+  std::string filePath;
+  /**< Seconds between file writes; must be positive when filePath is set */
+  double intervalSeconds = 10;
+};
+
+/**
+ * @class Exporter
+ * @brief Serves a registry in the Prometheus text format from a background
+ * thread.
+ *
+ * The HTTP endpoint only listens on the loopback interface; expose it
+ * through a local agent rather than directly. The file is written to a
+ * temporary name and renamed, so readers never see a partial file.
+ */
+class Exporter {
+ public:
+  /**
+   * @brief Starts publishing.
+   * @param registry The metrics to publish; must outlive the exporter.
+   * @param config Port, file and interval.
+   * @throws std::runtime_error if the port cannot be bound, or if a file
+   * is given with an interval that is not positive.
+   */
+  Exporter(Registry& registry, const ExporterConfig& config);
+
+  /**
+   * @brief Stops publishing; see stop().
+   */
+  ~Exporter();
+
+  Exporter(const Exporter&) = delete;
+  Exporter& operator=(const Exporter&) = delete;
+
+  /**
+   * @brief Stops the background thread after a last file write.
+   */
+  void stop();
+
+  /**
+   * @brief Gets the port the endpoint listens on.
+   * @return The bound port, or -1 without an endpoint.
+   */
+  int port() const { return boundPort; }
+
+ private:
+  /**
+   * @brief Background loop: answers requests and writes the file.
+   */
+  void loop();
+
+  /**
+   * @brief Answers one HTTP connection.
+   * @param client The accepted socket; closed before returning.
+   */
+  void serve(int client);
+
+  /**
+   * @brief Writes the exposition text to the file.
+   */
+  void writeFile();
+
+  Registry& registry;         /**< Metrics being published */
+  ExporterConfig config;      /**< Port, file and interval */
+  int listener;               /**< Listening socket, or -1 */
+  int boundPort;              /**< Port of listener, or -1 */
+  std::atomic<bool> running;  /**< Cleared by stop() */
+  std::thread worker;         /**< Runs loop() */
+};
+
+}  // namespace Metrics
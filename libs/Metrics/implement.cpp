@@ -0,0 +1,278 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "metrics.hpp"
+
+namespace Metrics {
+
+namespace {
+
+/**
+ * @brief Escapes a Prometheus label value.
+ * @param value The raw value.
+ * @return The value with backslashes, quotes and newlines escaped.
+ */
+std::string labelValue(const std::string& value) {
+  std::string escaped;
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+}  // namespace
+
+constexpr int LatencyHistogram::kSubBucketBits;
+constexpr uint64_t LatencyHistogram::kHalfBuckets;
+constexpr int LatencyHistogram::kMaxBits;
+constexpr size_t LatencyHistogram::kBuckets;
+
+/**
+ * @brief Creates an empty histogram.
+ */
+LatencyHistogram::LatencyHistogram() { reset(); }
+
+/**
+ * @brief Gets the number of samples recorded.
+ * @return The sample count.
+ */
+uint64_t LatencyHistogram::count() const {
+  uint64_t samples = 0;
+  for (const auto& bucket : counts) {
+    samples += bucket.load(std::memory_order_relaxed);
+  }
+  return samples;
+}
+
+/**
+ * @brief Gets a latency percentile.
+ * @param percentile The percentile, in [0, 100].
+ * @return The latency in microseconds, or 0 without samples.
+ */
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const {
+  // Copy the buckets first so concurrent records cannot skew the walk
+  std::vector<uint64_t> copy(kBuckets);
+  uint64_t samples = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    copy[i] = counts[i].load(std::memory_order_relaxed);
+    samples += copy[i];
+  }
+  if (samples == 0) {
+    return 0;
+  }
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * samples)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += copy[i];
+    if (seen >= rank) {
+      // A bucket covers a range; never report past the largest sample
+      return std::min(bucketValue(i),
+                      largest.load(std::memory_order_relaxed));
+    }
+  }
+  return largest.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Summarizes the histogram.
+ * @return The count, mean, p50, p90, p99 and max.
+ */
+LatencySummary LatencyHistogram::summary() const {
+  LatencySummary result;
+  result.count = count();
+  if (result.count == 0) {
+    return result;
+  }
+  result.sumMs = total.load(std::memory_order_relaxed) / 1000.0;
+  result.meanMs = result.sumMs / result.count;
+  result.p50Ms = valueAtPercentile(50) / 1000.0;
+  result.p90Ms = valueAtPercentile(90) / 1000.0;
+  result.p99Ms = valueAtPercentile(99) / 1000.0;
+  result.maxMs = largest.load(std::memory_order_relaxed) / 1000.0;
+  return result;
+}
+
+/**
+ * @brief Drops every sample.
+ */
+void LatencyHistogram::reset() {
+  for (auto& bucket : counts) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  total.store(0, std::memory_order_relaxed);
+  largest.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the largest value that maps to a bucket.
+ * @param index The bucket index.
+ * @return The value in microseconds.
+ */
+uint64_t LatencyHistogram::bucketValue(size_t index) {
+  const size_t linear = size_t{1} << kSubBucketBits;
+  if (index < linear) {
+    return index;
+  }
+  int shift = static_cast<int>((index - linear) / kHalfBuckets) + 1;
+  uint64_t sub = (index - linear) % kHalfBuckets + kHalfBuckets;
+  return ((sub + 1) << shift) - 1;
+}
+
+/**
+ * @brief Creates an empty registry.
+ * @param rateWindowSeconds Shortest interval an FPS figure is measured
+ * over; reads closer together than this repeat the last figure.
+ */
+Registry::Registry(double rateWindowSeconds)
+    : rateWindow(rateWindowSeconds) {}
+
+/**
+ * @brief Gets a stage's histogram, creating it if needed.
+ * @param name The stage name.
+ * @return The histogram, valid for the registry's lifetime.
+ */
+LatencyHistogram& Registry::stage(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<Stage>& entry = stages[name];
+  if (!entry) {
+    entry.reset(new Stage());
+    entry->rateStart = std::chrono::steady_clock::now();
+  }
+  return entry->latency;
+}
+
+/**
+ * @brief Replaces the per-layer timings.
+ * @param layers Times of one forward pass, in network order.
+ */
+void Registry::setLayerTimings(std::vector<LayerTiming> layers) {
+  std::lock_guard<std::mutex> lock(mutex);
+  this->layers = std::move(layers);
+}
+
+/**
+ * @brief Reads every stage and the layer timings.
+ * @return The current values.
+ */
+Snapshot Registry::snapshot() {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto now = std::chrono::steady_clock::now();
+  Snapshot result;
+  for (auto& entry : stages) {
+    Stage& stage = *entry.second;
+    StageSnapshot item;
+    item.name = entry.first;
+    item.latency = stage.latency.summary();
+    double elapsed =
+        std::chrono::duration<double>(now - stage.rateStart).count();
+    if (elapsed > 0 && elapsed >= rateWindow) {
+      stage.fps = (item.latency.count - stage.rateCount) / elapsed;
+      stage.rateStart = now;
+      stage.rateCount = item.latency.count;
+    }
+    item.fps = stage.fps;
+    result.stages.push_back(item);
+  }
+  result.layers = layers;
+  return result;
+}
+
+/**
+ * @brief Formats a snapshot in the Prometheus text exposition format.
+ * @param snapshot The values to format.
+ * @return The exposition text.
+ */
+std::string toPrometheusText(const Snapshot& snapshot) {
+  std::ostringstream out;
+  out << std::setprecision(9);
+  out << "# HELP acme_stage_latency_seconds Latency of each detection stage."
+      << "\n# TYPE acme_stage_latency_seconds summary\n";
+  for (const StageSnapshot& stage : snapshot.stages) {
+    const std::string label = "stage=\"" + labelValue(stage.name) + "\"";
+    const std::pair<const char*, double> quantiles[] = {
+        {"0.5", stage.latency.p50Ms},
+        {"0.9", stage.latency.p90Ms},
+        {"0.99", stage.latency.p99Ms}};
+    for (const auto& quantile : quantiles) {
+      out << "acme_stage_latency_seconds{" << label << ",quantile=\""
+          << quantile.first << "\"} " << quantile.second / 1000.0 << "\n";
+    }
+    out << "acme_stage_latency_seconds_sum{" << label << "} "
+        << stage.latency.sumMs / 1000.0 << "\n";
+    out << "acme_stage_latency_seconds_count{" << label << "} "
+        << stage.latency.count << "\n";
+  }
+
+  out << "# HELP acme_stage_latency_max_seconds Slowest run of each stage."
+      << "\n# TYPE acme_stage_latency_max_seconds gauge\n";
+  for (const StageSnapshot& stage : snapshot.stages) {
+    out << "acme_stage_latency_max_seconds{stage=\"" << labelValue(stage.name)
+        << "\"} " << stage.latency.maxMs / 1000.0 << "\n";
+  }
+
+  out << "# HELP acme_stage_fps Runs of each stage per second."
+      << "\n# TYPE acme_stage_fps gauge\n";
+  for (const StageSnapshot& stage : snapshot.stages) {
+    out << "acme_stage_fps{stage=\"" << labelValue(stage.name) << "\"} "
+        << stage.fps << "\n";
+  }
+
+  if (!snapshot.layers.empty()) {
+    out << "# HELP acme_layer_latency_seconds Time in each network layer"
+        << " during the last sampled forward pass."
+        << "\n# TYPE acme_layer_latency_seconds gauge\n";
+    for (const LayerTiming& layer : snapshot.layers) {
+      out << "acme_layer_latency_seconds{layer=\"" << labelValue(layer.name)
+          << "\"} " << layer.ms / 1000.0 << "\n";
+    }
+  }
+  return out.str();
+}
+
+/**
+ * @brief Formats a snapshot as a table for the console.
+ * @param snapshot The values to format.
+ * @param topLayers Number of slowest layers listed; 0 lists none.
+ * @return One line per stage, then the slowest layers.
+ */
+std::string toTable(const Snapshot& snapshot, size_t topLayers) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+  out << std::left << std::setw(14) << "stage" << std::right
+      << std::setw(10) << "count" << std::setw(10) << "p50 ms"
+      << std::setw(10) << "p99 ms" << std::setw(10) << "max ms"
+      << std::setw(10) << "fps" << "\n";
+  for (const StageSnapshot& stage : snapshot.stages) {
+    out << std::left << std::setw(14) << stage.name << std::right
+        << std::setw(10) << stage.latency.count << std::setw(10)
+        << stage.latency.p50Ms << std::setw(10) << stage.latency.p99Ms
+        << std::setw(10) << stage.latency.maxMs << std::setw(10)
+        << stage.fps << "\n";
+  }
+
+  std::vector<LayerTiming> slowest = snapshot.layers;
+  std::sort(slowest.begin(), slowest.end(),
+            [](const LayerTiming& a, const LayerTiming& b) {
+              return a.ms > b.ms;
+            });
+  slowest.resize(std::min(slowest.size(), topLayers));
+  for (const LayerTiming& layer : slowest) {
+    out << "  layer " << std::left << std::setw(24) << layer.name
+        << std::right << std::setw(8) << layer.ms << " ms\n";
+  }
+  return out.str();
+}
+
+}  // namespace Metrics
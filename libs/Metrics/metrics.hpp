@@ -0,0 +1,282 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file metrics.hpp
+ * @brief Header file for per-stage latency histograms, scoped timers and
+ * the registry that collects them.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Metrics {
+
+/**
+ * @struct LatencySummary
+ * @brief Percentiles of a latency histogram, in milliseconds.
+ */
+struct LatencySummary {
+  uint64_t count = 0; /**< Samples recorded */
+  double meanMs = 0;  /**< Mean latency */
+  double p50Ms = 0;   /**< Median latency */
+  double p90Ms = 0;   /**< 90th percentile */
+  double p99Ms = 0;   /**< 99th percentile */
+  double maxMs = 0;   /**< Slowest sample */
+  double sumMs = 0;   /**< Sum of all samples */
+};
+
+/**
+ * @class LatencyHistogram
+ * @brief HDR-style latency histogram with microsecond resolution.
+ *
+ * Values below 256 us get a bucket each; above that every power of two is
+ * split into 128 linear buckets, so any percentile is within 0.8% of the
+ * true value from 1 us up to about 12 days. record() is a few relaxed
+ * atomic adds and never blocks, so any number of threads may record while
+ * another reads.
+ */
+class LatencyHistogram {
+ public:
+  /**
+   * @brief Creates an empty histogram.
+   */
+  LatencyHistogram();
+
+  /**
+   * @brief Records one sample.
+   * @param micros The latency in microseconds.
+   */
+  void record(uint64_t micros) {
+    counts[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(micros, std::memory_order_relaxed);
+    uint64_t seen = largest.load(std::memory_order_relaxed);
+    while (micros > seen &&
+           !largest.compare_exchange_weak(seen, micros,
+                                          std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * @brief Gets the number of samples recorded.
+   * @return The sample count.
+   */
+  uint64_t count() const;
+
+  /**
+   * @brief Gets a latency percentile.
+   * @param percentile The percentile, in [0, 100].
+   * @return The latency in microseconds, or 0 without samples.
+   */
+  uint64_t valueAtPercentile(double percentile) const;
+
+  /**
+   * @brief Summarizes the histogram.
+   * @return The count, mean, p50, p90, p99 and max.
+   */
+  LatencySummary summary() const;
+
+  /**
+   * @brief Drops every sample.
+   */
+  void reset();
+
+ private:
+  /**< log2 of the linear buckets below 2^kSubBucketBits */
+  static constexpr int kSubBucketBits = 8;
+  /**< Linear buckets per power of two above the first range */
+  static constexpr uint64_t kHalfBuckets = uint64_t{1}
+                                           << (kSubBucketBits - 1);
+  /**< Samples are clamped below this many microseconds */
+  static constexpr int kMaxBits = 40;
+  /**< Total bucket count */
+  static constexpr size_t kBuckets = (uint64_t{1} << kSubBucketBits) +
+                                     (kMaxBits - kSubBucketBits) * kHalfBuckets;
+
+  /**
+   * @brief Maps a value to its bucket.
+   * @param micros The value.
+   * @return The bucket index.
+   */
+  static size_t bucketIndex(uint64_t micros) {
+    if (micros < (uint64_t{1} << kSubBucketBits)) {
+      return static_cast<size_t>(micros);
+    }
+    if (micros >= (uint64_t{1} << kMaxBits)) {
+      micros = (uint64_t{1} << kMaxBits) - 1;
+    }
+    int shift = 63 - __builtin_clzll(micros) - (kSubBucketBits - 1);
+    return (uint64_t{1} << kSubBucketBits) + (shift - 1) * kHalfBuckets +
+           ((micros >> shift) - kHalfBuckets);
+  }
+
+  /**
+   * @brief Gets the largest value that maps to a bucket.
+   * @param index The bucket index.
+   * @return The value in microseconds.
+   */
+  static uint64_t bucketValue(size_t index);
+
+  std::array<std::atomic<uint64_t>, kBuckets> counts; /**< Per bucket */
+  std::atomic<uint64_t> total;   /**< Sum of all samples */
+  std::atomic<uint64_t> largest; /**< Largest sample */
+};
+
+/**
+ * @class ScopedTimer
+ * @brief Records the time from construction to stop() or destruction.
+ *
+ * A null histogram turns the timer into a no-op that never reads the clock,
+ * so instrumented code costs nothing while metrics are off.
+ */
+class ScopedTimer {
+ public:
+  /**
+   * @brief Starts timing.
+   * @param histogram Receives the elapsed time; may be null.
+   */
+  explicit ScopedTimer(LatencyHistogram* histogram) : histogram(histogram) {
+    if (histogram != nullptr) {
+      start = std::chrono::steady_clock::now();
+    }
+  }
+
+  /**
+   * @brief Records the elapsed time unless stop() already did.
+   */
+  ~ScopedTimer() { stop(); }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  /**
+   * @brief Records the elapsed time now; later calls do nothing.
+   */
+  void stop() {
+    if (histogram != nullptr) {
+      histogram->record(static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count()));
+      histogram = nullptr;
+    }
+  }
+
+ private:
+  LatencyHistogram* histogram; /**< Target, or null once recorded */
+  std::chrono::steady_clock::time_point start; /**< Construction time */
+};
+
+/**
+ * @struct LayerTiming
+ * @brief Forward time of one network layer.
+ */
+struct LayerTiming {
+  std::string name; /**< Layer name as reported by the network */
+  double ms = 0;    /**< Time spent in the layer */
+};
+
+/**
+ * @struct StageSnapshot
+ * @brief Latency and throughput of one stage.
+ */
+struct StageSnapshot {
+  std::string name;       /**< Stage name, e.g. "inference" */
+  LatencySummary latency; /**< Latency percentiles since start */
+  double fps = 0;         /**< Completions per second, last interval */
+};
+
+/**
+ * @struct Snapshot
+ * @brief Everything a Registry knows at one instant.
+ */
+struct Snapshot {
+  std::vector<StageSnapshot> stages; /**< Stages, sorted by name */
+  /**< Per-layer times of the last sampled forward pass, in network order */
+  std::vector<LayerTiming> layers;
+};
+
+/**
+ * @class Registry
+ * @brief Owns the latency histogram of every named stage.
+ *
+ * Stages are created on first use and live as long as the registry, so
+ * callers look a stage up once and keep the reference. Recording never
+ * takes the registry's lock; only creating stages and reading do.
+ */
+class Registry {
+ public:
+  /**
+   * @brief Creates an empty registry.
+   * @param rateWindowSeconds Shortest interval an FPS figure is measured
+   * over; reads closer together than this repeat the last figure.
+   */
+  explicit Registry(double rateWindowSeconds = 1.0);
+
+  /**
+   * @brief Gets a stage's histogram, creating it if needed.
+   * @param name The stage name.
+   * @return The histogram, valid for the registry's lifetime.
+   */
+  LatencyHistogram& stage(const std::string& name);
+
+  /**
+   * @brief Replaces the per-layer timings.
+   * @param layers Times of one forward pass, in network order.
+   */
+  void setLayerTimings(std::vector<LayerTiming> layers);
+
+  /**
+   * @brief Reads every stage and the layer timings.
+   * @return The current values.
+   */
+  Snapshot snapshot();
+
+ private:
+  /**
+   * @struct Stage
+   * @brief A stage's histogram and the state of its FPS meter.
+   */
+  struct Stage {
+    LatencyHistogram latency; /**< Samples of the stage */
+    /**< Start of the current FPS interval */
+    std::chrono::steady_clock::time_point rateStart;
+    uint64_t rateCount = 0;   /**< Sample count at rateStart */
+    double fps = 0;           /**< Rate over the last full interval */
+  };
+
+  double rateWindow; /**< Shortest FPS interval, in seconds */
+  std::mutex mutex;  /**< Guards the members below */
+  std::map<std::string, std::unique_ptr<Stage>> stages; /**< By name */
+  std::vector<LayerTiming> layers; /**< Last sampled layer times */
+};
+
+/**
+ * @brief Formats a snapshot in the Prometheus text exposition format.
+ *
+ * Stage latencies become a summary (quantiles 0.5, 0.9 and 0.99 plus _sum
+ * and _count) with max and FPS gauges beside it; layer times become a
+ * gauge labelled by layer.
+ *
+ * @param snapshot The values to format.
+ * @return The exposition text.
+ */
+std::string toPrometheusText(const Snapshot& snapshot);
+
+/**
+ * @brief Formats a snapshot as a table for the console.
+ * @param snapshot The values to format.
+ * @param topLayers Number of slowest layers listed; 0 lists none.
+ * @return One line per stage, then the slowest layers.
+ */
+std::string toTable(const Snapshot& snapshot, size_t topLayers = 10);
+
+}  // namespace Metrics
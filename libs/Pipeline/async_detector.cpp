@@ -0,0 +1,240 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "async_detector.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include "thread_affinity.hpp"
+
+namespace Pipeline {
+
+/**
+ * @brief Starts the workers and waits until each has loaded its
+ * detector.
+ * @param factory Creates one detector per worker.
+ * @param config Tunables.
+ * @throws The first error a worker's factory threw; the workers are
+ * stopped by then.
+ */
+AsyncDetector::AsyncDetector(DetectorFactory factory,
+                             const AsyncConfig& config)
+    : config(config), running(0), stopping(false) {
+  this->config.workers = std::max<size_t>(1, config.workers);
+  // A slot per worker at least, or workers would idle behind the limit
+  this->config.maxInFlight =
+      std::max(this->config.workers, config.maxInFlight);
+
+  // Each worker loads its own detector once pinned; waiting for all of
+  // them still makes a bad model fail here rather than inside a worker
+  detectors.resize(this->config.workers);
+  std::vector<std::promise<void>> loaded(detectors.size());
+  std::vector<std::future<void>> ready;
+  for (size_t i = 0; i < detectors.size(); ++i) {
+    const int cpu = this->config.cpus.empty()
+                        ? -1
+                        : this->config.cpus[i % this->config.cpus.size()];
+    ready.push_back(loaded[i].get_future());
+    workers.emplace_back(&AsyncDetector::workerLoop, this, std::cref(factory),
+                         i, cpu, std::ref(loaded[i]));
+  }
+  std::exception_ptr error;
+  for (std::future<void>& worker : ready) {
+    try {
+      worker.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    stop();
+    std::rethrow_exception(error);
+  }
+}
+
+/**
+ * @brief Stops the workers; see stop().
+ */
+AsyncDetector::~AsyncDetector() { stop(); }
+
+/**
+ * @brief Queues a frame with the configured default deadline.
+ * @param frame The BGR frame. It is shared, not copied: do not write to
+ * it, e.g. by reading the next capture into it, until the future is
+ * ready.
+ * @return The frame's detections, or FrameDropped.
+ */
+std::future<Detector::Detections> AsyncDetector::submit(
+    const cv::Mat& frame) {
+  return submit(frame, config.deadline.count() > 0
+                           ? Clock::now() + config.deadline
+                           : Clock::time_point::max());
+}
+
+/**
+ * @brief Queues a frame that must reach a worker by a deadline.
+ * @param frame The BGR frame; shared, see submit(const cv::Mat&).
+ * @param deadline Latest time a worker may start on it.
+ * @return The frame's detections, or FrameDropped.
+ */
+std::future<Detector::Detections> AsyncDetector::submit(
+    const cv::Mat& frame, Clock::time_point deadline) {
+  Request request;
+  request.frame = frame;
+  request.deadline = deadline;
+  std::future<Detector::Detections> result = request.promise.get_future();
+
+  // Promises are failed outside the lock; a continuation may submit again
+  std::promise<Detector::Detections> evicted;
+  bool hasEvicted = false;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ++counters.submitted;
+    if (config.overflowPolicy == OverflowPolicy::kBlock) {
+      wake.wait(lock, [this]() {
+        return stopping || queue.size() + running < config.maxInFlight;
+      });
+    } else if (queue.size() + running >= config.maxInFlight) {
+      ++counters.dropped;
+      if (queue.empty()) {
+        // Every slot is running; the new frame is the one to give up
+        lock.unlock();
+        request.promise.set_exception(std::make_exception_ptr(
+            FrameDropped("all in-flight requests are running")));
+        return result;
+      }
+      evicted = std::move(queue.front().promise);
+      queue.pop_front();
+      hasEvicted = true;
+    }
+    if (stopping) {
+      lock.unlock();
+      request.promise.set_exception(
+          std::make_exception_ptr(FrameDropped("detector stopped")));
+      return result;
+    }
+    queue.push_back(std::move(request));
+  }
+  wake.notify_all();
+  if (hasEvicted) {
+    evicted.set_exception(
+        std::make_exception_ptr(FrameDropped("replaced by a newer frame")));
+  }
+  return result;
+}
+
+/**
+ * @brief Gets the number of requests submitted but not finished.
+ * @return Waiting plus running requests.
+ */
+size_t AsyncDetector::inFlight() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return queue.size() + running;
+}
+
+/**
+ * @brief Gets the counters.
+ * @return The statistics.
+ */
+AsyncStats AsyncDetector::stats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return counters;
+}
+
+/**
+ * @brief Drops every waiting request and joins the workers once the
+ * running ones finish. Later submissions are dropped at once.
+ */
+void AsyncDetector::stop() {
+  std::deque<Request> abandoned;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) {
+      return;
+    }
+    stopping = true;
+    abandoned.swap(queue);
+  }
+  wake.notify_all();
+  for (Request& request : abandoned) {
+    request.promise.set_exception(
+        std::make_exception_ptr(FrameDropped("detector stopped")));
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+/**
+ * @brief Worker loop: pins the thread, loads the worker's detector and
+ * detects requests until stopped.
+ * @param factory Creates the worker's detector.
+ * @param index The worker's slot in detectors.
+ * @param cpu CPU to pin the thread to, or -1.
+ * @param loaded Set once the detector is loaded, or to the error.
+ */
+void AsyncDetector::workerLoop(const DetectorFactory& factory, size_t index,
+                               int cpu, std::promise<void>& loaded) {
+  if (cpu >= 0) {
+    Detector::pinCurrentThread(cpu);
+  }
+  // Loaded after pinning so the network is first touched, and therefore
+  // allocated, on this CPU's NUMA node
+  try {
+    detectors[index] = factory();
+  } catch (...) {
+    loaded.set_exception(std::current_exception());
+    return;
+  }
+  loaded.set_value();
+  Detector::YOLODetector& detector = *detectors[index];
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+      if (stopping) {
+        return;
+      }
+      request = std::move(queue.front());
+      queue.pop_front();
+      if (Clock::now() > request.deadline) {
+        ++counters.expired;
+        lock.unlock();
+        wake.notify_all();  // A blocked submit() may take the slot
+        request.promise.set_exception(
+            std::make_exception_ptr(FrameDropped("deadline passed")));
+        continue;
+      }
+      ++running;
+    }
+
+    Detector::Detections detections;
+    std::exception_ptr error;
+    try {
+      detections = detector.detect(request.frame);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    // Counters first, so they are current once the future is ready
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --running;
+      if (error) {
+        ++counters.failed;
+      } else {
+        ++counters.completed;
+      }
+    }
+    wake.notify_all();
+    if (error) {
+      request.promise.set_exception(error);
+    } else {
+      request.promise.set_value(std::move(detections));
+    }
+  }
+}
+
+}  // namespace Pipeline
@@ -0,0 +1,192 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file async_detector.hpp
+ * @brief Header file for non-blocking detection through a pool of
+ * inference workers.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "detector.hpp"
+#include "ring_buffer.hpp"
+
+namespace Pipeline {
+
+/**
+ * @class FrameDropped
+ * @brief Error a future holds when its frame was never detected, because
+ * its deadline passed, a newer frame took its slot or the detector stopped.
+ */
+class FrameDropped : public std::runtime_error {
+ public:
+  /**
+   * @brief Constructs the error.
+   * @param reason Why the frame was dropped.
+   */
+  explicit FrameDropped(const std::string& reason)
+      : std::runtime_error("Frame dropped: " + reason) {}
+};
+
+/**
+ * @struct AsyncConfig
+ * @brief Tunables for the asynchronous detector.
+ */
+struct AsyncConfig {
+  size_t workers = 2; /**< Inference workers, each with its own network */
+  /**< Requests submitted but not finished, running ones included */
+  size_t maxInFlight = 4;
+  /**< What submit() does when maxInFlight requests are pending: drop the
+   * oldest waiting request (or the new one if every request is running),
+   * or wait for a slot */
+  OverflowPolicy overflowPolicy = OverflowPolicy::kDropOldest;
+  /**< Default time a request may wait for a worker; 0 = no deadline */
+  std::chrono::milliseconds deadline{0};
+  /**< CPUs the workers are pinned to, worker i to cpus[i % size]; empty
+   * leaves them to the scheduler (see Detector::pinningCpus()) */
+  std::vector<int> cpus;
+};
+
+/**
+ * @struct AsyncStats
+ * @brief Snapshot of the asynchronous detector counters.
+ */
+struct AsyncStats {
+  uint64_t submitted = 0; /**< Requests submitted */
+  uint64_t completed = 0; /**< Requests detected */
+  uint64_t expired = 0;   /**< Requests whose deadline passed in the queue */
+  uint64_t dropped = 0;   /**< Requests evicted for a newer frame */
+  uint64_t failed = 0;    /**< Requests whose detection threw */
+};
+
+/**
+ * @class AsyncDetector
+ * @brief Detects frames on worker threads and hands the results back as
+ * futures, so the caller never waits for a forward pass.
+ *
+ * Each worker owns a detector, and so a network, of its own; OpenCV DNN
+ * nets are not safe to share between threads. Requests wait in one queue
+ * in submission order. A request whose deadline has passed when a worker
+ * takes it is not detected, and its future throws FrameDropped.
+ */
+class AsyncDetector {
+ public:
+  /**
+   * @brief Creates the detector of one worker.
+   *
+   * Called once on each worker thread, after the thread is pinned, so the
+   * network is allocated next to the CPU that runs it. Workers call it at
+   * the same time.
+   */
+  using DetectorFactory =
+      std::function<std::unique_ptr<Detector::YOLODetector>()>;
+
+  /**
+   * @brief Clock the deadlines are measured on.
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Starts the workers and waits until each has loaded its
+   * detector.
+   * @param factory Creates one detector per worker.
+   * @param config Tunables.
+   * @throws The first error a worker's factory threw; the workers are
+   * stopped by then.
+   */
+  explicit AsyncDetector(DetectorFactory factory,
+                         const AsyncConfig& config = AsyncConfig());
+
+  /**
+   * @brief Stops the workers; see stop().
+   */
+  ~AsyncDetector();
+
+  AsyncDetector(const AsyncDetector&) = delete;
+  AsyncDetector& operator=(const AsyncDetector&) = delete;
+
+  /**
+   * @brief Queues a frame with the configured default deadline.
+   * @param frame The BGR frame. It is shared, not copied: do not write to
+   * it, e.g. by reading the next capture into it, until the future is
+   * ready.
+   * @return The frame's detections, or FrameDropped.
+   */
+  std::future<Detector::Detections> submit(const cv::Mat& frame);
+
+  /**
+   * @brief Queues a frame that must reach a worker by a deadline.
+   * @param frame The BGR frame; shared, see submit(const cv::Mat&).
+   * @param deadline Latest time a worker may start on it.
+   * @return The frame's detections, or FrameDropped.
+   */
+  std::future<Detector::Detections> submit(const cv::Mat& frame,
+                                           Clock::time_point deadline);
+
+  /**
+   * @brief Gets the number of requests submitted but not finished.
+   * @return Waiting plus running requests.
+   */
+  size_t inFlight() const;
+
+  /**
+   * @brief Gets the counters.
+   * @return The statistics.
+   */
+  AsyncStats stats() const;
+
+  /**
+   * @brief Drops every waiting request and joins the workers once the
+   * running ones finish. Later submissions are dropped at once.
+   */
+  void stop();
+
+ private:
+  /**
+   * @struct Request
+   * @brief One frame waiting for a worker.
+   */
+  struct Request {
+    cv::Mat frame;                 /**< Frame to detect */
+    Clock::time_point deadline;    /**< Latest start; max() = none */
+    /**< Receives the detections or the error */
+    std::promise<Detector::Detections> promise;
+  };
+
+  /**
+   * @brief Worker loop: pins the thread, loads the worker's detector and
+   * detects requests until stopped.
+   * @param factory Creates the worker's detector.
+   * @param index The worker's slot in detectors.
+   * @param cpu CPU to pin the thread to, or -1.
+   * @param loaded Set once the detector is loaded, or to the error.
+   */
+  void workerLoop(const DetectorFactory& factory, size_t index, int cpu,
+                  std::promise<void>& loaded);
+
+  AsyncConfig config; /**< Tunables */
+  /**< One detector per worker, loaded on its own thread */
+  std::vector<std::unique_ptr<Detector::YOLODetector>> detectors;
+  std::vector<std::thread> workers; /**< Inference threads */
+  mutable std::mutex mutex;         /**< Guards the members below */
+  std::condition_variable wake;     /**< Signals requests and free slots */
+  std::deque<Request> queue;        /**< Requests waiting for a worker */
+  size_t running;                   /**< Requests being detected */
+  bool stopping;                    /**< Set by stop() */
+  AsyncStats counters;              /**< Statistics */
+};
+
+}  // namespace Pipeline
@@ -0,0 +1,360 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <functional>
+#include <memory>
+#ifndef ACME_HEADLESS
+#include <opencv2/highgui.hpp>
+#endif
+
+#include "detection_log.hpp"
+
+namespace Pipeline {
+
+/**
+ * @brief Feeds a frame's detections to a tracker.
+ * @param tracker The tracker to update.
+ * @param detections The frame's detections.
+ * @return The confirmed tracks after the update.
+ */
+std::vector<Tracker::Track> trackDetections(
+    Tracker::MultiTracker& tracker, const Detector::Detections& detections) {
+  std::vector<cv::Rect2f> boxes;
+  boxes.reserve(detections.size());
+  for (const Detector::Detection& detection : detections) {
+    boxes.emplace_back(detection.box);
+  }
+  tracker.update(boxes);
+  return tracker.getConfirmedTracks();
+}
+
+#ifndef ACME_HEADLESS
+/**
+ * @brief Labels each confirmed track with its ID.
+ * @param frame The frame to annotate.
+ * @param tracks The confirmed tracks.
+ * @param drawBoxes Also outline the track boxes, for frames without
+ * detections.
+ */
+void drawTracks(const cv::Mat& frame,
+                const std::vector<Tracker::Track>& tracks,
+                bool drawBoxes) {
+  for (const Tracker::Track& track : tracks) {
+    if (drawBoxes) {
+      cv::rectangle(frame, cv::Rect(track.box), cv::Scalar(50, 178, 255), 2);
+    }
+    cv::Point anchor(cvRound(track.box.x),
+                     cvRound(track.box.y + track.box.height) - 5);
+    cv::putText(frame, "ID " + std::to_string(track.id), anchor,
+                cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(50, 178, 255), 2);
+  }
+}
+#endif
+
+/**
+ * @brief Opens a video source given on the command line.
+ * @param source A camera index ("0"), a video file path or a stream URL.
+ * @return The capture; check isOpened() for failure.
+ */
+cv::VideoCapture openCapture(const std::string& source) {
+  bool isIndex = !source.empty() &&
+                 std::all_of(source.begin(), source.end(), [](char c) {
+                   return std::isdigit(static_cast<unsigned char>(c)) != 0;
+                 });
+  if (isIndex) {
+    return cv::VideoCapture(std::stoi(source));
+  }
+  return cv::VideoCapture(source);
+}
+
+/**
+ * @brief Constructs a pipeline around an initialized detector.
+ * @param detector Detector used by the preprocessing, inference and
+ * postprocessing stages. Must outlive the pipeline.
+ * @param config Pipeline tunables.
+ */
+DetectionPipeline::DetectionPipeline(Detector::YOLODetector& detector,
+                                     const PipelineConfig& config)
+    : detector(detector),
+      config(config),
+      tracker(config.tracker),
+      resolution(config.resolution, detector.getInputSize()),
+      inputSide(0),
+      // Room for every frame and output head the queues can hold at once
+      framePool(8 * (config.queueCapacity + 1)),
+      running(false) {
+  for (auto& queue : queues) {
+    queue.reset(new RingBuffer<FramePacket>(config.queueCapacity));
+  }
+  for (auto& count : dropped) {
+    count.store(0);
+  }
+  for (auto& count : processed) {
+    count.store(0);
+  }
+}
+
+/**
+ * @brief Stops the workers if the pipeline is still running.
+ */
+DetectionPipeline::~DetectionPipeline() {
+  stop();
+  for (auto& worker : workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+/**
+ * @brief Runs the pipeline on a capture device until it ends or 'q' is
+ * pressed.
+ * @param cap An opened video capture. Owned by the capture thread until
+ * run() returns.
+ * @return The number of frames rendered.
+ */
+uint64_t DetectionPipeline::run(cv::VideoCapture& cap) {
+  if (!cap.isOpened()) {
+    std::cerr << "Error opening video stream or file" << std::endl;
+    return 0;
+  }
+
+  running.store(true);
+  workers.emplace_back(&DetectionPipeline::captureLoop, this, std::ref(cap));
+  workers.emplace_back(&DetectionPipeline::preprocessLoop, this);
+  workers.emplace_back(&DetectionPipeline::inferenceLoop, this);
+  workers.emplace_back(&DetectionPipeline::postprocessLoop, this);
+
+  // Render stage runs here so that HighGUI stays on one thread
+  std::unique_ptr<Storage::LogWriter> log;
+  if (!config.logPath.empty()) {
+    log.reset(new Storage::LogWriter(config.logPath));
+  }
+  Metrics::LatencyHistogram* renderLatency =
+      config.metrics ? &config.metrics->stage("render") : nullptr;
+  Metrics::LatencyHistogram* frameLatency =
+      config.metrics ? &config.metrics->stage("frame") : nullptr;
+  // Readers can attach before the first frame, unless the ring is sized
+  // for that frame
+  const bool publishing = !config.publish.name.empty();
+  const bool sizeForFrame =
+      config.publishFrames && config.publish.frameBytes == 0;
+  std::unique_ptr<Transport::Publisher> publisher;
+  if (publishing && !sizeForFrame) {
+    publisher.reset(new Transport::Publisher(config.publish));
+  }
+  uint64_t rendered = 0;
+  FramePacket packet;
+  while (queues[kPostprocess]->pop(packet)) {
+    if (log) {
+      log->appendFrame(packet.index, packet.timestampUs, packet.detections,
+                       packet.tracks);
+    }
+    if (publishing && !publisher) {
+      Transport::PublisherConfig publish = config.publish;
+      publish.frameBytes = packet.frame.total() * packet.frame.elemSize();
+      publisher.reset(new Transport::Publisher(publish));
+    }
+    // Readers get the results first; frames wait for the drawing
+    if (publisher && !config.publishFrames) {
+      publisher->publish(packet.index, packet.timestampUs, packet.detections,
+                         packet.tracks);
+    }
+#ifndef ACME_HEADLESS
+    if (config.display || config.publishFrames) {
+      Metrics::ScopedTimer renderTimer(renderLatency);
+      detector.render(packet.frame, packet.detections);
+      drawTracks(packet.frame, packet.tracks);
+      if (config.display) {
+        cv::imshow("YOLO Detection", packet.frame);
+      }
+    }
+#endif
+    if (publisher && config.publishFrames) {
+      publisher->publish(packet.index, packet.timestampUs, packet.detections,
+                         packet.tracks, packet.frame);
+    }
+    if (frameLatency != nullptr) {
+      // Capture to display, queueing included
+      int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+      frameLatency->record(static_cast<uint64_t>(
+          std::max<int64_t>(0, now - packet.timestampUs)));
+    }
+    ++rendered;
+    processed[kRender].fetch_add(1, std::memory_order_relaxed);
+
+    if (config.maxFrames > 0 && rendered >= config.maxFrames) {
+      break;
+    }
+#ifndef ACME_HEADLESS
+    if (config.display && cv::waitKey(1) == 113) {  // Press 'q' to exit
+      break;
+    }
+#endif
+  }
+
+  stop();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+  if (log) {
+    log->close();
+  }
+#ifndef ACME_HEADLESS
+  if (config.display) {
+    cv::destroyAllWindows();
+  }
+#endif
+  return rendered;
+}
+
+/**
+ * @brief Requests all stages to stop after their current frame.
+ */
+void DetectionPipeline::stop() {
+  running.store(false);
+  closeQueues();
+}
+
+/**
+ * @brief Gets a snapshot of the queue depths and per-stage counters.
+ * @return The current pipeline statistics.
+ */
+PipelineStats DetectionPipeline::stats() const {
+  PipelineStats snapshot;
+  for (size_t i = 0; i < queues.size(); ++i) {
+    snapshot.queueDepth[i] = queues[i]->size();
+    snapshot.dropped[i] = dropped[i].load(std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < processed.size(); ++i) {
+    snapshot.processed[i] = processed[i].load(std::memory_order_relaxed);
+  }
+  snapshot.inputSide = inputSide.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+/**
+ * @brief Capture stage: reads frames from the device.
+ * @param cap The opened video capture.
+ */
+void DetectionPipeline::captureLoop(cv::VideoCapture& cap) {
+  uint64_t index = 0;
+  Metrics::LatencyHistogram* captureLatency =
+      config.metrics ? &config.metrics->stage("capture") : nullptr;
+  while (running.load()) {
+    FramePacket packet;
+    packet.frame = framePool.acquire();
+    Metrics::ScopedTimer captureTimer(captureLatency);
+    if (!cap.read(packet.frame) || packet.frame.empty()) {
+      std::cerr << "Failed to load frame!" << std::endl;
+      break;
+    }
+    captureTimer.stop();
+    packet.index = index++;
+    packet.timestampUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    processed[kCapture].fetch_add(1, std::memory_order_relaxed);
+    forward(kCapture, std::move(packet));
+  }
+  // End of stream: let downstream stages drain and exit
+  queues[kCapture]->close();
+}
+
+/**
+ * @brief Preprocessing stage: converts frames to input blobs.
+ */
+void DetectionPipeline::preprocessLoop() {
+  FramePacket packet;
+  while (queues[kCapture]->pop(packet)) {
+    int side = inputSide.load(std::memory_order_relaxed);
+    if (side > 0 && side != detector.getInputSize().width) {
+      detector.setInputSize(cv::Size(side, side));
+    }
+    packet.blob = detector.preprocess(packet.frame, &packet.transform);
+    processed[kPreprocess].fetch_add(1, std::memory_order_relaxed);
+    forward(kPreprocess, std::move(packet));
+  }
+  queues[kPreprocess]->close();
+}
+
+/**
+ * @brief Inference stage: runs the network forward pass.
+ */
+void DetectionPipeline::inferenceLoop() {
+  FramePacket packet;
+  while (queues[kPreprocess]->pop(packet)) {
+    auto start = std::chrono::steady_clock::now();
+    packet.output = detector.infer(packet.blob);
+    if (config.resolution.budgetMs > 0) {
+      double latency = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      inputSide.store(resolution.update(latency).width,
+                      std::memory_order_relaxed);
+    }
+    // Outputs may alias the network's internal buffers, which the next
+    // forward pass overwrites while postprocessing still reads them. The
+    // copies come from the pool, like the frames.
+    for (auto& out : packet.output) {
+      cv::Mat copy = framePool.acquire();
+      out.copyTo(copy);
+      out = copy;
+    }
+    // Hands the blob back to the preprocessor's pool
+    packet.blob.release();
+    processed[kInference].fetch_add(1, std::memory_order_relaxed);
+    forward(kInference, std::move(packet));
+  }
+  queues[kInference]->close();
+}
+
+/**
+ * @brief Postprocessing stage: decodes detections and updates the tracks.
+ */
+void DetectionPipeline::postprocessLoop() {
+  FramePacket packet;
+  while (queues[kInference]->pop(packet)) {
+    // The input size may have changed since this frame was preprocessed
+    packet.detections = detector.postprocess(packet.transform, packet.output);
+    if (config.track) {
+      packet.tracks = trackDetections(tracker, packet.detections);
+    }
+    packet.output.clear();
+    processed[kPostprocess].fetch_add(1, std::memory_order_relaxed);
+    forward(kPostprocess, std::move(packet));
+  }
+  queues[kPostprocess]->close();
+}
+
+/**
+ * @brief Pushes a packet into a queue and records any evictions.
+ * @param queue Index of the queue to push into.
+ * @param packet The packet to push.
+ */
+void DetectionPipeline::forward(size_t queue, FramePacket packet) {
+  size_t evicted =
+      queues[queue]->push(std::move(packet), config.overflowPolicy);
+  if (evicted > 0) {
+    dropped[queue].fetch_add(evicted, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Closes every queue so blocked stages return.
+ */
+void DetectionPipeline::closeQueues() {
+  for (auto& queue : queues) {
+    queue->close();
+  }
+}
+
+}  // namespace Pipeline
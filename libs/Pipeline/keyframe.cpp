@@ -0,0 +1,164 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "keyframe.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <opencv2/imgproc.hpp>
+#ifndef ACME_HEADLESS
+#include <opencv2/highgui.hpp>
+#endif
+
+namespace Pipeline {
+
+/**
+ * @brief Constructs a scheduler.
+ * @param config Keyframe tunables.
+ */
+KeyframeScheduler::KeyframeScheduler(const KeyframeConfig& config)
+    : config(config), sinceKeyframe(0) {}
+
+/**
+ * @brief Decides whether a frame is a keyframe and records why.
+ * @param frame The new BGR frame.
+ * @param uncertainty Largest position variance among confirmed tracks.
+ * @return The trigger, or kSkipped if the detector should not run.
+ */
+KeyframeTrigger KeyframeScheduler::decide(const cv::Mat& frame,
+                                          float uncertainty) {
+  ++counters.frames;
+  ++sinceKeyframe;
+
+  KeyframeTrigger trigger = kSkipped;
+  float motion = measureMotion(frame);
+  if (keyThumbnail.empty()) {
+    trigger = kFirstFrame;
+  } else if (sinceKeyframe >= config.interval) {
+    trigger = kInterval;
+  } else if (uncertainty > config.maxUncertainty) {
+    trigger = kUncertainty;
+  } else if (config.motionThreshold > 0 && motion > config.motionThreshold) {
+    trigger = kMotion;
+  }
+
+  ++counters.triggers[trigger];
+  if (trigger != kSkipped) {
+    sinceKeyframe = 0;
+    cv::swap(thumbnail, keyThumbnail);
+  }
+  return trigger;
+}
+
+/**
+ * @brief Forgets the last keyframe so the next frame runs the detector.
+ */
+void KeyframeScheduler::reset() {
+  keyThumbnail.release();
+  sinceKeyframe = 0;
+}
+
+/**
+ * @brief Computes the mean absolute change from the last keyframe.
+ * @param frame The new BGR frame.
+ * @return The mean gray-level change, or 0 without a reference.
+ */
+float KeyframeScheduler::measureMotion(const cv::Mat& frame) {
+  if (config.motionThreshold <= 0 || frame.empty()) {
+    // Keep a placeholder so the first-frame check still works
+    thumbnail.create(1, 1, CV_8U);
+    return 0.f;
+  }
+  int width = std::min(config.motionWidth, frame.cols);
+  int height = std::max(1, frame.rows * width / frame.cols);
+  cv::resize(frame, resized, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+  if (resized.channels() == 3) {
+    cv::cvtColor(resized, thumbnail, cv::COLOR_BGR2GRAY);
+  } else {
+    resized.copyTo(thumbnail);
+  }
+  if (keyThumbnail.size() != thumbnail.size()) {
+    return 0.f;
+  }
+  return static_cast<float>(cv::norm(thumbnail, keyThumbnail, cv::NORM_L1) /
+                            thumbnail.total());
+}
+
+/**
+ * @brief Constructs an adaptive detector around an initialized detector.
+ * @param detector Detector run on keyframes. Must outlive this object.
+ * @param config Keyframe tunables.
+ * @param trackerConfig Association and lifecycle tunables.
+ */
+AdaptiveDetector::AdaptiveDetector(
+    Detector::YOLODetector& detector, const KeyframeConfig& config,
+    const Tracker::MultiTrackerConfig& trackerConfig)
+    : detector(detector),
+      scheduler(config),
+      tracker(trackerConfig),
+      correlator(config.correlation),
+      reanchor(config.reanchor) {}
+
+/**
+ * @brief Processes one frame.
+ * @param packet Holds the frame; receives the detections (keyframes only)
+ * and the confirmed tracks.
+ * @return Why the detector ran, or kSkipped.
+ */
+KeyframeTrigger AdaptiveDetector::process(FramePacket& packet) {
+  KeyframeTrigger trigger =
+      scheduler.decide(packet.frame, tracker.getMaxUncertainty());
+  if (trigger == kSkipped) {
+    packet.detections.clear();
+    tracker.predict();
+    if (reanchor) {
+      tracker.reanchor(correlator.locate(packet.frame, tracker));
+    }
+    packet.tracks = tracker.getConfirmedTracks();
+  } else {
+    packet.detections = detector.detect(packet.frame);
+    packet.tracks = trackDetections(tracker, packet.detections);
+    if (reanchor) {
+      correlator.learn(packet.frame, tracker.getTracks());
+    }
+  }
+  return trigger;
+}
+
+/**
+ * @brief Runs on a capture device until it ends or 'q' is pressed.
+ * @param cap An opened video capture.
+ * @param maxFrames Stop after this many frames; 0 runs until the end.
+ * @return The number of frames processed.
+ */
+uint64_t AdaptiveDetector::run(cv::VideoCapture& cap, uint64_t maxFrames) {
+  if (!cap.isOpened()) {
+    std::cerr << "Error opening video stream or file" << std::endl;
+    return 0;
+  }
+
+  uint64_t count = 0;
+  FramePacket packet;
+  while (cap.read(packet.frame) && !packet.frame.empty()) {
+    packet.index = count;
+    process(packet);
+#ifndef ACME_HEADLESS
+    detector.render(packet.frame, packet.detections);
+    drawTracks(packet.frame, packet.tracks, packet.detections.empty());
+    cv::imshow("YOLO Detection", packet.frame);
+#endif
+    ++count;
+    if (maxFrames > 0 && count >= maxFrames) {
+      break;
+    }
+#ifndef ACME_HEADLESS
+    if (cv::waitKey(1) == 113) {  // Press 'q' to exit
+      break;
+    }
+#endif
+  }
+#ifndef ACME_HEADLESS
+  cv::destroyAllWindows();
+#endif
+  return count;
+}
+
+}  // namespace Pipeline
@@ -0,0 +1,192 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file keyframe.hpp
+ * @brief Header file for skip-frame detection: a keyframe scheduler and a
+ * runner that fills the frames in between from the tracker's predictions.
+ */
+
+#include <array>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "correlation.hpp"
+#include "detector.hpp"
+#include "multi_tracker.hpp"
+#include "pipeline.hpp"
+
+namespace Pipeline {
+
+/**
+ * @enum KeyframeTrigger
+ * @brief Reason a frame was, or was not, sent through the network.
+ */
+enum KeyframeTrigger {
+  kSkipped,      /**< Not a keyframe; boxes come from the tracker */
+  kFirstFrame,   /**< Nothing is tracked yet */
+  kInterval,     /**< K frames have passed since the last keyframe */
+  kUncertainty,  /**< A confirmed track's position variance is too large */
+  kMotion,       /**< The scene changed too much since the last keyframe */
+  kTriggerCount  /**< Number of triggers, not a trigger */
+};
+
+/**
+ * @struct KeyframeConfig
+ * @brief Tunables for choosing which frames run the full detector.
+ */
+struct KeyframeConfig {
+  int interval = 5; /**< Run the detector at least every K frames */
+  /**< Position variance (px^2) of a confirmed track that forces detection */
+  float maxUncertainty = 2.f;
+  /**< Mean absolute gray-level change since the last keyframe that forces
+   * detection; 0 disables the motion trigger */
+  float motionThreshold = 6.f;
+  /**< Width of the thumbnail the motion measure is computed on */
+  int motionWidth = 64;
+  /**< Re-anchor tracks on skipped frames by correlating their appearance;
+   * false leaves them on the Kalman prediction */
+  bool reanchor = true;
+  Tracker::CorrelationConfig correlation; /**< Appearance search tunables */
+};
+
+/**
+ * @struct KeyframeStats
+ * @brief Counters describing how often and why the detector ran.
+ */
+struct KeyframeStats {
+  uint64_t frames = 0; /**< Frames seen */
+  /**< Frames per trigger; [kSkipped] counts the skipped frames */
+  std::array<uint64_t, kTriggerCount> triggers{};
+
+  /**
+   * @brief Gets the number of frames that ran the detector.
+   * @return The keyframe count.
+   */
+  uint64_t keyframes() const { return frames - triggers[kSkipped]; }
+
+  /**
+   * @brief Gets the ratio of frames to keyframes, i.e. the inference saving.
+   * @return Frames per detector run, or 0 before the first frame.
+   */
+  double savings() const {
+    return keyframes() == 0 ? 0.0
+                            : static_cast<double>(frames) / keyframes();
+  }
+};
+
+/**
+ * @class KeyframeScheduler
+ * @brief Decides per frame whether to run the full detector.
+ *
+ * A frame becomes a keyframe when K frames have passed, when the tracker is
+ * no longer sure enough of a confirmed target, or when a small grayscale
+ * thumbnail differs from the last keyframe's by more than a threshold.
+ */
+class KeyframeScheduler {
+ public:
+  /**
+   * @brief Constructs a scheduler.
+   * @param config Keyframe tunables.
+   */
+  explicit KeyframeScheduler(const KeyframeConfig& config = KeyframeConfig());
+
+  /**
+   * @brief Decides whether a frame is a keyframe and records why.
+   * @param frame The new BGR frame.
+   * @param uncertainty Largest position variance among confirmed tracks.
+   * @return The trigger, or kSkipped if the detector should not run.
+   */
+  KeyframeTrigger decide(const cv::Mat& frame, float uncertainty);
+
+  /**
+   * @brief Gets the counters.
+   * @return The scheduling statistics.
+   */
+  const KeyframeStats& stats() const { return counters; }
+
+  /**
+   * @brief Forgets the last keyframe so the next frame runs the detector.
+   */
+  void reset();
+
+ private:
+  /**
+   * @brief Computes the mean absolute change from the last keyframe.
+   * @param frame The new BGR frame.
+   * @return The mean gray-level change, or 0 without a reference.
+   */
+  float measureMotion(const cv::Mat& frame);
+
+  KeyframeConfig config;   /**< Keyframe tunables */
+  KeyframeStats counters;  /**< Scheduling statistics */
+  int sinceKeyframe;       /**< Frames since the last keyframe */
+  cv::Mat resized;         /**< Downscaled frame, reused across calls */
+  cv::Mat thumbnail;       /**< Gray thumbnail of the current frame */
+  cv::Mat keyThumbnail;    /**< Gray thumbnail of the last keyframe */
+};
+
+/**
+ * @class AdaptiveDetector
+ * @brief Runs the full YOLO pass on keyframes only and reports the tracker's
+ * boxes on the frames in between.
+ *
+ * Between keyframes a CorrelationTracker finds each track's keyframe
+ * appearance near its Kalman prediction and re-anchors the filter there, so
+ * boxes follow targets that turn or stop instead of coasting on their last
+ * velocity, and the uncertainty trigger fires only for targets it loses.
+ */
+class AdaptiveDetector {
+ public:
+  /**
+   * @brief Constructs an adaptive detector around an initialized detector.
+   * @param detector Detector run on keyframes. Must outlive this object.
+   * @param config Keyframe tunables.
+   * @param trackerConfig Association and lifecycle tunables.
+   */
+  AdaptiveDetector(
+      Detector::YOLODetector& detector,
+      const KeyframeConfig& config = KeyframeConfig(),
+      const Tracker::MultiTrackerConfig& trackerConfig =
+          Tracker::MultiTrackerConfig());
+
+  /**
+   * @brief Processes one frame.
+   * @param packet Holds the frame; receives the detections (keyframes only)
+   * and the confirmed tracks.
+   * @return Why the detector ran, or kSkipped.
+   */
+  KeyframeTrigger process(FramePacket& packet);
+
+  /**
+   * @brief Runs on a capture device until it ends or 'q' is pressed.
+   * @param cap An opened video capture.
+   * @param maxFrames Stop after this many frames; 0 runs until the end.
+   * @return The number of frames processed.
+   */
+  uint64_t run(cv::VideoCapture& cap, uint64_t maxFrames = 0);
+
+  /**
+   * @brief Gets the scheduling statistics.
+   * @return How often and why the detector ran.
+   */
+  const KeyframeStats& stats() const { return scheduler.stats(); }
+
+  /**
+   * @brief Gets the correlation search statistics.
+   * @return How many tracks were searched for and re-anchored.
+   */
+  const Tracker::CorrelationStats& correlationStats() const {
+    return correlator.stats();
+  }
+
+ private:
+  Detector::YOLODetector& detector; /**< Detector run on keyframes */
+  KeyframeScheduler scheduler;      /**< Keyframe decisions */
+  Tracker::MultiTracker tracker;    /**< Fills in the skipped frames */
+  Tracker::CorrelationTracker correlator; /**< Re-anchors skipped frames */
+  bool reanchor;                    /**< Use the correlator */
+};
+
+}  // namespace Pipeline
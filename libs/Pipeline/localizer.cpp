@@ -0,0 +1,103 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "localizer.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <opencv2/imgproc.hpp>
+#ifndef ACME_HEADLESS
+#include <opencv2/highgui.hpp>
+#endif
+
+namespace Pipeline {
+
+/**
+ * @brief Constructs a localizer around an initialized detector.
+ * @param detector Detector run on every frame. Must outlive this object.
+ * @param camera Calibration of the camera the frames come from.
+ * @param config Projection tunables.
+ * @param trackerConfig Tracker tunables, in meters.
+ * @throws std::runtime_error if the camera model is incomplete.
+ */
+Localizer::Localizer(Detector::YOLODetector& detector,
+                     const Projection::CameraModel& camera,
+                     const Projection::ProjectionConfig& config,
+                     const Tracker::MultiTrackerConfig& trackerConfig)
+    : detector(detector),
+      projector(camera, config),
+      tracker(trackerConfig) {}
+
+/**
+ * @brief Processes one frame.
+ * @param packet Holds the frame; receives the detections. Its pixel
+ * tracks are left empty; see groundTracks().
+ */
+void Localizer::process(FramePacket& packet) {
+  packet.detections = detector.detect(packet.frame);
+  packet.tracks.clear();
+  std::vector<cv::Rect> boxes;
+  boxes.reserve(packet.detections.size());
+  for (const Detector::Detection& detection : packet.detections) {
+    boxes.push_back(detection.box);
+  }
+  lastPositions = projector.project(boxes, packet.frame.size());
+  tracker.update(Projection::footprints(lastPositions));
+}
+
+/**
+ * @brief Runs on a capture device until it ends or 'q' is pressed.
+ * @param cap An opened video capture.
+ * @param maxFrames Stop after this many frames; 0 runs until the end.
+ * @return The number of frames processed.
+ */
+uint64_t Localizer::run(cv::VideoCapture& cap, uint64_t maxFrames) {
+  if (!cap.isOpened()) {
+    std::cerr << "Error opening video stream or file" << std::endl;
+    return 0;
+  }
+
+  uint64_t count = 0;
+  FramePacket packet;
+  while (cap.read(packet.frame) && !packet.frame.empty()) {
+    packet.index = count;
+    process(packet);
+#ifndef ACME_HEADLESS
+    detector.render(packet.frame, packet.detections);
+    char text[64];
+    for (size_t i = 0; i < lastPositions.size(); ++i) {
+      if (!lastPositions[i].valid) {
+        continue;
+      }
+      const cv::Rect& box = packet.detections[i].box;
+      std::snprintf(text, sizeof(text), "%.1f, %.1f m",
+                    lastPositions[i].point.x, lastPositions[i].point.y);
+      cv::putText(packet.frame, text, cv::Point(box.x, box.br().y + 15),
+                  cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(50, 178, 255), 1);
+    }
+    int line = 20;
+    for (const Tracker::Track& track : groundTracks()) {
+      std::snprintf(text, sizeof(text), "ID %d: x %.2f m, y %.2f m", track.id,
+                    track.box.x + 0.5f * track.box.width,
+                    track.box.y + 0.5f * track.box.height);
+      cv::putText(packet.frame, text, cv::Point(10, line),
+                  cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(50, 178, 255), 1);
+      line += 20;
+    }
+    cv::imshow("YOLO Detection", packet.frame);
+#endif
+    ++count;
+    if (maxFrames > 0 && count >= maxFrames) {
+      break;
+    }
+#ifndef ACME_HEADLESS
+    if (cv::waitKey(1) == 113) {  // Press 'q' to exit
+      break;
+    }
+#endif
+  }
+#ifndef ACME_HEADLESS
+  cv::destroyAllWindows();
+#endif
+  return count;
+}
+
+}  // namespace Pipeline
@@ -0,0 +1,88 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file localizer.hpp
+ * @brief Header file for detection with positions and tracks in the
+ * robot's metric reference frame.
+ */
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <vector>
+
+#include "detector.hpp"
+#include "multi_tracker.hpp"
+#include "pipeline.hpp"
+#include "projection.hpp"
+
+namespace Pipeline {
+
+/**
+ * @class Localizer
+ * @brief Detects people, places them on the ground in robot coordinates
+ * and tracks them there.
+ *
+ * Each frame's detections go through a GroundProjector, so the per-frame
+ * cost beyond detection is a few table lookups per person, and the tracker
+ * runs on every frame in meters rather than pixels. Its velocities are in
+ * meters per frame.
+ */
+class Localizer {
+ public:
+  /**
+   * @brief Constructs a localizer around an initialized detector.
+   * @param detector Detector run on every frame. Must outlive this object.
+   * @param camera Calibration of the camera the frames come from.
+   * @param config Projection tunables.
+   * @param trackerConfig Tracker tunables, in meters.
+   * @throws std::runtime_error if the camera model is incomplete.
+   */
+  Localizer(Detector::YOLODetector& detector,
+            const Projection::CameraModel& camera,
+            const Projection::ProjectionConfig& config =
+                Projection::ProjectionConfig(),
+            const Tracker::MultiTrackerConfig& trackerConfig =
+                Projection::metricTrackerConfig());
+
+  /**
+   * @brief Processes one frame.
+   * @param packet Holds the frame; receives the detections. Its pixel
+   * tracks are left empty; see groundTracks().
+   */
+  void process(FramePacket& packet);
+
+  /**
+   * @brief Runs on a capture device until it ends or 'q' is pressed.
+   * @param cap An opened video capture.
+   * @param maxFrames Stop after this many frames; 0 runs until the end.
+   * @return The number of frames processed.
+   */
+  uint64_t run(cv::VideoCapture& cap, uint64_t maxFrames = 0);
+
+  /**
+   * @brief Gets the positions of the last frame's detections.
+   * @return One position per detection, in order.
+   */
+  const std::vector<Projection::Position>& positions() const {
+    return lastPositions;
+  }
+
+  /**
+   * @brief Gets the confirmed tracks on the ground.
+   * @return Tracks whose box is a footprint in robot-frame (x, y) meters.
+   */
+  std::vector<Tracker::Track> groundTracks() const {
+    return tracker.getConfirmedTracks();
+  }
+
+ private:
+  Detector::YOLODetector& detector;     /**< Detector run on every frame */
+  Projection::GroundProjector projector; /**< Boxes to robot coordinates */
+  Tracker::MultiTracker tracker;        /**< Tracks in meters */
+  /**< Positions of the last frame's detections */
+  std::vector<Projection::Position> lastPositions;
+};
+
+}  // namespace Pipeline
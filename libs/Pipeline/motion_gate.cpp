@@ -0,0 +1,278 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "motion_gate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <opencv2/imgproc.hpp>
+#ifndef ACME_HEADLESS
+#include <opencv2/highgui.hpp>
+#endif
+
+namespace Pipeline {
+
+namespace {
+
+/**
+ * @brief Replaces overlapping rectangles by their union until none
+ * overlap.
+ * @param rects The rectangles, merged in place.
+ */
+void mergeOverlapping(std::vector<cv::Rect>& rects) {
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (size_t i = 0; i < rects.size() && !merged; ++i) {
+      for (size_t j = i + 1; j < rects.size(); ++j) {
+        if ((rects[i] & rects[j]).area() > 0) {
+          rects[i] |= rects[j];
+          rects.erase(rects.begin() + j);
+          merged = true;
+          break;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Grows a rectangle about its center to a minimum size, shifted to
+ * stay inside the frame.
+ * @param rect The rectangle, inside the frame.
+ * @param minSize Smallest width and height; capped by the frame size.
+ * @param frameSize Size of the frame.
+ * @return The grown rectangle.
+ */
+cv::Rect growTo(const cv::Rect& rect, const cv::Size& minSize,
+                const cv::Size& frameSize) {
+  const int width = std::max(rect.width, std::min(minSize.width,
+                                                  frameSize.width));
+  const int height = std::max(rect.height, std::min(minSize.height,
+                                                    frameSize.height));
+  const int x = rect.x - (width - rect.width) / 2;
+  const int y = rect.y - (height - rect.height) / 2;
+  return cv::Rect(std::min(std::max(x, 0), frameSize.width - width),
+                  std::min(std::max(y, 0), frameSize.height - height), width,
+                  height);
+}
+
+}  // namespace
+
+/**
+ * @brief Constructs a gate without a background.
+ * @param config Gate tunables.
+ */
+MotionGate::MotionGate(const MotionGateConfig& config) : config(config) {}
+
+/**
+ * @brief Compares a frame with the background, then blends it in.
+ * @param frame The BGR or gray frame.
+ * @return The changed regions in frame pixels, grown by regionMargin and
+ * merged where they overlap; empty if nothing changed. The first frame,
+ * or one of a new size, is reported changed as a whole.
+ */
+std::vector<cv::Rect> MotionGate::update(const cv::Mat& frame) {
+  const cv::Rect whole(cv::Point(), frame.size());
+  if (frame.empty()) {
+    return {};
+  }
+  const int width = std::max(1, std::min(config.thumbnailWidth, frame.cols));
+  const int height = std::max(1, frame.rows * width / frame.cols);
+  cv::resize(frame, resized, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+  if (resized.channels() == 3) {
+    cv::cvtColor(resized, gray, cv::COLOR_BGR2GRAY);
+  } else {
+    resized.copyTo(gray);
+  }
+  if (background.size() != gray.size()) {
+    gray.convertTo(background, CV_32F);
+    return std::vector<cv::Rect>(1, whole);
+  }
+
+  background.convertTo(reference, CV_8U);
+  cv::absdiff(gray, reference, mask);
+  cv::accumulateWeighted(gray, background, config.backgroundRate);
+  cv::threshold(mask, mask, config.pixelThreshold, 255, cv::THRESH_BINARY);
+  if (cv::countNonZero(mask) < config.minRegionPixels) {
+    return {};  // The common case on a static scene: no blob search
+  }
+
+  // Join the fragments of one moving object before labelling
+  cv::dilate(mask, mask, cv::Mat());
+  const int count =
+      cv::connectedComponentsWithStats(mask, labels, blobStats, centroids);
+  const double scaleX = static_cast<double>(frame.cols) / width;
+  const double scaleY = static_cast<double>(frame.rows) / height;
+  const int margin = config.regionMargin;
+  std::vector<cv::Rect> changed;
+  for (int i = 1; i < count; ++i) {  // Label 0 is the unchanged background
+    if (blobStats.at<int>(i, cv::CC_STAT_AREA) < config.minRegionPixels) {
+      continue;
+    }
+    const int left = blobStats.at<int>(i, cv::CC_STAT_LEFT);
+    const int top = blobStats.at<int>(i, cv::CC_STAT_TOP);
+    const int right = left + blobStats.at<int>(i, cv::CC_STAT_WIDTH);
+    const int bottom = top + blobStats.at<int>(i, cv::CC_STAT_HEIGHT);
+    const int x0 = static_cast<int>(std::floor(left * scaleX)) - margin;
+    const int y0 = static_cast<int>(std::floor(top * scaleY)) - margin;
+    const int x1 = static_cast<int>(std::ceil(right * scaleX)) + margin;
+    const int y1 = static_cast<int>(std::ceil(bottom * scaleY)) + margin;
+    changed.push_back(cv::Rect(x0, y0, x1 - x0, y1 - y0) & whole);
+  }
+  mergeOverlapping(changed);
+  return changed;
+}
+
+/**
+ * @brief Forgets the background so the next frame is changed as a whole.
+ */
+void MotionGate::reset() { background.release(); }
+
+/**
+ * @brief Constructs a gated detector around an initialized detector.
+ * @param detector Detector run on the changed regions. Must outlive this
+ * object.
+ * @param config Gate tunables.
+ * @param trackerConfig Association and lifecycle tunables.
+ */
+GatedDetector::GatedDetector(Detector::YOLODetector& detector,
+                             const MotionGateConfig& config,
+                             const Tracker::MultiTrackerConfig& trackerConfig)
+    : detector(detector),
+      config(config),
+      gate(config),
+      tracker(trackerConfig),
+      sinceFull(0) {
+  this->config.maxBatch = std::max(1, config.maxBatch);
+}
+
+/**
+ * @brief Processes one frame.
+ * @param packet Holds the frame; receives the detections, carried over
+ * from earlier frames where nothing changed, and the confirmed tracks.
+ * @return True if the network ran.
+ */
+bool GatedDetector::process(FramePacket& packet) {
+  ++counters.frames;
+  ++sinceFull;
+  regions = gate.update(packet.frame);
+  const bool refresh =
+      config.refreshInterval > 0 && sinceFull >= config.refreshInterval;
+  if (regions.empty() && !refresh) {
+    ++counters.skipped;
+    // Re-fed so tracks of people standing still are not aged out
+    packet.detections = previous;
+    packet.tracks = trackDetections(tracker, previous);
+    return false;
+  }
+
+  // A crop smaller than the input would be upscaled, which YOLO was not
+  // trained on; growing it also gives a person cut by the region context
+  const cv::Size frameSize = packet.frame.size();
+  for (cv::Rect& region : regions) {
+    region = growTo(region, detector.getInputSize(), frameSize);
+  }
+  mergeOverlapping(regions);
+  double area = 0;
+  for (const cv::Rect& region : regions) {
+    area += region.area();
+  }
+
+  if (refresh || area > config.maxRegionFraction * frameSize.area()) {
+    regions.assign(1, cv::Rect(cv::Point(), frameSize));
+    previous = detector.detect(packet.frame);
+    sinceFull = 0;
+    ++counters.fullFrames;
+  } else {
+    // Detections in a changed region are replaced by the new ones
+    Detector::Detections detections;
+    for (const Detector::Detection& detection : previous) {
+      bool stale = false;
+      for (const cv::Rect& region : regions) {
+        stale = stale || (detection.box & region).area() > 0;
+      }
+      if (!stale) {
+        detections.push_back(detection);
+      }
+    }
+    Detector::Detections found = detectRegions(packet.frame);
+    detections.insert(detections.end(), found.begin(), found.end());
+    previous.swap(detections);
+    ++counters.regionFrames;
+    counters.regions += regions.size();
+  }
+  packet.detections = previous;
+  packet.tracks = trackDetections(tracker, previous);
+  return true;
+}
+
+/**
+ * @brief Runs on a capture device until it ends or 'q' is pressed.
+ * @param cap An opened video capture.
+ * @param maxFrames Stop after this many frames; 0 runs until the end.
+ * @return The number of frames processed.
+ */
+uint64_t GatedDetector::run(cv::VideoCapture& cap, uint64_t maxFrames) {
+  if (!cap.isOpened()) {
+    std::cerr << "Error opening video stream or file" << std::endl;
+    return 0;
+  }
+
+  uint64_t count = 0;
+  FramePacket packet;
+  while (cap.read(packet.frame) && !packet.frame.empty()) {
+    packet.index = count;
+    process(packet);
+#ifndef ACME_HEADLESS
+    for (const cv::Rect& region : regions) {
+      cv::rectangle(packet.frame, region, cv::Scalar(128, 128, 128), 1);
+    }
+    detector.render(packet.frame, packet.detections);
+    drawTracks(packet.frame, packet.tracks);
+    cv::imshow("YOLO Detection", packet.frame);
+#endif
+    ++count;
+    if (maxFrames > 0 && count >= maxFrames) {
+      break;
+    }
+#ifndef ACME_HEADLESS
+    if (cv::waitKey(1) == 113) {  // Press 'q' to exit
+      break;
+    }
+#endif
+  }
+#ifndef ACME_HEADLESS
+  cv::destroyAllWindows();
+#endif
+  return count;
+}
+
+/**
+ * @brief Detects on the changed regions in batches.
+ * @param frame The BGR frame.
+ * @return The detections in frame pixels.
+ */
+Detector::Detections GatedDetector::detectRegions(const cv::Mat& frame) {
+  Detector::Detections detections;
+  const size_t maxBatch = static_cast<size_t>(config.maxBatch);
+  for (size_t begin = 0; begin < regions.size(); begin += maxBatch) {
+    const size_t end = std::min(begin + maxBatch, regions.size());
+    std::vector<cv::Mat> crops;
+    for (size_t k = begin; k < end; ++k) {
+      crops.push_back(frame(regions[k]));  // Views; letterboxing copies
+    }
+    std::vector<Detector::BoxTransform> transforms;
+    cv::Mat blob = detector.preprocessBatch(crops, &transforms);
+    for (size_t k = 0; k < transforms.size(); ++k) {
+      transforms[k].offsetX -= regions[begin + k].x;
+      transforms[k].offsetY -= regions[begin + k].y;
+    }
+    for (const Detector::Detections& crop :
+         detector.postprocessBatch(transforms, detector.infer(blob))) {
+      detections.insert(detections.end(), crop.begin(), crop.end());
+    }
+  }
+  return detections;
+}
+
+}  // namespace Pipeline
@@ -0,0 +1,185 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file motion_gate.hpp
+ * @brief Header file for motion-gated detection: a cheap frame-differencing
+ * stage that skips the network on static frames and sends it only the
+ * regions that changed.
+ */
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <vector>
+
+#include "detector.hpp"
+#include "multi_tracker.hpp"
+#include "pipeline.hpp"
+
+namespace Pipeline {
+
+/**
+ * @struct MotionGateConfig
+ * @brief Tunables for the motion gate and the gated detector.
+ */
+struct MotionGateConfig {
+  /**< Width of the grayscale thumbnail frames are compared on */
+  int thumbnailWidth = 160;
+  /**< Gray-level difference from the background that marks a thumbnail
+   * pixel as changed; sensor noise stays below it */
+  int pixelThreshold = 20;
+  /**< Changed thumbnail pixels a region needs; smaller blobs are noise */
+  int minRegionPixels = 4;
+  /**< Weight of each frame in the running-average background; a still
+   * object fades into it after a few times 1 / backgroundRate frames */
+  double backgroundRate = 0.05;
+  int regionMargin = 32; /**< Frame pixels a changed region is grown by */
+  /**< Fraction of the frame above which changed regions are not cropped
+   * and the whole frame is detected */
+  float maxRegionFraction = 0.5f;
+  /**< Frames between whole-frame detections that catch what the gate
+   * missed, e.g. a person who entered while the scene was dark; 0 = never */
+  int refreshInterval = 300;
+  int maxBatch = 4; /**< Most regions per forward pass */
+};
+
+/**
+ * @struct MotionStats
+ * @brief Counters of the gated detector.
+ */
+struct MotionStats {
+  uint64_t frames = 0;       /**< Frames seen */
+  uint64_t skipped = 0;      /**< Frames that did not run the network */
+  uint64_t regionFrames = 0; /**< Frames detected on changed regions only */
+  uint64_t fullFrames = 0;   /**< Frames detected whole */
+  uint64_t regions = 0;      /**< Regions detected on regionFrames */
+
+  /**
+   * @brief Gets the fraction of frames that skipped the network.
+   * @return skipped / frames, or 0 before the first frame.
+   */
+  double skipRatio() const {
+    return frames == 0 ? 0.0 : static_cast<double>(skipped) / frames;
+  }
+};
+
+/**
+ * @class MotionGate
+ * @brief Finds the regions of a frame that changed against a running
+ * background.
+ *
+ * Frames are shrunk to a grayscale thumbnail and compared with a running
+ * average of the previous ones through cv::absdiff, which OpenCV
+ * vectorizes. Changed pixels are grouped into connected blobs and mapped
+ * back to frame pixels. On a 1080p camera the whole test costs well under
+ * a millisecond, against hundreds for a YOLOv3 forward pass.
+ */
+class MotionGate {
+ public:
+  /**
+   * @brief Constructs a gate without a background.
+   * @param config Gate tunables.
+   */
+  explicit MotionGate(const MotionGateConfig& config = MotionGateConfig());
+
+  /**
+   * @brief Compares a frame with the background, then blends it in.
+   * @param frame The BGR or gray frame.
+   * @return The changed regions in frame pixels, grown by regionMargin and
+   * merged where they overlap; empty if nothing changed. The first frame,
+   * or one of a new size, is reported changed as a whole.
+   */
+  std::vector<cv::Rect> update(const cv::Mat& frame);
+
+  /**
+   * @brief Forgets the background so the next frame is changed as a whole.
+   */
+  void reset();
+
+ private:
+  MotionGateConfig config; /**< Gate tunables */
+  cv::Mat resized;         /**< Downscaled frame, reused across calls */
+  cv::Mat gray;            /**< Gray thumbnail of the current frame */
+  cv::Mat background;      /**< CV_32F running-average thumbnail */
+  cv::Mat reference;       /**< background as CV_8U */
+  cv::Mat mask;            /**< Changed thumbnail pixels */
+  cv::Mat labels;          /**< Blob label of each thumbnail pixel */
+  cv::Mat blobStats;       /**< Bounding box and area of each blob */
+  cv::Mat centroids;       /**< Blob centroids, unused */
+};
+
+/**
+ * @class GatedDetector
+ * @brief Runs the detector only on the parts of a frame that changed and
+ * carries the detections and tracks of static frames forward.
+ *
+ * A frame without change skips the network: the previous detections are
+ * reported again and fed to the tracker, so tracks of people standing
+ * still stay alive. A frame with change runs the network on each changed
+ * region, grown to at least the network input so it is never upscaled,
+ * and keeps the previous detections outside them. Large changes, such as
+ * the camera turning or the lights coming on, detect the whole frame.
+ */
+class GatedDetector {
+ public:
+  /**
+   * @brief Constructs a gated detector around an initialized detector.
+   * @param detector Detector run on the changed regions. Must outlive this
+   * object.
+   * @param config Gate tunables.
+   * @param trackerConfig Association and lifecycle tunables.
+   */
+  GatedDetector(Detector::YOLODetector& detector,
+                const MotionGateConfig& config = MotionGateConfig(),
+                const Tracker::MultiTrackerConfig& trackerConfig =
+                    Tracker::MultiTrackerConfig());
+
+  /**
+   * @brief Processes one frame.
+   * @param packet Holds the frame; receives the detections, carried over
+   * from earlier frames where nothing changed, and the confirmed tracks.
+   * @return True if the network ran.
+   */
+  bool process(FramePacket& packet);
+
+  /**
+   * @brief Runs on a capture device until it ends or 'q' is pressed.
+   * @param cap An opened video capture.
+   * @param maxFrames Stop after this many frames; 0 runs until the end.
+   * @return The number of frames processed.
+   */
+  uint64_t run(cv::VideoCapture& cap, uint64_t maxFrames = 0);
+
+  /**
+   * @brief Gets the regions the last frame was detected on.
+   * @return Regions in frame pixels; the whole frame after a full
+   * detection, empty after a skipped frame.
+   */
+  const std::vector<cv::Rect>& lastRegions() const { return regions; }
+
+  /**
+   * @brief Gets the counters.
+   * @return The gating statistics.
+   */
+  const MotionStats& stats() const { return counters; }
+
+ private:
+  /**
+   * @brief Detects on the changed regions in batches.
+   * @param frame The BGR frame.
+   * @return The detections in frame pixels.
+   */
+  Detector::Detections detectRegions(const cv::Mat& frame);
+
+  Detector::YOLODetector& detector; /**< Detector run on changed regions */
+  MotionGateConfig config;          /**< Gate tunables */
+  MotionGate gate;                  /**< Finds the changed regions */
+  Tracker::MultiTracker tracker;    /**< Tracks across all frames */
+  Detector::Detections previous;    /**< Detections carried forward */
+  std::vector<cv::Rect> regions;    /**< Regions of the last frame */
+  int sinceFull;                    /**< Frames since a whole-frame pass */
+  MotionStats counters;             /**< Statistics */
+};
+
+}  // namespace Pipeline
@@ -0,0 +1,194 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+#include "multi_stream.hpp"
+
+#include <functional>
+#include <iostream>
+
+namespace Pipeline {
+
+/**
+ * @brief Constructs a multi-stream detector around a shared detector.
+ * @param detector Detector whose network serves every stream. Must
+ * outlive this object.
+ * @param config Batching tunables.
+ */
+MultiStreamDetector::MultiStreamDetector(Detector::YOLODetector& detector,
+                                         const MultiStreamConfig& config)
+    : detector(detector),
+      config(config),
+      running(false),
+      cursor(0),
+      batches(0),
+      frames(0),
+      dropped(0) {
+  if (this->config.batchSize == 0) {
+    this->config.batchSize = 1;
+  }
+}
+
+/**
+ * @brief Stops the capture threads if still running.
+ */
+MultiStreamDetector::~MultiStreamDetector() {
+  stop();
+  for (auto& worker : workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+/**
+ * @brief Runs batched detection until every stream ends or stop() is
+ * called.
+ * @param captures Opened captures, one per stream. Each is read by its own
+ * thread until run() returns.
+ * @param onResult Callback receiving each detected frame.
+ * @return The number of frames detected.
+ */
+uint64_t MultiStreamDetector::run(std::vector<cv::VideoCapture>& captures,
+                                  const ResultCallback& onResult) {
+  queues.clear();
+  for (size_t i = 0; i < captures.size(); ++i) {
+    queues.emplace_back(new RingBuffer<FramePacket>(config.queueCapacity));
+  }
+
+  running.store(true);
+  for (size_t i = 0; i < captures.size(); ++i) {
+    if (!captures[i].isOpened()) {
+      std::cerr << "Error opening video stream " << i << std::endl;
+      queues[i]->close();
+      continue;
+    }
+    workers.emplace_back(&MultiStreamDetector::captureLoop, this, i,
+                         std::ref(captures[i]));
+  }
+
+  const uint64_t start = frames.load();
+  std::vector<size_t> streams;
+  std::vector<FramePacket> packets;
+  std::vector<cv::Mat> images;
+  std::vector<Detector::BoxTransform> transforms;
+  while (running.load() && collectBatch(streams, packets)) {
+    images.clear();
+    for (const FramePacket& packet : packets) {
+      images.push_back(packet.frame);
+    }
+
+    std::vector<cv::Mat> output =
+        detector.infer(detector.preprocessBatch(images, &transforms));
+    std::vector<Detector::Detections> results =
+        detector.postprocessBatch(transforms, output);
+
+    batches.fetch_add(1, std::memory_order_relaxed);
+    frames.fetch_add(packets.size(), std::memory_order_relaxed);
+    for (size_t i = 0; i < packets.size(); ++i) {
+      packets[i].detections = std::move(results[i]);
+      if (onResult) {
+        onResult(streams[i], packets[i]);
+      }
+    }
+  }
+
+  stop();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+  return frames.load() - start;
+}
+
+/**
+ * @brief Requests the capture and batching loops to stop.
+ */
+void MultiStreamDetector::stop() {
+  running.store(false);
+  for (auto& queue : queues) {
+    queue->close();
+  }
+}
+
+/**
+ * @brief Gets a snapshot of the batching counters.
+ * @return The current statistics.
+ */
+MultiStreamStats MultiStreamDetector::stats() const {
+  MultiStreamStats snapshot;
+  snapshot.batches = batches.load(std::memory_order_relaxed);
+  snapshot.frames = frames.load(std::memory_order_relaxed);
+  snapshot.dropped = dropped.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+/**
+ * @brief Capture loop of one stream.
+ * @param stream Index of the stream.
+ * @param cap The stream's opened capture.
+ */
+void MultiStreamDetector::captureLoop(size_t stream, cv::VideoCapture& cap) {
+  uint64_t index = 0;
+  while (running.load()) {
+    FramePacket packet;
+    if (!cap.read(packet.frame) || packet.frame.empty()) {
+      break;
+    }
+    packet.index = index++;
+    size_t evicted = queues[stream]->push(std::move(packet),
+                                          OverflowPolicy::kDropOldest);
+    dropped.fetch_add(evicted, std::memory_order_relaxed);
+  }
+  queues[stream]->close();
+}
+
+/**
+ * @brief Collects the next batch of frames from the stream queues.
+ * @param streams Receives the stream index of each collected frame.
+ * @param packets Receives the collected frames.
+ * @return False once every stream has ended and been drained.
+ */
+bool MultiStreamDetector::collectBatch(std::vector<size_t>& streams,
+                                       std::vector<FramePacket>& packets) {
+  streams.clear();
+  packets.clear();
+  if (queues.empty()) {
+    return false;
+  }
+
+  std::chrono::steady_clock::time_point deadline;
+  while (running.load() && packets.size() < config.batchSize) {
+    bool allEnded = true;
+    bool gotFrame = false;
+    for (size_t k = 0;
+         k < queues.size() && packets.size() < config.batchSize; ++k) {
+      size_t stream = (cursor + k) % queues.size();
+      FramePacket packet;
+      if (queues[stream]->tryPop(packet)) {
+        if (packets.empty()) {
+          deadline = std::chrono::steady_clock::now() + config.maxWait;
+        }
+        streams.push_back(stream);
+        packets.push_back(std::move(packet));
+        gotFrame = true;
+      }
+      if (!queues[stream]->isClosed() || queues[stream]->size() > 0) {
+        allEnded = false;
+      }
+    }
+    // Start the next batch on the following stream so no camera starves
+    cursor = (cursor + 1) % queues.size();
+
+    if (allEnded) {
+      break;
+    }
+    if (!packets.empty() && std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    if (!gotFrame) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+  return !packets.empty();
+}
+
+}  // namespace Pipeline
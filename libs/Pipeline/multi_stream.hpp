@@ -0,0 +1,142 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file multi_stream.hpp
+ * @brief Header file for batched detection over several video streams.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <opencv2/videoio.hpp>
+#include <thread>
+#include <vector>
+
+#include "detector.hpp"
+#include "pipeline.hpp"
+#include "ring_buffer.hpp"
+
+namespace Pipeline {
+
+/**
+ * @struct MultiStreamConfig
+ * @brief Tunables for the multi-stream detector.
+ */
+struct MultiStreamConfig {
+  size_t batchSize = 4; /**< Maximum frames per forward pass */
+  /**< Longest time a partial batch waits for more frames */
+  std::chrono::milliseconds maxWait{20};
+  size_t queueCapacity = 2; /**< Frames buffered per stream (drop-oldest) */
+};
+
+/**
+ * @struct MultiStreamStats
+ * @brief Snapshot of the multi-stream detector counters.
+ */
+struct MultiStreamStats {
+  uint64_t batches = 0;  /**< Forward passes run */
+  uint64_t frames = 0;   /**< Frames detected across all streams */
+  uint64_t dropped = 0;  /**< Frames evicted before they were batched */
+
+  /**
+   * @brief Gets the mean number of frames per forward pass.
+   * @return frames / batches, or 0 before the first batch.
+   */
+  double meanBatchSize() const {
+    return batches == 0 ? 0.0 : static_cast<double>(frames) / batches;
+  }
+};
+
+/**
+ * @class MultiStreamDetector
+ * @brief Detects people on several video streams with one shared network.
+ *
+ * Each stream has a capture thread that keeps its newest frames in a small
+ * drop-oldest queue. A single batching thread takes frames round-robin from
+ * the streams until the batch is full or the first frame has waited
+ * maxWait, stacks them into one NCHW blob, runs one forward pass and hands
+ * each frame's detections back through the result callback. The weights are
+ * loaded once no matter how many cameras are attached.
+ */
+class MultiStreamDetector {
+ public:
+  /**
+   * @brief Callback receiving each frame with its detections filled in.
+   *
+   * Called on the batching thread, in capture order within a stream.
+   */
+  using ResultCallback = std::function<void(size_t stream, FramePacket&)>;
+
+  /**
+   * @brief Constructs a multi-stream detector around a shared detector.
+   * @param detector Detector whose network serves every stream. Must
+   * outlive this object.
+   * @param config Batching tunables.
+   */
+  MultiStreamDetector(Detector::YOLODetector& detector,
+                      const MultiStreamConfig& config = MultiStreamConfig());
+
+  /**
+   * @brief Stops the capture threads if still running.
+   */
+  ~MultiStreamDetector();
+
+  MultiStreamDetector(const MultiStreamDetector&) = delete;
+  MultiStreamDetector& operator=(const MultiStreamDetector&) = delete;
+
+  /**
+   * @brief Runs batched detection until every stream ends or stop() is
+   * called.
+   * @param captures Opened captures, one per stream. Each is read by its own
+   * thread until run() returns.
+   * @param onResult Callback receiving each detected frame.
+   * @return The number of frames detected.
+   */
+  uint64_t run(std::vector<cv::VideoCapture>& captures,
+               const ResultCallback& onResult);
+
+  /**
+   * @brief Requests the capture and batching loops to stop.
+   */
+  void stop();
+
+  /**
+   * @brief Gets a snapshot of the batching counters.
+   * @return The current statistics.
+   */
+  MultiStreamStats stats() const;
+
+ private:
+  /**
+   * @brief Capture loop of one stream.
+   * @param stream Index of the stream.
+   * @param cap The stream's opened capture.
+   */
+  void captureLoop(size_t stream, cv::VideoCapture& cap);
+
+  /**
+   * @brief Collects the next batch of frames from the stream queues.
+   * @param streams Receives the stream index of each collected frame.
+   * @param packets Receives the collected frames.
+   * @return False once every stream has ended and been drained.
+   */
+  bool collectBatch(std::vector<size_t>& streams,
+                    std::vector<FramePacket>& packets);
+
+  Detector::YOLODetector& detector; /**< Detector shared by all streams */
+  MultiStreamConfig config;         /**< Batching tunables */
+  /**< Per-stream frame queues */
+  std::vector<std::unique_ptr<RingBuffer<FramePacket>>> queues;
+  std::vector<std::thread> workers; /**< Capture threads */
+  std::atomic<bool> running;        /**< Cleared to stop all loops */
+  size_t cursor;                    /**< Round-robin start stream */
+  std::atomic<uint64_t> batches;    /**< Forward passes run */
+  std::atomic<uint64_t> frames;     /**< Frames detected */
+  std::atomic<uint64_t> dropped;    /**< Frames evicted from the queues */
+};
+
+}  // namespace Pipeline
@@ -0,0 +1,479 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "offline.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <opencv2/core/utils/filesystem.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "pipeline.hpp"
+#include "thread_affinity.hpp"
+
+// Reading encoded packets with their keyframe flag arrived in OpenCV 4.7
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 7)
+#define ACME_HAVE_KEYFRAME_INDEX 1
+#endif
+
+namespace Pipeline {
+
+namespace {
+
+/**< Chunk end meaning "read to the end of the file" */
+constexpr uint64_t kToEnd = std::numeric_limits<uint64_t>::max();
+
+/**
+ * @brief Picks the chunk length for a source of known length.
+ * @param frameCount Number of frames, or 0 if unknown.
+ * @param workers Number of workers.
+ * @param preferred The configured chunk length.
+ * @return The preferred length, shortened so every worker gets a chunk.
+ */
+uint64_t chunkLength(uint64_t frameCount, size_t workers,
+                     uint64_t preferred) {
+  uint64_t share = (frameCount + workers - 1) / workers;
+  return std::max<uint64_t>(1, share > 0 ? std::min(preferred, share)
+                                         : preferred);
+}
+
+/**
+ * @brief Quotes a CSV field if it contains a separator or a quote.
+ * @param field The raw field.
+ * @return The field as it should appear in the file.
+ */
+std::string csvField(const std::string& field) {
+  if (field.find_first_of(",\"\n") == std::string::npos) {
+    return field;
+  }
+  std::string quoted = "\"";
+  for (char c : field) {
+    quoted += c;
+    if (c == '"') {
+      quoted += '"';
+    }
+  }
+  return quoted + "\"";
+}
+
+}  // namespace
+
+/**
+ * @brief Classifies a source given on the command line.
+ * @param source A directory, a video file path, a URL ("rtsp://...") or a
+ * camera index.
+ * @return The kind of source.
+ */
+SourceKind classifySource(const std::string& source) {
+  if (cv::utils::fs::isDirectory(source)) {
+    return SourceKind::kImageDirectory;
+  }
+  bool isIndex = !source.empty() &&
+                 std::all_of(source.begin(), source.end(), [](char c) {
+                   return std::isdigit(static_cast<unsigned char>(c)) != 0;
+                 });
+  if (isIndex || source.find("://") != std::string::npos) {
+    return SourceKind::kStream;
+  }
+  return SourceKind::kVideoFile;
+}
+
+/**
+ * @brief Lists the images in a directory.
+ * @param directory The directory; subdirectories are not searched.
+ * @return Paths of files with a common image extension, sorted by name.
+ */
+std::vector<std::string> listImages(const std::string& directory) {
+  static const char* kExtensions[] = {".jpg", ".jpeg", ".png", ".bmp",
+                                      ".tif", ".tiff", ".webp", ".ppm",
+                                      ".pgm"};
+  std::vector<cv::String> files;
+  cv::utils::fs::glob(directory, "*", files, false, false);
+
+  std::vector<std::string> images;
+  for (const cv::String& file : files) {
+    size_t dot = file.find_last_of('.');
+    if (dot == std::string::npos) {
+      continue;
+    }
+    std::string extension = file.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    for (const char* known : kExtensions) {
+      if (extension == known) {
+        images.push_back(file);
+        break;
+      }
+    }
+  }
+  std::sort(images.begin(), images.end());
+  return images;
+}
+
+/**
+ * @brief Finds the keyframes of a video file without decoding it.
+ * @param path The video file.
+ * @param frameCount Receives the number of packets read, if not null.
+ * @return Indices of the keyframes in decode order, or empty if unknown.
+ */
+std::vector<uint64_t> indexKeyframes(const std::string& path,
+                                     uint64_t* frameCount) {
+  std::vector<uint64_t> keyframes;
+  uint64_t count = 0;
+#ifdef ACME_HAVE_KEYFRAME_INDEX
+  cv::VideoCapture cap(path, cv::CAP_FFMPEG);
+  // A format of -1 makes grab() return encoded packets undecoded
+  if (cap.isOpened() && cap.set(cv::CAP_PROP_FORMAT, -1)) {
+    for (; cap.grab(); ++count) {
+      if (cap.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0) {
+        keyframes.push_back(count);
+      }
+    }
+  }
+#else
+  (void)path;
+#endif
+  if (frameCount != nullptr) {
+    *frameCount = count;
+  }
+  return keyframes;
+}
+
+/**
+ * @brief Splits a video into chunks that start on keyframes.
+ * @param frameCount Number of frames, or 0 if unknown.
+ * @param keyframes Keyframe indices in increasing order; may be empty.
+ * @param targetFrames Preferred chunk length.
+ * @return The chunks in order.
+ */
+std::vector<Chunk> planChunks(uint64_t frameCount,
+                              const std::vector<uint64_t>& keyframes,
+                              uint64_t targetFrames) {
+  const uint64_t target = std::max<uint64_t>(targetFrames, 1);
+  std::vector<Chunk> plan;
+  uint64_t begin = 0;
+  auto next = keyframes.begin();
+  while (frameCount > 0) {
+    uint64_t end = begin + target;
+    if (!keyframes.empty()) {
+      next = std::lower_bound(next, keyframes.end(), end);
+      end = next == keyframes.end() ? frameCount : *next;
+    }
+    if (end >= frameCount) {
+      break;
+    }
+    Chunk chunk;
+    chunk.sequence = plan.size();
+    chunk.begin = begin;
+    chunk.end = end;
+    plan.push_back(std::move(chunk));
+    begin = end;
+  }
+
+  Chunk last;
+  last.sequence = plan.size();
+  last.begin = begin;
+  last.end = kToEnd;
+  plan.push_back(std::move(last));
+  return plan;
+}
+
+/**
+ * @brief Constructs an offline processor.
+ * @param factory Creates one detector per worker.
+ * @param config Tunables.
+ */
+OfflineProcessor::OfflineProcessor(DetectorFactory factory,
+                                   const OfflineConfig& config)
+    : factory(std::move(factory)),
+      config(config),
+      nextSequence(0),
+      emitted(0),
+      emittedChunks(0),
+      running(false) {}
+
+/**
+ * @brief Processes one source to the end.
+ * @param source A video file, an image directory, a URL or a camera index.
+ * @param onResult Callback receiving each frame's detections in order.
+ * @return The number of frames detected.
+ * @throws std::runtime_error if the source cannot be opened, a worker's
+ * detector cannot be loaded or a worker fails.
+ */
+uint64_t OfflineProcessor::run(const std::string& source,
+                               const ResultCallback& onResult) {
+  auto start = std::chrono::steady_clock::now();
+  const SourceKind kind = classifySource(source);
+  size_t workerCount =
+      config.workers > 0
+          ? config.workers
+          : std::max<size_t>(1, std::thread::hardware_concurrency());
+
+  std::vector<std::string> images;
+  std::vector<Chunk> plan;
+  cv::VideoCapture stream;
+  if (kind == SourceKind::kImageDirectory) {
+    images = listImages(source);
+    if (images.empty()) {
+      throw std::runtime_error("No images found in " + source);
+    }
+    plan = planChunks(images.size(), {},
+                      chunkLength(images.size(), workerCount,
+                                  config.chunkFrames));
+  } else if (kind == SourceKind::kVideoFile) {
+    uint64_t frameCount = 0;
+    std::vector<uint64_t> keyframes = indexKeyframes(source, &frameCount);
+    if (frameCount == 0) {
+      cv::VideoCapture probe(source);
+      if (!probe.isOpened()) {
+        throw std::runtime_error("Cannot open video " + source);
+      }
+      frameCount = static_cast<uint64_t>(
+          std::max(0.0, probe.get(cv::CAP_PROP_FRAME_COUNT)));
+    }
+    plan = planChunks(frameCount, keyframes,
+                      chunkLength(frameCount, workerCount,
+                                  config.chunkFrames));
+  } else {
+    stream = openCapture(source);
+    if (!stream.isOpened()) {
+      throw std::runtime_error("Cannot open stream " + source);
+    }
+  }
+  if (!plan.empty()) {
+    workerCount = std::min(workerCount, plan.size());
+  }
+
+  chunks.reset(new RingBuffer<Chunk>(2 * workerCount));
+  this->onResult = onResult;
+  pending.clear();
+  nextSequence = 0;
+  emitted = 0;
+  emittedChunks = 0;
+  error.clear();
+  running.store(true);
+
+  const int poolThreads = cv::getNumThreads();
+  if (config.singleThreadedWorkers && workerCount > 1) {
+    cv::setNumThreads(1);
+  }
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < workerCount; ++i) {
+    const int cpu =
+        config.cpus.empty() ? -1 : config.cpus[i % config.cpus.size()];
+    workers.emplace_back(&OfflineProcessor::workerLoop, this,
+                         std::cref(source), kind, std::cref(images), cpu);
+  }
+
+  if (kind == SourceKind::kStream) {
+    // Read ahead on this thread; the queue bounds the frames held in memory
+    uint64_t index = 0;
+    uint64_t sequence = 0;
+    bool more = true;
+    while (more && running.load()) {
+      Chunk chunk;
+      chunk.begin = index;
+      cv::Mat frame;
+      while (chunk.frames.size() < config.streamChunkFrames &&
+             stream.read(frame) && !frame.empty()) {
+        chunk.frames.push_back(frame);
+        chunk.timestamps.push_back(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count());
+        frame.release();  // Next read must not overwrite the stored frame
+      }
+      more = chunk.frames.size() == config.streamChunkFrames;
+      if (chunk.frames.empty()) {
+        break;
+      }
+      index += chunk.frames.size();
+      chunk.end = index;
+      chunk.sequence = sequence++;
+      chunks->push(std::move(chunk), OverflowPolicy::kBlock);
+    }
+  } else {
+    for (Chunk& chunk : plan) {
+      if (!running.load()) {
+        break;
+      }
+      chunks->push(std::move(chunk), OverflowPolicy::kBlock);
+    }
+  }
+  chunks->close();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  cv::setNumThreads(poolThreads);
+  running.store(false);
+
+  lastStats.frames = emitted;
+  lastStats.chunks = emittedChunks;
+  lastStats.workers = workerCount;
+  lastStats.seconds = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  if (!error.empty()) {
+    throw std::runtime_error(error);
+  }
+  return emitted;
+}
+
+/**
+ * @brief Worker loop: pins the thread, loads the worker's detector and
+ * detects the frames of each chunk it takes.
+ * @param source The source being processed.
+ * @param kind The kind of source.
+ * @param images Image paths, for image directories.
+ * @param cpu CPU to pin the thread to, or -1.
+ */
+void OfflineProcessor::workerLoop(const std::string& source, SourceKind kind,
+                                  const std::vector<std::string>& images,
+                                  int cpu) {
+  if (cpu >= 0) {
+    Detector::pinCurrentThread(cpu);
+  }
+  // Loaded after pinning so the network is first touched, and therefore
+  // allocated, on this CPU's NUMA node. A bad model stops the run.
+  std::unique_ptr<Detector::YOLODetector> owned;
+  try {
+    owned = factory();
+  } catch (const std::exception& e) {
+    fail(e.what());
+    return;
+  }
+  Detector::YOLODetector& detector = *owned;
+  cv::VideoCapture cap;
+  uint64_t position = 0;  // Frame the capture will return next
+  Chunk chunk;
+  while (chunks->pop(chunk)) {
+    if (!running.load()) {
+      continue;  // Drain so the producer is never left blocked
+    }
+    std::vector<FrameResult> results;
+    try {
+      if (!chunk.frames.empty()) {
+        for (size_t i = 0; i < chunk.frames.size(); ++i) {
+          FrameResult result;
+          result.index = chunk.begin + i;
+          result.timestampUs = chunk.timestamps[i];
+          result.detections = detector.detect(chunk.frames[i]);
+          results.push_back(std::move(result));
+        }
+      } else if (kind == SourceKind::kImageDirectory) {
+        uint64_t end = std::min<uint64_t>(chunk.end, images.size());
+        for (uint64_t i = chunk.begin; i < end; ++i) {
+          FrameResult result;
+          result.index = i;
+          result.name = images[i];
+          cv::Mat image = cv::imread(images[i]);
+          if (image.empty()) {
+            std::cerr << "Skipping unreadable image " << images[i]
+                      << std::endl;
+          } else {
+            result.detections = detector.detect(image);
+          }
+          results.push_back(std::move(result));
+        }
+      } else {
+        if (!cap.isOpened()) {
+          if (!cap.open(source)) {
+            throw std::runtime_error("Cannot open video " + source);
+          }
+          position = 0;
+        }
+        if (position != chunk.begin) {
+          // Chunks start on keyframes, so the seek decodes nothing extra
+          cap.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(chunk.begin));
+          position = chunk.begin;
+        }
+        cv::Mat frame;
+        for (; position < chunk.end && cap.read(frame) && !frame.empty();
+             ++position) {
+          FrameResult result;
+          result.index = position;
+          result.timestampUs =
+              static_cast<int64_t>(cap.get(cv::CAP_PROP_POS_MSEC) * 1000);
+          result.detections = detector.detect(frame);
+          results.push_back(std::move(result));
+        }
+      }
+    } catch (const std::exception& e) {
+      fail(e.what());
+      continue;
+    }
+    complete(chunk.sequence, std::move(results));
+  }
+}
+
+/**
+ * @brief Stores a finished chunk and emits every chunk now in order.
+ * @param sequence The chunk's position in the output order.
+ * @param results The chunk's frame results.
+ */
+void OfflineProcessor::complete(uint64_t sequence,
+                                std::vector<FrameResult> results) {
+  std::lock_guard<std::mutex> lock(orderMutex);
+  pending.emplace(sequence, std::move(results));
+  for (auto it = pending.begin();
+       it != pending.end() && it->first == nextSequence;
+       it = pending.erase(it)) {
+    for (const FrameResult& result : it->second) {
+      if (onResult) {
+        onResult(result);
+      }
+      ++emitted;
+    }
+    ++nextSequence;
+    ++emittedChunks;
+  }
+}
+
+/**
+ * @brief Records the first worker error and stops the run.
+ * @param message What went wrong.
+ */
+void OfflineProcessor::fail(const std::string& message) {
+  {
+    std::lock_guard<std::mutex> lock(orderMutex);
+    if (error.empty()) {
+      error = message;
+    }
+  }
+  running.store(false);
+  chunks->close();
+}
+
+/**
+ * @brief Writes the CSV header matching writeCsv().
+ * @param out The stream to write to.
+ */
+void writeCsvHeader(std::ostream& out) {
+  out << "source,frame,name,class,score,x,y,width,height\n";
+}
+
+/**
+ * @brief Writes one CSV row per detection of a frame.
+ * @param out The stream to write to.
+ * @param source The source the frame came from.
+ * @param result The frame's detections.
+ */
+void writeCsv(std::ostream& out, const std::string& source,
+              const FrameResult& result) {
+  const std::string prefix = csvField(source) + "," +
+                             std::to_string(result.index) + "," +
+                             csvField(result.name) + ",";
+  for (const Detector::Detection& detection : result.detections) {
+    const cv::Rect& box = detection.box;
+    out << prefix << detection.classId << "," << detection.score << ","
+        << box.x << "," << box.y << "," << box.width << "," << box.height
+        << "\n";
+  }
+}
+
+}  // namespace Pipeline
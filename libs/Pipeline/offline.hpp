@@ -0,0 +1,253 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file offline.hpp
+ * @brief Header file for parallel offline detection over recorded footage.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "detector.hpp"
+#include "ring_buffer.hpp"
+
+namespace Pipeline {
+
+/**
+ * @enum SourceKind
+ * @brief How an offline source is read.
+ */
+enum class SourceKind {
+  kImageDirectory, /**< A directory of still images, read in name order */
+  kVideoFile,      /**< A seekable video file, split into chunks */
+  kStream          /**< A URL or camera that can only be read in order */
+};
+
+/**
+ * @brief Classifies a source given on the command line.
+ * @param source A directory, a video file path, a URL ("rtsp://...") or a
+ * camera index.
+ * @return The kind of source.
+ */
+SourceKind classifySource(const std::string& source);
+
+/**
+ * @brief Lists the images in a directory.
+ * @param directory The directory; subdirectories are not searched.
+ * @return Paths of files with a common image extension, sorted by name.
+ */
+std::vector<std::string> listImages(const std::string& directory);
+
+/**
+ * @brief Finds the keyframes of a video file without decoding it.
+ *
+ * Reads the encoded packets through the FFmpeg backend and records which
+ * ones are keyframes. Needs OpenCV 4.7 or newer; older versions return an
+ * empty list and chunks fall back to fixed lengths.
+ *
+ * @param path The video file.
+ * @param frameCount Receives the number of packets read, if not null.
+ * @return Indices of the keyframes in decode order, or empty if unknown.
+ */
+std::vector<uint64_t> indexKeyframes(const std::string& path,
+                                     uint64_t* frameCount = nullptr);
+
+/**
+ * @struct Chunk
+ * @brief A run of consecutive frames handled by one worker.
+ */
+struct Chunk {
+  uint64_t sequence = 0; /**< Position of the chunk in the output order */
+  uint64_t begin = 0;    /**< First frame index */
+  uint64_t end = 0;      /**< One past the last frame; UINT64_MAX = to EOF */
+  /**< Decoded frames for sources that cannot be seek()ed; empty otherwise */
+  std::vector<cv::Mat> frames;
+  /**< Wall-clock read time of each entry of frames, in microseconds */
+  std::vector<int64_t> timestamps;
+};
+
+/**
+ * @brief Splits a video into chunks that start on keyframes.
+ *
+ * Each chunk runs to the first keyframe at least targetFrames past its
+ * start, so every worker seeks straight to a keyframe and never decodes
+ * frames it then throws away. Without keyframes the chunks have exactly
+ * targetFrames frames. The last chunk is open-ended, since frame counts
+ * reported by containers are often estimates.
+ *
+ * @param frameCount Number of frames, or 0 if unknown.
+ * @param keyframes Keyframe indices in increasing order; may be empty.
+ * @param targetFrames Preferred chunk length.
+ * @return The chunks in order.
+ */
+std::vector<Chunk> planChunks(uint64_t frameCount,
+                              const std::vector<uint64_t>& keyframes,
+                              uint64_t targetFrames);
+
+/**
+ * @struct OfflineConfig
+ * @brief Tunables for offline processing.
+ */
+struct OfflineConfig {
+  size_t workers = 0;         /**< Detector threads; 0 = one per core */
+  uint64_t chunkFrames = 256; /**< Preferred frames per chunk */
+  /**< Frames per chunk read ahead from sources that cannot seek */
+  uint64_t streamChunkFrames = 16;
+  /**< Run each forward pass on one thread; parallelism then comes from the
+   * workers, which scales better than sharing OpenCV's thread pool */
+  bool singleThreadedWorkers = true;
+  /**< CPUs the workers are pinned to, worker i to cpus[i % size]; empty
+   * leaves them to the scheduler (see Detector::pinningCpus()) */
+  std::vector<int> cpus;
+};
+
+/**
+ * @struct FrameResult
+ * @brief Detections of one offline frame.
+ */
+struct FrameResult {
+  uint64_t index = 0;              /**< Frame or image number */
+  std::string name;                /**< Image path; empty for video */
+  /**< Media time for video files, read time for streams, 0 for images */
+  int64_t timestampUs = 0;
+  Detector::Detections detections; /**< Detections after NMS */
+};
+
+/**
+ * @struct OfflineStats
+ * @brief Counters of an offline run.
+ */
+struct OfflineStats {
+  uint64_t frames = 0;  /**< Frames detected */
+  uint64_t chunks = 0;  /**< Chunks processed */
+  size_t workers = 0;   /**< Worker threads used */
+  double seconds = 0;   /**< Wall time of the run */
+
+  /**
+   * @brief Gets the throughput.
+   * @return Frames per second of wall time, or 0 before a run.
+   */
+  double fps() const { return seconds > 0 ? frames / seconds : 0.0; }
+};
+
+/**
+ * @class OfflineProcessor
+ * @brief Runs detection over recorded footage as fast as the cores allow.
+ *
+ * Video files are split into keyframe-aligned chunks and image directories
+ * into runs of files; sources that cannot seek are read ahead in small
+ * chunks by the calling thread. Worker threads each own a detector and
+ * take chunks from a shared queue, so no network is shared between
+ * threads. Results are handed to the callback strictly in frame order,
+ * whatever order the chunks finish in. Frames are detected independently;
+ * tracks are not carried across them.
+ */
+class OfflineProcessor {
+ public:
+  /**
+   * @brief Creates the detector of one worker.
+   *
+   * Called once on each worker thread, after the thread is pinned, so the
+   * network is allocated next to the CPU that runs it. Workers call it at
+   * the same time.
+   */
+  using DetectorFactory =
+      std::function<std::unique_ptr<Detector::YOLODetector>()>;
+
+  /**
+   * @brief Callback receiving each frame's detections, in frame order.
+   *
+   * Called from the worker that completes the chunk, one call at a time.
+   */
+  using ResultCallback = std::function<void(const FrameResult&)>;
+
+  /**
+   * @brief Constructs an offline processor.
+   * @param factory Creates one detector per worker.
+   * @param config Tunables.
+   */
+  explicit OfflineProcessor(DetectorFactory factory,
+                            const OfflineConfig& config = OfflineConfig());
+
+  /**
+   * @brief Processes one source to the end.
+   * @param source A video file, an image directory, a URL or a camera index.
+   * @param onResult Callback receiving each frame's detections in order.
+   * @return The number of frames detected.
+   * @throws std::runtime_error if the source cannot be opened, a worker's
+   * detector cannot be loaded or a worker fails.
+   */
+  uint64_t run(const std::string& source, const ResultCallback& onResult);
+
+  /**
+   * @brief Gets the counters of the last run.
+   * @return The statistics.
+   */
+  OfflineStats stats() const { return lastStats; }
+
+ private:
+  /**
+   * @brief Worker loop: pins the thread, loads the worker's detector and
+   * detects the frames of each chunk it takes.
+   * @param source The source being processed.
+   * @param kind The kind of source.
+   * @param images Image paths, for image directories.
+   * @param cpu CPU to pin the thread to, or -1.
+   */
+  void workerLoop(const std::string& source, SourceKind kind,
+                  const std::vector<std::string>& images, int cpu);
+
+  /**
+   * @brief Stores a finished chunk and emits every chunk now in order.
+   * @param sequence The chunk's position in the output order.
+   * @param results The chunk's frame results.
+   */
+  void complete(uint64_t sequence, std::vector<FrameResult> results);
+
+  /**
+   * @brief Records the first worker error and stops the run.
+   * @param message What went wrong.
+   */
+  void fail(const std::string& message);
+
+  DetectorFactory factory; /**< Creates one detector per worker */
+  OfflineConfig config;    /**< Tunables */
+  /**< Chunks waiting for a worker */
+  std::unique_ptr<RingBuffer<Chunk>> chunks;
+  ResultCallback onResult; /**< Receives ordered results */
+  std::mutex orderMutex;   /**< Guards the members below */
+  /**< Finished chunks waiting for an earlier one */
+  std::map<uint64_t, std::vector<FrameResult>> pending;
+  uint64_t nextSequence;   /**< Next chunk to emit */
+  uint64_t emitted;        /**< Frames emitted so far */
+  uint64_t emittedChunks;  /**< Chunks emitted so far */
+  std::string error;       /**< First worker error, empty if none */
+  std::atomic<bool> running; /**< Cleared to stop the workers early */
+  OfflineStats lastStats;  /**< Counters of the last run */
+};
+
+/**
+ * @brief Writes the CSV header matching writeCsv().
+ * @param out The stream to write to.
+ */
+void writeCsvHeader(std::ostream& out);
+
+/**
+ * @brief Writes one CSV row per detection of a frame.
+ * @param out The stream to write to.
+ * @param source The source the frame came from.
+ * @param result The frame's detections.
+ */
+void writeCsv(std::ostream& out, const std::string& source,
+              const FrameResult& result);
+
+}  // namespace Pipeline
@@ -0,0 +1,235 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file pipeline.hpp
+ * @brief Header file for the multi-threaded detection pipeline.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "detector.hpp"
+#include "multi_tracker.hpp"
+#include "publisher.hpp"
+#include "resolution.hpp"
+#include "ring_buffer.hpp"
+
+namespace Pipeline {
+
+/**
+ * @enum Stage
+ * @brief Stages of the detection pipeline, in the order frames visit them.
+ */
+enum Stage {
+  kCapture = 0,
+  kPreprocess,
+  kInference,
+  kPostprocess,
+  kRender,
+  kStageCount
+};
+
+/**
+ * @struct PipelineConfig
+ * @brief Tunables for the detection pipeline.
+ */
+struct PipelineConfig {
+  size_t queueCapacity = 4; /**< Slots in each inter-stage queue */
+  /**< Backpressure policy applied when a queue is full */
+  OverflowPolicy overflowPolicy = OverflowPolicy::kDropOldest;
+  bool display = true;  /**< Show annotated frames with imshow */
+  bool track = true;    /**< Associate detections into tracks */
+  /**< Association and lifecycle tunables of the tracker */
+  Tracker::MultiTrackerConfig tracker;
+  size_t maxFrames = 0; /**< Stop after this many rendered frames (0 = run) */
+  /**< Input sizes and inference latency budget; budgetMs = 0 keeps the
+   * detector's input size fixed */
+  Detector::ResolutionConfig resolution;
+  /**< Binary log of every rendered frame's detections and tracks; empty
+   * disables logging */
+  std::string logPath;
+  /**< Shared memory ring every rendered frame's detections and tracks are
+   * published to; an empty name disables publishing. With publishFrames
+   * and frameBytes 0 the ring is sized for the first frame */
+  Transport::PublisherConfig publish;
+  bool publishFrames = false; /**< Also publish the annotated frames */
+  /**< Receives "capture", "render" and end-to-end "frame" latencies; the
+   * detector's own stages are timed through YOLODetector::setMetrics() */
+  Metrics::Registry* metrics = nullptr;
+};
+
+/**
+ * @struct PipelineStats
+ * @brief Snapshot of the pipeline counters.
+ *
+ * Queue index i is the queue feeding stage i + 1, so queueDepth[kCapture] is
+ * the number of captured frames waiting for preprocessing.
+ */
+struct PipelineStats {
+  /**< Items waiting in each queue */
+  std::array<size_t, kStageCount - 1> queueDepth{};
+  /**< Items evicted from each queue by the drop-oldest policy */
+  std::array<uint64_t, kStageCount - 1> dropped{};
+  /**< Frames completed by each stage */
+  std::array<uint64_t, kStageCount> processed{};
+  int inputSide = 0; /**< Input side chosen for the latency budget, 0 = off */
+};
+
+/**
+ * @struct FramePacket
+ * @brief A frame and the intermediate results attached to it by each stage.
+ */
+struct FramePacket {
+  uint64_t index = 0;           /**< Capture sequence number */
+  int64_t timestampUs = 0;      /**< Wall-clock capture time */
+  cv::Mat frame;                /**< Captured BGR frame */
+  cv::Mat blob;                 /**< Network input blob */
+  /**< Maps the network's boxes back to the frame */
+  Detector::BoxTransform transform;
+  std::vector<cv::Mat> output;  /**< Raw network outputs */
+  Detector::Detections detections; /**< Decoded detections */
+  std::vector<Tracker::Track> tracks; /**< Confirmed tracks after this frame */
+};
+
+/**
+ * @brief Opens a video source given on the command line.
+ * @param source A camera index ("0"), a video file path or a stream URL.
+ * @return The capture; check isOpened() for failure.
+ */
+cv::VideoCapture openCapture(const std::string& source);
+
+/**
+ * @brief Feeds a frame's detections to a tracker.
+ * @param tracker The tracker to update.
+ * @param detections The frame's detections.
+ * @return The confirmed tracks after the update.
+ */
+std::vector<Tracker::Track> trackDetections(
+    Tracker::MultiTracker& tracker, const Detector::Detections& detections);
+
+#ifndef ACME_HEADLESS
+/**
+ * @brief Labels each confirmed track with its ID.
+ * @param frame The frame to annotate.
+ * @param tracks The confirmed tracks.
+ * @param drawBoxes Also outline the track boxes, for frames without
+ * detections.
+ */
+void drawTracks(const cv::Mat& frame,
+                const std::vector<Tracker::Track>& tracks,
+                bool drawBoxes = false);
+#endif
+
+/**
+ * @class DetectionPipeline
+ * @brief Runs capture, preprocessing, inference, postprocessing and rendering
+ * on separate threads joined by bounded lock-free queues.
+ *
+ * Capture, preprocessing, inference and postprocessing each get a worker
+ * thread; rendering runs on the thread that calls run(), since HighGUI
+ * windows must be driven from a single thread.
+ */
+class DetectionPipeline {
+ public:
+  /**
+   * @brief Constructs a pipeline around an initialized detector.
+   * @param detector Detector used by the preprocessing, inference and
+   * postprocessing stages. Must outlive the pipeline.
+   * @param config Pipeline tunables.
+   */
+  DetectionPipeline(Detector::YOLODetector& detector,
+                    const PipelineConfig& config = PipelineConfig());
+
+  /**
+   * @brief Stops the workers if the pipeline is still running.
+   */
+  ~DetectionPipeline();
+
+  DetectionPipeline(const DetectionPipeline&) = delete;
+  DetectionPipeline& operator=(const DetectionPipeline&) = delete;
+
+  /**
+   * @brief Runs the pipeline on a capture device until it ends or 'q' is
+   * pressed.
+   * @param cap An opened video capture. Owned by the capture thread until
+   * run() returns.
+   * @return The number of frames rendered.
+   */
+  uint64_t run(cv::VideoCapture& cap);
+
+  /**
+   * @brief Requests all stages to stop after their current frame.
+   */
+  void stop();
+
+  /**
+   * @brief Gets a snapshot of the queue depths and per-stage counters.
+   * @return The current pipeline statistics.
+   */
+  PipelineStats stats() const;
+
+ private:
+  /**
+   * @brief Capture stage: reads frames from the device.
+   * @param cap The opened video capture.
+   */
+  void captureLoop(cv::VideoCapture& cap);
+
+  /**
+   * @brief Preprocessing stage: converts frames to input blobs.
+   */
+  void preprocessLoop();
+
+  /**
+   * @brief Inference stage: runs the network forward pass.
+   */
+  void inferenceLoop();
+
+  /**
+   * @brief Postprocessing stage: decodes detections and updates the tracks.
+   */
+  void postprocessLoop();
+
+  /**
+   * @brief Pushes a packet into a queue and records any evictions.
+   * @param queue Index of the queue to push into.
+   * @param packet The packet to push.
+   */
+  void forward(size_t queue, FramePacket packet);
+
+  /**
+   * @brief Closes every queue so blocked stages return.
+   */
+  void closeQueues();
+
+  Detector::YOLODetector& detector; /**< Detector shared by the stages */
+  PipelineConfig config;            /**< Pipeline tunables */
+  Tracker::MultiTracker tracker;    /**< Used by the postprocess stage only */
+  /**< Used by the inference stage only */
+  Detector::ResolutionController resolution;
+  /**< Input side picked by the inference stage for the preprocess stage */
+  std::atomic<int> inputSide;
+  /**< Recycles captured frames and copied network outputs once the render
+   * stage drops them; declared before the queues so it outlives them */
+  Detector::FramePool framePool;
+  /**< Queues joining consecutive stages */
+  std::array<std::unique_ptr<RingBuffer<FramePacket>>, kStageCount - 1>
+      queues;
+  /**< Evictions per queue */
+  std::array<std::atomic<uint64_t>, kStageCount - 1> dropped;
+  /**< Completed frames per stage */
+  std::array<std::atomic<uint64_t>, kStageCount> processed;
+  std::atomic<bool> running;         /**< Cleared to stop all stages */
+  std::vector<std::thread> workers;  /**< Stage worker threads */
+};
+
+}  // namespace Pipeline
@@ -0,0 +1,159 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "replay.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "detection_log.hpp"
+#include "pipeline.hpp"
+#include "postprocessor.hpp"
+
+namespace Pipeline {
+
+namespace {
+
+/**
+ * @brief Compares two detection lists exactly, scores by their bits.
+ * @param a The first list.
+ * @param b The second list.
+ * @return True if both hold the same detections in the same order.
+ */
+bool sameDetections(const Detector::Detections& a,
+                    const Detector::Detections& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].box != b[i].box || a[i].classId != b[i].classId ||
+        std::memcmp(&a[i].score, &b[i].score, sizeof(float)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+ * @brief Detects every frame of a source and records the frames, the raw
+ * network outputs and the detections.
+ * @param detector The initialized detector; its input size, decoding and
+ * suppression settings go into the recording.
+ * @param cap An opened video capture.
+ * @param path The recording to write.
+ * @param maxFrames Stop after this many frames; 0 runs until the end.
+ * @return The number of frames recorded.
+ */
+uint64_t recordStream(Detector::YOLODetector& detector, cv::VideoCapture& cap,
+                      const std::string& path, uint64_t maxFrames) {
+  Storage::RecordingSettings settings;
+  settings.inputSize = detector.getInputSize();
+  settings.decode = detector.getDecodeConfig();
+  settings.nms = detector.getNms();
+  Storage::RecordingWriter writer(path, settings);
+
+  FramePacket packet;
+  while (maxFrames == 0 || writer.frames() < maxFrames) {
+    if (!cap.read(packet.frame) || packet.frame.empty()) {
+      break;
+    }
+    packet.index = writer.frames();
+    packet.timestampUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    packet.blob = detector.preprocess(packet.frame, &packet.transform);
+    packet.output = detector.infer(packet.blob);
+    packet.detections = detector.postprocess(packet.transform, packet.output);
+    writer.append(packet.index, packet.timestampUs, packet.frame,
+                  packet.output, packet.detections);
+  }
+  writer.close();
+  return writer.frames();
+}
+
+/**
+ * @brief Replays a recording through preprocessing, decoding, suppression
+ * and tracking, as fast as they run.
+ * @param reader The recording, read from its first frame.
+ * @param config Replay options.
+ * @return The throughput, latencies and differences.
+ */
+ReplayReport replayRecording(Storage::RecordingReader& reader,
+                             const ReplayConfig& config) {
+  if (!config.referencePath.empty() && config.logPath.empty()) {
+    throw std::runtime_error("A reference log needs a replay log to compare");
+  }
+  const Storage::RecordingSettings& settings = reader.getSettings();
+  Metrics::Registry registry;
+  Metrics::LatencyHistogram& preprocessLatency = registry.stage("preprocess");
+  Metrics::LatencyHistogram& postprocessLatency =
+      registry.stage("postprocess");
+  Metrics::LatencyHistogram& trackLatency = registry.stage("track");
+  Metrics::LatencyHistogram& frameLatency = registry.stage("frame");
+  Detector::LetterboxPreprocessor letterbox;
+  Detector::Postprocessor postprocessor;
+  std::unique_ptr<Storage::LogWriter> log;
+  if (!config.logPath.empty()) {
+    log.reset(new Storage::LogWriter(config.logPath));
+  }
+
+  ReplayReport report;
+  Storage::RecordedFrame recorded;
+  Detector::BoxTransform transform;
+  std::vector<Tracker::Track> tracks;
+  for (int pass = 0; pass < std::max(config.repeat, 1); ++pass) {
+    // Every pass starts from a fresh tracker so all passes agree
+    Tracker::MultiTracker tracker(config.tracker);
+    reader.rewind();
+    while (reader.next(recorded)) {
+      auto start = std::chrono::steady_clock::now();
+      Metrics::ScopedTimer frameTimer(&frameLatency);
+      Metrics::ScopedTimer preprocessTimer(&preprocessLatency);
+      letterbox.process(recorded.frame, settings.inputSize, &transform);
+      preprocessTimer.stop();
+      Metrics::ScopedTimer postprocessTimer(&postprocessLatency);
+      Detector::Detections detections = postprocessor.run(
+          transform, recorded.outputs, settings.decode, settings.nms);
+      postprocessTimer.stop();
+      if (config.track) {
+        Metrics::ScopedTimer trackTimer(&trackLatency);
+        tracks = trackDetections(tracker, detections);
+      }
+      frameTimer.stop();
+      report.seconds += std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+      ++report.frames;
+
+      if (!sameDetections(detections, recorded.detections)) {
+        ++report.detectionMismatches;
+        if (report.firstMismatch < 0) {
+          report.firstMismatch = static_cast<int64_t>(recorded.index);
+        }
+      }
+      if (log && pass == 0) {
+        log->appendFrame(recorded.index, recorded.timestampUs, detections,
+                         tracks);
+      }
+    }
+  }
+  if (log) {
+    log->close();
+  }
+  if (!config.referencePath.empty()) {
+    Storage::LogReader replayed(config.logPath);
+    Storage::LogReader reference(config.referencePath);
+    Storage::LogDiff diff = Storage::diffLogs(replayed, reference);
+    report.referenceMismatches = diff.mismatches;
+    report.firstReferenceMismatch = diff.firstFrame;
+  }
+  report.latencies = registry.snapshot();
+  return report;
+}
+
+}  // namespace Pipeline
@@ -0,0 +1,94 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file replay.hpp
+ * @brief Header file for recording frames with their network outputs and
+ * replaying them through everything but inference.
+ */
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <string>
+
+#include "detector.hpp"
+#include "metrics.hpp"
+#include "multi_tracker.hpp"
+#include "recording.hpp"
+
+namespace Pipeline {
+
+/**
+ * @struct ReplayConfig
+ * @brief Options of a replay.
+ */
+struct ReplayConfig {
+  bool track = true;  /**< Feed the detections to a tracker */
+  Tracker::MultiTrackerConfig tracker; /**< Tracker tunables */
+  /**< Passes over the recording; the timings cover every pass */
+  int repeat = 1;
+  /**< Log of the replayed detections and tracks; empty writes none */
+  std::string logPath;
+  /**< Log of an earlier replay to compare logPath against; needs logPath */
+  std::string referencePath;
+};
+
+/**
+ * @struct ReplayReport
+ * @brief Throughput, latencies and differences of a replay.
+ */
+struct ReplayReport {
+  uint64_t frames = 0;      /**< Frames replayed, over every pass */
+  double seconds = 0;       /**< Time spent in the replayed stages */
+  /**< Frames whose detections differ from the recorded live ones */
+  uint64_t detectionMismatches = 0;
+  /**< Index of the first such frame; -1 if every frame matched */
+  int64_t firstMismatch = -1;
+  /**< Log rows that differ from the reference, when one is given */
+  uint64_t referenceMismatches = 0;
+  /**< Frame of the first row differing from the reference; -1 if none */
+  int64_t firstReferenceMismatch = -1;
+  /**< Latency percentiles of preprocess, postprocess, track and frame */
+  Metrics::Snapshot latencies;
+
+  /**
+   * @brief Gets the replay throughput.
+   * @return Frames per second, or 0 before any frame.
+   */
+  double fps() const { return seconds > 0 ? frames / seconds : 0; }
+};
+
+/**
+ * @brief Detects every frame of a source and records the frames, the raw
+ * network outputs and the detections.
+ * @param detector The initialized detector; its input size, decoding and
+ * suppression settings go into the recording.
+ * @param cap An opened video capture.
+ * @param path The recording to write.
+ * @param maxFrames Stop after this many frames; 0 runs until the end.
+ * @return The number of frames recorded.
+ * @throws std::runtime_error if the recording cannot be written.
+ */
+uint64_t recordStream(Detector::YOLODetector& detector, cv::VideoCapture& cap,
+                      const std::string& path, uint64_t maxFrames = 0);
+
+/**
+ * @brief Replays a recording through preprocessing, decoding, suppression
+ * and tracking, as fast as they run.
+ *
+ * No network is loaded: the recorded outputs stand in for inference, so a
+ * replay needs neither the camera nor the weights and gives the same
+ * result on every run. Each frame's detections are compared bit for bit
+ * with the ones the live run recorded.
+ *
+ * @param reader The recording, read from its first frame.
+ * @param config Replay options.
+ * @return The throughput, latencies and differences.
+ * @throws std::runtime_error if the recording is corrupt, a log cannot be
+ * written or read, or a reference is given without a log.
+ */
+ReplayReport replayRecording(Storage::RecordingReader& reader,
+                             const ReplayConfig& config = ReplayConfig());
+
+}  // namespace Pipeline
@@ -0,0 +1,302 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file ring_buffer.hpp
+ * @brief Bounded lock-free ring buffer used to join the pipeline stages.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace Pipeline {
+
+/**
+ * @enum OverflowPolicy
+ * @brief What a producer does when the downstream queue is full.
+ */
+enum class OverflowPolicy {
+  kBlock,      /**< Wait until the consumer frees a slot */
+  kDropOldest  /**< Evict the oldest queued item to make room */
+};
+
+/**
+ * @class RingBuffer
+ * @brief Bounded multi-producer/multi-consumer lock-free queue.
+ *
+ * Each slot carries a sequence number that tells producers and consumers
+ * whether it is free or filled, so no mutex is taken on the hot path. The
+ * producer side may also pop, which is how the drop-oldest policy evicts
+ * stale frames without a second lock.
+ *
+ * A blocking push() or pop() that finds the queue full or empty sleeps on
+ * a condition variable instead of polling. The other side takes the mutex
+ * to wake it only while a thread is asleep, so an idle stage costs no CPU
+ * and a busy queue never locks.
+ *
+ * @tparam T Movable element type.
+ */
+template <typename T>
+class RingBuffer {
+ public:
+  /**
+   * @brief Constructs a ring buffer.
+   * @param capacity Requested number of slots, rounded up to a power of two.
+   * @throws std::runtime_error if capacity is 0 or too large to round up.
+   */
+  explicit RingBuffer(size_t capacity)
+      : mask(roundUpPow2(capacity) - 1),
+        cells(new Cell[mask + 1]),
+        enqueuePos(0),
+        dequeuePos(0),
+        closed(false),
+        sleepingProducers(0),
+        sleepingConsumers(0) {
+    for (size_t i = 0; i <= mask; ++i) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  /**
+   * @brief Attempts to enqueue an item without waiting.
+   * @param item The item to enqueue, moved from on success.
+   * @return True if the item was enqueued, false if the queue is full.
+   */
+  bool tryPush(T& item) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells[pos & mask];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::move(item);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Attempts to dequeue an item without waiting.
+   * @param item Receives the dequeued item on success.
+   * @return True if an item was dequeued, false if the queue is empty.
+   */
+  bool tryPop(T& item) {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells[pos & mask];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+    item = std::move(cell->data);
+    cell->data = T();
+    cell->sequence.store(pos + mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Enqueues an item, applying the overflow policy when full.
+   * @param item The item to enqueue.
+   * @param policy Backpressure policy to apply when the queue is full.
+   * @return The number of queued items evicted to make room.
+   */
+  size_t push(T item, OverflowPolicy policy) {
+    size_t dropped = 0;
+    while (!tryPush(item)) {
+      if (closed.load(std::memory_order_acquire)) {
+        return dropped;
+      }
+      if (policy == OverflowPolicy::kDropOldest) {
+        T evicted;
+        if (tryPop(evicted)) {
+          ++dropped;
+        }
+      } else {
+        sleepUntil(notFull, sleepingProducers,
+                   [this]() { return writable(); });
+      }
+    }
+    wake(notEmpty, sleepingConsumers);
+    return dropped;
+  }
+
+  /**
+   * @brief Dequeues an item, waiting until one is available.
+   * @param item Receives the dequeued item.
+   * @return False once the queue has been closed and drained.
+   */
+  bool pop(T& item) {
+    while (!tryPop(item)) {
+      if (closed.load(std::memory_order_acquire)) {
+        if (!tryPop(item)) {
+          return false;
+        }
+        break;
+      }
+      sleepUntil(notEmpty, sleepingConsumers,
+                 [this]() { return readable(); });
+    }
+    wake(notFull, sleepingProducers);
+    return true;
+  }
+
+  /**
+   * @brief Marks the queue closed so waiting producers and consumers return.
+   */
+  void close() {
+    closed.store(true, std::memory_order_release);
+    // Under the lock, so no thread checks closed and then misses the wakeup
+    std::lock_guard<std::mutex> lock(mutex);
+    notFull.notify_all();
+    notEmpty.notify_all();
+  }
+
+  /**
+   * @brief Checks whether the queue has been closed.
+   * @return True after close() has been called.
+   */
+  bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Gets the approximate number of queued items.
+   * @return The queue depth at the time of the call.
+   */
+  size_t size() const {
+    size_t head = dequeuePos.load(std::memory_order_relaxed);
+    size_t tail = enqueuePos.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  /**
+   * @brief Gets the number of slots in the queue.
+   * @return The queue capacity.
+   */
+  size_t capacity() const { return mask + 1; }
+
+ private:
+  /**
+   * @struct Cell
+   * @brief A slot tagged with the sequence number of its next operation.
+   */
+  struct Cell {
+    std::atomic<size_t> sequence; /**< Slot sequence number */
+    T data;                       /**< Stored item */
+  };
+
+  /**
+   * @brief Checks whether the next slot to write is free.
+   * @return True if a push would likely succeed now.
+   */
+  bool writable() const {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    return cells[pos & mask].sequence.load(std::memory_order_acquire) == pos;
+  }
+
+  /**
+   * @brief Checks whether the next slot to read is filled.
+   * @return True if a pop would likely succeed now.
+   */
+  bool readable() const {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    return cells[pos & mask].sequence.load(std::memory_order_acquire) ==
+           pos + 1;
+  }
+
+  /**
+   * @brief Sleeps until a condition holds or the queue is closed.
+   * @param signal Condition variable the other side notifies.
+   * @param sleeping Count of threads asleep on signal.
+   * @param ready The condition, checked under the lock.
+   */
+  template <typename Ready>
+  void sleepUntil(std::condition_variable& signal,
+                  std::atomic<int>& sleeping, Ready ready) {
+    sleeping.fetch_add(1);
+    // Pairs with the fence in wake(): either the waker sees this sleeper
+    // or the check below sees the waker's slot
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      signal.wait(lock, [this, &ready]() {
+        return ready() || closed.load(std::memory_order_acquire);
+      });
+    }
+    sleeping.fetch_sub(1);
+  }
+
+  /**
+   * @brief Wakes a thread asleep on a condition variable, if there is one.
+   * @param signal The condition variable.
+   * @param sleeping Count of threads asleep on signal.
+   */
+  void wake(std::condition_variable& signal, std::atomic<int>& sleeping) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) > 0) {
+      // Taking the lock orders this after the sleeper's check or its wait
+      { std::lock_guard<std::mutex> lock(mutex); }
+      signal.notify_one();
+    }
+  }
+
+  /**
+   * @brief Rounds a capacity up to the next power of two.
+   * @param value Requested capacity.
+   * @return The smallest power of two not less than value (at least 2).
+   * @throws std::runtime_error if value is 0 or too large to round up.
+   */
+  static size_t roundUpPow2(size_t value) {
+    if (value == 0 || value > std::numeric_limits<size_t>::max() / 2 + 1) {
+      throw std::runtime_error("Queue capacity must be at least 1");
+    }
+    size_t result = 2;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  const size_t mask;              /**< Capacity minus one */
+  std::unique_ptr<Cell[]> cells;  /**< Slot storage */
+  std::atomic<size_t> enqueuePos; /**< Next slot to be written */
+  std::atomic<size_t> dequeuePos; /**< Next slot to be read */
+  std::atomic<bool> closed; /**< Set once the producer side shuts down */
+  std::mutex mutex;         /**< Guards sleeping on the condition variables */
+  std::condition_variable notFull;  /**< Signalled when a slot frees up */
+  std::condition_variable notEmpty; /**< Signalled when a slot fills */
+  std::atomic<int> sleepingProducers; /**< Producers waiting in push() */
+  std::atomic<int> sleepingConsumers; /**< Consumers waiting in pop() */
+};
+
+}  // namespace Pipeline
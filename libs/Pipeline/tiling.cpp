@@ -0,0 +1,291 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "tiling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <opencv2/imgproc.hpp>
+#include <stdexcept>
+#ifndef ACME_HEADLESS
+#include <opencv2/highgui.hpp>
+#endif
+
+namespace Pipeline {
+
+namespace {
+
+/**
+ * @brief Spreads tiles evenly along one frame side.
+ * @param length Length of the frame side.
+ * @param side Tile side.
+ * @param overlap Fraction of a tile shared with a neighbor.
+ * @return The tile starts; the last tile ends on the border.
+ */
+std::vector<int> tileStarts(int length, int side, float overlap) {
+  if (length <= side) {
+    return std::vector<int>(1, 0);
+  }
+  const int stride = std::max(1, static_cast<int>(side * (1.f - overlap)));
+  const int count = (length - side + stride - 1) / stride + 1;
+  std::vector<int> starts(count);
+  for (int i = 0; i < count; ++i) {
+    starts[i] = static_cast<int>(
+        std::lround(static_cast<double>(i) * (length - side) / (count - 1)));
+  }
+  return starts;
+}
+
+}  // namespace
+
+/**
+ * @brief Covers a frame with overlapping square tiles.
+ * @param frameSize Size of the frame.
+ * @param tileSide Side of a tile in frame pixels.
+ * @param overlap Fraction of a tile shared with a neighbor, in [0, 1).
+ * @return The tiles, row by row.
+ */
+std::vector<cv::Rect> makeTileGrid(const cv::Size& frameSize, int tileSide,
+                                   float overlap) {
+  if (tileSide <= 0 || !(overlap >= 0.f && overlap < 1.f)) {
+    throw std::runtime_error("Tiles need a positive side and an overlap in "
+                             "[0, 1)");
+  }
+  std::vector<cv::Rect> tiles;
+  const int width = std::min(tileSide, frameSize.width);
+  const int height = std::min(tileSide, frameSize.height);
+  for (int y : tileStarts(frameSize.height, tileSide, overlap)) {
+    for (int x : tileStarts(frameSize.width, tileSide, overlap)) {
+      tiles.emplace_back(x, y, width, height);
+    }
+  }
+  return tiles;
+}
+
+/**
+ * @brief Merges the detections of overlapping tiles.
+ * @param detections Detections in frame pixels, from every tile.
+ * @param threshold Intersection over the smaller box that merges.
+ * @return The merged detections, best first.
+ */
+Detector::Detections mergeDetections(const Detector::Detections& detections,
+                                     float threshold) {
+  std::vector<size_t> order(detections.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return detections[a].score > detections[b].score;
+  });
+
+  Detector::Detections merged;
+  std::vector<bool> used(detections.size(), false);
+  for (size_t i = 0; i < order.size(); ++i) {
+    if (used[order[i]]) {
+      continue;
+    }
+    const Detector::Detection& best = detections[order[i]];
+    Detector::Detection result = best;
+    for (size_t j = i + 1; j < order.size(); ++j) {
+      const Detector::Detection& other = detections[order[j]];
+      if (used[order[j]] || other.classId != best.classId) {
+        continue;
+      }
+      // Compared with the strongest box, not the growing union, so merges
+      // do not chain along a row of neighbors
+      const int smaller = std::min(best.box.area(), other.box.area());
+      if (smaller > 0 && (best.box & other.box).area() > threshold * smaller) {
+        result.box |= other.box;
+        used[order[j]] = true;
+      }
+    }
+    merged.push_back(result);
+  }
+  return merged;
+}
+
+/**
+ * @brief Constructs a tiled detector around an initialized detector.
+ * @param detector Detector run on the tiles. Must outlive this object.
+ * @param config Tiling tunables.
+ * @param trackerConfig Tracker used by process() and run().
+ */
+TiledDetector::TiledDetector(Detector::YOLODetector& detector,
+                             const TilingConfig& config,
+                             const Tracker::MultiTrackerConfig& trackerConfig)
+    : detector(detector),
+      config(config),
+      tracker(trackerConfig),
+      gridSide(0),
+      roiFrames(0) {
+  if (this->config.maxBatch < 1) {
+    this->config.maxBatch = 1;
+  }
+}
+
+/**
+ * @brief Detects on every tile of a frame.
+ * @param frame The BGR frame.
+ * @return The merged detections in frame pixels.
+ */
+Detector::Detections TiledDetector::detect(const cv::Mat& frame) {
+  updateGrid(frame.size());
+  selected = grid;
+  return detectSelected(frame);
+}
+
+/**
+ * @brief Detects on the tiles that touch any region of interest, or on
+ * every tile on a scan frame.
+ * @param frame The BGR frame.
+ * @param regions Areas of recent activity in frame pixels, grown by
+ * roiMargin before tiles are picked.
+ * @return The merged detections in frame pixels.
+ */
+Detector::Detections TiledDetector::detect(
+    const cv::Mat& frame, const std::vector<cv::Rect>& regions) {
+  updateGrid(frame.size());
+  const bool scan =
+      config.scanInterval <= 1 || roiFrames % config.scanInterval == 0;
+  ++roiFrames;
+  if (scan) {
+    selected = grid;
+    return detectSelected(frame);
+  }
+
+  selected.clear();
+  const int margin = config.roiMargin;
+  for (const cv::Rect& tile : grid) {
+    for (const cv::Rect& region : regions) {
+      cv::Rect grown(region.x - margin, region.y - margin,
+                     region.width + 2 * margin, region.height + 2 * margin);
+      if ((tile & grown).area() > 0) {
+        selected.push_back(tile);
+        break;
+      }
+    }
+  }
+  return detectSelected(frame);
+}
+
+/**
+ * @brief Processes one frame, using the tracks as regions of interest
+ * when roi is set.
+ * @param packet Holds the frame; receives the detections and the
+ * confirmed tracks.
+ * @param roi Restrict detection to the tiles around the tracks.
+ */
+void TiledDetector::process(FramePacket& packet, bool roi) {
+  if (roi) {
+    // Tentative tracks count too: a new person should keep its tiles
+    std::vector<cv::Rect> regions;
+    for (const Tracker::Track& track : tracker.getTracks()) {
+      regions.push_back(track.box);
+    }
+    packet.detections = detect(packet.frame, regions);
+  } else {
+    packet.detections = detect(packet.frame);
+  }
+  packet.tracks = trackDetections(tracker, packet.detections);
+}
+
+/**
+ * @brief Runs on a capture device until it ends or 'q' is pressed.
+ * @param cap An opened video capture.
+ * @param roi Restrict detection to the tiles around the tracks.
+ * @param maxFrames Stop after this many frames; 0 runs until the end.
+ * @return The number of frames processed.
+ */
+uint64_t TiledDetector::run(cv::VideoCapture& cap, bool roi,
+                            uint64_t maxFrames) {
+  if (!cap.isOpened()) {
+    std::cerr << "Error opening video stream or file" << std::endl;
+    return 0;
+  }
+
+  uint64_t count = 0;
+  FramePacket packet;
+  while (cap.read(packet.frame) && !packet.frame.empty()) {
+    packet.index = count;
+    process(packet, roi);
+#ifndef ACME_HEADLESS
+    for (const cv::Rect& tile : selected) {
+      cv::rectangle(packet.frame, tile, cv::Scalar(128, 128, 128), 1);
+    }
+    detector.render(packet.frame, packet.detections);
+    drawTracks(packet.frame, packet.tracks);
+    cv::imshow("YOLO Detection", packet.frame);
+#endif
+    ++count;
+    if (maxFrames > 0 && count >= maxFrames) {
+      break;
+    }
+#ifndef ACME_HEADLESS
+    if (cv::waitKey(1) == 113) {  // Press 'q' to exit
+      break;
+    }
+#endif
+  }
+#ifndef ACME_HEADLESS
+  cv::destroyAllWindows();
+#endif
+  return count;
+}
+
+/**
+ * @brief Detects on the selected tiles and merges the results.
+ * @param frame The BGR frame.
+ * @return The merged detections in frame pixels.
+ */
+Detector::Detections TiledDetector::detectSelected(const cv::Mat& frame) {
+  // Tiles are views into the frame; nothing is copied before letterboxing
+  std::vector<cv::Mat> images;
+  std::vector<cv::Point> origins;
+  for (const cv::Rect& tile : selected) {
+    images.push_back(frame(tile));
+    origins.push_back(tile.tl());
+  }
+  const bool wholeFrameTile =
+      grid.size() == 1 && grid[0].size() == frame.size();
+  if (config.fullFrame && !wholeFrameTile) {
+    images.push_back(frame);
+    origins.push_back(cv::Point());
+  }
+
+  Detector::Detections detections;
+  const size_t maxBatch = static_cast<size_t>(config.maxBatch);
+  for (size_t begin = 0; begin < images.size(); begin += maxBatch) {
+    const size_t end = std::min(begin + maxBatch, images.size());
+    std::vector<cv::Mat> batch(images.begin() + begin, images.begin() + end);
+    std::vector<Detector::BoxTransform> transforms;
+    cv::Mat blob = detector.preprocessBatch(batch, &transforms);
+    for (size_t k = 0; k < transforms.size(); ++k) {
+      // Shift each tile's boxes straight into frame pixels
+      transforms[k].offsetX -= origins[begin + k].x;
+      transforms[k].offsetY -= origins[begin + k].y;
+    }
+    for (const Detector::Detections& tile :
+         detector.postprocessBatch(transforms, detector.infer(blob))) {
+      detections.insert(detections.end(), tile.begin(), tile.end());
+    }
+    ++counters.batches;
+  }
+  ++counters.frames;
+  counters.tiles += selected.size();
+  return mergeDetections(detections, config.mergeThreshold);
+}
+
+/**
+ * @brief Rebuilds the tile grid if the frame size or tile side changed.
+ * @param frameSize Size of the new frame.
+ */
+void TiledDetector::updateGrid(const cv::Size& frameSize) {
+  // Follow the input size, which a latency budget may change
+  const int side = config.tileSide > 0 ? config.tileSide
+                                       : detector.getInputSize().width;
+  if (frameSize != gridSize || side != gridSide) {
+    grid = makeTileGrid(frameSize, side, config.overlap);
+    gridSize = frameSize;
+    gridSide = side;
+  }
+}
+
+}  // namespace Pipeline
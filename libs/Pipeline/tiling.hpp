@@ -0,0 +1,187 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file tiling.hpp
+ * @brief Header file for tiled detection on high-resolution frames.
+ */
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <vector>
+
+#include "detector.hpp"
+#include "multi_tracker.hpp"
+#include "pipeline.hpp"
+
+namespace Pipeline {
+
+/**
+ * @struct TilingConfig
+ * @brief Tunables for tiled detection.
+ */
+struct TilingConfig {
+  /**< Tile side in frame pixels; 0 uses the network input side, so tiles
+   * are detected at the camera's own resolution */
+  int tileSide = 0;
+  float overlap = 0.25f; /**< Fraction of a tile shared with a neighbor */
+  /**< Also detect on the whole frame, scaled down, for objects larger than
+   * the overlap */
+  bool fullFrame = true;
+  int maxBatch = 8; /**< Most images per forward pass */
+  /**< Intersection over the smaller box above which two detections of one
+   * class are merged into one */
+  float mergeThreshold = 0.5f;
+  int roiMargin = 64; /**< Pixels a region of interest is grown by */
+  /**< In region-of-interest mode, detect on every tile once per this many
+   * frames to find new objects; 1 always does */
+  int scanInterval = 10;
+};
+
+/**
+ * @struct TilingStats
+ * @brief Counters of the tiled detector.
+ */
+struct TilingStats {
+  uint64_t frames = 0;  /**< Frames detected */
+  uint64_t tiles = 0;   /**< Tiles detected, full frames excluded */
+  uint64_t batches = 0; /**< Forward passes run */
+
+  /**
+   * @brief Gets the mean number of tiles per frame.
+   * @return tiles / frames, or 0 before the first frame.
+   */
+  double meanTiles() const {
+    return frames == 0 ? 0.0 : static_cast<double>(tiles) / frames;
+  }
+};
+
+/**
+ * @brief Covers a frame with overlapping square tiles.
+ *
+ * Tiles are spread evenly so the last row and column end on the frame
+ * border; neighbors overlap by at least overlap * tileSide. A frame side
+ * shorter than the tile gets a single tile of that side.
+ *
+ * @param frameSize Size of the frame.
+ * @param tileSide Side of a tile in frame pixels.
+ * @param overlap Fraction of a tile shared with a neighbor, in [0, 1).
+ * @return The tiles, row by row.
+ */
+std::vector<cv::Rect> makeTileGrid(const cv::Size& frameSize, int tileSide,
+                                   float overlap);
+
+/**
+ * @brief Merges the detections of overlapping tiles.
+ *
+ * A person cut by a tile seam is detected in part on each side, so
+ * detections of one class are merged, strongest first, when their
+ * intersection covers more than the threshold of the smaller box; the
+ * merged box is the union and keeps the best score.
+ *
+ * @param detections Detections in frame pixels, from every tile.
+ * @param threshold Intersection over the smaller box that merges.
+ * @return The merged detections, best first.
+ */
+Detector::Detections mergeDetections(const Detector::Detections& detections,
+                                     float threshold);
+
+/**
+ * @class TiledDetector
+ * @brief Detects on overlapping tiles of a large frame so distant people
+ * keep enough pixels to be found.
+ *
+ * The tiles, plus the scaled-down frame if fullFrame is set, go through the
+ * network in batches of up to maxBatch, and each tile's boxes are mapped
+ * straight to frame pixels before the seams are merged. In
+ * region-of-interest mode only the tiles near recent tracks are detected,
+ * with a full scan every scanInterval frames.
+ */
+class TiledDetector {
+ public:
+  /**
+   * @brief Constructs a tiled detector around an initialized detector.
+   * @param detector Detector run on the tiles. Must outlive this object.
+   * @param config Tiling tunables.
+   * @param trackerConfig Tracker used by process() and run().
+   */
+  TiledDetector(Detector::YOLODetector& detector,
+                const TilingConfig& config = TilingConfig(),
+                const Tracker::MultiTrackerConfig& trackerConfig =
+                    Tracker::MultiTrackerConfig());
+
+  /**
+   * @brief Detects on every tile of a frame.
+   * @param frame The BGR frame.
+   * @return The merged detections in frame pixels.
+   */
+  Detector::Detections detect(const cv::Mat& frame);
+
+  /**
+   * @brief Detects on the tiles that touch any region of interest, or on
+   * every tile on a scan frame.
+   * @param frame The BGR frame.
+   * @param regions Areas of recent activity in frame pixels, grown by
+   * roiMargin before tiles are picked.
+   * @return The merged detections in frame pixels.
+   */
+  Detector::Detections detect(const cv::Mat& frame,
+                              const std::vector<cv::Rect>& regions);
+
+  /**
+   * @brief Processes one frame, using the tracks as regions of interest
+   * when roi is set.
+   * @param packet Holds the frame; receives the detections and the
+   * confirmed tracks.
+   * @param roi Restrict detection to the tiles around the tracks.
+   */
+  void process(FramePacket& packet, bool roi);
+
+  /**
+   * @brief Runs on a capture device until it ends or 'q' is pressed.
+   * @param cap An opened video capture.
+   * @param roi Restrict detection to the tiles around the tracks.
+   * @param maxFrames Stop after this many frames; 0 runs until the end.
+   * @return The number of frames processed.
+   */
+  uint64_t run(cv::VideoCapture& cap, bool roi, uint64_t maxFrames = 0);
+
+  /**
+   * @brief Gets the tiles the last detect() ran on.
+   * @return The tiles in frame pixels, full frame excluded.
+   */
+  const std::vector<cv::Rect>& lastTiles() const { return selected; }
+
+  /**
+   * @brief Gets the counters.
+   * @return The tiling statistics.
+   */
+  const TilingStats& stats() const { return counters; }
+
+ private:
+  /**
+   * @brief Detects on the selected tiles and merges the results.
+   * @param frame The BGR frame.
+   * @return The merged detections in frame pixels.
+   */
+  Detector::Detections detectSelected(const cv::Mat& frame);
+
+  /**
+   * @brief Rebuilds the tile grid if the frame size or tile side changed.
+   * @param frameSize Size of the new frame.
+   */
+  void updateGrid(const cv::Size& frameSize);
+
+  Detector::YOLODetector& detector; /**< Detector run on the tiles */
+  TilingConfig config;              /**< Tiling tunables */
+  Tracker::MultiTracker tracker;    /**< Tracks for process() and run() */
+  cv::Size gridSize;                /**< Frame size the grid was built for */
+  int gridSide;                     /**< Tile side the grid was built for */
+  std::vector<cv::Rect> grid;       /**< Every tile of the frame */
+  std::vector<cv::Rect> selected;   /**< Tiles of the last detect() */
+  uint64_t roiFrames;               /**< Frames detected in ROI mode */
+  TilingStats counters;             /**< Tiling statistics */
+};
+
+}  // namespace Pipeline
@@ -0,0 +1,370 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "projection.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <opencv2/calib3d.hpp>
+#include <stdexcept>
+
+namespace Projection {
+
+namespace {
+
+/**
+ * @brief Copies a 3x3 matrix read from a file.
+ * @param mat The matrix, of any depth.
+ * @param what Name used in the error.
+ * @return The matrix.
+ * @throws std::runtime_error if it is not 3x3.
+ */
+cv::Matx33d toMatx33d(const cv::Mat& mat, const std::string& what) {
+  if (mat.rows != 3 || mat.cols != 3) {
+    throw std::runtime_error(what + " must be a 3x3 matrix");
+  }
+  cv::Mat values;
+  mat.convertTo(values, CV_64F);
+  cv::Matx33d result;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      result(i, j) = values.at<double>(i, j);
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Copies a 3-vector read from a file.
+ * @param mat The vector, as a row or a column, of any depth.
+ * @param what Name used in the error.
+ * @return The vector.
+ * @throws std::runtime_error if it does not have three elements.
+ */
+cv::Vec3d toVec3d(const cv::Mat& mat, const std::string& what) {
+  if (mat.total() != 3 || mat.channels() != 1) {
+    throw std::runtime_error(what + " must have three elements");
+  }
+  cv::Mat values;
+  mat.reshape(1, 3).convertTo(values, CV_64F);
+  return cv::Vec3d(values.at<double>(0), values.at<double>(1),
+                   values.at<double>(2));
+}
+
+/**
+ * @brief Reads a two-channel table between its entries.
+ * @param table A CV_32FC2 table with one entry per pixel.
+ * @param point Where to read, in pixels; clamped to the table.
+ * @return The bilinear interpolation of the four nearest entries.
+ */
+cv::Vec2f sampleTable(const cv::Mat& table, const cv::Point2f& point) {
+  const float x = std::min(std::max(point.x, 0.f), table.cols - 1.f);
+  const float y = std::min(std::max(point.y, 0.f), table.rows - 1.f);
+  const int x0 = static_cast<int>(x);
+  const int y0 = static_cast<int>(y);
+  const int x1 = std::min(x0 + 1, table.cols - 1);
+  const int y1 = std::min(y0 + 1, table.rows - 1);
+  const float fx = x - x0;
+  const float fy = y - y0;
+  const cv::Vec2f* upper = table.ptr<cv::Vec2f>(y0);
+  const cv::Vec2f* lower = table.ptr<cv::Vec2f>(y1);
+  return (upper[x0] * (1.f - fx) + upper[x1] * fx) * (1.f - fy) +
+         (lower[x0] * (1.f - fx) + lower[x1] * fx) * fy;
+}
+
+}  // namespace
+
+/**
+ * @brief Builds the model of a camera on the robot's vertical axis,
+ * looking forward and pitched down.
+ * @param cameraMatrix Intrinsic matrix K.
+ * @param imageSize Image size the intrinsics were fit at.
+ * @param height Height of the camera above the ground in meters.
+ * @param pitchDegrees Downward tilt of the optical axis in degrees.
+ * @param distortion Distortion coefficients, or empty.
+ * @return The camera model.
+ */
+CameraModel makeCameraModel(const cv::Matx33d& cameraMatrix,
+                            const cv::Size& imageSize, double height,
+                            double pitchDegrees, const cv::Mat& distortion) {
+  const double pitch = pitchDegrees * CV_PI / 180.0;
+  const double c = std::cos(pitch);
+  const double s = std::sin(pitch);
+  CameraModel camera;
+  camera.imageSize = imageSize;
+  camera.cameraMatrix = cameraMatrix;
+  camera.distortion = distortion;
+  // Columns are the camera axes in the robot frame: x right = -y, y down =
+  // -z, z forward = x, then tilted down about the robot's y axis
+  camera.rotation = cv::Matx33d(0, -s, c,
+                                -1, 0, 0,
+                                0, -c, -s);
+  camera.translation = cv::Vec3d(0, 0, height);
+  return camera;
+}
+
+/**
+ * @brief Reads a camera model from an OpenCV YAML or XML file.
+ * @param path Path to the file.
+ * @return The camera model.
+ * @throws std::runtime_error if the file is missing or incomplete.
+ */
+CameraModel readCameraModel(const std::string& path) {
+  try {
+    cv::FileStorage storage(path, cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+      throw std::runtime_error("Cannot read camera model " + path);
+    }
+    const cv::Size imageSize(static_cast<int>(storage["image_width"]),
+                             static_cast<int>(storage["image_height"]));
+    cv::Mat cameraMatrix;
+    cv::Mat distortion;
+    storage["camera_matrix"] >> cameraMatrix;
+    storage["distortion_coefficients"] >> distortion;
+    if (imageSize.area() <= 0 || cameraMatrix.empty()) {
+      throw std::runtime_error(path + " needs image_width, image_height and "
+                               "camera_matrix");
+    }
+    const cv::Matx33d intrinsics = toMatx33d(cameraMatrix, "camera_matrix");
+    if (!distortion.empty()) {
+      distortion.convertTo(distortion, CV_64F);
+    }
+
+    if (!storage["rotation"].empty()) {
+      cv::Mat rotation;
+      cv::Mat translation;
+      storage["rotation"] >> rotation;
+      storage["translation"] >> translation;
+      if (rotation.total() == 3) {
+        cv::Mat vector = rotation.reshape(1, 3);
+        vector.convertTo(vector, CV_64F);
+        cv::Rodrigues(vector, rotation);
+      }
+      CameraModel camera;
+      camera.imageSize = imageSize;
+      camera.cameraMatrix = intrinsics;
+      camera.distortion = distortion;
+      camera.rotation = toMatx33d(rotation, "rotation");
+      camera.translation = toVec3d(translation, "translation");
+      return camera;
+    }
+    if (!storage["mount_height"].empty()) {
+      return makeCameraModel(intrinsics, imageSize,
+                             storage["mount_height"].real(),
+                             storage["mount_pitch"].real(), distortion);
+    }
+    throw std::runtime_error(path + " needs rotation and translation, or "
+                             "mount_height and mount_pitch");
+  } catch (const cv::Exception& e) {
+    throw std::runtime_error("Cannot parse camera model " + path + ": " +
+                             e.what());
+  }
+}
+
+/**
+ * @brief Builds the lookup tables.
+ * @param camera The calibrated camera.
+ * @param config Projection tunables.
+ * @throws std::runtime_error if the camera model is incomplete.
+ */
+GroundProjector::GroundProjector(const CameraModel& camera,
+                                 const ProjectionConfig& config)
+    : model(camera), config(config) {
+  const cv::Size size = model.imageSize;
+  if (size.area() <= 0 || model.cameraMatrix(0, 0) <= 0 ||
+      model.cameraMatrix(1, 1) <= 0) {
+    throw std::runtime_error("The camera model needs an image size and "
+                             "focal lengths");
+  }
+
+  // Undistorting point by point is iterative; do every pixel once here
+  cv::Mat pixels(1, size.area(), CV_32FC2);
+  cv::Vec2f* pixel = pixels.ptr<cv::Vec2f>();
+  for (int v = 0; v < size.height; ++v) {
+    for (int u = 0; u < size.width; ++u) {
+      *pixel++ = cv::Vec2f(static_cast<float>(u), static_cast<float>(v));
+    }
+  }
+  cv::Mat undistorted;
+  cv::undistortPoints(pixels, undistorted, model.cameraMatrix,
+                      model.distortion);
+  normalizedTable = undistorted.reshape(2, size.height);
+
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  groundTable.create(size, CV_32FC2);
+  for (int v = 0; v < size.height; ++v) {
+    const cv::Vec2f* rays = normalizedTable.ptr<cv::Vec2f>(v);
+    cv::Vec2f* ground = groundTable.ptr<cv::Vec2f>(v);
+    for (int u = 0; u < size.width; ++u) {
+      const cv::Vec3d ray =
+          model.rotation * cv::Vec3d(rays[u][0], rays[u][1], 1.0);
+      const double t = -model.translation[2] / ray[2];
+      if (ray[2] < 0 && t > 0) {
+        ground[u] = cv::Vec2f(
+            static_cast<float>(model.translation[0] + t * ray[0]),
+            static_cast<float>(model.translation[1] + t * ray[1]));
+      } else {
+        ground[u] = cv::Vec2f(nan, nan);  // At or above the horizon
+      }
+    }
+  }
+}
+
+/**
+ * @brief Locates a detection.
+ * @param box The detection box in frame pixels.
+ * @param frameSize Size of the frame; boxes are rescaled if it differs
+ * from the calibrated image size.
+ * @return The position; invalid if no estimate applies.
+ */
+Position GroundProjector::project(const cv::Rect& box,
+                                  const cv::Size& frameSize) const {
+  const float scaleX =
+      static_cast<float>(model.imageSize.width) / frameSize.width;
+  const float scaleY =
+      static_cast<float>(model.imageSize.height) / frameSize.height;
+  const float centerX = (box.x + 0.5f * box.width) * scaleX;
+  const float top = box.y * scaleY;
+  const float bottom = (box.y + box.height) * scaleY;
+  const bool feetCut =
+      box.y + box.height >= frameSize.height - config.borderMargin;
+  const bool headCut = box.y <= config.borderMargin;
+
+  Position position;
+  if (!feetCut) {
+    const cv::Vec2f ground =
+        sampleTable(groundTable, cv::Point2f(centerX, bottom));
+    const double range = std::hypot(ground[0] - model.translation[0],
+                                     ground[1] - model.translation[1]);
+    if (!std::isnan(ground[0]) && range <= config.maxGroundRange) {
+      position.point = cv::Point3f(ground[0], ground[1], 0.f);
+      position.source = DepthSource::kGroundPlane;
+      position.valid = true;
+      return position;
+    }
+  }
+
+  position.source = DepthSource::kHeightPrior;
+  if (feetCut) {
+    // Close enough for the feet to leave the frame: the top of the head
+    // lies on the plane at the prior height
+    cv::Point3f head;
+    if (!headCut &&
+        meetPlane(cv::Point2f(centerX, top), config.personHeight, &head)) {
+      position.point = cv::Point3f(head.x, head.y, 0.f);
+      position.valid = true;
+    }
+    return position;
+  }
+
+  // Far or above the horizon: the distance follows from the apparent
+  // height, taking the person as roughly parallel to the image plane
+  const cv::Point2f headRay = normalized(cv::Point2f(centerX, top));
+  const cv::Point2f feetRay = normalized(cv::Point2f(centerX, bottom));
+  const double span = feetRay.y - headRay.y;
+  if (headCut || span <= 0) {
+    return position;
+  }
+  const double depth = config.personHeight / span;
+  const cv::Vec3d feet =
+      model.translation +
+      model.rotation * cv::Vec3d(depth * feetRay.x, depth * feetRay.y, depth);
+  position.point = cv::Point3f(static_cast<float>(feet[0]),
+                               static_cast<float>(feet[1]), 0.f);
+  position.valid = true;
+  return position;
+}
+
+/**
+ * @brief Locates several detections.
+ * @param boxes The detection boxes in frame pixels.
+ * @param frameSize Size of the frame.
+ * @return One position per box, in order.
+ */
+std::vector<Position> GroundProjector::project(
+    const std::vector<cv::Rect>& boxes, const cv::Size& frameSize) const {
+  std::vector<Position> positions;
+  positions.reserve(boxes.size());
+  for (const cv::Rect& box : boxes) {
+    positions.push_back(project(box, frameSize));
+  }
+  return positions;
+}
+
+/**
+ * @brief Gets the undistorted normalized coordinates of a pixel.
+ * @param pixel A pixel of the calibrated image; clamped to the image and
+ * interpolated between table entries.
+ * @return (x / z, y / z) of the pixel's ray in the camera frame.
+ */
+cv::Point2f GroundProjector::normalized(const cv::Point2f& pixel) const {
+  const cv::Vec2f ray = sampleTable(normalizedTable, pixel);
+  return cv::Point2f(ray[0], ray[1]);
+}
+
+/**
+ * @brief Rotates a pixel's ray into the robot frame.
+ * @param pixel A pixel of the calibrated image.
+ * @return The ray direction, not normalized.
+ */
+cv::Vec3d GroundProjector::robotRay(const cv::Point2f& pixel) const {
+  const cv::Point2f ray = normalized(pixel);
+  return model.rotation * cv::Vec3d(ray.x, ray.y, 1.0);
+}
+
+/**
+ * @brief Intersects a pixel's ray with a horizontal plane.
+ * @param pixel A pixel of the calibrated image.
+ * @param height Height of the plane in meters.
+ * @param point Receives the intersection.
+ * @return False if the ray does not meet the plane in front of the
+ * camera.
+ */
+bool GroundProjector::meetPlane(const cv::Point2f& pixel, double height,
+                                cv::Point3f* point) const {
+  const cv::Vec3d ray = robotRay(pixel);
+  if (std::abs(ray[2]) < 1e-9) {
+    return false;
+  }
+  const double t = (height - model.translation[2]) / ray[2];
+  if (t <= 0) {
+    return false;
+  }
+  *point = cv::Point3f(static_cast<float>(model.translation[0] + t * ray[0]),
+                       static_cast<float>(model.translation[1] + t * ray[1]),
+                       static_cast<float>(height));
+  return true;
+}
+
+/**
+ * @brief Gets tracker tunables for positions in meters.
+ * @return The tracker tunables.
+ */
+Tracker::MultiTrackerConfig metricTrackerConfig() {
+  Tracker::MultiTrackerConfig config;
+  config.metric = Tracker::AssociationMetric::kCentroid;
+  config.maxDistance = 0.5f;
+  config.filter.processNoise = 1e-3f;
+  config.filter.measurementNoise = 4e-2f;  // 0.2 m standard deviation
+  return config;
+}
+
+/**
+ * @brief Turns positions into the boxes the tracker associates.
+ * @param positions Positions from GroundProjector::project(); invalid
+ * ones are left out.
+ * @param side Side of the square a person covers on the ground, meters.
+ * @return Squares in robot-frame (x, y) meters, centered on the positions.
+ */
+std::vector<cv::Rect2f> footprints(const std::vector<Position>& positions,
+                                   float side) {
+  std::vector<cv::Rect2f> boxes;
+  for (const Position& position : positions) {
+    if (position.valid) {
+      boxes.emplace_back(position.point.x - 0.5f * side,
+                         position.point.y - 0.5f * side, side, side);
+    }
+  }
+  return boxes;
+}
+
+}  // namespace Projection
@@ -0,0 +1,203 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file projection.hpp
+ * @brief Header file for the calibrated camera model and the monocular
+ * projection of detections into metric robot coordinates.
+ */
+
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+#include "multi_tracker.hpp"
+
+namespace Projection {
+
+/**
+ * @struct CameraModel
+ * @brief Intrinsic and extrinsic calibration of one camera.
+ *
+ * The robot frame follows ROS REP 103: x forward, y left, z up, with the
+ * ground plane at z = 0. The camera frame is the OpenCV optical frame:
+ * x right, y down, z along the optical axis.
+ */
+struct CameraModel {
+  cv::Size imageSize;       /**< Image size the intrinsics were fit at */
+  cv::Matx33d cameraMatrix; /**< Intrinsic matrix K */
+  /**< OpenCV distortion coefficients (k1, k2, p1, p2[, k3...]); empty
+   * for an undistorted image */
+  cv::Mat distortion;
+  /**< Rotates camera-frame directions into the robot frame */
+  cv::Matx33d rotation;
+  cv::Vec3d translation; /**< Camera position in the robot frame, meters */
+};
+
+/**
+ * @brief Builds the model of a camera on the robot's vertical axis,
+ * looking forward and pitched down.
+ * @param cameraMatrix Intrinsic matrix K.
+ * @param imageSize Image size the intrinsics were fit at.
+ * @param height Height of the camera above the ground in meters.
+ * @param pitchDegrees Downward tilt of the optical axis in degrees.
+ * @param distortion Distortion coefficients, or empty.
+ * @return The camera model.
+ */
+CameraModel makeCameraModel(const cv::Matx33d& cameraMatrix,
+                            const cv::Size& imageSize, double height,
+                            double pitchDegrees,
+                            const cv::Mat& distortion = cv::Mat());
+
+/**
+ * @brief Reads a camera model from an OpenCV YAML or XML file.
+ *
+ * The file holds image_width, image_height, camera_matrix and optionally
+ * distortion_coefficients, as written by OpenCV's calibration sample. The
+ * extrinsics are either a rotation (3x3 matrix, or 3x1 Rodrigues vector)
+ * and a translation, or mount_height and mount_pitch for a forward-facing
+ * camera on the robot's vertical axis.
+ *
+ * @param path Path to the file.
+ * @return The camera model.
+ * @throws std::runtime_error if the file is missing or incomplete.
+ */
+CameraModel readCameraModel(const std::string& path);
+
+/**
+ * @enum DepthSource
+ * @brief How the distance to a detection was found.
+ */
+enum class DepthSource {
+  kGroundPlane, /**< The feet's viewing ray meets the ground */
+  kHeightPrior  /**< The box's top or height, with a known person height */
+};
+
+/**
+ * @struct ProjectionConfig
+ * @brief Tunables for monocular projection.
+ */
+struct ProjectionConfig {
+  float personHeight = 1.7f; /**< Height prior in meters */
+  /**< Ground points farther than this are too sensitive to pitch error
+   * and the height prior is used instead, meters */
+  float maxGroundRange = 25.f;
+  /**< Boxes ending this close to the bottom edge, in pixels, have their
+   * feet cut off */
+  int borderMargin = 2;
+};
+
+/**
+ * @struct Position
+ * @brief A detection's location in the robot frame.
+ */
+struct Position {
+  cv::Point3f point;   /**< Ground contact point in meters */
+  DepthSource source = DepthSource::kGroundPlane; /**< Depth estimate */
+  bool valid = false;  /**< False if no estimate applies */
+};
+
+/**
+ * @class GroundProjector
+ * @brief Maps detection boxes to robot-frame positions through lookup
+ * tables built once from the calibration.
+ *
+ * The constructor undistorts every pixel once into a table of normalized
+ * image coordinates and intersects each pixel's viewing ray with the
+ * ground into a second table. Projecting a box is then a few table
+ * lookups: the ground table at the feet when they are visible and close
+ * enough, otherwise the height prior. The prior puts the top of the box
+ * on the plane z = personHeight when the feet are cut off, and otherwise
+ * takes the distance from the box's apparent height.
+ */
+class GroundProjector {
+ public:
+  /**
+   * @brief Builds the lookup tables.
+   * @param camera The calibrated camera.
+   * @param config Projection tunables.
+   * @throws std::runtime_error if the camera model is incomplete.
+   */
+  explicit GroundProjector(const CameraModel& camera,
+                           const ProjectionConfig& config = ProjectionConfig());
+
+  /**
+   * @brief Locates a detection.
+   * @param box The detection box in frame pixels.
+   * @param frameSize Size of the frame; boxes are rescaled if it differs
+   * from the calibrated image size.
+   * @return The position; invalid if no estimate applies.
+   */
+  Position project(const cv::Rect& box, const cv::Size& frameSize) const;
+
+  /**
+   * @brief Locates several detections.
+   * @param boxes The detection boxes in frame pixels.
+   * @param frameSize Size of the frame.
+   * @return One position per box, in order.
+   */
+  std::vector<Position> project(const std::vector<cv::Rect>& boxes,
+                                const cv::Size& frameSize) const;
+
+  /**
+   * @brief Gets the undistorted normalized coordinates of a pixel.
+   * @param pixel A pixel of the calibrated image; clamped to the image and
+   * interpolated between table entries.
+   * @return (x / z, y / z) of the pixel's ray in the camera frame.
+   */
+  cv::Point2f normalized(const cv::Point2f& pixel) const;
+
+  /**
+   * @brief Gets the camera model.
+   * @return The calibration the tables were built from.
+   */
+  const CameraModel& camera() const { return model; }
+
+ private:
+  /**
+   * @brief Rotates a pixel's ray into the robot frame.
+   * @param pixel A pixel of the calibrated image.
+   * @return The ray direction, not normalized.
+   */
+  cv::Vec3d robotRay(const cv::Point2f& pixel) const;
+
+  /**
+   * @brief Intersects a pixel's ray with a horizontal plane.
+   * @param pixel A pixel of the calibrated image.
+   * @param height Height of the plane in meters.
+   * @param point Receives the intersection.
+   * @return False if the ray does not meet the plane in front of the
+   * camera.
+   */
+  bool meetPlane(const cv::Point2f& pixel, double height,
+                 cv::Point3f* point) const;
+
+  CameraModel model;        /**< The calibration */
+  ProjectionConfig config;  /**< Projection tunables */
+  cv::Mat normalizedTable;  /**< CV_32FC2 undistorted (x/z, y/z) per pixel */
+  /**< CV_32FC2 robot-frame (x, y) where each pixel's ray meets the ground;
+   * NaN where it does not */
+  cv::Mat groundTable;
+};
+
+/**
+ * @brief Gets tracker tunables for positions in meters.
+ *
+ * Tracks are associated by center distance, gated at half a meter per
+ * frame, with Kalman noise for decimeter-level position error.
+ *
+ * @return The tracker tunables.
+ */
+Tracker::MultiTrackerConfig metricTrackerConfig();
+
+/**
+ * @brief Turns positions into the boxes the tracker associates.
+ * @param positions Positions from GroundProjector::project(); invalid
+ * ones are left out.
+ * @param side Side of the square a person covers on the ground, meters.
+ * @return Squares in robot-frame (x, y) meters, centered on the positions.
+ */
+std::vector<cv::Rect2f> footprints(const std::vector<Position>& positions,
+                                   float side = 0.5f);
+
+}  // namespace Projection
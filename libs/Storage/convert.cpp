@@ -0,0 +1,149 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include <algorithm>
+#include <cstring>
+
+#include "detection_log.hpp"
+
+namespace Storage {
+
+namespace {
+
+/**
+ * @struct RowCursor
+ * @brief Walks the rows of a log across its blocks.
+ */
+struct RowCursor {
+  const LogReader& reader; /**< The log */
+  size_t blockIndex;       /**< Current block */
+  size_t row;              /**< Row within the current block */
+  BlockView block;         /**< View of the current block */
+
+  /**
+   * @brief Starts at the first row.
+   * @param log The log to walk.
+   */
+  explicit RowCursor(const LogReader& log)
+      : reader(log), blockIndex(0), row(0) {
+    if (reader.blockCount() > 0) {
+      block = reader.block(0);
+    }
+  }
+
+  /**
+   * @brief Reads the next row.
+   * @param record Receives the row.
+   * @return False past the last row.
+   */
+  bool next(LogRecord& record) {
+    while (row == block.rows) {
+      if (++blockIndex >= reader.blockCount()) {
+        return false;
+      }
+      block = reader.block(blockIndex);
+      row = 0;
+    }
+    record = block.record(row++);
+    return true;
+  }
+};
+
+/**
+ * @brief Compares two floats by their bits.
+ * @param a The first value.
+ * @param b The second value.
+ * @return True if the bits are identical.
+ */
+bool sameBits(float a, float b) { return std::memcmp(&a, &b, sizeof a) == 0; }
+
+/**
+ * @brief Compares two rows exactly.
+ * @param a The first row.
+ * @param b The second row.
+ * @return True if every field is identical.
+ */
+bool sameRecord(const LogRecord& a, const LogRecord& b) {
+  return a.frame == b.frame && a.timestampUs == b.timestampUs &&
+         sameBits(a.box.x, b.box.x) && sameBits(a.box.y, b.box.y) &&
+         sameBits(a.box.width, b.box.width) &&
+         sameBits(a.box.height, b.box.height) &&
+         sameBits(a.score, b.score) && a.classId == b.classId &&
+         a.trackId == b.trackId;
+}
+
+}  // namespace
+
+/**
+ * @brief Writes every row of a log as CSV with a header line.
+ * @param reader The log.
+ * @param out The stream to write to.
+ */
+void exportCsv(const LogReader& reader, std::ostream& out) {
+  out << "frame,timestamp_us,x,y,width,height,score,class,track\n";
+  for (size_t b = 0; b < reader.blockCount(); ++b) {
+    BlockView block = reader.block(b);
+    for (size_t i = 0; i < block.rows; ++i) {
+      out << block.frame[i] << ',' << block.timestampUs[i] << ','
+          << block.x[i] << ',' << block.y[i] << ',' << block.width[i] << ','
+          << block.height[i] << ',' << block.score[i] << ','
+          << block.classId[i] << ',' << block.trackId[i] << '\n';
+    }
+  }
+}
+
+/**
+ * @brief Writes every row of a log as JSON Lines, one object per row.
+ * @param reader The log.
+ * @param out The stream to write to.
+ */
+void exportJson(const LogReader& reader, std::ostream& out) {
+  for (size_t b = 0; b < reader.blockCount(); ++b) {
+    BlockView block = reader.block(b);
+    for (size_t i = 0; i < block.rows; ++i) {
+      out << "{\"frame\":" << block.frame[i]
+          << ",\"timestamp_us\":" << block.timestampUs[i]
+          << ",\"x\":" << block.x[i] << ",\"y\":" << block.y[i]
+          << ",\"width\":" << block.width[i]
+          << ",\"height\":" << block.height[i]
+          << ",\"score\":" << block.score[i]
+          << ",\"class\":" << block.classId[i]
+          << ",\"track\":" << block.trackId[i] << "}\n";
+    }
+  }
+}
+
+/**
+ * @brief Compares two logs row by row. Floats compare by their bits, so
+ * any change in the computation shows up, however small.
+ * @param a The first log.
+ * @param b The second log.
+ * @return The number of differing rows and where they start.
+ */
+LogDiff diffLogs(const LogReader& a, const LogReader& b) {
+  LogDiff diff;
+  RowCursor left(a);
+  RowCursor right(b);
+  LogRecord leftRow;
+  LogRecord rightRow;
+  while (true) {
+    const bool hasLeft = left.next(leftRow);
+    const bool hasRight = right.next(rightRow);
+    if (!hasLeft && !hasRight) {
+      break;
+    }
+    ++diff.rows;
+    if (hasLeft && hasRight && sameRecord(leftRow, rightRow)) {
+      continue;
+    }
+    ++diff.mismatches;
+    if (diff.firstFrame < 0) {
+      uint64_t frame = hasLeft ? leftRow.frame : rightRow.frame;
+      if (hasLeft && hasRight) {
+        frame = std::min(leftRow.frame, rightRow.frame);
+      }
+      diff.firstFrame = static_cast<int64_t>(frame);
+    }
+  }
+  return diff;
+}
+
+}  // namespace Storage
@@ -0,0 +1,302 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file detection_log.hpp
+ * @brief Append-only columnar binary log of detections and tracks, with a
+ * streaming writer, a memory-mapped reader and CSV/JSON export.
+ *
+ * Layout, little-endian:
+ *
+ *     FileHeader                      32 bytes
+ *     Block 0 .. Block N-1            blockBytes each
+ *     IndexEntry[N]                   40 bytes each
+ *     Trailer                         24 bytes
+ *
+ * Every block has the same size: a 64-byte BlockHeader followed by one
+ * array of blockRows values per column (frame, timestampUs, x, y, width,
+ * height, score, classId, trackId). A block with fewer rows is zero-padded,
+ * so block i always starts at sizeof(FileHeader) + i * blockBytes. The
+ * index footer repeats the frame and time range of each block so a reader
+ * can find the blocks it needs without touching the others. A log whose
+ * writer died before writing the footer is still readable: the reader
+ * rebuilds the index from the block headers.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "detection.hpp"
+#include "multi_tracker.hpp"
+
+namespace Storage {
+
+/**
+ * @struct LogRecord
+ * @brief One row of the log: a detection or a track in one frame.
+ */
+struct LogRecord {
+  uint64_t frame = 0;      /**< Frame index */
+  /**< Capture time for live sources, media time for recorded ones */
+  int64_t timestampUs = 0;
+  cv::Rect2f box;          /**< Box in frame pixels */
+  float score = 0;         /**< Detection score; 0 for tracks */
+  int32_t classId = -1;    /**< Detected class; -1 for tracks */
+  int32_t trackId = -1;    /**< Track id; -1 for raw detections */
+};
+
+/**
+ * @struct BlockIndexEntry
+ * @brief Frame and time range of one block, as stored in the index footer.
+ */
+struct BlockIndexEntry {
+  uint64_t firstFrame;    /**< Frame of the first row */
+  uint64_t lastFrame;     /**< Frame of the last row */
+  int64_t firstTimestampUs; /**< Timestamp of the first row */
+  int64_t lastTimestampUs;  /**< Timestamp of the last row */
+  uint32_t rows;          /**< Rows in the block */
+  uint32_t reserved;      /**< Zero */
+};
+
+/**
+ * @struct ColumnLayout
+ * @brief Byte offsets of the columns within a block.
+ *
+ * 64-bit columns come first so that every column stays naturally aligned.
+ */
+struct ColumnLayout {
+  size_t frame = 0;       /**< Offset of the frame column */
+  size_t timestampUs = 0; /**< Offset of the timestamp column */
+  size_t x = 0;           /**< Offset of the box left column */
+  size_t y = 0;           /**< Offset of the box top column */
+  size_t width = 0;       /**< Offset of the box width column */
+  size_t height = 0;      /**< Offset of the box height column */
+  size_t score = 0;       /**< Offset of the score column */
+  size_t classId = 0;     /**< Offset of the class column */
+  size_t trackId = 0;     /**< Offset of the track id column */
+  size_t blockBytes = 0;  /**< Size of a whole block */
+
+  /**
+   * @brief Computes the layout of a block.
+   * @param blockRows Rows per block.
+   */
+  explicit ColumnLayout(uint32_t blockRows);
+};
+
+/**
+ * @struct BlockView
+ * @brief Zero-copy view of one block's columns inside a mapped log.
+ *
+ * The pointers stay valid as long as the LogReader that produced them.
+ */
+struct BlockView {
+  size_t rows = 0;                       /**< Rows in the block */
+  const uint64_t* frame = nullptr;       /**< Frame column */
+  const int64_t* timestampUs = nullptr;  /**< Timestamp column */
+  const float* x = nullptr;              /**< Box left column */
+  const float* y = nullptr;              /**< Box top column */
+  const float* width = nullptr;          /**< Box width column */
+  const float* height = nullptr;         /**< Box height column */
+  const float* score = nullptr;          /**< Score column */
+  const int32_t* classId = nullptr;      /**< Class column */
+  const int32_t* trackId = nullptr;      /**< Track id column */
+
+  /**
+   * @brief Gathers one row.
+   * @param i Row index within the block.
+   * @return The row as a record.
+   */
+  LogRecord record(size_t i) const;
+};
+
+/**
+ * @class LogWriter
+ * @brief Streams records into a log file, one full block at a time.
+ *
+ * Rows are written straight into the column arrays of an in-memory block,
+ * which goes to disk in a single write once full. Frames must not go
+ * backwards, which keeps the index sorted.
+ */
+class LogWriter {
+ public:
+  /**
+   * @brief Creates (or truncates) a log file.
+   * @param path The file to write.
+   * @param blockRows Rows per block; a positive multiple of 16.
+   * @throws std::runtime_error if the file cannot be opened or blockRows is
+   * invalid.
+   */
+  explicit LogWriter(const std::string& path, uint32_t blockRows = 4096);
+
+  /**
+   * @brief Closes the log, writing the last block and the index footer.
+   */
+  ~LogWriter();
+
+  LogWriter(const LogWriter&) = delete;
+  LogWriter& operator=(const LogWriter&) = delete;
+
+  /**
+   * @brief Appends one row.
+   * @param record The row.
+   * @throws std::runtime_error if the frame goes backwards or the log is
+   * closed.
+   */
+  void append(const LogRecord& record);
+
+  /**
+   * @brief Appends the detections and tracks of one frame.
+   * @param frame Frame index.
+   * @param timestampUs Frame timestamp in microseconds.
+   * @param detections Detections, stored with trackId -1.
+   * @param tracks Tracks, stored with classId -1 and score 0.
+   */
+  void appendFrame(uint64_t frame, int64_t timestampUs,
+                   const Detector::Detections& detections,
+                   const std::vector<Tracker::Track>& tracks =
+                       std::vector<Tracker::Track>());
+
+  /**
+   * @brief Writes the last partial block and the index footer. Later
+   * appends throw; calling close() again does nothing.
+   * @throws std::runtime_error if writing fails.
+   */
+  void close();
+
+  /**
+   * @brief Gets the number of rows appended so far.
+   * @return The row count.
+   */
+  uint64_t rows() const { return rowCount; }
+
+ private:
+  /**
+   * @brief Writes the current block, padded to full size, and starts a new
+   * one.
+   */
+  void flushBlock();
+
+  std::ofstream file;        /**< Output file */
+  uint32_t blockRows;        /**< Rows per block */
+  ColumnLayout layout;       /**< Column offsets within a block */
+  std::vector<char> block;   /**< The block being filled, as on disk */
+  size_t used;               /**< Rows in the current block */
+  /**< Index entries of the blocks written so far */
+  std::vector<BlockIndexEntry> index;
+  uint64_t rowCount;         /**< Rows appended */
+  uint64_t lastFrame;        /**< Frame of the last row appended */
+  bool closed;               /**< Set by close() */
+};
+
+/**
+ * @class LogReader
+ * @brief Maps a log into memory and exposes its blocks without copying.
+ */
+class LogReader {
+ public:
+  /**
+   * @brief Maps a log file.
+   * @param path The file to read.
+   * @throws std::runtime_error if the file cannot be mapped, is not a log
+   * or has an index that disagrees with its blocks.
+   */
+  explicit LogReader(const std::string& path);
+
+  /**
+   * @brief Unmaps the file.
+   */
+  ~LogReader();
+
+  LogReader(const LogReader&) = delete;
+  LogReader& operator=(const LogReader&) = delete;
+
+  /**
+   * @brief Gets the number of blocks.
+   * @return The block count.
+   */
+  size_t blockCount() const { return index.size(); }
+
+  /**
+   * @brief Gets the total number of rows.
+   * @return The row count.
+   */
+  uint64_t rows() const { return rowCount; }
+
+  /**
+   * @brief Gets one block.
+   * @param i Block index.
+   * @return A view of the block's columns.
+   */
+  BlockView block(size_t i) const;
+
+  /**
+   * @brief Gets the per-block frame and time ranges.
+   * @return The index, one entry per block.
+   */
+  const std::vector<BlockIndexEntry>& blockIndex() const { return index; }
+
+  /**
+   * @brief Finds the blocks that may hold rows of a frame range.
+   * @param firstFrame First frame wanted.
+   * @param lastFrame Last frame wanted.
+   * @return The range [begin, end) of block indices.
+   */
+  std::pair<size_t, size_t> findBlocks(uint64_t firstFrame,
+                                       uint64_t lastFrame) const;
+
+  /**
+   * @brief Tells whether the footer was missing and the index rebuilt.
+   * @return True for a log whose writer did not close it.
+   */
+  bool recovered() const { return rebuilt; }
+
+ private:
+  const char* data;   /**< Start of the mapping */
+  size_t size;        /**< Length of the mapping */
+  uint32_t blockRows; /**< Rows per block */
+  ColumnLayout layout; /**< Column offsets within a block */
+  std::vector<BlockIndexEntry> index; /**< One entry per block */
+  uint64_t rowCount;  /**< Total rows */
+  bool rebuilt;       /**< The index came from the block headers */
+};
+
+/**
+ * @brief Writes every row of a log as CSV with a header line.
+ * @param reader The log.
+ * @param out The stream to write to.
+ */
+void exportCsv(const LogReader& reader, std::ostream& out);
+
+/**
+ * @brief Writes every row of a log as JSON Lines, one object per row.
+ * @param reader The log.
+ * @param out The stream to write to.
+ */
+void exportJson(const LogReader& reader, std::ostream& out);
+
+/**
+ * @struct LogDiff
+ * @brief Outcome of comparing two logs row by row.
+ */
+struct LogDiff {
+  uint64_t rows = 0;        /**< Rows compared */
+  uint64_t mismatches = 0;  /**< Rows that differ, plus unmatched rows */
+  /**< Frame of the first differing row; -1 if the logs are identical */
+  int64_t firstFrame = -1;
+};
+
+/**
+ * @brief Compares two logs row by row. Floats compare by their bits, so
+ * any change in the computation shows up, however small.
+ * @param a The first log.
+ * @param b The second log.
+ * @return The number of differing rows and where they start.
+ */
+LogDiff diffLogs(const LogReader& a, const LogReader& b);
+
+}  // namespace Storage
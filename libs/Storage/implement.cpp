@@ -0,0 +1,451 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "detection_log.hpp"
+
+namespace Storage {
+
+namespace {
+
+/**< Version written to new logs */
+constexpr uint32_t kVersion = 1;
+/**< "BLK1", marks the start of every block */
+constexpr uint32_t kBlockMagic = 0x314B4C42;
+/**< Starts every log file */
+constexpr char kFileMagic[8] = {'A', 'C', 'M', 'E', 'L', 'O', 'G', '\0'};
+/**< Ends a log whose index footer was written */
+constexpr char kIndexMagic[8] = {'A', 'C', 'M', 'E', 'I', 'D', 'X', '\0'};
+
+/**
+ * @struct FileHeader
+ * @brief First bytes of a log file.
+ */
+struct FileHeader {
+  char magic[8];       /**< kFileMagic */
+  uint32_t version;    /**< kVersion */
+  uint32_t blockRows;  /**< Rows per block */
+  uint64_t blockBytes; /**< Bytes per block */
+  uint64_t reserved;   /**< Zero */
+};
+
+/**
+ * @struct BlockHeader
+ * @brief First bytes of every block.
+ */
+struct BlockHeader {
+  uint32_t magic;           /**< kBlockMagic */
+  uint32_t rows;            /**< Rows in the block */
+  uint64_t firstFrame;      /**< Frame of the first row */
+  uint64_t lastFrame;       /**< Frame of the last row */
+  int64_t firstTimestampUs; /**< Timestamp of the first row */
+  int64_t lastTimestampUs;  /**< Timestamp of the last row */
+  uint64_t reserved[3];     /**< Zero; pads the header to 64 bytes */
+};
+
+/**
+ * @struct Trailer
+ * @brief Last bytes of a closed log.
+ */
+struct Trailer {
+  uint64_t blockCount;  /**< Entries in the index */
+  uint64_t indexOffset; /**< File offset of the first index entry */
+  char magic[8];        /**< kIndexMagic */
+};
+
+static_assert(sizeof(FileHeader) == 32, "FileHeader layout changed");
+static_assert(sizeof(BlockHeader) == 64, "BlockHeader layout changed");
+static_assert(sizeof(BlockIndexEntry) == 40, "Index entry layout changed");
+static_assert(sizeof(Trailer) == 24, "Trailer layout changed");
+
+/**
+ * @brief Gets a typed pointer to a column of a block.
+ * @tparam T Column type.
+ * @param block Start of the block.
+ * @param offset Offset of the column.
+ * @return The column.
+ */
+template <typename T>
+T* column(char* block, size_t offset) {
+  return reinterpret_cast<T*>(block + offset);
+}
+
+/**
+ * @brief Gets a typed read-only pointer to a column of a block.
+ * @tparam T Column type.
+ * @param block Start of the block.
+ * @param offset Offset of the column.
+ * @return The column.
+ */
+template <typename T>
+const T* column(const char* block, size_t offset) {
+  return reinterpret_cast<const T*>(block + offset);
+}
+
+}  // namespace
+
+/**
+ * @brief Computes the layout of a block.
+ * @param blockRows Rows per block.
+ */
+ColumnLayout::ColumnLayout(uint32_t blockRows) {
+  size_t offset = sizeof(BlockHeader);
+  auto place = [&](size_t* field, size_t bytes) {
+    *field = offset;
+    offset += bytes * blockRows;
+  };
+  place(&frame, sizeof(uint64_t));
+  place(&timestampUs, sizeof(int64_t));
+  place(&x, sizeof(float));
+  place(&y, sizeof(float));
+  place(&width, sizeof(float));
+  place(&height, sizeof(float));
+  place(&score, sizeof(float));
+  place(&classId, sizeof(int32_t));
+  place(&trackId, sizeof(int32_t));
+  blockBytes = offset;
+}
+
+/**
+ * @brief Gathers one row.
+ * @param i Row index within the block.
+ * @return The row as a record.
+ */
+LogRecord BlockView::record(size_t i) const {
+  LogRecord record;
+  record.frame = frame[i];
+  record.timestampUs = timestampUs[i];
+  record.box = cv::Rect2f(x[i], y[i], width[i], height[i]);
+  record.score = score[i];
+  record.classId = classId[i];
+  record.trackId = trackId[i];
+  return record;
+}
+
+/**
+ * @brief Creates (or truncates) a log file.
+ * @param path The file to write.
+ * @param blockRows Rows per block; a positive multiple of 16.
+ * @throws std::runtime_error if the file cannot be opened or blockRows is
+ * invalid.
+ */
+LogWriter::LogWriter(const std::string& path, uint32_t blockRows)
+    : blockRows(blockRows),
+      layout(blockRows),
+      used(0),
+      rowCount(0),
+      lastFrame(0),
+      closed(false) {
+  if (blockRows == 0 || blockRows % 16 != 0) {
+    throw std::runtime_error("Log block rows must be a multiple of 16");
+  }
+  file.open(path.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file.good()) {
+    throw std::runtime_error("Cannot write log " + path);
+  }
+  FileHeader header = {};
+  std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.version = kVersion;
+  header.blockRows = blockRows;
+  header.blockBytes = layout.blockBytes;
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  block.assign(layout.blockBytes, 0);
+}
+
+/**
+ * @brief Closes the log, writing the last block and the index footer.
+ */
+LogWriter::~LogWriter() {
+  try {
+    close();
+  } catch (const std::exception&) {
+    // Destructors must not throw; the index can be rebuilt on read
+  }
+}
+
+/**
+ * @brief Appends one row.
+ * @param record The row.
+ * @throws std::runtime_error if the frame goes backwards or the log is
+ * closed.
+ */
+void LogWriter::append(const LogRecord& record) {
+  if (closed) {
+    throw std::runtime_error("Append to a closed log");
+  }
+  if (rowCount > 0 && record.frame < lastFrame) {
+    throw std::runtime_error("Log frames must not go backwards");
+  }
+  char* data = block.data();
+  column<uint64_t>(data, layout.frame)[used] = record.frame;
+  column<int64_t>(data, layout.timestampUs)[used] = record.timestampUs;
+  column<float>(data, layout.x)[used] = record.box.x;
+  column<float>(data, layout.y)[used] = record.box.y;
+  column<float>(data, layout.width)[used] = record.box.width;
+  column<float>(data, layout.height)[used] = record.box.height;
+  column<float>(data, layout.score)[used] = record.score;
+  column<int32_t>(data, layout.classId)[used] = record.classId;
+  column<int32_t>(data, layout.trackId)[used] = record.trackId;
+  ++rowCount;
+  lastFrame = record.frame;
+  if (++used == blockRows) {
+    flushBlock();
+  }
+}
+
+/**
+ * @brief Appends the detections and tracks of one frame.
+ * @param frame Frame index.
+ * @param timestampUs Frame timestamp in microseconds.
+ * @param detections Detections, stored with trackId -1.
+ * @param tracks Tracks, stored with classId -1 and score 0.
+ */
+void LogWriter::appendFrame(uint64_t frame, int64_t timestampUs,
+                            const Detector::Detections& detections,
+                            const std::vector<Tracker::Track>& tracks) {
+  LogRecord record;
+  record.frame = frame;
+  record.timestampUs = timestampUs;
+  for (const Detector::Detection& detection : detections) {
+    record.box = cv::Rect2f(detection.box);
+    record.score = detection.score;
+    record.classId = detection.classId;
+    append(record);
+  }
+  record.score = 0;
+  record.classId = -1;
+  for (const Tracker::Track& track : tracks) {
+    record.box = track.box;
+    record.trackId = track.id;
+    append(record);
+  }
+}
+
+/**
+ * @brief Writes the last partial block and the index footer. Later
+ * appends throw; calling close() again does nothing.
+ * @throws std::runtime_error if writing fails.
+ */
+void LogWriter::close() {
+  if (closed) {
+    return;
+  }
+  closed = true;
+  flushBlock();
+
+  Trailer trailer = {};
+  trailer.blockCount = index.size();
+  trailer.indexOffset = sizeof(FileHeader) + index.size() * layout.blockBytes;
+  std::memcpy(trailer.magic, kIndexMagic, sizeof(kIndexMagic));
+  file.write(reinterpret_cast<const char*>(index.data()),
+             index.size() * sizeof(BlockIndexEntry));
+  file.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+  file.close();
+  if (file.fail()) {
+    throw std::runtime_error("Failed to write the log footer");
+  }
+}
+
+/**
+ * @brief Writes the current block, padded to full size, and starts a new
+ * one.
+ */
+void LogWriter::flushBlock() {
+  if (used == 0) {
+    return;
+  }
+  char* data = block.data();
+  if (used < blockRows) {
+    // Zero the unused tail of every column so partial blocks are
+    // deterministic on disk
+    const size_t offsets[] = {layout.frame,   layout.timestampUs,
+                              layout.x,       layout.y,
+                              layout.width,   layout.height,
+                              layout.score,   layout.classId,
+                              layout.trackId, layout.blockBytes};
+    for (size_t c = 0; c + 1 < sizeof(offsets) / sizeof(offsets[0]); ++c) {
+      size_t width = (offsets[c + 1] - offsets[c]) / blockRows;
+      std::memset(data + offsets[c] + used * width, 0,
+                  (blockRows - used) * width);
+    }
+  }
+
+  BlockHeader header = {};
+  header.magic = kBlockMagic;
+  header.rows = static_cast<uint32_t>(used);
+  header.firstFrame = column<uint64_t>(data, layout.frame)[0];
+  header.lastFrame = column<uint64_t>(data, layout.frame)[used - 1];
+  header.firstTimestampUs = column<int64_t>(data, layout.timestampUs)[0];
+  header.lastTimestampUs = column<int64_t>(data, layout.timestampUs)[used - 1];
+  std::memcpy(data, &header, sizeof(header));
+
+  BlockIndexEntry entry = {};
+  entry.firstFrame = header.firstFrame;
+  entry.lastFrame = header.lastFrame;
+  entry.firstTimestampUs = header.firstTimestampUs;
+  entry.lastTimestampUs = header.lastTimestampUs;
+  entry.rows = header.rows;
+  index.push_back(entry);
+
+  file.write(data, block.size());
+  if (!file.good()) {
+    throw std::runtime_error("Failed to write a log block");
+  }
+  used = 0;
+}
+
+/**
+ * @brief Maps a log file.
+ * @param path The file to read.
+ * @throws std::runtime_error if the file cannot be mapped, is not a log
+ * or has an index that disagrees with its blocks.
+ */
+LogReader::LogReader(const std::string& path)
+    : data(nullptr),
+      size(0),
+      blockRows(0),
+      layout(0),
+      rowCount(0),
+      rebuilt(false) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open log " + path);
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    throw std::runtime_error("Not a detection log: " + path);
+  }
+  size = static_cast<size_t>(info.st_size);
+  void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);  // The mapping keeps the file alive
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Cannot map log " + path);
+  }
+  data = static_cast<const char*>(mapping);
+
+  FileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header.version != kVersion || header.blockRows == 0 ||
+      ColumnLayout(header.blockRows).blockBytes != header.blockBytes) {
+    ::munmap(const_cast<char*>(data), size);
+    throw std::runtime_error("Not a detection log: " + path);
+  }
+  blockRows = header.blockRows;
+  layout = ColumnLayout(blockRows);
+
+  // A closed log ends with the index; trust it only if it adds up exactly
+  bool haveIndex = false;
+  if (size >= sizeof(FileHeader) + sizeof(Trailer)) {
+    Trailer trailer;
+    std::memcpy(&trailer, data + size - sizeof(Trailer), sizeof(trailer));
+    // Bounded first, so the sizes below cannot overflow and wrap around
+    const uint64_t maxBlocks = (size - sizeof(FileHeader) - sizeof(Trailer)) /
+                               (layout.blockBytes + sizeof(BlockIndexEntry));
+    uint64_t blocksEnd =
+        sizeof(FileHeader) + trailer.blockCount * layout.blockBytes;
+    haveIndex =
+        std::memcmp(trailer.magic, kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+        trailer.blockCount <= maxBlocks && trailer.indexOffset == blocksEnd &&
+        blocksEnd + trailer.blockCount * sizeof(BlockIndexEntry) +
+                sizeof(Trailer) ==
+            size;
+    if (haveIndex) {
+      index.resize(trailer.blockCount);
+      std::memcpy(index.data(), data + trailer.indexOffset,
+                  index.size() * sizeof(BlockIndexEntry));
+      // block() trusts the row counts, so each must fit and match its block
+      for (size_t i = 0; i < index.size(); ++i) {
+        BlockHeader block;
+        std::memcpy(&block,
+                    data + sizeof(FileHeader) + i * layout.blockBytes,
+                    sizeof(block));
+        if (index[i].rows > blockRows || block.magic != kBlockMagic ||
+            block.rows != index[i].rows) {
+          ::munmap(const_cast<char*>(data), size);
+          throw std::runtime_error("Corrupt log index: " + path);
+        }
+      }
+    }
+  }
+  if (!haveIndex) {
+    rebuilt = true;
+    size_t count = (size - sizeof(FileHeader)) / layout.blockBytes;
+    for (size_t i = 0; i < count; ++i) {
+      BlockHeader block;
+      std::memcpy(&block, data + sizeof(FileHeader) + i * layout.blockBytes,
+                  sizeof(block));
+      if (block.magic != kBlockMagic || block.rows > blockRows) {
+        break;  // Torn write at the end of a log that was never closed
+      }
+      BlockIndexEntry entry = {};
+      entry.firstFrame = block.firstFrame;
+      entry.lastFrame = block.lastFrame;
+      entry.firstTimestampUs = block.firstTimestampUs;
+      entry.lastTimestampUs = block.lastTimestampUs;
+      entry.rows = block.rows;
+      index.push_back(entry);
+    }
+  }
+  for (const BlockIndexEntry& entry : index) {
+    rowCount += entry.rows;
+  }
+}
+
+/**
+ * @brief Unmaps the file.
+ */
+LogReader::~LogReader() {
+  if (data != nullptr) {
+    ::munmap(const_cast<char*>(data), size);
+  }
+}
+
+/**
+ * @brief Gets one block.
+ * @param i Block index.
+ * @return A view of the block's columns.
+ */
+BlockView LogReader::block(size_t i) const {
+  const char* start = data + sizeof(FileHeader) + i * layout.blockBytes;
+  BlockView view;
+  view.rows = index[i].rows;
+  view.frame = column<uint64_t>(start, layout.frame);
+  view.timestampUs = column<int64_t>(start, layout.timestampUs);
+  view.x = column<float>(start, layout.x);
+  view.y = column<float>(start, layout.y);
+  view.width = column<float>(start, layout.width);
+  view.height = column<float>(start, layout.height);
+  view.score = column<float>(start, layout.score);
+  view.classId = column<int32_t>(start, layout.classId);
+  view.trackId = column<int32_t>(start, layout.trackId);
+  return view;
+}
+
+/**
+ * @brief Finds the blocks that may hold rows of a frame range.
+ * @param firstFrame First frame wanted.
+ * @param lastFrame Last frame wanted.
+ * @return The range [begin, end) of block indices.
+ */
+std::pair<size_t, size_t> LogReader::findBlocks(uint64_t firstFrame,
+                                                uint64_t lastFrame) const {
+  auto begin = std::partition_point(
+      index.begin(), index.end(),
+      [&](const BlockIndexEntry& e) { return e.lastFrame < firstFrame; });
+  auto end = std::partition_point(
+      begin, index.end(),
+      [&](const BlockIndexEntry& e) { return e.firstFrame <= lastFrame; });
+  return std::make_pair(static_cast<size_t>(begin - index.begin()),
+                        static_cast<size_t>(end - index.begin()));
+}
+
+}  // namespace Storage
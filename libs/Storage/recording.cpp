@@ -0,0 +1,342 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "recording.hpp"
+
+#include <cstring>
+#include <opencv2/imgcodecs.hpp>
+#include <stdexcept>
+
+namespace Storage {
+
+namespace {
+
+/**< Version written to new recordings */
+constexpr uint32_t kRecordingVersion = 1;
+/**< Starts every recording */
+constexpr char kRecordingMagic[8] = {'A', 'C', 'M', 'E', 'R', 'E', 'C', '\0'};
+/**< "FRM1", marks the start of every frame */
+constexpr uint32_t kFrameMagic = 0x314D5246;
+
+/**
+ * @struct RecordingHeader
+ * @brief First bytes of a recording.
+ */
+struct RecordingHeader {
+  char magic[8];          /**< kRecordingMagic */
+  uint32_t version;       /**< kRecordingVersion */
+  uint32_t settingsBytes; /**< Length of the settings text that follows */
+};
+
+/**
+ * @struct FrameHeader
+ * @brief First bytes of every frame.
+ */
+struct FrameHeader {
+  uint32_t magic;          /**< kFrameMagic */
+  uint32_t headCount;      /**< Output heads that follow the image */
+  uint64_t index;          /**< Frame index */
+  int64_t timestampUs;     /**< Capture time */
+  uint32_t encodedBytes;   /**< Length of the PNG image */
+  uint32_t detectionCount; /**< Detections after the heads */
+};
+
+/**
+ * @struct HeadHeader
+ * @brief First bytes of every output head.
+ */
+struct HeadHeader {
+  int32_t rows;      /**< Rows of the head */
+  int32_t cols;      /**< Floats per row */
+  uint32_t keptRows; /**< Rows stored, each as an index and cols floats */
+  uint32_t reserved; /**< Zero */
+};
+
+/**
+ * @struct DetectionEntry
+ * @brief One stored detection.
+ */
+struct DetectionEntry {
+  int32_t x;       /**< Left edge */
+  int32_t y;       /**< Top edge */
+  int32_t width;   /**< Width */
+  int32_t height;  /**< Height */
+  float score;     /**< Score */
+  int32_t classId; /**< Class */
+};
+
+static_assert(sizeof(RecordingHeader) == 16, "RecordingHeader layout changed");
+static_assert(sizeof(FrameHeader) == 32, "FrameHeader layout changed");
+static_assert(sizeof(HeadHeader) == 16, "HeadHeader layout changed");
+static_assert(sizeof(DetectionEntry) == 24, "DetectionEntry layout changed");
+
+/**
+ * @brief Writes raw bytes.
+ * @param out The stream.
+ * @param data The bytes.
+ * @param bytes How many.
+ */
+void writeBytes(std::ofstream& out, const void* data, size_t bytes) {
+  out.write(static_cast<const char*>(data), bytes);
+}
+
+/**
+ * @brief Reads raw bytes.
+ * @param in The stream.
+ * @param data Receives the bytes.
+ * @param bytes How many.
+ * @throws std::runtime_error if the stream ends first.
+ */
+void readBytes(std::ifstream& in, void* data, size_t bytes) {
+  in.read(static_cast<char*>(data), bytes);
+  if (static_cast<size_t>(in.gcount()) != bytes) {
+    throw std::runtime_error("Truncated recording");
+  }
+}
+
+/**
+ * @brief Serializes the settings as OpenCV YAML.
+ * @param settings The settings.
+ * @return The YAML text.
+ */
+std::string writeSettings(const RecordingSettings& settings) {
+  cv::FileStorage fs(".yml",
+                     cv::FileStorage::WRITE | cv::FileStorage::MEMORY);
+  fs << "input_width" << settings.inputSize.width;
+  fs << "input_height" << settings.inputSize.height;
+  fs << "min_objectness" << settings.minObjectness;
+  fs << "conf_threshold" << settings.decode.confThreshold;
+  fs << "class_id" << settings.decode.classId;
+  fs << "multi_class" << static_cast<int>(settings.decode.multiClass);
+  fs << "classes" << settings.decode.classes;
+  fs << "nms_method" << static_cast<int>(settings.nms.method);
+  fs << "nms_iou_threshold" << settings.nms.iouThreshold;
+  fs << "nms_score_threshold" << settings.nms.scoreThreshold;
+  fs << "nms_sigma" << settings.nms.sigma;
+  fs << "nms_class_aware" << static_cast<int>(settings.nms.classAware);
+  fs << "nms_top_k" << settings.nms.topK;
+  return fs.releaseAndGetString();
+}
+
+/**
+ * @brief Parses settings written by writeSettings().
+ * @param text The YAML text.
+ * @return The settings.
+ */
+RecordingSettings readSettings(const std::string& text) {
+  cv::FileStorage fs(text, cv::FileStorage::READ | cv::FileStorage::MEMORY);
+  RecordingSettings settings;
+  settings.inputSize = cv::Size(static_cast<int>(fs["input_width"]),
+                                static_cast<int>(fs["input_height"]));
+  settings.minObjectness = static_cast<float>(fs["min_objectness"]);
+  settings.decode.confThreshold = static_cast<float>(fs["conf_threshold"]);
+  settings.decode.classId = static_cast<int>(fs["class_id"]);
+  settings.decode.multiClass = static_cast<int>(fs["multi_class"]) != 0;
+  fs["classes"] >> settings.decode.classes;
+  settings.nms.method =
+      static_cast<Detector::NmsMethod>(static_cast<int>(fs["nms_method"]));
+  settings.nms.iouThreshold = static_cast<float>(fs["nms_iou_threshold"]);
+  settings.nms.scoreThreshold = static_cast<float>(fs["nms_score_threshold"]);
+  settings.nms.sigma = static_cast<float>(fs["nms_sigma"]);
+  settings.nms.classAware = static_cast<int>(fs["nms_class_aware"]) != 0;
+  settings.nms.topK = static_cast<int>(fs["nms_top_k"]);
+  return settings;
+}
+
+}  // namespace
+
+/**
+ * @brief Creates (or truncates) a recording.
+ * @param path Path of the file.
+ * @param settings Input size, row threshold and decoding parameters.
+ * @throws std::runtime_error if the file cannot be created or
+ * minObjectness is above the decoding score threshold.
+ */
+RecordingWriter::RecordingWriter(const std::string& path,
+                                 const RecordingSettings& settings)
+    : out(path, std::ios::binary | std::ios::trunc),
+      settings(settings),
+      frameCount(0) {
+  if (!out) {
+    throw std::runtime_error("Cannot write recording " + path);
+  }
+  if (settings.minObjectness > settings.decode.confThreshold) {
+    throw std::runtime_error("The recording would drop rows the decoder "
+                             "keeps; lower minObjectness");
+  }
+  const std::string text = writeSettings(settings);
+  RecordingHeader header{};
+  std::memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+  header.version = kRecordingVersion;
+  header.settingsBytes = static_cast<uint32_t>(text.size());
+  writeBytes(out, &header, sizeof(header));
+  writeBytes(out, text.data(), text.size());
+}
+
+/**
+ * @brief Appends one frame.
+ * @param index Frame index.
+ * @param timestampUs Capture time in microseconds.
+ * @param frame The captured frame.
+ * @param outputs The network's output heads for the frame, CV_32F with
+ * one row per anchor.
+ * @param detections Detections of the live run.
+ * @throws std::runtime_error if the frame cannot be encoded or written.
+ */
+void RecordingWriter::append(uint64_t index, int64_t timestampUs,
+                             const cv::Mat& frame,
+                             const std::vector<cv::Mat>& outputs,
+                             const Detector::Detections& detections) {
+  if (!out.is_open()) {
+    throw std::runtime_error("Append to a closed recording");
+  }
+  // PNG is lossless, so replayed preprocessing sees the captured pixels
+  if (!cv::imencode(".png", frame, encoded,
+                    {cv::IMWRITE_PNG_COMPRESSION, 1})) {
+    throw std::runtime_error("Cannot encode a recorded frame");
+  }
+
+  FrameHeader header{};
+  header.magic = kFrameMagic;
+  header.headCount = static_cast<uint32_t>(outputs.size());
+  header.index = index;
+  header.timestampUs = timestampUs;
+  header.encodedBytes = static_cast<uint32_t>(encoded.size());
+  header.detectionCount = static_cast<uint32_t>(detections.size());
+  writeBytes(out, &header, sizeof(header));
+  writeBytes(out, encoded.data(), encoded.size());
+
+  for (const cv::Mat& output : outputs) {
+    if (output.type() != CV_32F || output.dims != 2 || output.cols < 5 ||
+        !output.isContinuous()) {
+      throw std::runtime_error("Recorded outputs must be continuous 2D "
+                               "CV_32F rows of [box, objectness, scores]");
+    }
+    HeadHeader head{};
+    head.rows = output.rows;
+    head.cols = output.cols;
+    for (int r = 0; r < output.rows; ++r) {
+      head.keptRows += output.ptr<float>(r)[4] >= settings.minObjectness;
+    }
+    writeBytes(out, &head, sizeof(head));
+    const size_t rowBytes = output.cols * sizeof(float);
+    for (int r = 0; r < output.rows; ++r) {
+      const float* values = output.ptr<float>(r);
+      if (values[4] >= settings.minObjectness) {
+        const uint32_t rowIndex = static_cast<uint32_t>(r);
+        writeBytes(out, &rowIndex, sizeof(rowIndex));
+        writeBytes(out, values, rowBytes);
+      }
+    }
+  }
+
+  for (const Detector::Detection& detection : detections) {
+    DetectionEntry entry{detection.box.x,      detection.box.y,
+                         detection.box.width,  detection.box.height,
+                         detection.score,      detection.classId};
+    writeBytes(out, &entry, sizeof(entry));
+  }
+  if (!out) {
+    throw std::runtime_error("Failed to write a recorded frame");
+  }
+  ++frameCount;
+}
+
+/**
+ * @brief Flushes and closes the file. Later appends are errors.
+ */
+void RecordingWriter::close() {
+  if (out.is_open()) {
+    out.close();
+  }
+}
+
+/**
+ * @brief Opens a recording and reads its settings.
+ * @param path Path of the file.
+ * @throws std::runtime_error if the file is missing or not a recording.
+ */
+RecordingReader::RecordingReader(const std::string& path)
+    : in(path, std::ios::binary) {
+  if (!in) {
+    throw std::runtime_error("Cannot read recording " + path);
+  }
+  RecordingHeader header{};
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (in.gcount() != sizeof(header) ||
+      std::memcmp(header.magic, kRecordingMagic, sizeof(header.magic)) != 0) {
+    throw std::runtime_error(path + " is not a recording");
+  }
+  if (header.version != kRecordingVersion) {
+    throw std::runtime_error("Unsupported recording version " +
+                             std::to_string(header.version));
+  }
+  std::string text(header.settingsBytes, '\0');
+  readBytes(in, &text[0], text.size());
+  settings = readSettings(text);
+  firstFrame = in.tellg();
+}
+
+/**
+ * @brief Reads the next frame.
+ * @param frame Receives the frame.
+ * @return False at the end of the recording.
+ * @throws std::runtime_error if the file is truncated or corrupt.
+ */
+bool RecordingReader::next(RecordedFrame& frame) {
+  FrameHeader header{};
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (in.gcount() == 0) {
+    return false;
+  }
+  if (in.gcount() != sizeof(header) || header.magic != kFrameMagic) {
+    throw std::runtime_error("Corrupt recording frame");
+  }
+  frame.index = header.index;
+  frame.timestampUs = header.timestampUs;
+
+  encoded.resize(header.encodedBytes);
+  readBytes(in, encoded.data(), encoded.size());
+  frame.frame = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+  if (frame.frame.empty()) {
+    throw std::runtime_error("Cannot decode a recorded frame");
+  }
+
+  frame.outputs.resize(header.headCount);
+  for (cv::Mat& output : frame.outputs) {
+    HeadHeader head{};
+    readBytes(in, &head, sizeof(head));
+    if (head.rows < 0 || head.cols < 5 ||
+        head.keptRows > static_cast<uint32_t>(head.rows)) {
+      throw std::runtime_error("Corrupt recording head");
+    }
+    output.create(head.rows, head.cols, CV_32F);  // Reused if same shape
+    output.setTo(cv::Scalar::all(0));
+    for (uint32_t k = 0; k < head.keptRows; ++k) {
+      uint32_t rowIndex = 0;
+      readBytes(in, &rowIndex, sizeof(rowIndex));
+      if (rowIndex >= static_cast<uint32_t>(head.rows)) {
+        throw std::runtime_error("Corrupt recording row");
+      }
+      readBytes(in, output.ptr<float>(rowIndex), head.cols * sizeof(float));
+    }
+  }
+
+  frame.detections.resize(header.detectionCount);
+  for (Detector::Detection& detection : frame.detections) {
+    DetectionEntry entry{};
+    readBytes(in, &entry, sizeof(entry));
+    detection.box = cv::Rect(entry.x, entry.y, entry.width, entry.height);
+    detection.score = entry.score;
+    detection.classId = entry.classId;
+  }
+  return true;
+}
+
+/**
+ * @brief Goes back to the first frame.
+ */
+void RecordingReader::rewind() {
+  in.clear();
+  in.seekg(firstFrame);
+}
+
+}  // namespace Storage
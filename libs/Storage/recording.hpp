@@ -0,0 +1,151 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file recording.hpp
+ * @brief Recording of captured frames, raw network outputs and the live
+ * detections, for replaying the non-inference pipeline without a camera
+ * or the weights.
+ *
+ * Layout, little-endian:
+ *
+ *     RecordingHeader            16 bytes
+ *     Settings                   OpenCV YAML text, settingsBytes long
+ *     Frame 0 .. Frame N-1
+ *
+ * Each frame is a 32-byte FrameHeader, the frame encoded losslessly (PNG),
+ * then every output head as a 16-byte HeadHeader followed by its kept rows,
+ * each a uint32 row index and the row's floats, then the live detections.
+ * Only rows whose objectness is at least minObjectness are kept; the
+ * decoder rejects the others before reading them, so replays are bit-exact
+ * for any score threshold at or above it.
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+#include "decode.hpp"
+#include "detection.hpp"
+#include "nms.hpp"
+
+namespace Storage {
+
+/**
+ * @struct RecordingSettings
+ * @brief How the recorded outputs were produced and are to be decoded.
+ */
+struct RecordingSettings {
+  cv::Size inputSize;  /**< Network input size of every recorded frame */
+  /**< Rows with a lower objectness are dropped; 0 keeps every row */
+  float minObjectness = 0.01f;
+  Detector::DecodeConfig decode; /**< Decoding of the live run */
+  Detector::NmsConfig nms;       /**< Suppression of the live run */
+};
+
+/**
+ * @struct RecordedFrame
+ * @brief One frame of a recording.
+ */
+struct RecordedFrame {
+  uint64_t index = 0;       /**< Frame index */
+  int64_t timestampUs = 0;  /**< Capture time in microseconds */
+  cv::Mat frame;            /**< The captured BGR frame */
+  /**< Network output heads; dropped rows read as zeros */
+  std::vector<cv::Mat> outputs;
+  Detector::Detections detections; /**< Detections of the live run */
+};
+
+/**
+ * @class RecordingWriter
+ * @brief Streams frames and network outputs into a recording file.
+ */
+class RecordingWriter {
+ public:
+  /**
+   * @brief Creates (or truncates) a recording.
+   * @param path Path of the file.
+   * @param settings Input size, row threshold and decoding parameters.
+   * @throws std::runtime_error if the file cannot be created or
+   * minObjectness is above the decoding score threshold.
+   */
+  RecordingWriter(const std::string& path, const RecordingSettings& settings);
+
+  /**
+   * @brief Appends one frame.
+   * @param index Frame index.
+   * @param timestampUs Capture time in microseconds.
+   * @param frame The captured frame.
+   * @param outputs The network's output heads for the frame, CV_32F with
+   * one row per anchor.
+   * @param detections Detections of the live run.
+   * @throws std::runtime_error if the frame cannot be encoded or written.
+   */
+  void append(uint64_t index, int64_t timestampUs, const cv::Mat& frame,
+              const std::vector<cv::Mat>& outputs,
+              const Detector::Detections& detections);
+
+  /**
+   * @brief Flushes and closes the file. Later appends are errors.
+   */
+  void close();
+
+  /**
+   * @brief Gets the number of frames appended so far.
+   * @return The frame count.
+   */
+  uint64_t frames() const { return frameCount; }
+
+ private:
+  std::ofstream out;          /**< The recording */
+  RecordingSettings settings; /**< Written to the header */
+  std::vector<uchar> encoded; /**< Reused PNG buffer */
+  uint64_t frameCount;        /**< Frames appended */
+};
+
+/**
+ * @class RecordingReader
+ * @brief Reads a recording frame by frame.
+ */
+class RecordingReader {
+ public:
+  /**
+   * @brief Opens a recording and reads its settings.
+   * @param path Path of the file.
+   * @throws std::runtime_error if the file is missing or not a recording.
+   */
+  explicit RecordingReader(const std::string& path);
+
+  /**
+   * @brief Gets the settings the recording was made with.
+   * @return The settings.
+   */
+  const RecordingSettings& getSettings() const { return settings; }
+
+  /**
+   * @brief Reads the next frame.
+   *
+   * The output matrices of the previous frame are reused when the shapes
+   * match, so copy them to keep them past the next call.
+   *
+   * @param frame Receives the frame.
+   * @return False at the end of the recording.
+   * @throws std::runtime_error if the file is truncated or corrupt.
+   */
+  bool next(RecordedFrame& frame);
+
+  /**
+   * @brief Goes back to the first frame.
+   */
+  void rewind();
+
+ private:
+  std::ifstream in;           /**< The recording */
+  RecordingSettings settings; /**< Read from the header */
+  std::streampos firstFrame;  /**< Offset of the first frame */
+  std::vector<uchar> encoded; /**< Reused PNG buffer */
+};
+
+}  // namespace Storage
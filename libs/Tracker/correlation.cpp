@@ -0,0 +1,276 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "correlation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace Tracker {
+
+namespace {
+
+/**
+ * @brief Gets the center of a box.
+ * @param box The box.
+ * @return The center point.
+ */
+cv::Point2f centerOf(const cv::Rect2f& box) {
+  return cv::Point2f(box.x + box.width * 0.5f, box.y + box.height * 0.5f);
+}
+
+/**
+ * @brief Locates a peak between samples by fitting a parabola through it
+ * and its two neighbors.
+ * @param before Score one step before the peak.
+ * @param peak Score at the peak.
+ * @param after Score one step after the peak.
+ * @return The offset of the true peak, in [-0.5, 0.5].
+ */
+float peakOffset(float before, float peak, float after) {
+  float curvature = before - 2.f * peak + after;
+  if (curvature >= 0.f) {
+    return 0.f;
+  }
+  return std::max(-0.5f, std::min(0.5f, 0.5f * (before - after) /
+                                             curvature));
+}
+
+/**
+ * @brief Sums a rectangle of an integral image.
+ * @param integral CV_64F integral image.
+ * @param x Left column of the rectangle.
+ * @param y Top row of the rectangle.
+ * @param width Rectangle width.
+ * @param height Rectangle height.
+ * @return The sum of the pixels inside.
+ */
+double boxSum(const cv::Mat& integral, int x, int y, int width, int height) {
+  const double* top = integral.ptr<double>(y);
+  const double* bottom = integral.ptr<double>(y + height);
+  return bottom[x + width] - bottom[x] - top[x + width] + top[x];
+}
+
+}  // namespace
+
+/**
+ * @brief Computes the normalized cross-correlation of a template at every
+ * position inside a larger image.
+ * @param image CV_32F image to search.
+ * @param templ CV_32F template with zero mean and unit norm.
+ * @param sums Integral image of the image (CV_64F).
+ * @param squares Integral image of the image's squares (CV_64F).
+ * @param scores Receives the correlation at each top-left offset, in
+ * [-1, 1]; flat windows score 0.
+ */
+void normalizedCrossCorrelation(const cv::Mat& image, const cv::Mat& templ,
+                                const cv::Mat& sums, const cv::Mat& squares,
+                                cv::Mat* scores) {
+  const int width = templ.cols;
+  const int height = templ.rows;
+  scores->create(image.rows - height + 1, image.cols - width + 1, CV_32F);
+  const double count = static_cast<double>(width) * height;
+  // Below a tenth of a gray level of deviation the window is flat
+  const double minVariance = count * 0.01;
+  for (int y = 0; y < scores->rows; ++y) {
+    float* out = scores->ptr<float>(y);
+    for (int x = 0; x < scores->cols; ++x) {
+      // The template has zero mean, so the window's mean cancels out
+      float dot = 0.f;
+#if CV_SIMD
+      const int step = cv::v_float32::nlanes;
+      cv::v_float32 acc = cv::vx_setzero_f32();
+#endif
+      for (int r = 0; r < height; ++r) {
+        const float* t = templ.ptr<float>(r);
+        const float* s = image.ptr<float>(y + r) + x;
+        int c = 0;
+#if CV_SIMD
+        for (; c <= width - step; c += step) {
+          acc = cv::v_fma(cv::vx_load(t + c), cv::vx_load(s + c), acc);
+        }
+#endif
+        for (; c < width; ++c) {
+          dot += t[c] * s[c];
+        }
+      }
+#if CV_SIMD
+      dot += cv::v_reduce_sum(acc);
+#endif
+      double sum = boxSum(sums, x, y, width, height);
+      double variance = boxSum(squares, x, y, width, height) -
+                        sum * sum / count;
+      out[x] = variance > minVariance
+                   ? static_cast<float>(dot / std::sqrt(variance))
+                   : 0.f;
+    }
+  }
+#if CV_SIMD
+  cv::v_cleanup();
+#endif
+}
+
+/**
+ * @brief Constructs a tracker without templates.
+ * @param config Search tunables.
+ */
+CorrelationTracker::CorrelationTracker(const CorrelationConfig& config)
+    : config(config) {}
+
+/**
+ * @brief Converts a frame to grayscale into the reused buffer.
+ * @param frame The BGR or grayscale frame.
+ * @return The grayscale frame.
+ */
+const cv::Mat& CorrelationTracker::toGray(const cv::Mat& frame) {
+  if (frame.channels() == 1) {
+    gray = frame;
+  } else {
+    cv::cvtColor(frame, gray,
+                 frame.channels() == 4 ? cv::COLOR_BGRA2GRAY
+                                       : cv::COLOR_BGR2GRAY);
+  }
+  return gray;
+}
+
+/**
+ * @brief Resamples a region of the gray frame to a float patch. Pixels
+ * outside the frame repeat the border.
+ * @param region Region in frame pixels.
+ * @param size Size of the patch.
+ * @param patch Receives the CV_32F patch.
+ */
+void CorrelationTracker::sample(const cv::Rect& region, const cv::Size& size,
+                                cv::Mat* patch) {
+  const cv::Rect inside = region & cv::Rect(0, 0, gray.cols, gray.rows);
+  if (inside.area() == 0) {
+    patch->create(size, CV_32F);
+    patch->setTo(cv::Scalar::all(0));
+    return;
+  }
+  cv::Mat source = gray(inside);
+  if (inside != region) {
+    cv::copyMakeBorder(source, border, inside.y - region.y,
+                       region.br().y - inside.br().y, inside.x - region.x,
+                       region.br().x - inside.br().x, cv::BORDER_REPLICATE);
+    source = border;
+  }
+  cv::resize(source, resized, size, 0, 0, cv::INTER_AREA);
+  resized.convertTo(*patch, CV_32F);
+}
+
+/**
+ * @brief Takes the templates of the live tracks from a frame whose boxes
+ * came from the detector, and forgets the tracks that are gone.
+ * @param frame The BGR or grayscale frame.
+ * @param tracks The tracks, with boxes for this frame.
+ */
+void CorrelationTracker::learn(const cv::Mat& frame,
+                               const std::vector<Track>& tracks) {
+  toGray(frame);
+  const cv::Rect bounds(0, 0, gray.cols, gray.rows);
+  const double count = static_cast<double>(config.patchSize.area());
+  std::map<int, cv::Mat> learned;
+  for (const Track& track : tracks) {
+    cv::Rect region(cvRound(track.box.x), cvRound(track.box.y),
+                    cvRound(track.box.width), cvRound(track.box.height));
+    // Too small to resample, or mostly outside the frame
+    if (region.width < 4 || region.height < 4 ||
+        2 * (region & bounds).area() < region.area()) {
+      continue;
+    }
+    cv::Mat patch;
+    sample(region, config.patchSize, &patch);
+    cv::Scalar mean;
+    cv::Scalar deviation;
+    cv::meanStdDev(patch, mean, deviation);
+    if (deviation[0] < 0.1) {
+      continue;  // Flat; it would match anything
+    }
+    // Zero mean and unit norm, so a window's score is one dot product
+    const double norm = deviation[0] * std::sqrt(count);
+    patch.convertTo(patch, CV_32F, 1.0 / norm, -mean[0] / norm);
+    learned[track.id] = patch;
+  }
+  templates.swap(learned);
+}
+
+/**
+ * @brief Searches for every live track around its prediction.
+ * @param frame The BGR or grayscale frame.
+ * @param tracker The tracker, advanced to this frame with predict().
+ * @return One box per live track, in getTracks() order, ready for
+ * MultiTracker::reanchor(); empty where the track has no template or
+ * no position scored minScore.
+ */
+const std::vector<cv::Rect2f>& CorrelationTracker::locate(
+    const cv::Mat& frame, const MultiTracker& tracker) {
+  const std::vector<Track>& tracks = tracker.getTracks();
+  boxes.assign(tracks.size(), cv::Rect2f());
+  if (templates.empty()) {
+    return boxes;
+  }
+  toGray(frame);
+  const cv::Size patch = config.patchSize;
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    const Track& track = tracks[i];
+    std::map<int, cv::Mat>::const_iterator templ = templates.find(track.id);
+    if (templ == templates.end() || track.box.width < 1.f ||
+        track.box.height < 1.f) {
+      continue;
+    }
+    ++counters.searches;
+
+    // Search as far as the prediction is uncertain, at the template's scale
+    const float radius = std::max(
+        config.minRadius,
+        std::min(config.maxRadius,
+                 config.searchSigmas *
+                     std::sqrt(tracker.getPositionVariance(i))));
+    const float scaleX = track.box.width / patch.width;
+    const float scaleY = track.box.height / patch.height;
+    const int marginX = std::max(1, static_cast<int>(std::ceil(radius /
+                                                               scaleX)));
+    const int marginY = std::max(1, static_cast<int>(std::ceil(radius /
+                                                               scaleY)));
+    const cv::Size size(patch.width + 2 * marginX,
+                        patch.height + 2 * marginY);
+    const cv::Point2f center = centerOf(track.box);
+    const cv::Rect region(cvRound(center.x - size.width * scaleX * 0.5f),
+                          cvRound(center.y - size.height * scaleY * 0.5f),
+                          std::max(1, cvRound(size.width * scaleX)),
+                          std::max(1, cvRound(size.height * scaleY)));
+    sample(region, size, &window);
+    cv::integral(window, sums, squares, CV_64F, CV_64F);
+    normalizedCrossCorrelation(window, templ->second, sums, squares, &scores);
+
+    double best = 0;
+    cv::Point at;
+    cv::minMaxLoc(scores, nullptr, &best, nullptr, &at);
+    if (best < config.minScore) {
+      continue;
+    }
+    ++counters.anchored;
+    cv::Point2f offset(static_cast<float>(at.x), static_cast<float>(at.y));
+    const float* row = scores.ptr<float>(at.y);
+    if (at.x > 0 && at.x + 1 < scores.cols) {
+      offset.x += peakOffset(row[at.x - 1], row[at.x], row[at.x + 1]);
+    }
+    if (at.y > 0 && at.y + 1 < scores.rows) {
+      offset.y += peakOffset(scores.at<float>(at.y - 1, at.x), row[at.x],
+                             scores.at<float>(at.y + 1, at.x));
+    }
+    // Map the template's center back through the region actually sampled
+    const float stepX = static_cast<float>(region.width) / size.width;
+    const float stepY = static_cast<float>(region.height) / size.height;
+    const cv::Point2f found(region.x + (offset.x + patch.width * 0.5f) * stepX,
+                            region.y +
+                                (offset.y + patch.height * 0.5f) * stepY);
+    boxes[i] = cv::Rect2f(found.x - track.box.width * 0.5f,
+                          found.y - track.box.height * 0.5f, track.box.width,
+                          track.box.height);
+  }
+  return boxes;
+}
+
+}  // namespace Tracker
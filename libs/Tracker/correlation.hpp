@@ -0,0 +1,140 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file correlation.hpp
+ * @brief Header file for the appearance-based short-term tracker that
+ * re-anchors tracks between detector runs.
+ */
+
+#include <cstdint>
+#include <map>
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "multi_tracker.hpp"
+
+namespace Tracker {
+
+/**
+ * @struct CorrelationConfig
+ * @brief Tunables for the correlation search.
+ */
+struct CorrelationConfig {
+  /**< Size every box is resampled to; tall, like the people tracked */
+  cv::Size patchSize = cv::Size(16, 32);
+  /**< Search radius in standard deviations of the predicted position */
+  float searchSigmas = 3.f;
+  float minRadius = 4.f;   /**< Smallest search radius, in frame pixels */
+  float maxRadius = 48.f;  /**< Largest search radius, in frame pixels */
+  /**< Lowest normalized cross-correlation that re-anchors a track */
+  float minScore = 0.6f;
+};
+
+/**
+ * @struct CorrelationStats
+ * @brief Counters of the correlation searches.
+ */
+struct CorrelationStats {
+  uint64_t searches = 0;  /**< Tracks searched for */
+  uint64_t anchored = 0;  /**< Searches that scored at least minScore */
+};
+
+/**
+ * @class CorrelationTracker
+ * @brief Finds tracked boxes in frames the detector skipped by normalized
+ * cross-correlation of small grayscale patches.
+ *
+ * On frames the detector ran on, learn() keeps each track's box resampled
+ * to patchSize as a zero-mean, unit-norm template. On the frames in
+ * between, locate() resamples a window around each track's Kalman
+ * prediction at the same scale and slides the template over it. The window
+ * grows with the predicted position's standard deviation, so a confident
+ * filter searches only a few pixels. Window sums come from integral
+ * images and the template products are vectorized, so a track costs a few
+ * microseconds, a tiny fraction of a forward pass.
+ */
+class CorrelationTracker {
+ public:
+  /**
+   * @brief Constructs a tracker without templates.
+   * @param config Search tunables.
+   */
+  explicit CorrelationTracker(
+      const CorrelationConfig& config = CorrelationConfig());
+
+  /**
+   * @brief Takes the templates of the live tracks from a frame whose boxes
+   * came from the detector, and forgets the tracks that are gone.
+   * @param frame The BGR or grayscale frame.
+   * @param tracks The tracks, with boxes for this frame.
+   */
+  void learn(const cv::Mat& frame, const std::vector<Track>& tracks);
+
+  /**
+   * @brief Searches for every live track around its prediction.
+   * @param frame The BGR or grayscale frame.
+   * @param tracker The tracker, advanced to this frame with predict().
+   * @return One box per live track, in getTracks() order, ready for
+   * MultiTracker::reanchor(); empty where the track has no template or
+   * no position scored minScore.
+   */
+  const std::vector<cv::Rect2f>& locate(const cv::Mat& frame,
+                                        const MultiTracker& tracker);
+
+  /**
+   * @brief Gets the counters.
+   * @return The search statistics.
+   */
+  const CorrelationStats& stats() const { return counters; }
+
+  /**
+   * @brief Forgets every template.
+   */
+  void clear() { templates.clear(); }
+
+ private:
+  /**
+   * @brief Converts a frame to grayscale into the reused buffer.
+   * @param frame The BGR or grayscale frame.
+   * @return The grayscale frame.
+   */
+  const cv::Mat& toGray(const cv::Mat& frame);
+
+  /**
+   * @brief Resamples a region of the gray frame to a float patch. Pixels
+   * outside the frame repeat the border.
+   * @param region Region in frame pixels.
+   * @param size Size of the patch.
+   * @param patch Receives the CV_32F patch.
+   */
+  void sample(const cv::Rect& region, const cv::Size& size, cv::Mat* patch);
+
+  CorrelationConfig config;     /**< Search tunables */
+  CorrelationStats counters;    /**< Search statistics */
+  std::map<int, cv::Mat> templates; /**< Normalized template per track id */
+  std::vector<cv::Rect2f> boxes; /**< Result of the last locate() */
+  cv::Mat gray;                 /**< Grayscale frame */
+  cv::Mat border;               /**< Region padded where it leaves the frame */
+  cv::Mat resized;              /**< Region resampled, before conversion */
+  cv::Mat window;               /**< Resampled search window */
+  cv::Mat sums;                 /**< Integral image of the window */
+  cv::Mat squares;              /**< Integral image of its squares */
+  cv::Mat scores;               /**< Correlation at every offset */
+};
+
+/**
+ * @brief Computes the normalized cross-correlation of a template at every
+ * position inside a larger image.
+ * @param image CV_32F image to search.
+ * @param templ CV_32F template with zero mean and unit norm.
+ * @param sums Integral image of the image (CV_64F).
+ * @param squares Integral image of the image's squares (CV_64F).
+ * @param scores Receives the correlation at each top-left offset, in
+ * [-1, 1]; flat windows score 0.
+ */
+void normalizedCrossCorrelation(const cv::Mat& image, const cv::Mat& templ,
+                                const cv::Mat& sums, const cv::Mat& squares,
+                                cv::Mat* scores);
+
+}  // namespace Tracker
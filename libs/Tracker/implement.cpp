@@ -48,6 +48,38 @@ void Tracker::initialize() {
   isInitialized = true;
 }
 
+/**
+ * @brief Initialize the tracker at a known position with zero velocity.
+ * @param position The first observed position of the target.
+ */
+void Tracker::initialize(const cv::Point2f& position) {
+  initialize();
+  state.at<float>(0) = position.x;
+  state.at<float>(1) = position.y;
+  kf.statePost = state.clone();
+}
+
+/**
+ * @brief Advance the filter by one frame without a measurement.
+ * @return cv::Point2f The predicted position of the target.
+ */
+cv::Point2f Tracker::predict() {
+  const cv::Mat& prediction = kf.predict();
+  return cv::Point2f(prediction.at<float>(0), prediction.at<float>(1));
+}
+
+/**
+ * @brief Update the filter with a measurement after predict().
+ * @param meas The observed position of the target.
+ * @return cv::Point2f The corrected position of the target.
+ */
+cv::Point2f Tracker::correct(const cv::Point2f& meas) {
+  measurement.at<float>(0) = meas.x;
+  measurement.at<float>(1) = meas.y;
+  const cv::Mat& corrected = kf.correct(measurement);
+  return cv::Point2f(corrected.at<float>(0), corrected.at<float>(1));
+}
+
 /**
  * @brief Tracks the target based on the given measurement.
  * This method uses the Kalman filter to predict and correct the state of the
@@ -90,4 +122,14 @@ cv::Point2f Tracker::getPredictedPosition() {
   return cv::Point2f(prediction.at<float>(0), prediction.at<float>(1));
 }
 
+/**
+ * @brief Get the estimated velocity.
+ * Reads the velocity components of the last corrected (or predicted) state.
+ *
+ * @return cv::Point2f The velocity of the target per frame.
+ */
+cv::Point2f Tracker::getVelocity() const {
+  return cv::Point2f(kf.statePost.at<float>(2), kf.statePost.at<float>(3));
+}
+
 }  // namespace Tracker
@@ -0,0 +1,227 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "kalman_bank.hpp"
+
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace Tracker {
+
+/**
+ * @brief Constructs an empty bank.
+ * @param config Noise parameters.
+ */
+KalmanBank::KalmanBank(const KalmanBankConfig& config) : config(config) {}
+
+/**
+ * @brief Reserves storage so adding up to count filters does not allocate.
+ * @param count Number of filters to make room for.
+ */
+void KalmanBank::reserve(size_t count) {
+  for (std::vector<float>* column :
+       {&x, &y, &dx, &dy, &pPos, &pCross, &pVel, &zx, &zy, &hasZ}) {
+    column->reserve(count);
+  }
+}
+
+/**
+ * @brief Adds a filter at a known position with zero velocity.
+ * @param position The first observed position of the target.
+ * @return Index of the new filter.
+ */
+size_t KalmanBank::add(const cv::Point2f& position) {
+  x.push_back(position.x);
+  y.push_back(position.y);
+  dx.push_back(0.f);
+  dy.push_back(0.f);
+  pPos.push_back(config.initialCovariance);
+  pCross.push_back(0.f);
+  pVel.push_back(config.initialCovariance);
+  zx.push_back(0.f);
+  zy.push_back(0.f);
+  hasZ.push_back(0.f);
+  return x.size() - 1;
+}
+
+/**
+ * @brief Copies the filter at one index over another.
+ * @param from Source index.
+ * @param to Destination index.
+ */
+void KalmanBank::move(size_t from, size_t to) {
+  for (std::vector<float>* column :
+       {&x, &y, &dx, &dy, &pPos, &pCross, &pVel, &zx, &zy, &hasZ}) {
+    (*column)[to] = (*column)[from];
+  }
+}
+
+/**
+ * @brief Keeps the first count filters and drops the rest.
+ * @param count Number of filters to keep.
+ */
+void KalmanBank::resize(size_t count) {
+  for (std::vector<float>* column :
+       {&x, &y, &dx, &dy, &pPos, &pCross, &pVel, &zx, &zy, &hasZ}) {
+    column->resize(count);
+  }
+}
+
+/**
+ * @brief Removes every filter while keeping the allocated capacity.
+ */
+void KalmanBank::clear() { resize(0); }
+
+/**
+ * @brief Advances every filter by one frame.
+ *
+ * Per axis, with the covariance block [a b; b c]:
+ * x' = x + dx, and P' = F P F^T + Q gives a' = a + 2b + c + q, b' = b + c,
+ * c' = c + q.
+ */
+void KalmanBank::predict() {
+  const int count = static_cast<int>(size());
+  const float q = config.processNoise;
+  float* px = x.data();
+  float* py = y.data();
+  float* pdx = dx.data();
+  float* pdy = dy.data();
+  float* a = pPos.data();
+  float* b = pCross.data();
+  float* c = pVel.data();
+  int i = 0;
+#if CV_SIMD
+  const int step = cv::v_float32::nlanes;
+  const cv::v_float32 vq = cv::vx_setall_f32(q);
+  for (; i <= count - step; i += step) {
+    cv::v_store(px + i, cv::vx_load(px + i) + cv::vx_load(pdx + i));
+    cv::v_store(py + i, cv::vx_load(py + i) + cv::vx_load(pdy + i));
+    cv::v_float32 va = cv::vx_load(a + i);
+    cv::v_float32 vb = cv::vx_load(b + i);
+    cv::v_float32 vc = cv::vx_load(c + i);
+    cv::v_store(a + i, va + vb + vb + vc + vq);
+    cv::v_store(b + i, vb + vc);
+    cv::v_store(c + i, vc + vq);
+  }
+  cv::v_cleanup();
+#endif
+  for (; i < count; ++i) {
+    px[i] += pdx[i];
+    py[i] += pdy[i];
+    float ai = a[i];
+    float bi = b[i];
+    float ci = c[i];
+    a[i] = ai + bi + bi + ci + q;
+    b[i] = bi + ci;
+    c[i] = ci + q;
+  }
+}
+
+/**
+ * @brief Queues a measurement for the next correct().
+ * @param index Filter index.
+ * @param measurement The observed position of the target.
+ */
+void KalmanBank::setMeasurement(size_t index,
+                                const cv::Point2f& measurement) {
+  zx[index] = measurement.x;
+  zy[index] = measurement.y;
+  hasZ[index] = 1.f;
+}
+
+/**
+ * @brief Updates every filter with its queued measurement, if any, and
+ * clears the queue. Filters without a measurement keep their prediction.
+ *
+ * Per axis, S = a + r and the gain is K = [a b]^T / S. Scaling the gain by
+ * the 0/1 measurement flag turns unmeasured filters into no-ops, so the pass
+ * has no branches.
+ */
+void KalmanBank::correct() {
+  const int count = static_cast<int>(size());
+  const float r = config.measurementNoise;
+  float* px = x.data();
+  float* py = y.data();
+  float* pdx = dx.data();
+  float* pdy = dy.data();
+  float* a = pPos.data();
+  float* b = pCross.data();
+  float* c = pVel.data();
+  float* mx = zx.data();
+  float* my = zy.data();
+  float* flag = hasZ.data();
+  int i = 0;
+#if CV_SIMD
+  const int step = cv::v_float32::nlanes;
+  const cv::v_float32 vr = cv::vx_setall_f32(r);
+  const cv::v_float32 zero = cv::vx_setzero_f32();
+  for (; i <= count - step; i += step) {
+    cv::v_float32 va = cv::vx_load(a + i);
+    cv::v_float32 vb = cv::vx_load(b + i);
+    cv::v_float32 vc = cv::vx_load(c + i);
+    cv::v_float32 scale = cv::vx_load(flag + i) / (va + vr);
+    cv::v_float32 k0 = va * scale;
+    cv::v_float32 k1 = vb * scale;
+    cv::v_float32 vx = cv::vx_load(px + i);
+    cv::v_float32 vy = cv::vx_load(py + i);
+    cv::v_float32 ex = cv::vx_load(mx + i) - vx;
+    cv::v_float32 ey = cv::vx_load(my + i) - vy;
+    cv::v_store(px + i, cv::v_fma(k0, ex, vx));
+    cv::v_store(py + i, cv::v_fma(k0, ey, vy));
+    cv::v_store(pdx + i, cv::v_fma(k1, ex, cv::vx_load(pdx + i)));
+    cv::v_store(pdy + i, cv::v_fma(k1, ey, cv::vx_load(pdy + i)));
+    cv::v_store(a + i, va - k0 * va);
+    cv::v_store(b + i, vb - k0 * vb);
+    cv::v_store(c + i, vc - k1 * vb);
+    cv::v_store(flag + i, zero);
+  }
+  cv::v_cleanup();
+#endif
+  for (; i < count; ++i) {
+    float scale = flag[i] / (a[i] + r);
+    float k0 = a[i] * scale;
+    float k1 = b[i] * scale;
+    float ex = mx[i] - px[i];
+    float ey = my[i] - py[i];
+    px[i] += k0 * ex;
+    py[i] += k0 * ey;
+    pdx[i] += k1 * ex;
+    pdy[i] += k1 * ey;
+    c[i] -= k1 * b[i];
+    a[i] -= k0 * a[i];
+    b[i] -= k0 * b[i];
+    flag[i] = 0.f;
+  }
+}
+
+/**
+ * @brief Gets the position estimate of a filter.
+ * @param index Filter index.
+ * @return The estimated position.
+ */
+cv::Point2f KalmanBank::getPosition(size_t index) const {
+  return cv::Point2f(x[index], y[index]);
+}
+
+/**
+ * @brief Gets the velocity estimate of a filter.
+ * @param index Filter index.
+ * @return The estimated velocity per frame.
+ */
+cv::Point2f KalmanBank::getVelocity(size_t index) const {
+  return cv::Point2f(dx[index], dy[index]);
+}
+
+/**
+ * @brief Gets the error covariance of a filter as a full 4x4 matrix.
+ * @param index Filter index.
+ * @return The covariance of [x, y, dx, dy].
+ */
+cv::Matx44f KalmanBank::getCovariance(size_t index) const {
+  float a = pPos[index];
+  float b = pCross[index];
+  float c = pVel[index];
+  return cv::Matx44f(a, 0, b, 0,
+                     0, a, 0, b,
+                     b, 0, c, 0,
+                     0, b, 0, c);
+}
+
+}  // namespace Tracker
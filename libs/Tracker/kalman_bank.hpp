@@ -0,0 +1,145 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file kalman_bank.hpp
+ * @brief Header file for the batched constant-velocity Kalman filter bank.
+ */
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace Tracker {
+
+/**
+ * @struct KalmanBankConfig
+ * @brief Noise parameters shared by every filter in a KalmanBank.
+ *
+ * The defaults match the cv::KalmanFilter set up by Tracker::Tracker.
+ */
+struct KalmanBankConfig {
+  float processNoise = 1e-2f;     /**< Diagonal of the process noise Q */
+  float measurementNoise = 1e-1f; /**< Diagonal of the measurement noise R */
+  float initialCovariance = 1.f;  /**< Diagonal of the error covariance P0 */
+};
+
+/**
+ * @class KalmanBank
+ * @brief Many constant-velocity Kalman filters updated together.
+ *
+ * Each filter has the state [x, y, dx, dy], the transition
+ * F = [I I; 0 I] and the measurement H = [I 0], exactly like Tracker::Tracker.
+ * Because F, H, Q and R all act on x and y independently and identically, the
+ * 4x4 covariance is two identical 2x2 [position, velocity] blocks, so a filter
+ * stores three covariance terms and the 4x4 and 2x4 products reduce to a few
+ * closed-form multiply-adds. Filters are kept as structure-of-arrays and
+ * predict() / correct() sweep all of them in one vectorized pass; once the
+ * arrays have grown, no call allocates.
+ */
+class KalmanBank {
+ public:
+  /**
+   * @brief Constructs an empty bank.
+   * @param config Noise parameters.
+   */
+  explicit KalmanBank(const KalmanBankConfig& config = KalmanBankConfig());
+
+  /**
+   * @brief Gets the number of filters.
+   * @return The filter count.
+   */
+  size_t size() const { return x.size(); }
+
+  /**
+   * @brief Reserves storage so adding up to count filters does not allocate.
+   * @param count Number of filters to make room for.
+   */
+  void reserve(size_t count);
+
+  /**
+   * @brief Adds a filter at a known position with zero velocity.
+   * @param position The first observed position of the target.
+   * @return Index of the new filter.
+   */
+  size_t add(const cv::Point2f& position);
+
+  /**
+   * @brief Copies the filter at one index over another.
+   * @param from Source index.
+   * @param to Destination index.
+   */
+  void move(size_t from, size_t to);
+
+  /**
+   * @brief Keeps the first count filters and drops the rest.
+   * @param count Number of filters to keep.
+   */
+  void resize(size_t count);
+
+  /**
+   * @brief Removes every filter while keeping the allocated capacity.
+   */
+  void clear();
+
+  /**
+   * @brief Advances every filter by one frame.
+   */
+  void predict();
+
+  /**
+   * @brief Queues a measurement for the next correct().
+   * @param index Filter index.
+   * @param measurement The observed position of the target.
+   */
+  void setMeasurement(size_t index, const cv::Point2f& measurement);
+
+  /**
+   * @brief Updates every filter with its queued measurement, if any, and
+   * clears the queue. Filters without a measurement keep their prediction.
+   */
+  void correct();
+
+  /**
+   * @brief Gets the position estimate of a filter.
+   * @param index Filter index.
+   * @return The estimated position.
+   */
+  cv::Point2f getPosition(size_t index) const;
+
+  /**
+   * @brief Gets the velocity estimate of a filter.
+   * @param index Filter index.
+   * @return The estimated velocity per frame.
+   */
+  cv::Point2f getVelocity(size_t index) const;
+
+  /**
+   * @brief Gets the position variance of a filter, the (0, 0) entry of its
+   * error covariance.
+   * @param index Filter index.
+   * @return The variance of x (equal to that of y).
+   */
+  float getPositionVariance(size_t index) const { return pPos[index]; }
+
+  /**
+   * @brief Gets the error covariance of a filter as a full 4x4 matrix.
+   * @param index Filter index.
+   * @return The covariance of [x, y, dx, dy].
+   */
+  cv::Matx44f getCovariance(size_t index) const;
+
+ private:
+  KalmanBankConfig config;   /**< Noise parameters */
+  std::vector<float> x;      /**< Position x of each filter */
+  std::vector<float> y;      /**< Position y of each filter */
+  std::vector<float> dx;     /**< Velocity x of each filter */
+  std::vector<float> dy;     /**< Velocity y of each filter */
+  std::vector<float> pPos;   /**< Position variance of each axis block */
+  std::vector<float> pCross; /**< Position-velocity covariance */
+  std::vector<float> pVel;   /**< Velocity variance */
+  std::vector<float> zx;     /**< Queued measurement x */
+  std::vector<float> zy;     /**< Queued measurement y */
+  std::vector<float> hasZ;   /**< 1 where a measurement is queued, else 0 */
+};
+
+}  // namespace Tracker
@@ -0,0 +1,627 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "multi_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace Tracker {
+
+namespace {
+
+/**< Cost given to (track, detection) pairs that failed the gate */
+constexpr float kForbiddenCost = 1e6f;
+
+/**
+ * @brief Gets the center of a box.
+ * @param box The box.
+ * @return The center point.
+ */
+cv::Point2f centerOf(const cv::Rect2f& box) {
+  return cv::Point2f(box.x + box.width * 0.5f, box.y + box.height * 0.5f);
+}
+
+/**
+ * @class SpatialGrid
+ * @brief Sorted uniform grid for finding detections near a query region.
+ *
+ * Entries are (cell key, detection) pairs kept in one sorted vector, so a
+ * lookup is a binary search and building the grid needs no hashing.
+ */
+class SpatialGrid {
+ public:
+  /**
+   * @brief Constructs an empty grid.
+   * @param cellSize Side of a square cell in pixels.
+   */
+  explicit SpatialGrid(float cellSize) : cellSize(std::max(cellSize, 1.f)) {}
+
+  /**
+   * @brief Registers a detection in every cell its region overlaps.
+   * @param region The region covered by the detection.
+   * @param index The detection index.
+   */
+  void insert(const cv::Rect2f& region, int index) {
+    int x0, y0, x1, y1;
+    cellRange(region, &x0, &y0, &x1, &y1);
+    for (int cy = y0; cy <= y1; ++cy) {
+      for (int cx = x0; cx <= x1; ++cx) {
+        entries.emplace_back(key(cx, cy), index);
+      }
+    }
+  }
+
+  /**
+   * @brief Sorts the entries; call once after the last insert().
+   */
+  void build() { std::sort(entries.begin(), entries.end()); }
+
+  /**
+   * @brief Visits the detections registered in cells overlapping a region.
+   *
+   * A detection spanning several cells may be visited more than once.
+   *
+   * @param region The query region.
+   * @param visit Callable taking a detection index.
+   */
+  template <typename Visit>
+  void query(const cv::Rect2f& region, Visit visit) const {
+    int x0, y0, x1, y1;
+    cellRange(region, &x0, &y0, &x1, &y1);
+    // A huge region touches more cells than there are entries: scan instead
+    int64_t cells = static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+    if (cells > static_cast<int64_t>(entries.size())) {
+      for (const auto& entry : entries) {
+        visit(entry.second);
+      }
+      return;
+    }
+    for (int cy = y0; cy <= y1; ++cy) {
+      for (int cx = x0; cx <= x1; ++cx) {
+        auto first = std::lower_bound(
+            entries.begin(), entries.end(),
+            std::make_pair(key(cx, cy), std::numeric_limits<int>::min()));
+        for (auto it = first; it != entries.end() && it->first == key(cx, cy);
+             ++it) {
+          visit(it->second);
+        }
+      }
+    }
+  }
+
+ private:
+  /**
+   * @brief Packs cell coordinates into one sortable key.
+   * @param cx Cell column.
+   * @param cy Cell row.
+   * @return The cell key.
+   */
+  static int64_t key(int cx, int cy) {
+    return (static_cast<int64_t>(cy) << 32) |
+           static_cast<int64_t>(static_cast<uint32_t>(cx));
+  }
+
+  /**
+   * @brief Computes the inclusive range of cells overlapping a region.
+   * @param region The region.
+   * @param x0 Receives the first column.
+   * @param y0 Receives the first row.
+   * @param x1 Receives the last column.
+   * @param y1 Receives the last row.
+   */
+  void cellRange(const cv::Rect2f& region, int* x0, int* y0, int* x1,
+                 int* y1) const {
+    *x0 = static_cast<int>(std::floor(region.x / cellSize));
+    *y0 = static_cast<int>(std::floor(region.y / cellSize));
+    *x1 = static_cast<int>(std::floor((region.x + region.width) / cellSize));
+    *y1 = static_cast<int>(std::floor((region.y + region.height) / cellSize));
+  }
+
+  float cellSize; /**< Side of a cell in pixels */
+  std::vector<std::pair<int64_t, int>> entries; /**< (cell, detection) */
+};
+
+/**
+ * @brief Finds the representative of a union-find set with path halving.
+ * @param parent Parent array.
+ * @param node The node.
+ * @return The set representative.
+ */
+int findRoot(std::vector<int>* parent, int node) {
+  while ((*parent)[node] != node) {
+    (*parent)[node] = (*parent)[(*parent)[node]];
+    node = (*parent)[node];
+  }
+  return node;
+}
+
+}  // namespace
+
+/**
+ * @brief Computes the intersection over union of two boxes.
+ * @param a First box.
+ * @param b Second box.
+ * @return IoU in [0, 1].
+ */
+float intersectionOverUnion(const cv::Rect2f& a, const cv::Rect2f& b) {
+  float interW = std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x);
+  float interH =
+      std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y);
+  if (interW <= 0.f || interH <= 0.f) {
+    return 0.f;
+  }
+  float inter = interW * interH;
+  float unionArea = a.width * a.height + b.width * b.height - inter;
+  return unionArea > 0.f ? inter / unionArea : 0.f;
+}
+
+/**
+ * @brief Solves a dense rectangular assignment problem (Hungarian method).
+ * @param cost Row-major rows x cols cost matrix.
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @return The column assigned to each row, or -1 when rows > cols leaves a
+ * row unassigned.
+ */
+std::vector<int> solveHungarian(const std::vector<float>& cost, int rows,
+                                int cols) {
+  std::vector<int> rowToCol(rows, -1);
+  if (rows == 0 || cols == 0) {
+    return rowToCol;
+  }
+
+  // The potential method below needs n <= m, so solve the transpose if not
+  const bool transposed = rows > cols;
+  const int n = transposed ? cols : rows;
+  const int m = transposed ? rows : cols;
+  auto at = [&](int i, int j) -> double {
+    return transposed ? cost[j * cols + i] : cost[i * cols + j];
+  };
+
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<double> u(n + 1, 0.0), v(m + 1, 0.0), minv(m + 1);
+  std::vector<int> p(m + 1, 0), way(m + 1, 0);
+  std::vector<char> used(m + 1);
+  for (int i = 1; i <= n; ++i) {
+    p[0] = i;
+    int j0 = 0;
+    std::fill(minv.begin(), minv.end(), inf);
+    std::fill(used.begin(), used.end(), 0);
+    do {
+      used[j0] = 1;
+      int i0 = p[j0];
+      int j1 = 0;
+      double delta = inf;
+      for (int j = 1; j <= m; ++j) {
+        if (used[j]) {
+          continue;
+        }
+        double cur = at(i0 - 1, j - 1) - u[i0] - v[j];
+        if (cur < minv[j]) {
+          minv[j] = cur;
+          way[j] = j0;
+        }
+        if (minv[j] < delta) {
+          delta = minv[j];
+          j1 = j;
+        }
+      }
+      for (int j = 0; j <= m; ++j) {
+        if (used[j]) {
+          u[p[j]] += delta;
+          v[j] -= delta;
+        } else {
+          minv[j] -= delta;
+        }
+      }
+      j0 = j1;
+    } while (p[j0] != 0);
+    do {
+      int j1 = way[j0];
+      p[j0] = p[j1];
+      j0 = j1;
+    } while (j0 != 0);
+  }
+
+  for (int j = 1; j <= m; ++j) {
+    if (p[j] == 0) {
+      continue;
+    }
+    if (transposed) {
+      rowToCol[j - 1] = p[j] - 1;
+    } else {
+      rowToCol[p[j] - 1] = j - 1;
+    }
+  }
+  return rowToCol;
+}
+
+/**
+ * @brief Constructs an empty multi-object tracker.
+ * @param config Association and lifecycle tunables.
+ */
+MultiTracker::MultiTracker(const MultiTrackerConfig& config)
+    : config(config), filters(config.filter), nextId(0) {}
+
+/**
+ * @brief Advances all tracks by one frame and associates detections.
+ * @param detections Boxes detected in the new frame.
+ * @return The live tracks after the update, tentative ones included.
+ */
+const std::vector<Track>& MultiTracker::update(
+    const std::vector<cv::Rect2f>& detections) {
+  // Predict every track forward to the new frame
+  advance();
+
+  std::vector<CandidatePair> pairs;
+  gatherPairs(detections, &pairs);
+  std::vector<int> trackToDetection;
+  assign(pairs, static_cast<int>(detections.size()), &trackToDetection);
+
+  // Correct matched tracks in one pass over the filter bank
+  std::vector<char> detectionUsed(detections.size(), 0);
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    int d = trackToDetection[i];
+    if (d >= 0) {
+      detectionUsed[d] = 1;
+      filters.setMeasurement(i, centerOf(detections[d]));
+    }
+  }
+  filters.correct();
+
+  // Refresh the matched boxes, age the rest, and drop the lost ones
+  size_t kept = 0;
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    Track& track = tracks[i];
+    int d = trackToDetection[i];
+    if (d >= 0) {
+      const cv::Rect2f& det = detections[d];
+      cv::Point2f center = filters.getPosition(i);
+      track.box = cv::Rect2f(center.x - det.width * 0.5f,
+                             center.y - det.height * 0.5f, det.width,
+                             det.height);
+      ++track.hits;
+      track.misses = 0;
+      if (track.state == TrackState::kTentative &&
+          track.hits >= config.confirmHits) {
+        track.state = TrackState::kConfirmed;
+      }
+    } else {
+      ++track.misses;
+    }
+    track.velocity = filters.getVelocity(i);
+
+    bool lost = track.misses > config.maxMisses ||
+                (track.state == TrackState::kTentative && track.misses > 0);
+    if (!lost) {
+      if (kept != i) {
+        tracks[kept] = track;
+        filters.move(i, kept);
+      }
+      ++kept;
+    }
+  }
+  tracks.resize(kept);
+  filters.resize(kept);
+
+  // Unmatched detections start new tentative tracks
+  for (size_t d = 0; d < detections.size(); ++d) {
+    if (detectionUsed[d]) {
+      continue;
+    }
+    Track track;
+    track.id = nextId++;
+    track.box = detections[d];
+    track.hits = 1;
+    track.state = config.confirmHits <= 1 ? TrackState::kConfirmed
+                                          : TrackState::kTentative;
+    filters.add(centerOf(detections[d]));
+    tracks.push_back(track);
+  }
+  return tracks;
+}
+
+/**
+ * @brief Advances all tracks by one frame on their predictions alone, for
+ * frames where detection was skipped. Misses are not counted.
+ * @return The live tracks after the prediction.
+ */
+const std::vector<Track>& MultiTracker::predict() {
+  advance();
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    tracks[i].velocity = filters.getVelocity(i);
+  }
+  return tracks;
+}
+
+/**
+ * @brief Corrects the tracks just advanced by predict() with positions
+ * measured without the detector, e.g. by a CorrelationTracker. Hits and
+ * misses are not counted.
+ * @param boxes One box per live track, in getTracks() order; an empty box
+ * leaves that track on its prediction.
+ * @return The live tracks after the correction.
+ */
+const std::vector<Track>& MultiTracker::reanchor(
+    const std::vector<cv::Rect2f>& boxes) {
+  const size_t count = std::min(boxes.size(), tracks.size());
+  for (size_t i = 0; i < count; ++i) {
+    if (boxes[i].area() > 0) {
+      filters.setMeasurement(i, centerOf(boxes[i]));
+    }
+  }
+  filters.correct();
+  for (size_t i = 0; i < count; ++i) {
+    if (boxes[i].area() > 0) {
+      cv::Point2f center = filters.getPosition(i);
+      Track& track = tracks[i];
+      track.box.x = center.x - track.box.width * 0.5f;
+      track.box.y = center.y - track.box.height * 0.5f;
+      track.velocity = filters.getVelocity(i);
+    }
+  }
+  return tracks;
+}
+
+/**
+ * @brief Gets the largest position variance among the confirmed tracks.
+ * @return The variance in squared pixels, or 0 without confirmed tracks.
+ */
+float MultiTracker::getMaxUncertainty() const {
+  float worst = 0.f;
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    if (tracks[i].state == TrackState::kConfirmed) {
+      worst = std::max(worst, filters.getPositionVariance(i));
+    }
+  }
+  return worst;
+}
+
+/**
+ * @brief Gets the position variance of one live track.
+ * @param index Index into getTracks().
+ * @return The variance in squared pixels.
+ */
+float MultiTracker::getPositionVariance(size_t index) const {
+  return filters.getPositionVariance(index);
+}
+
+/**
+ * @brief Predicts every filter one frame ahead and moves the boxes.
+ */
+void MultiTracker::advance() {
+  filters.predict();
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    cv::Point2f center = filters.getPosition(i);
+    Track& track = tracks[i];
+    track.box.x = center.x - track.box.width * 0.5f;
+    track.box.y = center.y - track.box.height * 0.5f;
+    ++track.age;
+  }
+}
+
+/**
+ * @brief Gets the live tracks.
+ * @return The tracks as of the last update.
+ */
+const std::vector<Track>& MultiTracker::getTracks() const { return tracks; }
+
+/**
+ * @brief Gets the confirmed tracks only.
+ * @return Copies of the confirmed tracks.
+ */
+std::vector<Track> MultiTracker::getConfirmedTracks() const {
+  std::vector<Track> confirmed;
+  for (const Track& track : tracks) {
+    if (track.state == TrackState::kConfirmed) {
+      confirmed.push_back(track);
+    }
+  }
+  return confirmed;
+}
+
+/**
+ * @brief Removes every track. IDs keep counting up.
+ */
+void MultiTracker::clear() {
+  tracks.clear();
+  filters.clear();
+}
+
+/**
+ * @brief Finds gated (track, detection) pairs through a spatial grid.
+ * @param detections Boxes detected in the new frame.
+ * @param pairs Receives the candidate pairs.
+ */
+void MultiTracker::gatherPairs(const std::vector<cv::Rect2f>& detections,
+                               std::vector<CandidatePair>* pairs) const {
+  pairs->clear();
+  if (tracks.empty() || detections.empty()) {
+    return;
+  }
+
+  const bool useIoU = config.metric == AssociationMetric::kIoU;
+  float cellSize = config.maxDistance;
+  if (useIoU) {
+    // Cells about the size of a typical box keep each box in a few cells
+    std::vector<float> sizes;
+    sizes.reserve(detections.size());
+    for (const cv::Rect2f& det : detections) {
+      sizes.push_back(std::max(det.width, det.height));
+    }
+    std::nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2,
+                     sizes.end());
+    cellSize = sizes[sizes.size() / 2];
+  }
+
+  SpatialGrid grid(cellSize);
+  for (size_t d = 0; d < detections.size(); ++d) {
+    if (useIoU) {
+      grid.insert(detections[d], static_cast<int>(d));
+    } else {
+      cv::Point2f c = centerOf(detections[d]);
+      grid.insert(cv::Rect2f(c.x, c.y, 0.f, 0.f), static_cast<int>(d));
+    }
+  }
+  grid.build();
+
+  // Stamp of the last track that scored each detection, to skip repeats
+  std::vector<int> seenBy(detections.size(), -1);
+  for (size_t t = 0; t < tracks.size(); ++t) {
+    const cv::Rect2f& predicted = tracks[t].box;
+    cv::Rect2f region = predicted;
+    if (!useIoU) {
+      cv::Point2f c = centerOf(predicted);
+      region = cv::Rect2f(c.x - config.maxDistance, c.y - config.maxDistance,
+                          2 * config.maxDistance, 2 * config.maxDistance);
+    }
+    const int trackIndex = static_cast<int>(t);
+    grid.query(region, [&](int d) {
+      if (seenBy[d] == trackIndex) {
+        return;
+      }
+      seenBy[d] = trackIndex;
+      float cost;
+      if (useIoU) {
+        float iou = intersectionOverUnion(predicted, detections[d]);
+        if (iou < config.minIoU) {
+          return;
+        }
+        cost = 1.f - iou;
+      } else {
+        cv::Point2f delta = centerOf(predicted) - centerOf(detections[d]);
+        cost = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+        if (cost > config.maxDistance) {
+          return;
+        }
+      }
+      pairs->push_back({trackIndex, d, cost});
+    });
+  }
+}
+
+/**
+ * @brief Picks non-conflicting matches from the candidate pairs.
+ * @param pairs Candidate pairs.
+ * @param numDetections Number of detections in the frame.
+ * @param trackToDetection Receives the matched detection of each track or
+ * -1.
+ */
+void MultiTracker::assign(const std::vector<CandidatePair>& pairs,
+                          int numDetections,
+                          std::vector<int>* trackToDetection) const {
+  const int numTracks = static_cast<int>(tracks.size());
+  trackToDetection->assign(numTracks, -1);
+  if (pairs.empty()) {
+    return;
+  }
+
+  std::vector<char> detectionTaken(numDetections, 0);
+  auto greedy = [&](std::vector<CandidatePair> subset) {
+    std::sort(subset.begin(), subset.end(),
+              [](const CandidatePair& a, const CandidatePair& b) {
+                return a.cost < b.cost;
+              });
+    for (const CandidatePair& pair : subset) {
+      if ((*trackToDetection)[pair.track] < 0 &&
+          !detectionTaken[pair.detection]) {
+        (*trackToDetection)[pair.track] = pair.detection;
+        detectionTaken[pair.detection] = 1;
+      }
+    }
+  };
+
+  if (config.solver == AssignmentSolver::kGreedy) {
+    greedy(pairs);
+    return;
+  }
+
+  // Split the bipartite pair graph into independent clusters. Nodes are
+  // tracks [0, numTracks) followed by detections.
+  std::vector<int> parent(numTracks + numDetections);
+  std::iota(parent.begin(), parent.end(), 0);
+  for (const CandidatePair& pair : pairs) {
+    int a = findRoot(&parent, pair.track);
+    int b = findRoot(&parent, numTracks + pair.detection);
+    if (a != b) {
+      parent[a] = b;
+    }
+  }
+
+  // Order pairs by cluster so each cluster is a contiguous run
+  std::vector<std::pair<int, int>> order;  // (cluster root, pair index)
+  order.reserve(pairs.size());
+  for (size_t k = 0; k < pairs.size(); ++k) {
+    order.emplace_back(findRoot(&parent, pairs[k].track),
+                       static_cast<int>(k));
+  }
+  std::sort(order.begin(), order.end());
+
+  std::vector<int> localTrack(numTracks, -1);
+  std::vector<int> localDetection(numDetections, -1);
+  std::vector<int> clusterTracks, clusterDetections;
+  std::vector<CandidatePair> cluster;
+  std::vector<float> cost;
+  for (size_t begin = 0; begin < order.size();) {
+    size_t end = begin;
+    cluster.clear();
+    while (end < order.size() && order[end].first == order[begin].first) {
+      cluster.push_back(pairs[order[end].second]);
+      ++end;
+    }
+    begin = end;
+
+    if (cluster.size() == 1) {
+      const CandidatePair& only = cluster.front();
+      (*trackToDetection)[only.track] = only.detection;
+      detectionTaken[only.detection] = 1;
+      continue;
+    }
+
+    clusterTracks.clear();
+    clusterDetections.clear();
+    for (const CandidatePair& pair : cluster) {
+      if (localTrack[pair.track] < 0) {
+        localTrack[pair.track] = static_cast<int>(clusterTracks.size());
+        clusterTracks.push_back(pair.track);
+      }
+      if (localDetection[pair.detection] < 0) {
+        localDetection[pair.detection] =
+            static_cast<int>(clusterDetections.size());
+        clusterDetections.push_back(pair.detection);
+      }
+    }
+
+    const int rows = static_cast<int>(clusterTracks.size());
+    const int cols = static_cast<int>(clusterDetections.size());
+    if (std::max(rows, cols) > config.maxHungarianSize) {
+      greedy(cluster);
+    } else {
+      cost.assign(static_cast<size_t>(rows) * cols, kForbiddenCost);
+      for (const CandidatePair& pair : cluster) {
+        cost[localTrack[pair.track] * cols + localDetection[pair.detection]] =
+            pair.cost;
+      }
+      std::vector<int> match = solveHungarian(cost, rows, cols);
+      for (int r = 0; r < rows; ++r) {
+        int c = match[r];
+        if (c >= 0 && cost[r * cols + c] < kForbiddenCost) {
+          (*trackToDetection)[clusterTracks[r]] = clusterDetections[c];
+          detectionTaken[clusterDetections[c]] = 1;
+        }
+      }
+    }
+
+    for (int track : clusterTracks) {
+      localTrack[track] = -1;
+    }
+    for (int detection : clusterDetections) {
+      localDetection[detection] = -1;
+    }
+  }
+}
+
+}  // namespace Tracker
@@ -0,0 +1,211 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file multi_tracker.hpp
+ * @brief Header file for the multi-object tracker built on KalmanBank.
+ */
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "kalman_bank.hpp"
+
+namespace Tracker {
+
+/**
+ * @enum AssociationMetric
+ * @brief Cost used to match detections to tracks.
+ */
+enum class AssociationMetric {
+  kIoU,      /**< 1 - intersection over union of the boxes */
+  kCentroid  /**< Euclidean distance between box centers */
+};
+
+/**
+ * @enum AssignmentSolver
+ * @brief Algorithm used to pick matches from the gated candidate pairs.
+ */
+enum class AssignmentSolver {
+  kGreedy,    /**< Take the cheapest remaining pair first */
+  kHungarian  /**< Optimal assignment within each cluster of pairs */
+};
+
+/**
+ * @enum TrackState
+ * @brief Lifecycle state of a track.
+ */
+enum class TrackState {
+  kTentative, /**< Born recently, not yet matched confirmHits times */
+  kConfirmed  /**< Matched often enough to be reported */
+};
+
+/**
+ * @struct MultiTrackerConfig
+ * @brief Tunables for association and track lifecycle.
+ */
+struct MultiTrackerConfig {
+  AssociationMetric metric = AssociationMetric::kIoU; /**< Matching cost */
+  AssignmentSolver solver = AssignmentSolver::kHungarian; /**< Matcher */
+  float minIoU = 0.3f;       /**< IoU gate for AssociationMetric::kIoU */
+  float maxDistance = 50.f;  /**< Center gate for kCentroid */
+  int confirmHits = 3;       /**< Matches needed to confirm a track */
+  int maxMisses = 5;         /**< Missed frames before a track is dropped */
+  /**< Clusters larger than this fall back to greedy matching */
+  int maxHungarianSize = 256;
+  /**< Kalman noise, in the squared units of the boxes (pixels by default) */
+  KalmanBankConfig filter;
+};
+
+/**
+ * @struct Track
+ * @brief A tracked target as reported to callers.
+ */
+struct Track {
+  int id = -1;          /**< Stable identifier, never reused */
+  cv::Rect2f box;       /**< Current box estimate */
+  cv::Point2f velocity; /**< Estimated center velocity per frame */
+  TrackState state = TrackState::kTentative; /**< Lifecycle state */
+  int hits = 0;         /**< Frames with a matched detection */
+  int misses = 0;       /**< Consecutive frames without a match */
+  int age = 0;          /**< Frames since birth */
+};
+
+/**
+ * @class MultiTracker
+ * @brief Tracks many targets by associating each frame's detections with
+ * Kalman-predicted tracks.
+ *
+ * The filters live in one KalmanBank, indexed like the tracks, so predicting
+ * and correcting every track is a single vectorized pass per frame.
+ *
+ * Candidate pairs are found through a uniform grid over the detections, so
+ * each track only scores the detections near its predicted box and the cost
+ * stays close to linear in the number of targets. Gated pairs are split into
+ * independent clusters and each cluster is solved on its own, which keeps
+ * the cubic Hungarian step limited to the handful of targets that actually
+ * compete for the same detections.
+ */
+class MultiTracker {
+ public:
+  /**
+   * @brief Constructs an empty multi-object tracker.
+   * @param config Association and lifecycle tunables.
+   */
+  explicit MultiTracker(
+      const MultiTrackerConfig& config = MultiTrackerConfig());
+
+  /**
+   * @brief Advances all tracks by one frame and associates detections.
+   * @param detections Boxes detected in the new frame.
+   * @return The live tracks after the update, tentative ones included.
+   */
+  const std::vector<Track>& update(const std::vector<cv::Rect2f>& detections);
+
+  /**
+   * @brief Advances all tracks by one frame on their predictions alone, for
+   * frames where detection was skipped. Misses are not counted.
+   * @return The live tracks after the prediction.
+   */
+  const std::vector<Track>& predict();
+
+  /**
+   * @brief Corrects the tracks just advanced by predict() with positions
+   * measured without the detector, e.g. by a CorrelationTracker. Hits and
+   * misses are not counted.
+   * @param boxes One box per live track, in getTracks() order; an empty box
+   * leaves that track on its prediction.
+   * @return The live tracks after the correction.
+   */
+  const std::vector<Track>& reanchor(const std::vector<cv::Rect2f>& boxes);
+
+  /**
+   * @brief Gets the largest position variance among the confirmed tracks.
+   * @return The variance in squared pixels, or 0 without confirmed tracks.
+   */
+  float getMaxUncertainty() const;
+
+  /**
+   * @brief Gets the position variance of one live track.
+   * @param index Index into getTracks().
+   * @return The variance in squared pixels.
+   */
+  float getPositionVariance(size_t index) const;
+
+  /**
+   * @brief Gets the live tracks.
+   * @return The tracks as of the last update.
+   */
+  const std::vector<Track>& getTracks() const;
+
+  /**
+   * @brief Gets the confirmed tracks only.
+   * @return Copies of the confirmed tracks.
+   */
+  std::vector<Track> getConfirmedTracks() const;
+
+  /**
+   * @brief Removes every track. IDs keep counting up.
+   */
+  void clear();
+
+ private:
+  /**
+   * @struct CandidatePair
+   * @brief A gated (track, detection) pair and its association cost.
+   */
+  struct CandidatePair {
+    int track;     /**< Track index */
+    int detection; /**< Detection index */
+    float cost;    /**< Association cost, lower is better */
+  };
+
+  /**
+   * @brief Finds gated (track, detection) pairs through a spatial grid.
+   * @param detections Boxes detected in the new frame.
+   * @param pairs Receives the candidate pairs.
+   */
+  void gatherPairs(const std::vector<cv::Rect2f>& detections,
+                   std::vector<CandidatePair>* pairs) const;
+
+  /**
+   * @brief Picks non-conflicting matches from the candidate pairs.
+   * @param pairs Candidate pairs.
+   * @param numDetections Number of detections in the frame.
+   * @param trackToDetection Receives the matched detection of each track or
+   * -1.
+   */
+  void assign(const std::vector<CandidatePair>& pairs, int numDetections,
+              std::vector<int>* trackToDetection) const;
+
+  /**
+   * @brief Predicts every filter one frame ahead and moves the boxes.
+   */
+  void advance();
+
+  MultiTrackerConfig config;      /**< Association and lifecycle tunables */
+  std::vector<Track> tracks;      /**< Live tracks */
+  KalmanBank filters;             /**< Kalman filter of each live track */
+  int nextId;                     /**< ID given to the next new track */
+};
+
+/**
+ * @brief Solves a dense rectangular assignment problem (Hungarian method).
+ * @param cost Row-major rows x cols cost matrix.
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @return The column assigned to each row, or -1 when rows > cols leaves a
+ * row unassigned.
+ */
+std::vector<int> solveHungarian(const std::vector<float>& cost, int rows,
+                                int cols);
+
+/**
+ * @brief Computes the intersection over union of two boxes.
+ * @param a First box.
+ * @param b Second box.
+ * @return IoU in [0, 1].
+ */
+float intersectionOverUnion(const cv::Rect2f& a, const cv::Rect2f& b);
+
+}  // namespace Tracker
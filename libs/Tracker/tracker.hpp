@@ -32,6 +32,25 @@ class Tracker {
    */
   void initialize();
 
+  /**
+   * @brief Initialize the tracker at a known position with zero velocity.
+   * @param position - the first observed position of the target.
+   */
+  void initialize(const cv::Point2f& position);
+
+  /**
+   * @brief Advance the filter by one frame without a measurement.
+   * @return Predicted position of the target.
+   */
+  cv::Point2f predict();
+
+  /**
+   * @brief Update the filter with a measurement after predict().
+   * @param measurement - the observed position of the target.
+   * @return Corrected position of the target.
+   */
+  cv::Point2f correct(const cv::Point2f& measurement);
+
   /**
    * @brief Method to track humans.
    * @param measurement - the observed position of the target.
@@ -45,6 +64,12 @@ class Tracker {
    */
   cv::Point2f getPredictedPosition();
 
+  /**
+   * @brief Get the estimated velocity.
+   * @return Velocity of the target in position units per frame.
+   */
+  cv::Point2f getVelocity() const;
+
  private:
   cv::KalmanFilter kf;  // Kalman filter for tracking
   cv::Mat state;        // State matrix [x, y, dx, dy]
@@ -0,0 +1,200 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "publisher.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace Transport {
+
+/**
+ * @brief Creates the shared memory segment, replacing a stale one of the
+ * same name left by a process that did not exit cleanly.
+ * @param config Name and geometry of the ring.
+ * @throws std::runtime_error if the name or geometry is invalid or the
+ * segment cannot be created.
+ */
+Publisher::Publisher(const PublisherConfig& config)
+    : config(config),
+      layout(config.maxDetections, config.maxTracks, config.frameBytes),
+      base(nullptr),
+      size(0),
+      header(nullptr),
+      sequence(0) {
+  if (config.name.size() < 2 || config.name[0] != '/' ||
+      config.name.find('/', 1) != std::string::npos) {
+    throw std::runtime_error("Bad shared memory name " + config.name +
+                             "; expected /name");
+  }
+  // With one slot the publisher would always be rewriting the only message
+  if (config.slots < 2) {
+    throw std::runtime_error("A detection ring needs at least 2 slots");
+  }
+
+  // Readers of a previous segment keep their mapping and see it closed
+  ::shm_unlink(config.name.c_str());
+  int fd = ::shm_open(config.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot create shared memory " + config.name +
+                             ": " + std::strerror(errno));
+  }
+  size = layout.segmentBytes(config.slots);
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    const int error = errno;
+    ::close(fd);
+    ::shm_unlink(config.name.c_str());
+    throw std::runtime_error("Cannot size shared memory " + config.name +
+                             ": " + std::strerror(error));
+  }
+  void* mapping =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);  // The mapping keeps the segment alive
+  if (mapping == MAP_FAILED) {
+    const int error = errno;
+    ::shm_unlink(config.name.c_str());
+    throw std::runtime_error("Cannot map shared memory " + config.name +
+                             ": " + std::strerror(error));
+  }
+  base = static_cast<char*>(mapping);
+  // Fault every page in now rather than on the first messages
+  std::memset(base, 0, size);
+
+  header = new (base) SegmentHeader();
+  header->version = kSegmentVersion;
+  header->slotCount = config.slots;
+  header->maxDetections = config.maxDetections;
+  header->maxTracks = config.maxTracks;
+  header->frameBytes = config.frameBytes;
+  header->slotBytes = layout.slotBytes;
+  header->publisherPid = static_cast<int32_t>(::getpid());
+  header->published.store(0, std::memory_order_relaxed);
+  header->closed.store(0, std::memory_order_relaxed);
+  for (uint32_t i = 0; i < config.slots; ++i) {
+    SlotHeader* slot = new (base + sizeof(SegmentHeader) +
+                            i * layout.slotBytes) SlotHeader();
+    slot->version.store(0, std::memory_order_relaxed);
+  }
+  // Readers check the magic first; it tells them the rest is set up
+  header->magic.store(kSegmentMagic, std::memory_order_release);
+}
+
+/**
+ * @brief Marks the stream closed, unmaps it and removes its name. Readers
+ * that still map it keep reading the messages left in it.
+ */
+Publisher::~Publisher() {
+  header->closed.store(1, std::memory_order_release);
+  ::munmap(base, size);
+  ::shm_unlink(config.name.c_str());
+}
+
+/**
+ * @brief Publishes one frame's results.
+ * @param frame Frame index.
+ * @param timestampUs Capture time of the frame in microseconds.
+ * @param detections The frame's detections; those beyond maxDetections are
+ * left out and the message flagged kTruncated.
+ * @param tracks The confirmed tracks; those beyond maxTracks are left out
+ * and the message flagged kTruncated.
+ * @param image The frame to publish, or empty. A frame larger than
+ * frameBytes is left out and the message flagged kFrameSkipped.
+ * @return The message's sequence number.
+ */
+uint64_t Publisher::publish(uint64_t frame, int64_t timestampUs,
+                            const Detector::Detections& detections,
+                            const std::vector<Tracker::Track>& tracks,
+                            const cv::Mat& image) {
+  char* slotBase = base + sizeof(SegmentHeader) +
+                   (sequence % config.slots) * layout.slotBytes;
+  SlotHeader* slot = reinterpret_cast<SlotHeader*>(slotBase);
+
+  // Odd: readers that copy the slot from now on throw the copy away
+  slot->version.store(2 * sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  uint32_t flags = 0;
+  const size_t detectionCount =
+      std::min<size_t>(detections.size(), config.maxDetections);
+  const size_t trackCount = std::min<size_t>(tracks.size(), config.maxTracks);
+  if (detectionCount < detections.size() || trackCount < tracks.size()) {
+    flags |= kTruncated;
+  }
+  DetectionRecord* detectionRecords =
+      reinterpret_cast<DetectionRecord*>(slotBase + layout.detections);
+  for (size_t i = 0; i < detectionCount; ++i) {
+    const Detector::Detection& detection = detections[i];
+    DetectionRecord& record = detectionRecords[i];
+    record.x = detection.box.x;
+    record.y = detection.box.y;
+    record.width = detection.box.width;
+    record.height = detection.box.height;
+    record.score = detection.score;
+    record.classId = detection.classId;
+  }
+  TrackRecord* trackRecords =
+      reinterpret_cast<TrackRecord*>(slotBase + layout.tracks);
+  for (size_t i = 0; i < trackCount; ++i) {
+    const Tracker::Track& track = tracks[i];
+    TrackRecord& record = trackRecords[i];
+    record.x = track.box.x;
+    record.y = track.box.y;
+    record.width = track.box.width;
+    record.height = track.box.height;
+    record.vx = track.velocity.x;
+    record.vy = track.velocity.y;
+    record.id = track.id;
+    record.state = static_cast<int32_t>(track.state);
+    record.hits = track.hits;
+    record.misses = track.misses;
+    record.age = track.age;
+    record.reserved = 0;
+  }
+
+  int32_t rows = 0;
+  int32_t cols = 0;
+  if (!image.empty()) {
+    const size_t rowBytes = image.cols * image.elemSize();
+    if (rowBytes * image.rows <= config.frameBytes) {
+      rows = image.rows;
+      cols = image.cols;
+      char* pixels = slotBase + layout.frame;
+      if (image.isContinuous()) {
+        std::memcpy(pixels, image.data, rowBytes * image.rows);
+      } else {
+        for (int y = 0; y < image.rows; ++y) {
+          std::memcpy(pixels + y * rowBytes, image.ptr(y), rowBytes);
+        }
+      }
+    } else {
+      flags |= kFrameSkipped;
+    }
+  }
+
+  slot->frame = frame;
+  slot->timestampUs = timestampUs;
+  slot->publishedUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  slot->detections = static_cast<uint32_t>(detectionCount);
+  slot->tracks = static_cast<uint32_t>(trackCount);
+  slot->rows = rows;
+  slot->cols = cols;
+  slot->type = rows > 0 ? image.type() : 0;
+  slot->flags = flags;
+
+  // Even: the message is complete; then tell readers it exists
+  slot->version.store(2 * sequence + 2, std::memory_order_release);
+  header->published.store(sequence + 1, std::memory_order_release);
+  return sequence++;
+}
+
+}  // namespace Transport
@@ -0,0 +1,107 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file publisher.hpp
+ * @brief Publishes each frame's detections, tracks and optionally the
+ * annotated frame to processes on the same machine through a ring in POSIX
+ * shared memory.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+#include "detection.hpp"
+#include "multi_tracker.hpp"
+#include "shm_layout.hpp"
+
+namespace Transport {
+
+/**
+ * @struct PublisherConfig
+ * @brief Name and geometry of the shared memory ring.
+ */
+struct PublisherConfig {
+  /**< POSIX shared memory name, starting with '/'; readers open the same
+   * name. Empty disables publishing where the config is optional */
+  std::string name;
+  /**< Messages the ring holds; a reader more than this many messages
+   * behind skips ahead to the oldest one still intact */
+  uint32_t slots = 16;
+  uint32_t maxDetections = 256; /**< Detections kept per message */
+  uint32_t maxTracks = 256;     /**< Tracks kept per message */
+  /**< Largest frame a message carries, in bytes; 0 publishes no frames */
+  size_t frameBytes = 0;
+};
+
+/**
+ * @class Publisher
+ * @brief The single writer of a shared memory detection ring.
+ *
+ * publish() writes straight into the next slot and never waits for
+ * readers: it costs a copy of the message into memory the readers map, and
+ * nothing more, however many readers there are.
+ */
+class Publisher {
+ public:
+  /**
+   * @brief Creates the shared memory segment, replacing a stale one of the
+   * same name left by a process that did not exit cleanly.
+   * @param config Name and geometry of the ring.
+   * @throws std::runtime_error if the name or geometry is invalid or the
+   * segment cannot be created.
+   */
+  explicit Publisher(const PublisherConfig& config);
+
+  /**
+   * @brief Marks the stream closed, unmaps it and removes its name. Readers
+   * that still map it keep reading the messages left in it.
+   */
+  ~Publisher();
+
+  Publisher(const Publisher&) = delete;
+  Publisher& operator=(const Publisher&) = delete;
+
+  /**
+   * @brief Publishes one frame's results.
+   * @param frame Frame index.
+   * @param timestampUs Capture time of the frame in microseconds.
+   * @param detections The frame's detections; those beyond maxDetections
+   * are left out and the message flagged kTruncated.
+   * @param tracks The confirmed tracks; those beyond maxTracks are left
+   * out and the message flagged kTruncated.
+   * @param image The frame to publish, or empty. A frame larger than
+   * frameBytes is left out and the message flagged kFrameSkipped.
+   * @return The message's sequence number.
+   */
+  uint64_t publish(uint64_t frame, int64_t timestampUs,
+                   const Detector::Detections& detections,
+                   const std::vector<Tracker::Track>& tracks =
+                       std::vector<Tracker::Track>(),
+                   const cv::Mat& image = cv::Mat());
+
+  /**
+   * @brief Gets the number of messages published.
+   * @return The message count.
+   */
+  uint64_t published() const { return sequence; }
+
+  /**
+   * @brief Gets the shared memory name readers open.
+   * @return The name.
+   */
+  const std::string& name() const { return config.name; }
+
+ private:
+  PublisherConfig config;  /**< Name and geometry */
+  SlotLayout layout;       /**< Offsets within a slot */
+  char* base;              /**< Start of the mapping */
+  size_t size;             /**< Length of the mapping */
+  SegmentHeader* header;   /**< Header at the start of the mapping */
+  uint64_t sequence;       /**< Sequence number of the next message */
+};
+
+}  // namespace Transport
@@ -0,0 +1,171 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file shm_layout.hpp
+ * @brief Layout of the shared memory segment a Publisher writes and
+ * Subscribers read.
+ *
+ * Layout, native byte order (publisher and readers share one machine):
+ *
+ *     SegmentHeader                   128 bytes
+ *     Slot 0 .. Slot N-1              slotBytes each
+ *
+ * Every slot is a 64-byte SlotHeader followed by maxDetections
+ * DetectionRecords, maxTracks TrackRecords and frameBytes of frame pixels,
+ * so message n lives at a fixed offset: slot n % N. The records are plain
+ * structs written in place; nothing is serialized.
+ *
+ * Each slot is a seqlock. The publisher sets its version to 2n + 1 before
+ * writing message n and to 2n + 2 once done, then bumps
+ * SegmentHeader::published. A reader copies the slot out and keeps the
+ * copy only if the version read before and after is 2n + 2; a different
+ * value means the publisher lapped the reader and overwrote the slot
+ * mid-copy. Readers never write to the segment, so any number of them can
+ * follow the stream without slowing the publisher down or being seen by
+ * it.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Transport {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "Shared memory counters must be lock-free");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "Shared memory counters must be plain words");
+
+/**< "ACMESHM1"; written last, once the segment is set up */
+constexpr uint64_t kSegmentMagic = 0x314d4853454d4341ULL;
+constexpr uint32_t kSegmentVersion = 1; /**< Bumped on layout changes */
+
+/**
+ * @enum MessageFlags
+ * @brief Bits of SlotHeader::flags.
+ */
+enum MessageFlags : uint32_t {
+  kTruncated = 1u << 0,    /**< Detections or tracks beyond the slot's room
+                              were left out */
+  kFrameSkipped = 1u << 1  /**< A frame was given but did not fit the slot */
+};
+
+/**
+ * @struct SegmentHeader
+ * @brief Start of the segment: its geometry and the publish counter.
+ */
+struct SegmentHeader {
+  std::atomic<uint64_t> magic;  /**< kSegmentMagic once ready */
+  uint32_t version;             /**< kSegmentVersion */
+  uint32_t slotCount;           /**< Messages the ring holds */
+  uint32_t maxDetections;       /**< DetectionRecords per slot */
+  uint32_t maxTracks;           /**< TrackRecords per slot */
+  uint64_t frameBytes;          /**< Frame pixel bytes per slot */
+  uint64_t slotBytes;           /**< Size of a whole slot */
+  int32_t publisherPid;         /**< Process that writes the segment */
+  uint32_t reserved;            /**< Zero */
+  /**< Messages published so far; on its own cache line, since it is the
+   * only header field written while the stream runs */
+  alignas(64) std::atomic<uint64_t> published;
+  std::atomic<uint32_t> closed; /**< Set once the publisher is done */
+};
+
+/**
+ * @struct SlotHeader
+ * @brief Start of a slot: the seqlock and the message's scalar fields.
+ */
+struct alignas(64) SlotHeader {
+  /**< 2n + 1 while message n is written, 2n + 2 once it is complete */
+  std::atomic<uint64_t> version;
+  uint64_t frame;          /**< Frame index */
+  int64_t timestampUs;     /**< Capture time of the frame */
+  int64_t publishedUs;     /**< Wall-clock time the message was written */
+  uint32_t detections;     /**< DetectionRecords in use */
+  uint32_t tracks;         /**< TrackRecords in use */
+  int32_t rows;            /**< Frame rows; 0 without a frame */
+  int32_t cols;            /**< Frame columns */
+  int32_t type;            /**< Frame OpenCV type, e.g. CV_8UC3 */
+  uint32_t flags;          /**< MessageFlags */
+};
+
+/**
+ * @struct DetectionRecord
+ * @brief One detection as stored in a slot.
+ */
+struct DetectionRecord {
+  int32_t x;        /**< Box left in frame pixels */
+  int32_t y;        /**< Box top */
+  int32_t width;    /**< Box width */
+  int32_t height;   /**< Box height */
+  float score;      /**< Class confidence score */
+  int32_t classId;  /**< Index into the class names list */
+};
+
+/**
+ * @struct TrackRecord
+ * @brief One confirmed track as stored in a slot.
+ */
+struct TrackRecord {
+  float x;          /**< Box left in frame pixels */
+  float y;          /**< Box top */
+  float width;      /**< Box width */
+  float height;     /**< Box height */
+  float vx;         /**< Center velocity per frame, x */
+  float vy;         /**< Center velocity per frame, y */
+  int32_t id;       /**< Track id */
+  int32_t state;    /**< Tracker::TrackState */
+  int32_t hits;     /**< Frames with a matched detection */
+  int32_t misses;   /**< Consecutive frames without a match */
+  int32_t age;      /**< Frames since birth */
+  int32_t reserved; /**< Zero */
+};
+
+static_assert(sizeof(SegmentHeader) == 128, "SegmentHeader layout");
+static_assert(sizeof(SlotHeader) == 64, "SlotHeader layout");
+static_assert(sizeof(DetectionRecord) == 24, "DetectionRecord layout");
+static_assert(sizeof(TrackRecord) == 48, "TrackRecord layout");
+
+/**
+ * @struct SlotLayout
+ * @brief Byte offsets of the arrays within a slot.
+ *
+ * Every array starts on a 64-byte boundary so a slot never shares a cache
+ * line with its neighbour and frame rows copy at full width.
+ */
+struct SlotLayout {
+  size_t detections = 0;  /**< Offset of the DetectionRecords */
+  size_t tracks = 0;      /**< Offset of the TrackRecords */
+  size_t frame = 0;       /**< Offset of the frame pixels */
+  size_t slotBytes = 0;   /**< Size of a whole slot */
+
+  /**
+   * @brief Computes the layout of a slot.
+   * @param maxDetections DetectionRecords per slot.
+   * @param maxTracks TrackRecords per slot.
+   * @param frameBytes Frame pixel bytes per slot.
+   */
+  SlotLayout(uint32_t maxDetections, uint32_t maxTracks, uint64_t frameBytes)
+      : detections(sizeof(SlotHeader)),
+        tracks(alignUp(detections + maxDetections * sizeof(DetectionRecord))),
+        frame(alignUp(tracks + maxTracks * sizeof(TrackRecord))),
+        slotBytes(alignUp(frame + frameBytes)) {}
+
+  /**
+   * @brief Gets the size of a segment with this slot layout.
+   * @param slotCount Slots in the ring.
+   * @return Bytes from the segment header to the end of the last slot.
+   */
+  size_t segmentBytes(uint32_t slotCount) const {
+    return sizeof(SegmentHeader) + slotCount * slotBytes;
+  }
+
+  /**
+   * @brief Rounds an offset up to a cache line.
+   * @param offset The offset.
+   * @return The next multiple of 64.
+   */
+  static size_t alignUp(size_t offset) { return (offset + 63) & ~size_t(63); }
+};
+
+}  // namespace Transport
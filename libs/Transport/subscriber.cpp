@@ -0,0 +1,249 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "subscriber.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace Transport {
+
+namespace {
+
+/**< How long wait() yields between polls before it starts to sleep */
+constexpr std::chrono::microseconds kSpin(100);
+/**< Sleep between polls once spinning is over */
+constexpr std::chrono::microseconds kSleep(50);
+
+}  // namespace
+
+/**
+ * @brief Maps a publisher's ring.
+ * @param name The shared memory name the publisher was given.
+ * @param fromOldest Start at the oldest message still in the ring rather
+ * than at the next one published.
+ * @throws std::runtime_error if there is no publisher of that name yet or
+ * the segment is not a detection ring.
+ */
+Subscriber::Subscriber(const std::string& name, bool fromOldest)
+    : name(name),
+      base(nullptr),
+      size(0),
+      header(nullptr),
+      layout(0, 0, 0),
+      next(0),
+      receivedCount(0),
+      missedCount(0) {
+  int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open shared memory " + name + ": " +
+                             std::strerror(errno));
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(SegmentHeader)) {
+    ::close(fd);
+    throw std::runtime_error("Not a detection ring, or not set up yet: " +
+                             name);
+  }
+  size = static_cast<size_t>(info.st_size);
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  flags |= MAP_POPULATE;  // Fault the ring in now, not on the first reads
+#endif
+  void* mapping = ::mmap(nullptr, size, PROT_READ, flags, fd, 0);
+  ::close(fd);  // The mapping keeps the segment alive
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Cannot map shared memory " + name + ": " +
+                             std::strerror(errno));
+  }
+  base = static_cast<const char*>(mapping);
+  header = reinterpret_cast<const SegmentHeader*>(base);
+
+  bool valid =
+      header->magic.load(std::memory_order_acquire) == kSegmentMagic &&
+      header->version == kSegmentVersion && header->slotCount >= 2;
+  if (valid) {
+    layout = SlotLayout(header->maxDetections, header->maxTracks,
+                        header->frameBytes);
+    valid = layout.slotBytes == header->slotBytes &&
+            layout.segmentBytes(header->slotCount) <= size;
+  }
+  if (!valid) {
+    ::munmap(const_cast<char*>(base), size);
+    throw std::runtime_error("Not a detection ring, or not set up yet: " +
+                             name);
+  }
+
+  next = header->published.load(std::memory_order_acquire);
+  if (fromOldest) {
+    next -= std::min<uint64_t>(next, header->slotCount - 1);
+  }
+}
+
+/**
+ * @brief Unmaps the ring.
+ */
+Subscriber::~Subscriber() { ::munmap(const_cast<char*>(base), size); }
+
+/**
+ * @brief Reads the next message if there is one, without waiting.
+ * @param message Receives the message.
+ * @return False if no new message has been published.
+ */
+bool Subscriber::poll(Message* message) {
+  while (true) {
+    const uint64_t published =
+        header->published.load(std::memory_order_acquire);
+    if (next >= published) {
+      return false;
+    }
+    // The publisher may already be rewriting the slot of the message
+    // slotCount back, so the oldest intact one is the one after it
+    const uint64_t oldest =
+        published - std::min<uint64_t>(published, header->slotCount - 1);
+    if (next < oldest) {
+      missedCount += oldest - next;
+      next = oldest;
+    }
+    if (readSlot(next, message)) {
+      ++next;
+      ++receivedCount;
+      return true;
+    }
+    // Overwritten while we copied it: lost, try the next one
+    ++missedCount;
+    ++next;
+  }
+}
+
+/**
+ * @brief Reads the next message, waiting for it if needed. Spins for the
+ * first 100 us, then sleeps in 50 us steps.
+ * @param message Receives the message.
+ * @param timeout Longest wait.
+ * @return False on timeout or once the stream is closed and drained.
+ */
+bool Subscriber::wait(Message* message, std::chrono::microseconds timeout) {
+  const auto start = std::chrono::steady_clock::now();
+  while (!poll(message)) {
+    const auto waited = std::chrono::steady_clock::now() - start;
+    if (waited >= timeout) {
+      return false;
+    }
+    if (waited < kSpin) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (closed()) {
+      // Published before the close; nothing can follow it
+      return poll(message);
+    }
+    std::this_thread::sleep_for(kSleep);
+  }
+  return true;
+}
+
+/**
+ * @brief Skips to the newest message, for readers that only want the
+ * latest results.
+ */
+void Subscriber::seekLatest() {
+  const uint64_t published =
+      header->published.load(std::memory_order_acquire);
+  if (published > 0) {
+    next = std::max(next, published - 1);
+  }
+}
+
+/**
+ * @brief Tells whether the publisher closed the stream or its process is
+ * gone. Messages already published can still be read.
+ * @return True once no further message will arrive.
+ */
+bool Subscriber::closed() const {
+  if (header->closed.load(std::memory_order_acquire) != 0) {
+    return true;
+  }
+  // A publisher that crashed never set the flag
+  return ::kill(header->publisherPid, 0) != 0 && errno == ESRCH;
+}
+
+/**
+ * @brief Copies one message out of its slot.
+ * @param sequence The message to read.
+ * @param message Receives it.
+ * @return False if the publisher overwrote the slot during the copy.
+ */
+bool Subscriber::readSlot(uint64_t sequence, Message* message) const {
+  const char* slotBase = base + sizeof(SegmentHeader) +
+                         (sequence % header->slotCount) * layout.slotBytes;
+  const SlotHeader* slot = reinterpret_cast<const SlotHeader*>(slotBase);
+  const uint64_t complete = 2 * sequence + 2;
+  if (slot->version.load(std::memory_order_acquire) != complete) {
+    return false;
+  }
+
+  // A torn copy is thrown away below, but its counts and sizes must still
+  // stay inside the slot while copying
+  message->sequence = sequence;
+  message->frame = slot->frame;
+  message->timestampUs = slot->timestampUs;
+  message->publishedUs = slot->publishedUs;
+  message->flags = slot->flags;
+  const uint32_t detectionCount =
+      std::min(slot->detections, header->maxDetections);
+  const uint32_t trackCount = std::min(slot->tracks, header->maxTracks);
+  const int rows = slot->rows;
+  const int cols = slot->cols;
+  const int type = slot->type;
+
+  const DetectionRecord* detectionRecords =
+      reinterpret_cast<const DetectionRecord*>(slotBase + layout.detections);
+  message->detections.resize(detectionCount);
+  for (uint32_t i = 0; i < detectionCount; ++i) {
+    const DetectionRecord& record = detectionRecords[i];
+    Detector::Detection& detection = message->detections[i];
+    detection.box =
+        cv::Rect(record.x, record.y, record.width, record.height);
+    detection.score = record.score;
+    detection.classId = record.classId;
+  }
+  const TrackRecord* trackRecords =
+      reinterpret_cast<const TrackRecord*>(slotBase + layout.tracks);
+  message->tracks.resize(trackCount);
+  for (uint32_t i = 0; i < trackCount; ++i) {
+    const TrackRecord& record = trackRecords[i];
+    Tracker::Track& track = message->tracks[i];
+    track.id = record.id;
+    track.box = cv::Rect2f(record.x, record.y, record.width, record.height);
+    track.velocity = cv::Point2f(record.vx, record.vy);
+    track.state = static_cast<Tracker::TrackState>(record.state);
+    track.hits = record.hits;
+    track.misses = record.misses;
+    track.age = record.age;
+  }
+
+  if (rows > 0 && cols > 0 && (type & ~CV_MAT_TYPE_MASK) == 0 &&
+      static_cast<uint64_t>(rows) * cols * CV_ELEM_SIZE(type) <=
+          header->frameBytes) {
+    message->image.create(rows, cols, type);
+    std::memcpy(message->image.data, slotBase + layout.frame,
+                message->image.total() * message->image.elemSize());
+  } else {
+    message->image.release();
+  }
+
+  // Keep the copy only if the slot still holds the same message
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot->version.load(std::memory_order_relaxed) == complete;
+}
+
+}  // namespace Transport
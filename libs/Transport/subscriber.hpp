@@ -0,0 +1,132 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file subscriber.hpp
+ * @brief Client library for processes that follow a Publisher's detection
+ * ring in shared memory.
+ *
+ * A Subscriber only needs OpenCV core and the Detector and Tracker headers;
+ * it maps the ring read-only and keeps its position to itself, so a reader
+ * that stalls or crashes cannot affect the publisher or the other readers.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+#include "detection.hpp"
+#include "multi_tracker.hpp"
+#include "shm_layout.hpp"
+
+namespace Transport {
+
+/**
+ * @struct Message
+ * @brief One frame's results as read from the ring.
+ *
+ * Reusing one Message across reads reuses its vectors and frame buffer.
+ */
+struct Message {
+  uint64_t sequence = 0;     /**< Position in the stream, from 0 */
+  uint64_t frame = 0;        /**< Frame index */
+  int64_t timestampUs = 0;   /**< Capture time of the frame */
+  int64_t publishedUs = 0;   /**< Wall-clock time it was published */
+  uint32_t flags = 0;        /**< MessageFlags */
+  Detector::Detections detections;   /**< The frame's detections */
+  std::vector<Tracker::Track> tracks; /**< The confirmed tracks */
+  cv::Mat image;             /**< The published frame; empty if none */
+};
+
+/**
+ * @class Subscriber
+ * @brief Reads the messages of a detection ring in order.
+ *
+ * A reader that falls more than the ring's slot count behind loses the
+ * messages the publisher overwrote; it resumes at the oldest one still
+ * intact and counts the rest in missed().
+ */
+class Subscriber {
+ public:
+  /**
+   * @brief Maps a publisher's ring.
+   * @param name The shared memory name the publisher was given.
+   * @param fromOldest Start at the oldest message still in the ring rather
+   * than at the next one published.
+   * @throws std::runtime_error if there is no publisher of that name yet or
+   * the segment is not a detection ring.
+   */
+  explicit Subscriber(const std::string& name, bool fromOldest = false);
+
+  /**
+   * @brief Unmaps the ring.
+   */
+  ~Subscriber();
+
+  Subscriber(const Subscriber&) = delete;
+  Subscriber& operator=(const Subscriber&) = delete;
+
+  /**
+   * @brief Reads the next message if there is one, without waiting.
+   * @param message Receives the message.
+   * @return False if no new message has been published.
+   */
+  bool poll(Message* message);
+
+  /**
+   * @brief Reads the next message, waiting for it if needed. Spins for the
+   * first 100 us, then sleeps in 50 us steps.
+   * @param message Receives the message.
+   * @param timeout Longest wait.
+   * @return False on timeout or once the stream is closed and drained.
+   */
+  bool wait(Message* message, std::chrono::microseconds timeout);
+
+  /**
+   * @brief Skips to the newest message, for readers that only want the
+   * latest results.
+   */
+  void seekLatest();
+
+  /**
+   * @brief Tells whether the publisher closed the stream or its process is
+   * gone. Messages already published can still be read.
+   * @return True once no further message will arrive.
+   */
+  bool closed() const;
+
+  /**
+   * @brief Gets the number of messages read.
+   * @return The message count.
+   */
+  uint64_t received() const { return receivedCount; }
+
+  /**
+   * @brief Gets the number of messages overwritten before they were read.
+   * @return The message count.
+   */
+  uint64_t missed() const { return missedCount; }
+
+ private:
+  /**
+   * @brief Copies one message out of its slot.
+   * @param sequence The message to read.
+   * @param message Receives it.
+   * @return False if the publisher overwrote the slot during the copy.
+   */
+  bool readSlot(uint64_t sequence, Message* message) const;
+
+  std::string name;              /**< Shared memory name */
+  const char* base;              /**< Start of the mapping */
+  size_t size;                   /**< Length of the mapping */
+  const SegmentHeader* header;   /**< Header at the start of the mapping */
+  SlotLayout layout;             /**< Offsets within a slot */
+  uint64_t next;                 /**< Sequence of the next message to read */
+  uint64_t receivedCount;        /**< Messages read */
+  uint64_t missedCount;          /**< Messages lost to the publisher */
+};
+
+}  // namespace Transport
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+#
+# Compares two perf-bench JSON reports and fails on regressions.
+#
+# Usage:
+#   compare_bench.py BASELINE.json CURRENT.json [--threshold 0.10]
+#                    [--missing-ok]
+#   compare_bench.py BASELINE.json CURRENT.json --update
+#
+# Each benchmark is compared on its median real time when the report holds
+# repetition aggregates (--benchmark_repetitions), else on the fastest run.
+# The exit status is 1 if any benchmark slowed down by more than the
+# threshold, 2 if the baseline is missing (0 with --missing-ok, after
+# saying how to record one), 0 otherwise. --update copies CURRENT over
+# BASELINE after a deliberate change in performance.
+#
+
+import argparse
+import json
+import shutil
+import sys
+
+# Nanoseconds per Google Benchmark time unit
+UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_times(path):
+    """Returns ({name: real time in ns}, context) for one report."""
+    with open(path) as report_file:
+        report = json.load(report_file)
+    medians = {}
+    fastest = {}
+    for run in report.get("benchmarks", []):
+        if run.get("error_occurred"):
+            continue  # Skipped, e.g. no model weights on this machine
+        name = run.get("run_name", run["name"])
+        time = run["real_time"] * UNITS[run.get("time_unit", "ns")]
+        if run.get("run_type") == "aggregate":
+            if run.get("aggregate_name") == "median":
+                medians[name] = time
+        else:
+            fastest[name] = min(time, fastest.get(name, time))
+    fastest.update(medians)
+    return fastest, report.get("context", {})
+
+
+def format_time(ns):
+    """Formats a time in the largest unit that keeps it above 1."""
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return "%.2f %s" % (ns / scale, unit)
+    return "%.0f ns" % ns
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare two perf-bench JSON reports.")
+    parser.add_argument("baseline", help="stored perf-bench JSON")
+    parser.add_argument("current", help="perf-bench JSON of this build")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="slowdown fraction treated as a regression")
+    parser.add_argument("--update", action="store_true",
+                        help="replace the baseline with the current report")
+    parser.add_argument("--missing-ok", action="store_true",
+                        help="skip the comparison if there is no baseline")
+    args = parser.parse_args()
+
+    if args.update:
+        shutil.copyfile(args.current, args.baseline)
+        print("Baseline %s updated from %s" % (args.baseline, args.current))
+        return 0
+
+    try:
+        baseline, baseline_context = load_times(args.baseline)
+    except FileNotFoundError:
+        outcome = "skipping" if args.missing_ok else "cannot compare"
+        print("No baseline at %s; %s. Record one on the reference machine "
+              "with\n  %s %s %s --update\nand commit it."
+              % (args.baseline, outcome, sys.argv[0], args.baseline,
+                 args.current))
+        return 0 if args.missing_ok else 2
+    current, current_context = load_times(args.current)
+
+    for key in ("host_name", "num_cpus", "mhz_per_cpu",
+                "library_build_type"):
+        if baseline_context.get(key) != current_context.get(key):
+            print("warning: %s differs (%s vs %s); timings may not be "
+                  "comparable" % (key, baseline_context.get(key),
+                                  current_context.get(key)))
+
+    regressions = 0
+    width = max([len(name) for name in set(baseline) | set(current)] + [9])
+    print("%-*s %12s %12s %9s" % (width, "benchmark", "baseline", "current",
+                                  "change"))
+    for name in sorted(set(baseline) | set(current)):
+        if name not in baseline or name not in current:
+            where = "baseline" if name in baseline else "current"
+            print("%-*s only in %s" % (width, name, where))
+            continue
+        change = current[name] / baseline[name] - 1.0
+        verdict = ""
+        if change > args.threshold:
+            verdict = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            verdict = "  faster"
+        print("%-*s %12s %12s %+8.1f%%%s" % (
+            width, name, format_time(baseline[name]),
+            format_time(current[name]), 100 * change, verdict))
+
+    if regressions:
+        print("%d benchmark(s) slower than the baseline by more than %.0f%%"
+              % (regressions, 100 * args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,134 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file async_test.cpp
+ * @brief Unit tests for the asynchronous detector.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "async_detector.hpp"
+#include "test_helpers.hpp"
+
+using Pipeline::AsyncConfig;
+using Pipeline::AsyncDetector;
+using Pipeline::FrameDropped;
+using Testing::makeDetector;
+
+namespace {
+
+/**
+ * @brief Waits for a future and reports whether its frame was dropped.
+ * @param result The future.
+ * @return True if it holds FrameDropped.
+ */
+bool isDropped(std::future<Detector::Detections>& result) {
+  try {
+    result.get();
+  } catch (const FrameDropped&) {
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for futures matching the blocking detector.
+ */
+TEST(AsyncTest, MatchesBlockingDetect) {
+  cv::Mat frame(240, 320, CV_8UC3, cv::Scalar::all(90));
+  cv::rectangle(frame, cv::Rect(120, 40, 60, 160), cv::Scalar(30, 60, 200),
+                cv::FILLED);
+  Detector::Detections expected = makeDetector()->detect(frame);
+
+  AsyncConfig config;
+  config.workers = 2;
+  AsyncDetector async(makeDetector, config);
+  std::vector<std::future<Detector::Detections>> results;
+  for (int i = 0; i < 4; ++i) {
+    results.push_back(async.submit(frame));
+  }
+  for (auto& result : results) {
+    Detector::Detections detections = result.get();
+    ASSERT_EQ(detections.size(), expected.size());
+    for (size_t i = 0; i < detections.size(); ++i) {
+      EXPECT_EQ(detections[i].box, expected[i].box);
+    }
+  }
+  EXPECT_EQ(async.stats().completed, 4u);
+  EXPECT_EQ(async.inFlight(), 0u);
+}
+
+/**
+ * @brief Test case for deadlines and the in-flight limit dropping frames.
+ */
+TEST(AsyncTest, DropsStaleFrames) {
+  cv::Mat frame(240, 320, CV_8UC3, cv::Scalar::all(90));
+  AsyncConfig config;
+  config.workers = 1;
+  config.maxInFlight = 2;
+  AsyncDetector async(makeDetector, config);
+
+  auto late = async.submit(frame, AsyncDetector::Clock::now() -
+                                      std::chrono::milliseconds(1));
+  EXPECT_TRUE(isDropped(late));
+  EXPECT_EQ(async.stats().expired, 1u);
+
+  // A forward pass takes far longer than four submissions, so two of them
+  // cannot find a free slot
+  std::vector<std::future<Detector::Detections>> results;
+  for (int i = 0; i < 4; ++i) {
+    results.push_back(async.submit(frame));
+    EXPECT_LE(async.inFlight(), 2u);
+  }
+  int dropped = 0;
+  for (auto& result : results) {
+    dropped += isDropped(result) ? 1 : 0;
+  }
+  EXPECT_EQ(dropped, 2);
+  EXPECT_EQ(async.stats().dropped, 2u);
+
+  async.stop();
+  auto afterStop = async.submit(frame);
+  EXPECT_TRUE(isDropped(afterStop));
+}
+
+/**
+ * @brief Test case for each worker loading its detector on its own thread,
+ * and for a failed load reaching the constructor.
+ */
+TEST(AsyncTest, WorkersLoadTheirOwnDetectors) {
+  const std::thread::id self = std::this_thread::get_id();
+  std::mutex mutex;
+  std::set<std::thread::id> loaders;
+  AsyncConfig config;
+  config.workers = 2;
+  {
+    AsyncDetector async(
+        [&]() {
+          std::lock_guard<std::mutex> lock(mutex);
+          loaders.insert(std::this_thread::get_id());
+          return makeDetector();
+        },
+        config);
+  }
+  EXPECT_EQ(loaders.size(), 2u);
+  EXPECT_EQ(loaders.count(self), 0u) << "Loaded on the worker threads";
+
+  EXPECT_THROW(AsyncDetector async(
+                   []() -> std::unique_ptr<Detector::YOLODetector> {
+                     throw std::runtime_error("bad model");
+                   },
+                   config),
+               std::runtime_error);
+}
@@ -0,0 +1,111 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file backend_test.cpp
+ * @brief Unit tests for inference backend parsing, discovery and selection.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "backend.hpp"
+#include "model_cache.hpp"
+#include "test_helpers.hpp"
+
+using Detector::BackendKind;
+using Detector::BackendOption;
+using Detector::ModelFiles;
+using Detector::Precision;
+
+/**
+ * @brief Test case for option names and their round trip.
+ */
+TEST(BackendTest, ParseOptionNames) {
+  BackendOption option = Detector::parseBackendOption("OpenVINO");
+  EXPECT_EQ(option.kind, BackendKind::kOpenVino);
+  EXPECT_EQ(option.precision, Precision::kFP32) << "Precision defaults to fp32";
+
+  option = Detector::parseBackendOption("onnxruntime-int8");
+  EXPECT_EQ(option.kind, BackendKind::kOnnxRuntime);
+  EXPECT_EQ(option.precision, Precision::kINT8);
+
+  for (const char* name : {"opencv-fp32", "opencv-fp16", "opencv-int8",
+                           "openvino-fp32", "onnxruntime-fp32"}) {
+    EXPECT_EQ(Detector::parseBackendOption(name).name(), name);
+  }
+
+  EXPECT_THROW(Detector::parseBackendOption("tensorrt"), std::runtime_error);
+  EXPECT_THROW(Detector::parseBackendOption("opencv-int4"),
+               std::runtime_error);
+}
+
+/**
+ * @brief Test case for discovery and creation without usable model files.
+ */
+TEST(BackendTest, MissingModelsAreReported) {
+  ModelFiles none;
+  EXPECT_TRUE(Detector::availableBackends(none).empty());
+
+  ModelFiles int8Only;
+  int8Only.onnxInt8 = "model-int8.onnx";
+  std::vector<BackendOption> options = Detector::availableBackends(int8Only);
+  ASSERT_FALSE(options.empty());
+  EXPECT_EQ(options[0].kind, BackendKind::kOpenCv);
+  EXPECT_EQ(options[0].precision, Precision::kINT8);
+
+  EXPECT_THROW(Detector::createBackend(BackendOption(), none),
+               std::runtime_error);
+  ModelFiles invalid;
+  invalid.config = "invalid.cfg";
+  invalid.weights = "invalid.weights";
+  EXPECT_THROW(Detector::createBackend(BackendOption(), invalid),
+               std::runtime_error);
+}
+
+/**
+ * @brief Test case checking that selection fails loudly when nothing runs
+ * and records why each candidate failed.
+ */
+TEST(BackendTest, SelectionNeedsARunnableBackend) {
+  ModelFiles invalid;
+  invalid.config = "invalid.cfg";
+  invalid.weights = "invalid.weights";
+  std::vector<BackendOption> candidates = {
+      Detector::parseBackendOption("opencv"),
+      Detector::parseBackendOption("openvino-fp16")};
+  const int shape[] = {1, 3, 32, 32};
+  cv::Mat sample(4, shape, CV_32F, cv::Scalar(0));
+
+  Detector::BackendReport report;
+  try {
+    Detector::selectFastestBackend(candidates, invalid, sample, 1, &report);
+    FAIL() << "Selection should throw";
+  } catch (const std::runtime_error& e) {
+    std::string message = e.what();
+    EXPECT_NE(message.find("opencv-fp32"), std::string::npos);
+    EXPECT_NE(message.find("openvino-fp16"), std::string::npos);
+  }
+}
+
+/**
+ * @brief Test case for a Darknet backend running the network it is given
+ * rather than a copy loaded from the files.
+ */
+TEST(BackendTest, DarknetBackendsShareTheNetwork) {
+  ModelFiles files = Testing::makeModelFiles();
+  cv::dnn::Net net =
+      cv::dnn::readNetFromDarknet(files.config, files.weights);
+  std::unique_ptr<Detector::InferenceBackend> backend =
+      Detector::createBackend(BackendOption(), files, net);
+
+  const int shape[] = {1, 3, 320, 320};
+  cv::Mat sample(4, shape, CV_32F, cv::Scalar(0.5));
+  std::vector<cv::Mat> outputs = backend->infer(sample);
+  ASSERT_EQ(outputs.size(), 3u);
+  EXPECT_EQ(outputs[0].dims, 2);
+  EXPECT_FALSE(Detector::readLayerTimings(net).empty())
+      << "The forward pass ran on the given network";
+}
@@ -0,0 +1,111 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file correlation_test.cpp
+ * @brief Unit tests for the normalized cross-correlation kernel and for
+ * re-anchoring tracks on appearance between keyframes.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+#include <vector>
+
+#include "correlation.hpp"
+#include "multi_tracker.hpp"
+
+namespace {
+
+/**
+ * @brief Builds smooth random texture, like clothing or a cluttered wall.
+ * @param size Size of the image.
+ * @param seed Varies the texture.
+ * @return A CV_8UC3 image.
+ */
+cv::Mat makeTexture(const cv::Size& size, int seed) {
+  cv::Mat texture(size, CV_8UC3);
+  cv::RNG rng(seed);
+  rng.fill(texture, cv::RNG::UNIFORM, 0, 256);
+  cv::GaussianBlur(texture, texture, cv::Size(0, 0), 3);
+  cv::normalize(texture, texture, 0, 255, cv::NORM_MINMAX);
+  return texture;
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for the vectorized kernel agreeing with OpenCV's
+ * TM_CCOEFF_NORMED matching.
+ */
+TEST(CorrelationTest, MatchesOpenCvTemplateMatching) {
+  cv::Mat image;
+  cv::cvtColor(makeTexture(cv::Size(45, 61), 1), image, cv::COLOR_BGR2GRAY);
+  image.convertTo(image, CV_32F);
+  // An odd width exercises the scalar tail after the vector loop
+  cv::Mat templ = image(cv::Rect(11, 17, 19, 30)).clone();
+  cv::Scalar mean;
+  cv::Scalar deviation;
+  cv::meanStdDev(templ, mean, deviation);
+  const double norm = deviation[0] * std::sqrt(templ.total());
+  cv::Mat normalized;
+  templ.convertTo(normalized, CV_32F, 1.0 / norm, -mean[0] / norm);
+
+  cv::Mat sums;
+  cv::Mat squares;
+  cv::integral(image, sums, squares, CV_64F, CV_64F);
+  cv::Mat scores;
+  Tracker::normalizedCrossCorrelation(image, normalized, sums, squares,
+                                      &scores);
+  cv::Mat expected;
+  cv::matchTemplate(image, templ, expected, cv::TM_CCOEFF_NORMED);
+  ASSERT_EQ(scores.size(), expected.size());
+  EXPECT_LT(cv::norm(scores, expected, cv::NORM_INF), 1e-3);
+
+  double best = 0;
+  cv::Point at;
+  cv::minMaxLoc(scores, nullptr, &best, nullptr, &at);
+  EXPECT_EQ(at, cv::Point(11, 17));
+  EXPECT_NEAR(best, 1.0, 1e-3);
+}
+
+/**
+ * @brief Test case for a target that stops between keyframes: coasting
+ * drifts on with the old velocity, re-anchoring stays on the target.
+ */
+TEST(CorrelationTest, ReanchoringFollowsAStoppedTarget) {
+  const cv::Mat background = makeTexture(cv::Size(320, 240), 2);
+  const cv::Mat person = makeTexture(cv::Size(40, 100), 3);
+  cv::Rect2f truth(60.f, 70.f, 40.f, 100.f);
+  Tracker::MultiTracker coasting;
+  Tracker::MultiTracker anchored;
+  Tracker::CorrelationTracker correlator;
+
+  for (int frame = 0; frame < 20; ++frame) {
+    // Walks right for the detected frames, then stands still
+    if (frame < 12) {
+      truth.x += 3.f;
+    }
+    cv::Mat image = background.clone();
+    cv::Mat region = image(cv::Rect(truth));
+    person.copyTo(region);
+    if (frame < 12) {
+      std::vector<cv::Rect2f> detections(1, truth);
+      coasting.update(detections);
+      anchored.update(detections);
+      correlator.learn(image, anchored.getTracks());
+      continue;
+    }
+    coasting.predict();
+    anchored.predict();
+    anchored.reanchor(correlator.locate(image, anchored));
+  }
+
+  ASSERT_EQ(anchored.getTracks().size(), 1u);
+  const cv::Rect2f& held = anchored.getTracks()[0].box;
+  const cv::Rect2f& drifted = coasting.getTracks()[0].box;
+  EXPECT_LT(std::hypot(held.x - truth.x, held.y - truth.y), 2.f);
+  EXPECT_GT(std::hypot(drifted.x - truth.x, drifted.y - truth.y), 10.f);
+  EXPECT_EQ(correlator.stats().searches, 8u);
+  EXPECT_EQ(correlator.stats().anchored, 8u);
+}
@@ -0,0 +1,189 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file decode_test.cpp
+ * @brief Unit tests for the YOLO output decoding kernel.
+ *
+ * The kernel is checked against the per-row cv::minMaxLoc decoding it
+ * replaced, on synthetic outputs shaped like a YOLOv3 head.
+ */
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "decode.hpp"
+
+using Detector::Candidates;
+using Detector::DecodeConfig;
+
+namespace {
+
+/**
+ * @brief Builds a synthetic YOLO head in which some rows clear the threshold.
+ * @param rows Number of rows.
+ * @param cols Row width (5 + number of classes).
+ * @param seed Random seed.
+ * @return A rows x cols CV_32F matrix.
+ */
+cv::Mat makeHead(int rows, int cols, uint64_t seed) {
+  cv::RNG rng(seed);
+  cv::Mat head(rows, cols, CV_32F, cv::Scalar(0));
+  for (int j = 0; j < rows; ++j) {
+    float* row = head.ptr<float>(j);
+    row[0] = rng.uniform(0.f, 1.f);
+    row[1] = rng.uniform(0.f, 1.f);
+    row[2] = rng.uniform(0.f, 0.5f);
+    row[3] = rng.uniform(0.f, 0.5f);
+    // Roughly one row in ten is a confident object
+    float objectness = rng.uniform(0, 10) == 0 ? rng.uniform(0.5f, 1.f)
+                                               : rng.uniform(0.f, 0.3f);
+    row[4] = objectness;
+    for (int c = 5; c < cols; ++c) {
+      row[c] = objectness * rng.uniform(0.f, 1.f);
+    }
+  }
+  return head;
+}
+
+/**
+ * @brief Reference decoding using cv::minMaxLoc on each row.
+ * @param head The output head.
+ * @param frameSize Frame size used to scale boxes.
+ * @param threshold Confidence threshold.
+ * @param candidates Receives the decoded candidates.
+ */
+void referenceDecode(const cv::Mat& head, const cv::Size& frameSize,
+                     float threshold, Candidates& candidates) {
+  for (int j = 0; j < head.rows; ++j) {
+    const float* data = head.ptr<float>(j);
+    cv::Mat scores = head.row(j).colRange(5, head.cols);
+    cv::Point classIdPoint;
+    double confidence;
+    cv::minMaxLoc(scores, nullptr, &confidence, nullptr, &classIdPoint);
+    if (confidence > threshold) {
+      int centerX = static_cast<int>(data[0] * frameSize.width);
+      int centerY = static_cast<int>(data[1] * frameSize.height);
+      int width = static_cast<int>(data[2] * frameSize.width);
+      int height = static_cast<int>(data[3] * frameSize.height);
+      candidates.boxes.emplace_back(centerX - width / 2, centerY - height / 2,
+                                    width, height);
+      candidates.scores.push_back(static_cast<float>(confidence));
+      candidates.classIds.push_back(classIdPoint.x);
+    }
+  }
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for multi-class decoding against the minMaxLoc reference.
+ */
+TEST(DecodeTest, MultiClassMatchesReference) {
+  const cv::Size frameSize(640, 480);
+  cv::Mat head = makeHead(2028, 85, 42);
+
+  DecodeConfig config;
+  config.multiClass = true;
+  Candidates decoded;
+  Detector::decodeYoloOutputs({head}, frameSize, config, decoded);
+
+  Candidates reference;
+  referenceDecode(head, frameSize, config.confThreshold, reference);
+
+  ASSERT_GT(reference.size(), 0u) << "Synthetic head should yield candidates";
+  ASSERT_EQ(decoded.size(), reference.size());
+  for (size_t i = 0; i < reference.size(); ++i) {
+    EXPECT_EQ(decoded.boxes[i], reference.boxes[i]);
+    EXPECT_FLOAT_EQ(decoded.scores[i], reference.scores[i]);
+    EXPECT_EQ(decoded.classIds[i], reference.classIds[i]);
+  }
+}
+
+/**
+ * @brief Test case for single-class decoding.
+ *
+ * Only the configured class score is read, so a row whose person score
+ * clears the threshold is kept even if another class scores higher.
+ */
+TEST(DecodeTest, SingleClassReadsOnlyTargetScore) {
+  cv::Mat head(2, 85, CV_32F, cv::Scalar(0));
+  float* kept = head.ptr<float>(0);
+  kept[0] = kept[1] = kept[2] = kept[3] = 0.5f;
+  kept[4] = 0.9f;
+  kept[5] = 0.6f;   // person
+  kept[10] = 0.8f;  // another class
+  float* rejected = head.ptr<float>(1);
+  rejected[4] = 0.9f;
+  rejected[5] = 0.2f;
+
+  Candidates decoded;
+  Detector::decodeYoloOutputs({head}, cv::Size(416, 416), DecodeConfig(),
+                              decoded);
+  ASSERT_EQ(decoded.size(), 1u);
+  EXPECT_EQ(decoded.classIds[0], 0);
+  EXPECT_FLOAT_EQ(decoded.scores[0], 0.6f);
+  EXPECT_EQ(decoded.boxes[0], cv::Rect(104, 104, 208, 208));
+}
+
+/**
+ * @brief Test case for a class subset keeping the best of its classes.
+ *
+ * Classes outside the subset are ignored even when they score higher.
+ */
+TEST(DecodeTest, ClassSubsetKeepsBestListed) {
+  cv::Mat head(2, 85, CV_32F, cv::Scalar(0));
+  float* truck = head.ptr<float>(0);
+  truck[4] = 0.9f;
+  truck[5] = 0.55f;  // person
+  truck[12] = 0.7f;  // truck
+  truck[20] = 0.8f;  // not in the subset
+  float* other = head.ptr<float>(1);
+  other[4] = 0.9f;
+  other[20] = 0.9f;
+
+  DecodeConfig config;
+  config.classes = {0, 7};
+  Candidates decoded;
+  Detector::decodeYoloOutputs({head}, cv::Size(416, 416), config, decoded);
+  ASSERT_EQ(decoded.size(), 1u);
+  EXPECT_EQ(decoded.classIds[0], 7);
+  EXPECT_FLOAT_EQ(decoded.scores[0], 0.7f);
+
+  config.classes = {0, 85};  // Out of range for this head
+  Detector::decodeYoloOutputs({head}, cv::Size(416, 416), config, decoded);
+  EXPECT_EQ(decoded.size(), 0u);
+}
+
+/**
+ * @brief Test case for the objectness early exit.
+ *
+ * Rows whose objectness does not clear the threshold are skipped without
+ * reading their class scores.
+ */
+TEST(DecodeTest, LowObjectnessIsSkipped) {
+  cv::Mat head(1, 85, CV_32F, cv::Scalar(0));
+  head.at<float>(0, 4) = 0.3f;
+  head.at<float>(0, 5) = 0.9f;
+
+  Candidates decoded;
+  Detector::decodeYoloOutputs({head}, cv::Size(416, 416), DecodeConfig(),
+                              decoded);
+  EXPECT_EQ(decoded.size(), 0u);
+}
+
+/**
+ * @brief Test case for argmax tie-breaking and non-multiple-of-lane lengths.
+ */
+TEST(DecodeTest, ArgmaxReturnsFirstMaximum) {
+  for (int count = 1; count <= 37; ++count) {
+    std::vector<float> scores(count, 0.1f);
+    const int expected = count / 2;
+    scores[expected] = 0.7f;
+    scores[count - 1] = 0.7f;  // Later tie must not win
+    int index = -1;
+    float best = Detector::argmaxScore(scores.data(), count, &index);
+    EXPECT_FLOAT_EQ(best, 0.7f);
+    EXPECT_EQ(index, expected) << "count = " << count;
+  }
+}
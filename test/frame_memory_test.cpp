@@ -0,0 +1,229 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file frame_memory_test.cpp
+ * @brief Unit tests for the frame buffer pool, the per-frame arena, the
+ * detector's pooled buffers and the heap-free steady state of postprocess.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "detector.hpp"
+#include "frame_memory.hpp"
+#include "nms.hpp"
+#include "test_helpers.hpp"
+
+namespace {
+
+/**< operator new calls made by the calling thread; thread-local so OpenCV's
+ * pool threads do not disturb the count */
+thread_local uint64_t threadHeapAllocations = 0;
+
+}  // namespace
+
+/**
+ * @brief Counts every allocation of the test binary made through operator
+ * new, which std::vector and the other standard containers go through.
+ * @param size Bytes to allocate.
+ * @return The storage.
+ * @throws std::bad_alloc if the heap is exhausted.
+ */
+void* operator new(std::size_t size) {
+  ++threadHeapAllocations;
+  if (void* storage = std::malloc(size == 0 ? 1 : size)) {
+    return storage;
+  }
+  throw std::bad_alloc();
+}
+
+/**
+ * @brief Frees storage from the counting operator new.
+ * @param storage The storage, or null.
+ */
+void operator delete(void* storage) noexcept { std::free(storage); }
+
+/**
+ * @brief Frees storage from the counting operator new.
+ * @param storage The storage, or null.
+ * @param size Bytes allocated, unused.
+ */
+void operator delete(void* storage, std::size_t size) noexcept {
+  (void)size;
+  std::free(storage);
+}
+
+/**
+ * @brief Test case for buffers going back to the pool when the last matrix
+ * releases them and coming out again for the next matrix of that size.
+ */
+TEST(FrameMemoryTest, PoolRecyclesBuffers) {
+  Detector::FramePool pool(4);
+  const uchar* first = nullptr;
+  for (int i = 0; i < 10; ++i) {
+    cv::Mat frame = pool.acquire();
+    frame.create(480, 640, CV_8UC3);
+    if (first == nullptr) {
+      first = frame.data;
+    }
+    EXPECT_EQ(frame.data, first) << "Same buffer at frame " << i;
+    frame.setTo(cv::Scalar::all(i));
+  }
+  Detector::PoolStats stats = pool.stats();
+  EXPECT_EQ(stats.allocations, 1u);
+  EXPECT_EQ(stats.reuses, 9u);
+  EXPECT_EQ(stats.pooled, 1u);
+  EXPECT_EQ(stats.outstanding, 0u);
+
+  {
+    // Copies share a buffer; a second frame in flight needs its own
+    cv::Mat held = pool.acquire();
+    held.create(480, 640, CV_8UC3);
+    cv::Mat copy = held;
+    cv::Mat other = pool.acquire();
+    cv::Mat(480, 640, CV_8UC3, cv::Scalar::all(7)).copyTo(other);
+    EXPECT_EQ(copy.data, held.data);
+    EXPECT_NE(other.data, held.data);
+    EXPECT_EQ(pool.stats().outstanding, 2u);
+  }
+  stats = pool.stats();
+  EXPECT_EQ(stats.allocations, 2u);
+  EXPECT_EQ(stats.pooled, 2u);
+}
+
+/**
+ * @brief Test case for the arena handing out aligned slices and growing
+ * to the busiest frame so later frames never spill.
+ */
+TEST(FrameMemoryTest, ArenaGrowsToTheBusiestFrame) {
+  Detector::FrameArena arena(256);
+  void* slice = arena.allocate(3, 1);
+  void* aligned = arena.allocate(sizeof(double), alignof(double));
+  EXPECT_NE(slice, aligned);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % alignof(double), 0u);
+  arena.reset();
+  EXPECT_EQ(arena.used(), 0u);
+
+  // A frame bigger than the block spills, then the block is resized
+  const Detector::ArenaAllocator<float> allocator(&arena);
+  {
+    Detector::ArenaVector<float> big(1000, 1.f, allocator);
+    EXPECT_GT(arena.used(), arena.capacity());
+  }
+  arena.reset();
+  EXPECT_GE(arena.capacity(), 1000 * sizeof(float));
+
+  const uint64_t before = Detector::allocationCount().allocations;
+  for (int frame = 0; frame < 5; ++frame) {
+    {
+      Detector::ArenaVector<float> scratch(allocator);
+      scratch.reserve(1000);
+      scratch.assign(1000, static_cast<float>(frame));
+      EXPECT_FLOAT_EQ(scratch.back(), static_cast<float>(frame));
+    }
+    arena.reset();
+  }
+  EXPECT_EQ(Detector::allocationCount().allocations, before);
+}
+
+/**
+ * @brief Test case for suppression giving the same result with or without
+ * an arena.
+ */
+TEST(FrameMemoryTest, ArenaNmsMatchesHeapNms) {
+  cv::RNG rng(5);
+  Detector::Candidates candidates;
+  for (int i = 0; i < 300; ++i) {
+    candidates.boxes.emplace_back(rng.uniform(0, 600), rng.uniform(0, 400),
+                                  rng.uniform(20, 80), rng.uniform(40, 160));
+    candidates.scores.push_back(rng.uniform(0.3f, 1.f));
+    candidates.classIds.push_back(rng.uniform(0, 3));
+  }
+  Detector::FrameArena arena(512);
+  for (Detector::NmsMethod method :
+       {Detector::NmsMethod::kGreedy, Detector::NmsMethod::kSoft,
+        Detector::NmsMethod::kMatrix}) {
+    Detector::NmsConfig config;
+    config.method = method;
+    std::vector<int> expected;
+    std::vector<float> expectedScores;
+    Detector::nonMaxSuppression(candidates, config, expected,
+                                &expectedScores);
+    std::vector<int> indices;
+    std::vector<float> scores;
+    Detector::nonMaxSuppression(candidates, config, indices, &scores, &arena);
+    arena.reset();
+    EXPECT_EQ(indices, expected);
+    EXPECT_EQ(scores, expectedScores);
+  }
+}
+
+/**
+ * @brief Test case for repeated detection drawing nothing new from the frame
+ * pools and the arena once the first frames have sized them. The forward
+ * pass, the output list and the returned detections allocate outside them.
+ */
+TEST(FrameMemoryTest, DetectionSteadyStateReusesPooledBuffers) {
+  std::unique_ptr<Detector::YOLODetector> detector = Testing::makeDetector();
+  cv::Mat frame(480, 640, CV_8UC3, cv::Scalar::all(90));
+  cv::rectangle(frame, cv::Rect(280, 120, 80, 240), cv::Scalar(30, 60, 200),
+                cv::FILLED);
+  for (int i = 0; i < 3; ++i) {
+    detector->detect(frame);
+  }
+  const Detector::AllocationCount before = Detector::allocationCount();
+  for (int i = 0; i < 5; ++i) {
+    detector->detect(frame);
+  }
+  const Detector::AllocationCount after = Detector::allocationCount();
+  EXPECT_EQ(after.allocations, before.allocations);
+  EXPECT_EQ(after.bytes, before.bytes);
+}
+
+/**
+ * @brief Test case for postprocess making no heap allocation at all once
+ * warmed up, counted at operator new, when it writes into a reused vector.
+ */
+TEST(FrameMemoryTest, PostprocessSteadyStateIsHeapFree) {
+  std::unique_ptr<Detector::YOLODetector> detector = Testing::makeDetector();
+  cv::Mat frame(480, 640, CV_8UC3, cv::Scalar::all(90));
+  Detector::BoxTransform transform;
+  detector->preprocess(frame, &transform);
+  // Clusters of overlapping people, so decoding and NMS both have work
+  cv::RNG rng(7);
+  std::vector<cv::Mat> output(3);
+  for (cv::Mat& head : output) {
+    head = cv::Mat::zeros(300, 85, CV_32F);
+    for (int row = 0; row < 60; ++row) {
+      float* values = head.ptr<float>(row);
+      values[0] = 0.2f + 0.2f * (row % 4) + rng.uniform(0.f, 0.02f);
+      values[1] = 0.5f + rng.uniform(0.f, 0.02f);
+      values[2] = 0.1f;
+      values[3] = 0.4f;
+      values[4] = 0.9f;
+      values[5] = rng.uniform(0.6f, 1.f);
+    }
+  }
+
+  Detector::Detections detections;
+  for (int i = 0; i < 3; ++i) {
+    detector->postprocess(transform, output, &detections);
+  }
+  ASSERT_FALSE(detections.empty());
+  const Detector::Detections expected = detections;
+  const uint64_t before = threadHeapAllocations;
+  for (int i = 0; i < 20; ++i) {
+    detector->postprocess(transform, output, &detections);
+  }
+  EXPECT_EQ(threadHeapAllocations, before);
+  ASSERT_EQ(detections.size(), expected.size());
+  for (size_t i = 0; i < detections.size(); ++i) {
+    EXPECT_EQ(detections[i].box, expected[i].box);
+    EXPECT_EQ(detections[i].classId, expected[i].classId);
+  }
+}
@@ -0,0 +1,106 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file keyframe_test.cpp
+ * @brief Unit tests for the keyframe scheduler and for tracking through the
+ * frames it skips.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "keyframe.hpp"
+#include "multi_tracker.hpp"
+
+using Pipeline::KeyframeConfig;
+using Pipeline::KeyframeScheduler;
+
+/**
+ * @brief Test case for the first-frame and interval triggers.
+ */
+TEST(KeyframeTest, IntervalTrigger) {
+  KeyframeConfig config;
+  config.interval = 4;
+  KeyframeScheduler scheduler(config);
+  cv::Mat frame(48, 64, CV_8UC3, cv::Scalar(80, 80, 80));
+
+  EXPECT_EQ(scheduler.decide(frame, 0.f), Pipeline::kFirstFrame);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 1; i < config.interval; ++i) {
+      EXPECT_EQ(scheduler.decide(frame, 0.f), Pipeline::kSkipped);
+    }
+    EXPECT_EQ(scheduler.decide(frame, 0.f), Pipeline::kInterval);
+  }
+
+  const Pipeline::KeyframeStats& stats = scheduler.stats();
+  EXPECT_EQ(stats.frames, 13u);
+  EXPECT_EQ(stats.keyframes(), 4u);
+  EXPECT_EQ(stats.triggers[Pipeline::kSkipped], 9u);
+  EXPECT_DOUBLE_EQ(stats.savings(), 13.0 / 4.0);
+}
+
+/**
+ * @brief Test case for the uncertainty and motion triggers.
+ */
+TEST(KeyframeTest, UncertaintyAndMotionTriggers) {
+  KeyframeConfig config;
+  config.interval = 100;
+  config.maxUncertainty = 2.f;
+  config.motionThreshold = 6.f;
+  KeyframeScheduler scheduler(config);
+  cv::Mat frame(48, 64, CV_8UC3, cv::Scalar(80, 80, 80));
+
+  scheduler.decide(frame, 0.f);
+  EXPECT_EQ(scheduler.decide(frame, 1.f), Pipeline::kSkipped);
+  EXPECT_EQ(scheduler.decide(frame, 3.f), Pipeline::kUncertainty);
+
+  // A small change stays below the threshold; a large one does not
+  cv::Mat dimmer(48, 64, CV_8UC3, cv::Scalar(78, 78, 78));
+  EXPECT_EQ(scheduler.decide(dimmer, 0.f), Pipeline::kSkipped);
+  cv::Mat changed = frame.clone();
+  changed(cv::Rect(0, 0, 32, 48)).setTo(cv::Scalar(200, 200, 200));
+  EXPECT_EQ(scheduler.decide(changed, 0.f), Pipeline::kMotion);
+  // The changed frame is the new reference
+  EXPECT_EQ(scheduler.decide(changed, 0.f), Pipeline::kSkipped);
+}
+
+/**
+ * @brief Test case checking that predicted boxes stay close to the truth
+ * when only every Kth frame is detected.
+ */
+TEST(KeyframeTest, BoundedErrorBetweenKeyframes) {
+  const int interval = 5;
+  const int count = 20;
+  Tracker::MultiTracker tracker;
+
+  std::vector<cv::Rect2f> boxes;
+  std::vector<cv::Point2f> velocities;
+  for (int i = 0; i < count; ++i) {
+    boxes.emplace_back(100.f * (i % 5), 150.f * (i / 5), 40.f, 100.f);
+    velocities.emplace_back(static_cast<float>(i % 3) - 1.f, 0.5f);
+  }
+
+  float worst = 0.f;
+  for (int step = 0; step < 100; ++step) {
+    for (int i = 0; i < count; ++i) {
+      boxes[i].x += velocities[i].x;
+      boxes[i].y += velocities[i].y;
+    }
+    // Detect every frame while tracks warm up, then every Kth frame
+    if (step < 10 || step % interval == 0) {
+      tracker.update(boxes);
+      continue;
+    }
+    tracker.predict();
+    std::vector<Tracker::Track> tracks = tracker.getConfirmedTracks();
+    ASSERT_EQ(tracks.size(), static_cast<size_t>(count));
+    for (const Tracker::Track& track : tracks) {
+      const cv::Rect2f& truth = boxes[track.id];
+      worst = std::max(worst, std::hypot(track.box.x - truth.x,
+                                         track.box.y - truth.y));
+    }
+  }
+  EXPECT_LT(worst, 2.f) << "Coasting tracks should stay within 2 px";
+}
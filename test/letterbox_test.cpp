@@ -0,0 +1,191 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file letterbox_test.cpp
+ * @brief Unit tests for letterbox preprocessing and its inverse transform.
+ *
+ * The blob is checked against cv::dnn::blobFromImage on the scaled frame,
+ * and the transform by decoding boxes placed at known frame positions.
+ */
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "decode.hpp"
+#include "letterbox.hpp"
+
+using Detector::LetterboxPreprocessor;
+
+namespace {
+
+/**
+ * @brief Wraps one channel plane of a blob.
+ * @param blob An N x 3 x H x W blob.
+ * @param n Image index.
+ * @param c Channel index.
+ * @return An H x W header over the plane.
+ */
+cv::Mat plane(const cv::Mat& blob, int n, int c) {
+  return cv::Mat(blob.size[2], blob.size[3], CV_32F,
+                 const_cast<float*>(blob.ptr<float>(n, c)));
+}
+
+/**
+ * @brief Builds a frame of random pixels.
+ * @param size Frame size.
+ * @param seed Random seed.
+ * @return A CV_8UC3 frame.
+ */
+cv::Mat randomFrame(const cv::Size& size, uint64_t seed) {
+  cv::Mat frame(size, CV_8UC3);
+  cv::RNG(seed).fill(frame, cv::RNG::UNIFORM, 0, 256);
+  return frame;
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for where the scaled frame lands in the input.
+ */
+TEST(LetterboxTest, RectCentersScaledFrame) {
+  const cv::Size input(416, 416);
+  EXPECT_EQ(Detector::letterboxRect(cv::Size(640, 480), input),
+            cv::Rect(0, 52, 416, 312));
+  EXPECT_EQ(Detector::letterboxRect(cv::Size(480, 640), input),
+            cv::Rect(52, 0, 312, 416));
+  EXPECT_EQ(Detector::letterboxRect(cv::Size(416, 416), input),
+            cv::Rect(0, 0, 416, 416));
+}
+
+/**
+ * @brief Test case for a frame that needs no resize or padding.
+ *
+ * The blob must match blobFromImage with RB swap and 1/255 scaling.
+ */
+TEST(LetterboxTest, MatchesBlobFromImageWithoutPadding) {
+  cv::Mat frame = randomFrame(cv::Size(416, 416), 7);
+  LetterboxPreprocessor letterbox;
+  cv::Mat blob = letterbox.process(frame, cv::Size(416, 416));
+  cv::Mat reference = cv::dnn::blobFromImage(
+      frame, 1 / 255.0, cv::Size(416, 416), cv::Scalar(), true, false);
+
+  ASSERT_EQ(blob.dims, 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(blob.size[i], reference.size[i]);
+  }
+  EXPECT_LT(cv::norm(blob, reference, cv::NORM_INF), 1e-6);
+}
+
+/**
+ * @brief Test case for a padded frame.
+ *
+ * The content region matches blobFromImage on the resized frame and the
+ * border holds the pad value.
+ */
+TEST(LetterboxTest, PadsAroundResizedContent) {
+  cv::Mat frame = randomFrame(cv::Size(640, 480), 11);
+  LetterboxPreprocessor letterbox(0.5f);
+  cv::Mat blob = letterbox.process(frame, cv::Size(416, 416));
+
+  cv::Rect content(0, 52, 416, 312);
+  cv::Mat resized;
+  cv::resize(frame, resized, content.size(), 0, 0, cv::INTER_LINEAR);
+  cv::Mat reference = cv::dnn::blobFromImage(resized, 1 / 255.0, cv::Size(),
+                                             cv::Scalar(), true, false);
+  for (int c = 0; c < 3; ++c) {
+    EXPECT_LT(cv::norm(plane(blob, 0, c)(content), plane(reference, 0, c),
+                       cv::NORM_INF),
+              1e-6);
+    cv::Mat top = plane(blob, 0, c).rowRange(0, content.y);
+    cv::Mat bottom = plane(blob, 0, c).rowRange(content.br().y, 416);
+    EXPECT_EQ(cv::countNonZero(top != 0.5f), 0);
+    EXPECT_EQ(cv::countNonZero(bottom != 0.5f), 0);
+  }
+}
+
+/**
+ * @brief Test case for the inverse transform.
+ *
+ * A box placed in the frame and mapped into the letterboxed input must
+ * decode back to the same frame pixels.
+ */
+TEST(LetterboxTest, TransformRestoresFrameBoxes) {
+  const cv::Size input(416, 416);
+  for (const cv::Size& frameSize : {cv::Size(640, 480), cv::Size(480, 640),
+                                    cv::Size(1920, 1080)}) {
+    cv::Rect content = Detector::letterboxRect(frameSize, input);
+    double ratio = static_cast<double>(content.width) / frameSize.width;
+    cv::Rect2d box(frameSize.width * 0.2, frameSize.height * 0.3,
+                   frameSize.width * 0.25, frameSize.height * 0.4);
+
+    cv::Mat head(1, 85, CV_32F, cv::Scalar(0));
+    float* row = head.ptr<float>(0);
+    row[0] = static_cast<float>(
+        ((box.x + box.width / 2) * ratio + content.x) / input.width);
+    row[1] = static_cast<float>(
+        ((box.y + box.height / 2) * ratio + content.y) / input.height);
+    row[2] = static_cast<float>(box.width * ratio / input.width);
+    row[3] = static_cast<float>(box.height * ratio / input.height);
+    row[4] = row[5] = 0.9f;
+
+    Detector::Candidates decoded;
+    Detector::decodeYoloOutputs(
+        {head}, Detector::letterboxTransform(frameSize, input),
+        Detector::DecodeConfig(), decoded);
+    ASSERT_EQ(decoded.size(), 1u);
+    const cv::Rect& result = decoded.boxes[0];
+    EXPECT_NEAR(result.x, box.x, 2) << frameSize;
+    EXPECT_NEAR(result.y, box.y, 2) << frameSize;
+    EXPECT_NEAR(result.width, box.width, 2) << frameSize;
+    EXPECT_NEAR(result.height, box.height, 2) << frameSize;
+  }
+}
+
+/**
+ * @brief Test case for blob reuse.
+ *
+ * A released blob's buffer is handed out again; a blob still held is not
+ * overwritten.
+ */
+TEST(LetterboxTest, ReusesOnlyReleasedBlobs) {
+  cv::Mat frame = randomFrame(cv::Size(640, 480), 3);
+  LetterboxPreprocessor letterbox;
+  cv::Mat first = letterbox.process(frame, cv::Size(320, 320));
+  const uchar* data = first.data;
+  first.release();
+
+  cv::Mat second = letterbox.process(frame, cv::Size(320, 320));
+  EXPECT_EQ(second.data, data) << "Released blob should be reused";
+  cv::Mat third = letterbox.process(frame, cv::Size(320, 320));
+  EXPECT_NE(third.data, second.data) << "Held blob must not be reused";
+}
+
+/**
+ * @brief Test case for batched letterboxing of frames of different sizes.
+ */
+TEST(LetterboxTest, BatchMatchesSingleFrames) {
+  std::vector<cv::Mat> frames = {randomFrame(cv::Size(640, 480), 1),
+                                 randomFrame(cv::Size(300, 500), 2)};
+  LetterboxPreprocessor letterbox;
+  std::vector<Detector::BoxTransform> transforms;
+  cv::Mat batch = letterbox.processBatch(frames, cv::Size(416, 416),
+                                         &transforms);
+  ASSERT_EQ(batch.size[0], 2);
+  ASSERT_EQ(transforms.size(), 2u);
+
+  for (int n = 0; n < 2; ++n) {
+    Detector::BoxTransform transform;
+    cv::Mat single = letterbox.process(frames[n], cv::Size(416, 416),
+                                       &transform);
+    for (int c = 0; c < 3; ++c) {
+      EXPECT_EQ(cv::norm(plane(batch, n, c), plane(single, 0, c),
+                         cv::NORM_INF),
+                0);
+    }
+    EXPECT_FLOAT_EQ(transforms[n].scaleX, transform.scaleX);
+    EXPECT_FLOAT_EQ(transforms[n].offsetY, transform.offsetY);
+  }
+}
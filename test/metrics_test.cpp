@@ -0,0 +1,246 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file metrics_test.cpp
+ * @brief Unit tests for latency histograms, the registry and the exporter.
+ */
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "detector.hpp"
+#include "exporter.hpp"
+#include "metrics.hpp"
+#include "test_helpers.hpp"
+
+using Metrics::LatencyHistogram;
+using Metrics::Registry;
+
+namespace {
+
+/**
+ * @brief Fetches a path from the exporter's endpoint.
+ * @param port The endpoint's port.
+ * @param path The request path.
+ * @return The whole response, headers included.
+ */
+std::string httpGet(int port, const std::string& path) {
+  int client = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  std::string response;
+  if (::connect(client, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address)) == 0) {
+    std::string request = "GET " + path + " HTTP/1.0\r\n\r\n";
+    ::send(client, request.data(), request.size(), 0);
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::recv(client, buffer, sizeof(buffer), 0)) > 0) {
+      response.append(buffer, static_cast<size_t>(n));
+    }
+  }
+  ::close(client);
+  return response;
+}
+
+/**
+ * @class FailingBackend
+ * @brief Backend whose forward passes always throw.
+ */
+class FailingBackend : public Detector::InferenceBackend {
+ public:
+  /**
+   * @brief Fails a forward pass.
+   * @param blob Ignored.
+   * @return Nothing; always throws.
+   */
+  std::vector<cv::Mat> infer(const cv::Mat& /*blob*/) override {
+    throw std::runtime_error("Forward pass failed");
+  }
+
+  /**
+   * @brief Gets the engine and precision this backend runs.
+   * @return The default option.
+   */
+  Detector::BackendOption option() const override {
+    return Detector::BackendOption();
+  }
+};
+
+}  // namespace
+
+/**
+ * @brief Test case for percentiles staying within the bucket precision.
+ */
+TEST(MetricsTest, HistogramPercentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.valueAtPercentile(50), 0u);
+  for (uint64_t micros = 1; micros <= 100000; ++micros) {
+    histogram.record(micros);
+  }
+  EXPECT_EQ(histogram.count(), 100000u);
+  EXPECT_NEAR(histogram.valueAtPercentile(50), 50000.0, 50000 * 0.008);
+  EXPECT_NEAR(histogram.valueAtPercentile(99), 99000.0, 99000 * 0.008);
+  EXPECT_EQ(histogram.valueAtPercentile(100), 100000u);
+
+  Metrics::LatencySummary summary = histogram.summary();
+  EXPECT_DOUBLE_EQ(summary.maxMs, 100.0);
+  EXPECT_NEAR(summary.meanMs, 50.0, 0.001);
+
+  histogram.reset();
+  EXPECT_EQ(histogram.count(), 0u);
+}
+
+/**
+ * @brief Test case for small and huge values landing in valid buckets.
+ */
+TEST(MetricsTest, HistogramRange) {
+  LatencyHistogram histogram;
+  histogram.record(0);
+  histogram.record(255);
+  histogram.record(256);
+  histogram.record(~uint64_t{0});  // Clamped into the top bucket
+  EXPECT_EQ(histogram.count(), 4u);
+  EXPECT_EQ(histogram.valueAtPercentile(25), 0u);
+  EXPECT_EQ(histogram.valueAtPercentile(50), 255u);
+  EXPECT_EQ(histogram.valueAtPercentile(75), 257u);
+}
+
+/**
+ * @brief Test case for scoped timers and null histograms.
+ */
+TEST(MetricsTest, ScopedTimer) {
+  LatencyHistogram histogram;
+  {
+    Metrics::ScopedTimer timer(&histogram);
+    timer.stop();
+    timer.stop();  // Records once
+  }
+  { Metrics::ScopedTimer timer(nullptr); }
+  EXPECT_EQ(histogram.count(), 1u);
+}
+
+/**
+ * @brief Test case for the registry snapshot and its text formats.
+ */
+TEST(MetricsTest, RegistryExposition) {
+  Registry registry(0);  // Measure FPS on every read
+  LatencyHistogram& capture = registry.stage("capture");
+  EXPECT_EQ(&capture, &registry.stage("capture"));
+  capture.record(2000);
+  registry.stage("inference").record(40000);
+  registry.setLayerTimings({{"conv_0", 1.5}, {"yolo_\"82\"", 0.25}});
+
+  Metrics::Snapshot snapshot = registry.snapshot();
+  ASSERT_EQ(snapshot.stages.size(), 2u);
+  EXPECT_EQ(snapshot.stages[0].name, "capture");
+  EXPECT_GT(snapshot.stages[0].fps, 0.0);
+
+  std::string text = Metrics::toPrometheusText(snapshot);
+  EXPECT_NE(text.find("# TYPE acme_stage_latency_seconds summary"),
+            std::string::npos);
+  EXPECT_NE(
+      text.find(
+          "acme_stage_latency_seconds{stage=\"inference\",quantile=\"0.5\"} "
+          "0.04\n"),
+      std::string::npos);
+  EXPECT_NE(text.find("acme_stage_latency_seconds_count{stage=\"capture\"} 1"),
+            std::string::npos);
+  EXPECT_NE(text.find("layer=\"yolo_\\\"82\\\"\""), std::string::npos)
+      << "Quotes in label values are escaped";
+
+  std::string table = Metrics::toTable(snapshot, 1);
+  EXPECT_NE(table.find("conv_0"), std::string::npos);
+  EXPECT_EQ(table.find("yolo_"), std::string::npos) << "Only the slowest";
+}
+
+/**
+ * @brief Test case for the HTTP endpoint and the file dump.
+ */
+TEST(MetricsTest, ExporterServesAndWrites) {
+  Registry registry;
+  registry.stage("render").record(1000);
+  Metrics::ExporterConfig config;
+  config.port = 0;  // Any free port
+  config.filePath = cv::tempfile(".prom");
+  Metrics::Exporter exporter(registry, config);
+  ASSERT_GT(exporter.port(), 0);
+
+  std::string response = httpGet(exporter.port(), "/metrics");
+  EXPECT_EQ(response.compare(0, 15, "HTTP/1.0 200 OK"), 0);
+  EXPECT_NE(response.find("stage=\"render\""), std::string::npos);
+  EXPECT_EQ(httpGet(exporter.port(), "/other").compare(0, 12, "HTTP/1.0 404"),
+            0);
+
+  exporter.stop();
+  std::ifstream file(config.filePath);
+  std::string contents((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  EXPECT_NE(contents.find("acme_stage_fps{stage=\"render\"}"),
+            std::string::npos);
+  std::remove(config.filePath.c_str());
+}
+
+/**
+ * @brief Test case for refusing a file export without a positive interval.
+ */
+TEST(MetricsTest, ExporterRejectsNonPositiveInterval) {
+  Registry registry;
+  Metrics::ExporterConfig config;
+  config.filePath = cv::tempfile(".prom");
+  config.intervalSeconds = 0;
+  EXPECT_THROW(Metrics::Exporter(registry, config), std::runtime_error);
+  config.intervalSeconds = -1;
+  EXPECT_THROW(Metrics::Exporter(registry, config), std::runtime_error);
+  std::remove(config.filePath.c_str());
+}
+
+/**
+ * @brief Test case for the detector timing its stages and layers.
+ */
+TEST(MetricsTest, DetectorRecordsStages) {
+  std::unique_ptr<Detector::YOLODetector> detector = Testing::makeDetector();
+  Registry registry;
+  detector->setMetrics(&registry);
+  detector->detect(cv::Mat(240, 320, CV_8UC3, cv::Scalar::all(90)));
+
+  Metrics::Snapshot snapshot = registry.snapshot();
+  ASSERT_EQ(snapshot.stages.size(), 3u);
+  for (const Metrics::StageSnapshot& stage : snapshot.stages) {
+    EXPECT_EQ(stage.latency.count, 1u) << stage.name;
+  }
+  EXPECT_FALSE(snapshot.layers.empty()) << "First pass is sampled";
+
+  detector->setMetrics(nullptr);
+  detector->detect(cv::Mat(240, 320, CV_8UC3, cv::Scalar::all(90)));
+  EXPECT_EQ(registry.stage("inference").count(), 1u);
+}
+
+/**
+ * @brief Test case for a failed warmup leaving the metrics switched on.
+ */
+TEST(MetricsTest, FailedWarmupKeepsRecording) {
+  std::unique_ptr<Detector::YOLODetector> detector = Testing::makeDetector();
+  Registry registry;
+  detector->setMetrics(&registry);
+  detector->setBackend(std::unique_ptr<Detector::InferenceBackend>(
+      new FailingBackend()));
+  EXPECT_THROW(detector->warmup(), std::runtime_error);
+
+  detector->setBackend(nullptr);
+  detector->detect(cv::Mat(240, 320, CV_8UC3, cv::Scalar::all(90)));
+  EXPECT_EQ(registry.stage("inference").count(), 1u);
+}
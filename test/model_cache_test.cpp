@@ -0,0 +1,74 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file model_cache_test.cpp
+ * @brief Unit tests for hashing and the model cache.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "detector.hpp"
+#include "model_cache.hpp"
+#include "test_helpers.hpp"
+
+/**
+ * @brief Test case for the hash matching XXH64.
+ */
+TEST(ModelCacheTest, HashesMatchXxh64) {
+  EXPECT_EQ(Detector::hashBytes("", 0), 0xef46db3751d8e999ULL);
+  EXPECT_EQ(Detector::hashBytes("abc", 3), 0x44bc2cf5ad770999ULL);
+  EXPECT_EQ(Detector::hexKey(0x44bc2cf5ad770999ULL), "44bc2cf5ad770999");
+}
+
+/**
+ * @brief Test case for fingerprints following a file's size and
+ * modification time without reading it.
+ */
+TEST(ModelCacheTest, FingerprintsFollowChanges) {
+  const std::string path = cv::tempfile(".weights");
+  std::ofstream(path) << "first";
+  const uint64_t first = Detector::fingerprintFile(path);
+  EXPECT_EQ(Detector::fingerprintFile(path), first);
+  EXPECT_NE(Detector::fingerprintFile(path, 1), first);
+  EXPECT_NE(Detector::fingerprintFile("config/yolov3.cfg"), first);
+
+  std::ofstream(path) << "replaced";
+  EXPECT_NE(Detector::fingerprintFile(path), first);
+  std::remove(path.c_str());
+  EXPECT_THROW(Detector::fingerprintFile(path), std::runtime_error);
+}
+
+/**
+ * @brief Test case for a second start reusing the recorded backend choice.
+ */
+TEST(ModelCacheTest, SecondStartSkipsBenchmark) {
+  const std::string directory = cv::tempfile() + "/models";
+  std::vector<Detector::BackendOption> candidates = {
+      Detector::BackendOption()};
+
+  Detector::BackendReport first;
+  Detector::BackendReport second;
+  for (Detector::BackendReport* report : {&first, &second}) {
+    std::unique_ptr<Detector::YOLODetector> detector = Testing::makeDetector();
+    detector->setModelCache(directory);
+    *report = detector->selectBackend(candidates, "", "", 1);
+    EXPECT_GT(detector->warmup(), 0.0);
+  }
+  EXPECT_FALSE(first.cached);
+  EXPECT_TRUE(second.cached);
+  EXPECT_EQ(second.chosen, first.chosen);
+  ASSERT_EQ(second.timings.size(), 1u);
+  EXPECT_DOUBLE_EQ(second.timings[0].latencyMs, first.timings[0].latencyMs);
+
+  std::string option;
+  double latencyMs = 0;
+  EXPECT_FALSE(Detector::ModelCache(directory).readChoice("0000", &option,
+                                                          &latencyMs));
+}
@@ -0,0 +1,114 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file motion_gate_test.cpp
+ * @brief Unit tests for the motion gate and gated detection.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "motion_gate.hpp"
+#include "test_helpers.hpp"
+
+/**
+ * @brief Test case for static and noisy frames closing the gate and a
+ * moving object opening it around the object only.
+ */
+TEST(MotionGateTest, FindsChangedRegions) {
+  cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar::all(90));
+  Pipeline::MotionGate gate;
+  std::vector<cv::Rect> regions = gate.update(frame);
+  ASSERT_EQ(regions.size(), 1u);
+  EXPECT_EQ(regions[0], cv::Rect(0, 0, 1280, 720)) << "No background yet";
+  EXPECT_TRUE(gate.update(frame).empty());
+
+  cv::Mat noise(frame.size(), CV_16SC3);
+  cv::randn(noise, cv::Scalar::all(0), cv::Scalar::all(4));
+  cv::Mat noisy;
+  cv::add(frame, noise, noisy, cv::noArray(), CV_8U);
+  EXPECT_TRUE(gate.update(noisy).empty()) << "Sensor noise is not motion";
+
+  const cv::Rect person(600, 200, 60, 160);
+  cv::Mat moved = frame.clone();
+  cv::rectangle(moved, person, cv::Scalar::all(230), cv::FILLED);
+  regions = gate.update(moved);
+  ASSERT_EQ(regions.size(), 1u);
+  EXPECT_EQ(regions[0] & person, person);
+  EXPECT_LT(regions[0].area(), 6 * person.area()) << "Only around it";
+}
+
+/**
+ * @brief Test case for static frames skipping the network while their
+ * detections and tracks carry forward.
+ */
+TEST(MotionGateTest, StaticFramesSkipInference) {
+  std::unique_ptr<Detector::YOLODetector> detector = Testing::makeDetector();
+  Pipeline::GatedDetector gated(*detector);
+
+  Pipeline::FramePacket packet;
+  packet.frame = cv::Mat(480, 1280, CV_8UC3, cv::Scalar::all(90));
+  cv::rectangle(packet.frame, cv::Rect(120, 40, 60, 160),
+                cv::Scalar(30, 60, 200), cv::FILLED);
+  EXPECT_TRUE(gated.process(packet)) << "The first frame is detected";
+  const Detector::Detections first = packet.detections;
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_FALSE(gated.process(packet));
+    ASSERT_EQ(packet.detections.size(), first.size());
+    EXPECT_TRUE(gated.lastRegions().empty());
+  }
+
+  cv::rectangle(packet.frame, cv::Rect(1000, 300, 40, 40),
+                cv::Scalar(200, 200, 200), cv::FILLED);
+  EXPECT_TRUE(gated.process(packet));
+  ASSERT_EQ(gated.lastRegions().size(), 1u);
+  EXPECT_EQ(gated.lastRegions()[0].size(), cv::Size(320, 320))
+      << "Grown to the input size";
+
+  const Pipeline::MotionStats& stats = gated.stats();
+  EXPECT_EQ(stats.frames, 7u);
+  EXPECT_EQ(stats.skipped, 5u);
+  EXPECT_EQ(stats.fullFrames, 1u);
+  EXPECT_EQ(stats.regionFrames, 1u);
+}
+
+/**
+ * @brief Test case for changed regions detected together in one batch,
+ * each getting the detections of a crop run on its own.
+ */
+TEST(MotionGateTest, RegionsShareABatch) {
+  std::unique_ptr<Detector::YOLODetector> detector = Testing::makeDetector();
+  Pipeline::GatedDetector gated(*detector);
+
+  Pipeline::FramePacket packet;
+  packet.frame = cv::Mat(480, 1280, CV_8UC3, cv::Scalar::all(90));
+  gated.process(packet);
+  EXPECT_FALSE(gated.process(packet));
+
+  for (int x : {120, 1000}) {
+    cv::rectangle(packet.frame, cv::Rect(x, 160, 60, 160),
+                  cv::Scalar(30, 60, 200), cv::FILLED);
+  }
+  EXPECT_TRUE(gated.process(packet));
+  const std::vector<cv::Rect> regions = gated.lastRegions();
+  ASSERT_EQ(regions.size(), 2u) << "Both fit one batch of maxBatch";
+  EXPECT_EQ(gated.stats().regionFrames, 1u);
+
+  for (const cv::Rect& region : regions) {
+    for (Detector::Detection expected :
+         detector->detect(packet.frame(region))) {
+      expected.box.x += region.x;
+      expected.box.y += region.y;
+      bool found = false;
+      for (const Detector::Detection& detection : packet.detections) {
+        found = found || (detection.box == expected.box &&
+                          detection.classId == expected.classId &&
+                          std::abs(detection.score - expected.score) < 1e-4f);
+      }
+      EXPECT_TRUE(found) << "Missing " << expected.box << " in " << region;
+    }
+  }
+}
@@ -0,0 +1,171 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file nms_test.cpp
+ * @brief Unit tests for class-aware NMS and the detector's class filter.
+ */
+
+#include <gtest/gtest.h>
+
+#include <opencv2/dnn.hpp>
+#include <stdexcept>
+#include <vector>
+
+#include "detector.hpp"
+#include "nms.hpp"
+#include "test_helpers.hpp"
+
+using Detector::Candidates;
+using Detector::NmsConfig;
+using Detector::NmsMethod;
+
+namespace {
+
+/**
+ * @brief Adds one candidate.
+ * @param candidates The candidates to append to.
+ * @param box The box.
+ * @param score The score.
+ * @param classId The class.
+ */
+void add(Candidates* candidates, const cv::Rect& box, float score,
+         int classId = 0) {
+  candidates->boxes.push_back(box);
+  candidates->scores.push_back(score);
+  candidates->classIds.push_back(classId);
+}
+
+/**
+ * @brief Builds a crowd of jittered boxes, several per person.
+ * @param count Number of boxes.
+ * @return The candidates, all of class 0.
+ */
+Candidates makeCrowd(int count) {
+  cv::RNG rng(count);
+  Candidates candidates;
+  for (int i = 0; i < count; ++i) {
+    int person = i / 6;
+    add(&candidates,
+        cv::Rect((person * 37) % 600 + rng.uniform(-6, 6),
+                 (person * 23) % 300 + rng.uniform(-6, 6),
+                 60 + rng.uniform(-6, 6), 140 + rng.uniform(-6, 6)),
+        rng.uniform(0.3f, 1.f));
+  }
+  return candidates;
+}
+
+/**
+ * @brief Three boxes: a strong one, a near duplicate and a neighbor.
+ * @return Candidates whose IoUs with the first are 0.82 and 0.25.
+ */
+Candidates makeTriple() {
+  Candidates candidates;
+  add(&candidates, cv::Rect(0, 0, 100, 100), 0.9f);
+  add(&candidates, cv::Rect(10, 0, 100, 100), 0.8f);
+  add(&candidates, cv::Rect(60, 0, 100, 100), 0.8f);
+  return candidates;
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for greedy NMS matching cv::dnn::NMSBoxes exactly.
+ */
+TEST(NmsTest, GreedyMatchesNMSBoxes) {
+  for (int count : {0, 1, 50, 600}) {
+    Candidates candidates = makeCrowd(count);
+    std::vector<int> expected;
+    cv::dnn::NMSBoxes(candidates.boxes, candidates.scores, 0.5f, 0.4f,
+                      expected);
+    for (NmsMethod method : {NmsMethod::kOpenCv, NmsMethod::kGreedy}) {
+      NmsConfig config;
+      config.method = method;
+      std::vector<int> indices;
+      Detector::nonMaxSuppression(candidates, config, indices);
+      EXPECT_EQ(indices, expected) << count << " boxes";
+    }
+  }
+}
+
+/**
+ * @brief Test case for boxes of different classes not suppressing each
+ * other unless classAware is off.
+ */
+TEST(NmsTest, ClassAware) {
+  Candidates candidates;
+  add(&candidates, cv::Rect(0, 0, 50, 100), 0.9f, 0);
+  add(&candidates, cv::Rect(2, 0, 50, 100), 0.8f, 7);
+  add(&candidates, cv::Rect(4, 0, 50, 100), 0.7f, 0);
+  for (NmsMethod method : {NmsMethod::kOpenCv, NmsMethod::kGreedy,
+                           NmsMethod::kSoft, NmsMethod::kMatrix}) {
+    NmsConfig config;
+    config.method = method;
+    std::vector<int> indices;
+    Detector::nonMaxSuppression(candidates, config, indices);
+    EXPECT_EQ(indices, std::vector<int>({0, 1}))
+        << static_cast<int>(method);
+
+    config.classAware = false;
+    Detector::nonMaxSuppression(candidates, config, indices);
+    EXPECT_EQ(indices, std::vector<int>({0})) << static_cast<int>(method);
+  }
+}
+
+/**
+ * @brief Test case for Soft-NMS and Matrix NMS decaying rather than
+ * dropping a partly overlapping neighbor.
+ */
+TEST(NmsTest, DecayingMethods) {
+  Candidates candidates = makeTriple();
+  for (NmsMethod method : {NmsMethod::kSoft, NmsMethod::kMatrix}) {
+    NmsConfig config;
+    config.method = method;
+    std::vector<int> indices;
+    std::vector<float> scores;
+    Detector::nonMaxSuppression(candidates, config, indices, &scores);
+    ASSERT_EQ(indices, std::vector<int>({0, 2})) << static_cast<int>(method);
+    EXPECT_FLOAT_EQ(scores[0], 0.9f);
+    // exp(-0.25^2 / 0.5) of the neighbor's score
+    EXPECT_NEAR(scores[1], 0.8f * 0.8825f, 1e-3f);
+  }
+
+  NmsConfig config;
+  config.topK = 1;
+  std::vector<int> indices;
+  Detector::nonMaxSuppression(candidates, config, indices);
+  EXPECT_EQ(indices, std::vector<int>({0}));
+}
+
+/**
+ * @brief Test case for method names and overlap of degenerate boxes.
+ */
+TEST(NmsTest, Helpers) {
+  EXPECT_EQ(Detector::parseNmsMethod("matrix"), NmsMethod::kMatrix);
+  EXPECT_THROW(Detector::parseNmsMethod("fast"), std::runtime_error);
+  EXPECT_FLOAT_EQ(Detector::intersectionOverUnion(cv::Rect(0, 0, 10, 10),
+                                                  cv::Rect(5, 0, 10, 10)),
+                  50.f / 150.f);
+  EXPECT_EQ(Detector::intersectionOverUnion(cv::Rect(), cv::Rect()), 0.f);
+}
+
+/**
+ * @brief Test case for the detector's class filter.
+ */
+TEST(NmsTest, DetectorClassFilter) {
+  Detector::YOLODetector detector(Testing::kConfigPath, Testing::kWeightsPath,
+                                  Testing::kLabelsPath);
+  EXPECT_EQ(detector.getClassFilter(), std::vector<int>({0}));
+  detector.setClasses({"truck", "person", "truck"});
+  EXPECT_EQ(detector.getClassFilter(), std::vector<int>({0, 7}));
+  detector.setClasses({});
+  EXPECT_TRUE(detector.getClassFilter().empty());
+  EXPECT_THROW(detector.setClasses({"forklift"}), std::runtime_error);
+  EXPECT_THROW(detector.setClassFilter({80}), std::runtime_error);
+
+  detector.setClassFilter({2});
+  detector.setInputSize(cv::Size(320, 320));
+  for (const Detector::Detection& detection :
+       detector.detect(cv::Mat(240, 320, CV_8UC3, cv::Scalar::all(90)))) {
+    EXPECT_EQ(detection.classId, 2);
+  }
+}
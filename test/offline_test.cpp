@@ -0,0 +1,163 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file offline_test.cpp
+ * @brief Unit tests for offline chunked processing.
+ */
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <opencv2/core/utils/filesystem.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "offline.hpp"
+#include "test_helpers.hpp"
+
+using Pipeline::Chunk;
+using Pipeline::FrameResult;
+using Pipeline::OfflineProcessor;
+using Testing::makeDetector;
+
+namespace {
+
+/**< Chunk end meaning "to the end of the file" */
+const uint64_t kToEnd = std::numeric_limits<uint64_t>::max();
+
+/**
+ * @brief Creates an empty scratch directory.
+ * @return The directory path.
+ */
+std::string makeScratchDirectory() {
+  std::string path = cv::tempfile();
+  cv::utils::fs::createDirectories(path);
+  return path;
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for chunks snapping to the next keyframe.
+ */
+TEST(OfflineTest, ChunksStartOnKeyframes) {
+  std::vector<Chunk> plan = Pipeline::planChunks(100, {0, 30, 60, 90}, 40);
+  ASSERT_EQ(plan.size(), 2u);
+  EXPECT_EQ(plan[0].begin, 0u);
+  EXPECT_EQ(plan[0].end, 60u);
+  EXPECT_EQ(plan[1].begin, 60u);
+  EXPECT_EQ(plan[1].end, kToEnd);
+
+  plan = Pipeline::planChunks(100, {0, 30, 60, 90}, 25);
+  ASSERT_EQ(plan.size(), 4u);
+  for (size_t i = 0; i < plan.size(); ++i) {
+    EXPECT_EQ(plan[i].sequence, i);
+    EXPECT_EQ(plan[i].begin, 30 * i);
+  }
+}
+
+/**
+ * @brief Test case for fixed-length chunks without a keyframe index.
+ */
+TEST(OfflineTest, ChunksWithoutKeyframes) {
+  std::vector<Chunk> plan = Pipeline::planChunks(10, {}, 4);
+  ASSERT_EQ(plan.size(), 3u);
+  EXPECT_EQ(plan[1].begin, 4u);
+  EXPECT_EQ(plan[1].end, 8u);
+  EXPECT_EQ(plan[2].end, kToEnd);
+
+  plan = Pipeline::planChunks(0, {}, 4);
+  ASSERT_EQ(plan.size(), 1u) << "Unknown length reads to the end";
+  EXPECT_EQ(plan[0].end, kToEnd);
+}
+
+/**
+ * @brief Test case for source classification and image listing.
+ */
+TEST(OfflineTest, ClassifiesSourcesAndListsImages) {
+  std::string directory = makeScratchDirectory();
+  cv::Mat image(8, 8, CV_8UC3, cv::Scalar::all(0));
+  cv::imwrite(cv::utils::fs::join(directory, "b.png"), image);
+  cv::imwrite(cv::utils::fs::join(directory, "a.jpg"), image);
+  std::ofstream(cv::utils::fs::join(directory, "notes.txt")) << "not an image";
+
+  EXPECT_EQ(Pipeline::classifySource(directory),
+            Pipeline::SourceKind::kImageDirectory);
+  EXPECT_EQ(Pipeline::classifySource("rtsp://127.0.0.1:8554/robot"),
+            Pipeline::SourceKind::kStream);
+  EXPECT_EQ(Pipeline::classifySource("0"), Pipeline::SourceKind::kStream);
+  EXPECT_EQ(Pipeline::classifySource("footage.mp4"),
+            Pipeline::SourceKind::kVideoFile);
+
+  std::vector<std::string> images = Pipeline::listImages(directory);
+  ASSERT_EQ(images.size(), 2u);
+  EXPECT_EQ(images[0], cv::utils::fs::join(directory, "a.jpg"));
+  EXPECT_EQ(images[1], cv::utils::fs::join(directory, "b.png"));
+  cv::utils::fs::remove_all(directory);
+}
+
+/**
+ * @brief Test case for ordered output from parallel workers on an image
+ * directory.
+ */
+TEST(OfflineTest, ImageDirectoryResultsInOrder) {
+  std::string directory = makeScratchDirectory();
+  for (int i = 0; i < 4; ++i) {
+    cv::Mat image(240, 320, CV_8UC3, cv::Scalar::all(40 * i));
+    cv::imwrite(
+        cv::utils::fs::join(directory, "frame" + std::to_string(i) + ".png"),
+        image);
+  }
+
+  Pipeline::OfflineConfig config;
+  config.workers = 2;
+  config.chunkFrames = 1;
+  OfflineProcessor processor(makeDetector, config);
+  std::vector<FrameResult> results;
+  uint64_t frames = processor.run(
+      directory, [&](const FrameResult& result) { results.push_back(result); });
+
+  EXPECT_EQ(frames, 4u);
+  ASSERT_EQ(results.size(), 4u);
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i].index, i);
+    EXPECT_EQ(results[i].name,
+              cv::utils::fs::join(directory,
+                                  "frame" + std::to_string(i) + ".png"));
+  }
+  EXPECT_EQ(processor.stats().workers, 2u);
+  cv::utils::fs::remove_all(directory);
+}
+
+/**
+ * @brief Test case for a video split into chunks across workers.
+ */
+TEST(OfflineTest, VideoChunksResultsInOrder) {
+  std::string directory = makeScratchDirectory();
+  std::string path = cv::utils::fs::join(directory, "clip.avi");
+  cv::VideoWriter writer(path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                         10, cv::Size(320, 240));
+  ASSERT_TRUE(writer.isOpened());
+  for (int i = 0; i < 6; ++i) {
+    writer.write(cv::Mat(240, 320, CV_8UC3, cv::Scalar::all(30 * i)));
+  }
+  writer.release();
+
+  Pipeline::OfflineConfig config;
+  config.workers = 3;
+  config.chunkFrames = 2;
+  OfflineProcessor processor(makeDetector, config);
+  std::vector<uint64_t> indices;
+  processor.run(path, [&](const FrameResult& result) {
+    indices.push_back(result.index);
+  });
+
+  ASSERT_EQ(indices.size(), 6u);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    EXPECT_EQ(indices[i], i);
+  }
+  EXPECT_EQ(processor.stats().chunks, 3u);
+  cv::utils::fs::remove_all(directory);
+}
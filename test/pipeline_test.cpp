@@ -0,0 +1,280 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file pipeline_test.cpp
+ * @brief Unit tests for the lock-free RingBuffer joining the pipeline stages
+ * and for the pipeline running a short capture end to end.
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <opencv2/core/utils/filesystem.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pipeline.hpp"
+#include "ring_buffer.hpp"
+#include "subscriber.hpp"
+#include "test_helpers.hpp"
+
+using Pipeline::DetectionPipeline;
+using Pipeline::OverflowPolicy;
+using Pipeline::PipelineConfig;
+using Pipeline::PipelineStats;
+using Pipeline::RingBuffer;
+
+namespace {
+
+/**
+ * @brief Writes a short image sequence with a person-like shape that moves
+ * a little every frame.
+ * @param frames Number of images.
+ * @return A pattern cv::VideoCapture opens the sequence with.
+ */
+std::string writeSequence(int frames) {
+  const std::string directory = cv::tempfile();
+  cv::utils::fs::createDirectories(directory);
+  for (int i = 0; i < frames; ++i) {
+    cv::Mat image(240, 320, CV_8UC3, cv::Scalar::all(90));
+    cv::rectangle(image, cv::Rect(100 + 2 * i, 40, 40, 120),
+                  cv::Scalar(30, 60, 200), cv::FILLED);
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%03d.png", i);
+    cv::imwrite(cv::utils::fs::join(directory, name), image);
+  }
+  return cv::utils::fs::join(directory, "frame_%03d.png");
+}
+
+/**
+ * @struct PipelineRun
+ * @brief What a pipeline run rendered, as seen from outside.
+ */
+struct PipelineRun {
+  uint64_t rendered = 0;        /**< run()'s return value */
+  PipelineStats stats;          /**< Counters after run() returned */
+  std::vector<uint64_t> frames; /**< Rendered frame indices, in order */
+};
+
+/**
+ * @brief Runs a pipeline on an image sequence without a window and follows
+ * the frames it renders through its detection ring.
+ * @param config Pipeline tunables; display and publishing are set here.
+ * @param pattern The image sequence.
+ * @param name Distinguishes the rings of one test process.
+ * @return The run's outcome.
+ */
+PipelineRun runPipeline(PipelineConfig config, const std::string& pattern,
+                        const std::string& name) {
+  config.display = false;
+  config.publish.name =
+      "/acme_pipeline_" + std::to_string(::getpid()) + "_" + name;
+  config.publish.slots = 64;  // Room for every frame; nothing is lapped
+
+  PipelineRun run;
+  std::thread reader([&run, &config]() {
+    // The ring appears once run() starts
+    std::unique_ptr<Transport::Subscriber> subscriber;
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (!subscriber && std::chrono::steady_clock::now() < deadline) {
+      try {
+        subscriber.reset(new Transport::Subscriber(config.publish.name, true));
+      } catch (const std::runtime_error&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    ASSERT_TRUE(subscriber) << "The pipeline never published";
+    Transport::Message message;
+    while (subscriber->wait(&message, std::chrono::seconds(30))) {
+      run.frames.push_back(message.frame);
+    }
+  });
+
+  std::unique_ptr<Detector::YOLODetector> detector = Testing::makeDetector();
+  cv::VideoCapture cap(pattern, cv::CAP_IMAGES);
+  DetectionPipeline pipeline(*detector, config);
+  run.rendered = pipeline.run(cap);
+  run.stats = pipeline.stats();
+  reader.join();
+  return run;
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for capacity rounding and FIFO order.
+ */
+TEST(RingBufferTest, FifoOrder) {
+  RingBuffer<int> queue(3);
+  EXPECT_EQ(queue.capacity(), 4u) << "Capacity should round up to 4";
+
+  for (int i = 0; i < 4; ++i) {
+    int item = i;
+    EXPECT_TRUE(queue.tryPush(item));
+  }
+  int extra = 4;
+  EXPECT_FALSE(queue.tryPush(extra)) << "Full queue should reject a push";
+  EXPECT_EQ(queue.size(), 4u);
+
+  for (int i = 0; i < 4; ++i) {
+    int item = -1;
+    ASSERT_TRUE(queue.tryPop(item));
+    EXPECT_EQ(item, i);
+  }
+  int item = -1;
+  EXPECT_FALSE(queue.tryPop(item)) << "Empty queue should reject a pop";
+}
+
+/**
+ * @brief Test case for the drop-oldest overflow policy.
+ *
+ * Pushing into a full queue should evict the oldest items and keep the
+ * newest ones.
+ */
+TEST(RingBufferTest, DropOldestEvictsStaleItems) {
+  RingBuffer<int> queue(2);
+  size_t dropped = 0;
+  for (int i = 0; i < 5; ++i) {
+    dropped += queue.push(i, OverflowPolicy::kDropOldest);
+  }
+  EXPECT_EQ(dropped, 3u);
+
+  int item = -1;
+  ASSERT_TRUE(queue.tryPop(item));
+  EXPECT_EQ(item, 3);
+  ASSERT_TRUE(queue.tryPop(item));
+  EXPECT_EQ(item, 4);
+}
+
+/**
+ * @brief Test case for the blocking policy with a concurrent consumer.
+ *
+ * Every item should arrive exactly once and in order.
+ */
+TEST(RingBufferTest, BlockPolicyDeliversEverything) {
+  RingBuffer<int> queue(4);
+  const int count = 10000;
+
+  std::thread producer([&queue, count]() {
+    for (int i = 0; i < count; ++i) {
+      queue.push(i, OverflowPolicy::kBlock);
+    }
+    queue.close();
+  });
+
+  int expected = 0;
+  int item = -1;
+  while (queue.pop(item)) {
+    EXPECT_EQ(item, expected);
+    ++expected;
+  }
+  producer.join();
+  EXPECT_EQ(expected, count);
+}
+
+/**
+ * @brief Test case for closing an empty queue.
+ *
+ * A consumer waiting on an empty queue should return once it is closed.
+ */
+TEST(RingBufferTest, CloseReleasesConsumer) {
+  RingBuffer<int> queue(2);
+  std::thread closer([&queue]() { queue.close(); });
+  int item = -1;
+  EXPECT_FALSE(queue.pop(item));
+  closer.join();
+  EXPECT_TRUE(queue.isClosed());
+}
+
+/**
+ * @brief Test case for closing a full queue.
+ *
+ * A producer asleep on a full queue should return once it is closed, and a
+ * queue cannot be made without slots.
+ */
+TEST(RingBufferTest, CloseReleasesProducer) {
+  RingBuffer<int> queue(2);
+  queue.push(0, OverflowPolicy::kBlock);
+  queue.push(1, OverflowPolicy::kBlock);
+  std::thread producer(
+      [&queue]() { queue.push(2, OverflowPolicy::kBlock); });
+  queue.close();
+  producer.join();
+  EXPECT_EQ(queue.size(), 2u);
+  EXPECT_THROW(RingBuffer<int>(0), std::runtime_error);
+}
+
+/**
+ * @brief Test case for every frame of a capture passing through all stage
+ * threads and coming out in capture order.
+ */
+TEST(DetectionPipelineTest, RendersEveryFrameInOrder) {
+  PipelineConfig config;
+  config.overflowPolicy = OverflowPolicy::kBlock;
+  PipelineRun run = runPipeline(config, writeSequence(12), "ordered");
+
+  EXPECT_EQ(run.rendered, 12u);
+  ASSERT_EQ(run.frames.size(), 12u);
+  for (size_t i = 0; i < run.frames.size(); ++i) {
+    EXPECT_EQ(run.frames[i], i);
+  }
+  for (uint64_t processed : run.stats.processed) {
+    EXPECT_EQ(processed, 12u);
+  }
+  for (size_t i = 0; i < run.stats.dropped.size(); ++i) {
+    EXPECT_EQ(run.stats.dropped[i], 0u);
+    EXPECT_EQ(run.stats.queueDepth[i], 0u) << "Every queue drained";
+  }
+}
+
+/**
+ * @brief Test case for the drop-oldest policy shedding frames the network
+ * cannot keep up with while the rest stay in order.
+ */
+TEST(DetectionPipelineTest, DropOldestSkipsStaleFrames) {
+  PipelineConfig config;
+  config.queueCapacity = 1;
+  config.overflowPolicy = OverflowPolicy::kDropOldest;
+  PipelineRun run = runPipeline(config, writeSequence(30), "dropping");
+
+  EXPECT_EQ(run.stats.processed[Pipeline::kCapture], 30u);
+  uint64_t dropped = 0;
+  for (uint64_t count : run.stats.dropped) {
+    dropped += count;
+  }
+  EXPECT_GT(dropped, 0u) << "Capture outpaces inference";
+  EXPECT_EQ(run.rendered + dropped, 30u) << "Every frame is accounted for";
+  ASSERT_EQ(run.frames.size(), run.rendered);
+  ASSERT_FALSE(run.frames.empty());
+  for (size_t i = 1; i < run.frames.size(); ++i) {
+    EXPECT_GT(run.frames[i], run.frames[i - 1]);
+  }
+  EXPECT_EQ(run.frames.back(), 29u) << "The newest frame is never dropped";
+}
+
+/**
+ * @brief Test case for maxFrames stopping every stage thread before the
+ * capture ends.
+ */
+TEST(DetectionPipelineTest, MaxFramesShutsDownEarly) {
+  PipelineConfig config;
+  config.overflowPolicy = OverflowPolicy::kBlock;
+  config.maxFrames = 3;
+  PipelineRun run = runPipeline(config, writeSequence(40), "shutdown");
+
+  EXPECT_EQ(run.rendered, 3u);
+  EXPECT_EQ(run.frames, std::vector<uint64_t>({0, 1, 2}));
+  EXPECT_EQ(run.stats.processed[Pipeline::kRender], 3u);
+  EXPECT_LT(run.stats.processed[Pipeline::kCapture], 40u)
+      << "Capture stops once the pipeline does";
+}
@@ -0,0 +1,147 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file projection_test.cpp
+ * @brief Unit tests for the camera model and the projection of detections
+ * into robot coordinates.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "multi_tracker.hpp"
+#include "projection.hpp"
+
+namespace {
+
+/** Intrinsics of a 640x480 camera with a 600 pixel focal length */
+const cv::Matx33d kIntrinsics(600, 0, 320, 0, 600, 240, 0, 0, 1);
+
+/**
+ * @brief Projects a robot-frame point into the image of an undistorted
+ * camera.
+ * @param camera The camera.
+ * @param point The point in meters.
+ * @return The pixel.
+ */
+cv::Point2f toPixel(const Projection::CameraModel& camera,
+                    const cv::Vec3d& point) {
+  const cv::Vec3d local = camera.rotation.t() * (point - camera.translation);
+  const cv::Vec3d pixel = camera.cameraMatrix * (local * (1.0 / local[2]));
+  return cv::Point2f(static_cast<float>(pixel[0]),
+                     static_cast<float>(pixel[1]));
+}
+
+/**
+ * @brief Builds the box of a person standing at a ground point.
+ * @param camera The camera.
+ * @param x Distance ahead of the robot in meters.
+ * @param y Distance to the left of the robot in meters.
+ * @return The box, clipped to the image.
+ */
+cv::Rect personBox(const Projection::CameraModel& camera, double x,
+                   double y) {
+  const cv::Point2f feet = toPixel(camera, cv::Vec3d(x, y, 0));
+  const cv::Point2f head = toPixel(camera, cv::Vec3d(x, y, 1.7));
+  const cv::Rect box(cvRound(feet.x) - 20, cvRound(head.y), 40,
+                     cvRound(feet.y - head.y));
+  return box & cv::Rect(cv::Point(), camera.imageSize);
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for reading the calibration shipped in config/ and
+ * rejecting a missing one.
+ */
+TEST(ProjectionTest, ReadsCameraModel) {
+  const Projection::CameraModel camera =
+      Projection::readCameraModel("config/camera.yml");
+  const Projection::CameraModel expected =
+      Projection::makeCameraModel(kIntrinsics, cv::Size(640, 480), 1.0, 10.0);
+  EXPECT_EQ(camera.imageSize, cv::Size(640, 480));
+  EXPECT_DOUBLE_EQ(camera.cameraMatrix(0, 0), 600.0);
+  EXPECT_DOUBLE_EQ(camera.translation[2], 1.0);
+  EXPECT_LT(cv::norm(camera.rotation - expected.rotation), 1e-9);
+
+  EXPECT_THROW(Projection::readCameraModel("config/missing.yml"),
+               std::runtime_error);
+}
+
+/**
+ * @brief Test case for the two depth sources: the ground plane when the
+ * feet are visible and the height prior when they are cut off.
+ */
+TEST(ProjectionTest, GroundPlaneAndHeightPrior) {
+  const Projection::CameraModel level =
+      Projection::makeCameraModel(kIntrinsics, cv::Size(640, 480), 1.0, 10.0);
+  const Projection::GroundProjector projector(level);
+  // Feet on the optical axis meet the ground at height / tan(pitch)
+  Projection::Position position =
+      projector.project(cv::Rect(300, 140, 40, 100), level.imageSize);
+  ASSERT_TRUE(position.valid);
+  EXPECT_EQ(position.source, Projection::DepthSource::kGroundPlane);
+  EXPECT_NEAR(position.point.x, 1.0 / std::tan(10.0 * CV_PI / 180.0), 1e-2);
+  EXPECT_NEAR(position.point.y, 0.0, 1e-2);
+
+  // Doubling the frame size rescales the box into the calibrated image
+  position = projector.project(cv::Rect(600, 280, 80, 200),
+                               cv::Size(1280, 960));
+  ASSERT_TRUE(position.valid);
+  EXPECT_NEAR(position.point.x, 1.0 / std::tan(10.0 * CV_PI / 180.0), 1e-2);
+
+  // A high camera looking down loses the feet of people close by
+  const Projection::CameraModel high =
+      Projection::makeCameraModel(kIntrinsics, cv::Size(640, 480), 2.5, 30.0);
+  const Projection::GroundProjector close(high);
+  const cv::Rect box = personBox(high, 1.8, 0.3);
+  ASSERT_EQ(box.br().y, 480) << "Feet below the frame";
+  position = close.project(box, high.imageSize);
+  ASSERT_TRUE(position.valid);
+  EXPECT_EQ(position.source, Projection::DepthSource::kHeightPrior);
+  EXPECT_NEAR(position.point.x, 1.8, 0.05);
+  EXPECT_NEAR(position.point.y, 0.3, 0.05);
+}
+
+/**
+ * @brief Test case for tracking a walking person in meters on every frame.
+ */
+TEST(ProjectionTest, TracksInMeters) {
+  const Projection::CameraModel camera =
+      Projection::makeCameraModel(kIntrinsics, cv::Size(640, 480), 1.0, 10.0);
+  const Projection::GroundProjector projector(camera);
+  Tracker::MultiTracker tracker(Projection::metricTrackerConfig());
+
+  int id = -1;
+  for (int frame = 0; frame < 30; ++frame) {
+    // Walking away from the robot at 0.1 m per frame, a step to the left
+    const double x = 3.0 + 0.1 * frame;
+    const std::vector<cv::Rect> boxes = {personBox(camera, x, 0.5),
+                                         personBox(camera, 4.0, -1.5)};
+    const std::vector<Projection::Position> positions =
+        projector.project(boxes, camera.imageSize);
+    ASSERT_TRUE(positions[0].valid);
+    EXPECT_NEAR(positions[0].point.x, x, 0.05 * x) << "Within 5% of range";
+    tracker.update(Projection::footprints(positions));
+
+    for (const Tracker::Track& track : tracker.getConfirmedTracks()) {
+      if (track.box.y > 0) {
+        if (id < 0) {
+          id = track.id;
+        }
+        EXPECT_EQ(track.id, id) << "Keeps its ID at frame " << frame;
+      }
+    }
+  }
+  ASSERT_GE(id, 0);
+  const std::vector<Tracker::Track> tracks = tracker.getConfirmedTracks();
+  ASSERT_EQ(tracks.size(), 2u);
+  for (const Tracker::Track& track : tracks) {
+    if (track.id == id) {
+      EXPECT_NEAR(track.velocity.x, 0.1f, 0.03f) << "Meters per frame";
+    }
+  }
+}
@@ -0,0 +1,162 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file replay_test.cpp
+ * @brief Unit tests for the recording format and the replay of the
+ * non-inference pipeline.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "letterbox.hpp"
+#include "postprocessor.hpp"
+#include "recording.hpp"
+#include "replay.hpp"
+
+namespace {
+
+/**< Network input size of the test recordings */
+const cv::Size kInputSize(320, 320);
+
+/**
+ * @brief Builds a network output head with a few confident people among
+ * mostly empty rows, like a real frame.
+ * @param seed Varies the content between frames.
+ * @return A 300 x 85 CV_32F head.
+ */
+cv::Mat makeHead(int seed) {
+  cv::RNG rng(seed);
+  cv::Mat head(300, 85, CV_32F);
+  rng.fill(head, cv::RNG::UNIFORM, 0.f, 0.005f);
+  for (int r = 0; r < head.rows; r += 23) {
+    float* row = head.ptr<float>(r);
+    row[0] = rng.uniform(0.2f, 0.8f);
+    row[1] = rng.uniform(0.2f, 0.8f);
+    row[2] = rng.uniform(0.05f, 0.2f);
+    row[3] = rng.uniform(0.1f, 0.4f);
+    row[4] = rng.uniform(0.f, 1.f);
+    row[5] = rng.uniform(0.3f, 1.f);
+  }
+  return head;
+}
+
+/**
+ * @brief Writes a recording of a few synthetic frames, with the detections
+ * a live run would have made on them.
+ * @param path The file to write.
+ * @param frames Receives the frames as written.
+ */
+void writeRecording(const std::string& path,
+                    std::vector<Storage::RecordedFrame>* frames) {
+  Storage::RecordingSettings settings;
+  settings.inputSize = kInputSize;
+  Storage::RecordingWriter writer(path, settings);
+  Detector::LetterboxPreprocessor letterbox;
+  Detector::Postprocessor postprocessor;
+  for (int i = 0; i < 4; ++i) {
+    Storage::RecordedFrame frame;
+    frame.index = static_cast<uint64_t>(i);
+    frame.timestampUs = 1000 * i;
+    frame.frame.create(240, 320, CV_8UC3);
+    cv::randu(frame.frame, cv::Scalar::all(0), cv::Scalar::all(255));
+    frame.outputs.push_back(makeHead(i));
+    Detector::BoxTransform transform;
+    letterbox.process(frame.frame, kInputSize, &transform);
+    frame.detections = postprocessor.run(transform, frame.outputs,
+                                         settings.decode, settings.nms);
+    writer.append(frame.index, frame.timestampUs, frame.frame, frame.outputs,
+                  frame.detections);
+    frames->push_back(frame);
+  }
+  writer.close();
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for a recording giving back the frames losslessly, the
+ * kept rows bit for bit and zeros for the dropped ones.
+ */
+TEST(ReplayTest, RecordingRoundTrips) {
+  const std::string path = cv::tempfile(".acmerec");
+  std::vector<Storage::RecordedFrame> written;
+  writeRecording(path, &written);
+  ASSERT_FALSE(written[0].detections.empty());
+
+  Storage::RecordingReader reader(path);
+  EXPECT_EQ(reader.getSettings().inputSize, kInputSize);
+  Storage::RecordedFrame frame;
+  for (const Storage::RecordedFrame& expected : written) {
+    ASSERT_TRUE(reader.next(frame));
+    EXPECT_EQ(frame.index, expected.index);
+    EXPECT_EQ(frame.timestampUs, expected.timestampUs);
+    EXPECT_EQ(cv::norm(frame.frame, expected.frame, cv::NORM_INF), 0);
+    ASSERT_EQ(frame.outputs.size(), 1u);
+    const cv::Mat& head = expected.outputs[0];
+    for (int r = 0; r < head.rows; ++r) {
+      const bool kept =
+          head.at<float>(r, 4) >= reader.getSettings().minObjectness;
+      cv::Mat row =
+          kept ? head.row(r) : cv::Mat(cv::Mat::zeros(1, head.cols, CV_32F));
+      EXPECT_EQ(cv::norm(frame.outputs[0].row(r), row, cv::NORM_INF), 0)
+          << "Row " << r;
+    }
+    EXPECT_EQ(frame.detections.size(), expected.detections.size());
+  }
+  EXPECT_FALSE(reader.next(frame));
+  std::remove(path.c_str());
+}
+
+/**
+ * @brief Test case for a replay reproducing the recorded detections and
+ * an earlier replay's log exactly, on every pass.
+ */
+TEST(ReplayTest, ReplayIsBitExact) {
+  const std::string path = cv::tempfile(".acmerec");
+  const std::string first = cv::tempfile(".acmelog");
+  const std::string second = cv::tempfile(".acmelog");
+  std::vector<Storage::RecordedFrame> written;
+  writeRecording(path, &written);
+
+  Storage::RecordingReader reader(path);
+  Pipeline::ReplayConfig config;
+  config.repeat = 3;
+  config.logPath = first;
+  Pipeline::ReplayReport report = Pipeline::replayRecording(reader, config);
+  EXPECT_EQ(report.frames, 3 * written.size());
+  EXPECT_EQ(report.detectionMismatches, 0u);
+  EXPECT_EQ(report.firstMismatch, -1);
+  EXPECT_GT(report.fps(), 0);
+  EXPECT_EQ(report.latencies.stages.size(), 4u);
+
+  config.repeat = 1;
+  config.logPath = second;
+  config.referencePath = first;
+  report = Pipeline::replayRecording(reader, config);
+  EXPECT_EQ(report.detectionMismatches, 0u);
+  EXPECT_EQ(report.referenceMismatches, 0u);
+  EXPECT_EQ(report.firstReferenceMismatch, -1);
+
+  std::remove(path.c_str());
+  std::remove(first.c_str());
+  std::remove(second.c_str());
+}
+
+/**
+ * @brief Test case for rejecting missing recordings and thresholds the
+ * recording could not replay exactly.
+ */
+TEST(ReplayTest, RejectsBadInput) {
+  EXPECT_THROW(Storage::RecordingReader("missing.acmerec"),
+               std::runtime_error);
+  Storage::RecordingSettings settings;
+  settings.minObjectness = settings.decode.confThreshold + 0.1f;
+  const std::string path = cv::tempfile(".acmerec");
+  EXPECT_THROW(Storage::RecordingWriter(path, settings), std::runtime_error);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,90 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file resolution_test.cpp
+ * @brief Unit tests for reading the input size from Darknet configs and for
+ * the latency-budget resolution controller.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "detector.hpp"
+#include "resolution.hpp"
+
+using Detector::ResolutionConfig;
+using Detector::ResolutionController;
+
+/**
+ * @brief Test case for parsing the [net] section of Darknet configs.
+ */
+TEST(ResolutionTest, ReadsInputSizeFromConfig) {
+  EXPECT_EQ(Detector::readDarknetInputSize("config/yolov3.cfg"),
+            cv::Size(416, 416));
+  EXPECT_EQ(Detector::readDarknetInputSize("config/yolov3-tiny.cfg"),
+            cv::Size(416, 416));
+
+  const char* path = "resolution_test.cfg";
+  {
+    std::ofstream cfg(path);
+    cfg << "[net]\n# width=999\nwidth = 608\n height=320\n\n"
+        << "[convolutional]\nwidth=32\n";
+  }
+  EXPECT_EQ(Detector::readDarknetInputSize(path), cv::Size(608, 320));
+  {
+    std::ofstream cfg(path);
+    cfg << "[net]\nwidth=wide\nheight=320\n";
+  }
+  EXPECT_THROW(Detector::readDarknetInputSize(path), std::runtime_error);
+  std::remove(path);
+
+  EXPECT_THROW(Detector::readDarknetInputSize("missing.cfg"),
+               std::runtime_error);
+}
+
+/**
+ * @brief Test case for stepping down over budget and back up with headroom.
+ */
+TEST(ResolutionTest, FollowsLatencyBudget) {
+  ResolutionConfig config;
+  config.budgetMs = 100;
+  config.smoothing = 1.0;  // React to each sample for the test
+  config.cooldown = 0;
+  ResolutionController controller(config, cv::Size(608, 608));
+  EXPECT_EQ(controller.current(), cv::Size(608, 608));
+
+  EXPECT_EQ(controller.update(150), cv::Size(416, 416));
+  EXPECT_EQ(controller.update(120), cv::Size(320, 320));
+  EXPECT_EQ(controller.update(110), cv::Size(320, 320)) << "Smallest size";
+
+  // 40 ms at 320 predicts about 68 ms at 416, inside 80% of the budget
+  EXPECT_EQ(controller.update(40), cv::Size(416, 416));
+  // 60 ms at 416 predicts about 128 ms at 608, too close to the budget
+  EXPECT_EQ(controller.update(60), cv::Size(416, 416));
+  EXPECT_EQ(controller.switches(), 3);
+}
+
+/**
+ * @brief Test case for the cooldown and for the disabled controller.
+ */
+TEST(ResolutionTest, CooldownAndDisabled) {
+  ResolutionConfig config;
+  config.budgetMs = 50;
+  config.smoothing = 1.0;
+  config.cooldown = 2;
+  ResolutionController controller(config, cv::Size(400, 400));
+  EXPECT_EQ(controller.current(), cv::Size(416, 416)) << "Nearest side";
+
+  EXPECT_EQ(controller.update(80), cv::Size(320, 320));
+  EXPECT_EQ(controller.update(80), cv::Size(320, 320)) << "Cooling down";
+  EXPECT_EQ(controller.update(10), cv::Size(320, 320)) << "Cooling down";
+  EXPECT_EQ(controller.update(10), cv::Size(416, 416));
+
+  config.budgetMs = 0;
+  ResolutionController fixed(config, cv::Size(608, 608));
+  EXPECT_EQ(fixed.update(1000), cv::Size(608, 608));
+  EXPECT_EQ(fixed.switches(), 0);
+}
@@ -0,0 +1,132 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file shared_detector_test.cpp
+ * @brief Unit tests for the CPU list helpers and for detecting from many
+ * threads through one SharedDetector.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "shared_detector.hpp"
+#include "thread_affinity.hpp"
+#include "test_helpers.hpp"
+
+namespace {
+
+/**
+ * @class NumThreadsGuard
+ * @brief Restores OpenCV's process-wide thread count when a test ends,
+ * however it ends.
+ */
+class NumThreadsGuard {
+ public:
+  /**
+   * @brief Saves the current thread count.
+   */
+  NumThreadsGuard() : threads(cv::getNumThreads()) {}
+
+  /**
+   * @brief Restores the saved thread count.
+   */
+  ~NumThreadsGuard() { cv::setNumThreads(threads); }
+
+ private:
+  int threads; /**< Thread count before the test */
+};
+
+}  // namespace
+
+/**
+ * @brief Test case for parsing CPU lists and resolving the pinning CPUs.
+ */
+TEST(SharedDetectorTest, CpuLists) {
+  EXPECT_EQ(Detector::parseCpuList("0-3,8, 10-11\n"),
+            std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_TRUE(Detector::parseCpuList("").empty());
+  EXPECT_THROW(Detector::parseCpuList("3-1"), std::runtime_error);
+  EXPECT_THROW(Detector::parseCpuList("x"), std::runtime_error);
+  EXPECT_FALSE(Detector::onlineCpus().empty());
+
+  Detector::ThreadingConfig threading;
+  threading.cpus = {2, 3};
+  EXPECT_TRUE(Detector::pinningCpus(threading).empty());
+  threading.pin = true;
+  EXPECT_EQ(Detector::pinningCpus(threading), threading.cpus);
+  threading.cpus.clear();
+  EXPECT_EQ(Detector::pinningCpus(threading), Detector::onlineCpus());
+  threading.numaNode = 1 << 20;
+  EXPECT_THROW(Detector::pinningCpus(threading), std::runtime_error);
+
+  // Pin a scratch thread, not the one running the tests
+  bool pinned = false;
+  std::thread([&pinned]() {
+    pinned = Detector::pinCurrentThread(Detector::onlineCpus().back());
+  }).join();
+#ifdef __linux__
+  EXPECT_TRUE(pinned);
+#endif
+}
+
+/**
+ * @brief Test case for threads detecting at once, each on a context of its
+ * own that is freed when the thread exits, with the same result as a plain
+ * detector.
+ */
+TEST(SharedDetectorTest, ThreadsGetTheirOwnContexts) {
+  // intraOpThreads is set for the whole process; later tests get theirs
+  NumThreadsGuard restore;
+  Detector::ThreadingConfig threading;
+  threading.intraOpThreads = 1;
+  Detector::SharedDetector shared(Testing::makeModelFiles(),
+                                  Testing::kLabelsPath, threading);
+  shared.configure([](Detector::YOLODetector& context) {
+    context.setInputSize(cv::Size(320, 320));
+    context.setBackend(Detector::parseBackendOption("opencv"));
+  });
+
+  cv::Mat frame(480, 640, CV_8UC3, cv::Scalar::all(90));
+  cv::rectangle(frame, cv::Rect(280, 120, 80, 240), cv::Scalar(30, 60, 200),
+                cv::FILLED);
+  const Detector::Detections expected = Testing::makeDetector()->detect(frame);
+
+  const int threads = 3;
+  std::vector<Detector::Detections> results(threads);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&shared, &frame, &results, i]() {
+      for (int pass = 0; pass < 2; ++pass) {
+        results[i] = shared.detect(frame);
+      }
+      EXPECT_EQ(shared.context().getInputSize(), cv::Size(320, 320));
+      // The backend ran the context's own network, not a second copy
+      cv::dnn::Net net = shared.context().getNet();
+      EXPECT_FALSE(Detector::readLayerTimings(net).empty());
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  EXPECT_EQ(shared.contextCount(), 0u) << "Exiting threads free theirs";
+  for (const Detector::Detections& result : results) {
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      EXPECT_EQ(result[i].box, expected[i].box);
+      EXPECT_EQ(result[i].classId, expected[i].classId);
+      EXPECT_FLOAT_EQ(result[i].score, expected[i].score);
+    }
+  }
+
+  shared.detect(frame);
+  EXPECT_EQ(shared.contextCount(), 1u);
+  shared.releaseContext();
+  EXPECT_EQ(shared.contextCount(), 0u);
+  EXPECT_EQ(cv::getNumThreads(), 1);
+}
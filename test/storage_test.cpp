@@ -0,0 +1,207 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file storage_test.cpp
+ * @brief Unit tests for the binary detection log.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "detection_log.hpp"
+
+using Storage::LogReader;
+using Storage::LogRecord;
+using Storage::LogWriter;
+using BlockRange = std::pair<size_t, size_t>;
+
+namespace {
+
+/**
+ * @brief Builds the record written for row i of the test logs.
+ * @param i Row number.
+ * @return A record on frame i / 2, so frames repeat and never go back.
+ */
+LogRecord makeRecord(uint64_t i) {
+  LogRecord record;
+  record.frame = i / 2;
+  record.timestampUs = static_cast<int64_t>(i) * 1000;
+  record.box = cv::Rect2f(i, 2.0f * i, 10, 20);
+  record.score = 0.5f;
+  record.classId = static_cast<int32_t>(i % 80);
+  record.trackId = i % 3 == 0 ? static_cast<int32_t>(i) : -1;
+  return record;
+}
+
+/**
+ * @brief Writes rows 0..rows-1 to a new log of 16-row blocks.
+ * @param path The log file.
+ * @param rows Number of rows.
+ */
+void writeLog(const std::string& path, uint64_t rows) {
+  LogWriter writer(path, 16);
+  for (uint64_t i = 0; i < rows; ++i) {
+    writer.append(makeRecord(i));
+  }
+  writer.close();
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for reading back every row across several blocks.
+ */
+TEST(StorageTest, RoundTripsAcrossBlocks) {
+  std::string path = cv::tempfile(".acmelog");
+  writeLog(path, 40);
+
+  LogReader reader(path);
+  EXPECT_FALSE(reader.recovered());
+  EXPECT_EQ(reader.rows(), 40u);
+  ASSERT_EQ(reader.blockCount(), 3u);
+  EXPECT_EQ(reader.blockIndex()[2].rows, 8u) << "Last block is partial";
+
+  uint64_t i = 0;
+  for (size_t b = 0; b < reader.blockCount(); ++b) {
+    Storage::BlockView block = reader.block(b);
+    for (size_t r = 0; r < block.rows; ++r, ++i) {
+      LogRecord expected = makeRecord(i);
+      LogRecord actual = block.record(r);
+      EXPECT_EQ(actual.frame, expected.frame);
+      EXPECT_EQ(actual.timestampUs, expected.timestampUs);
+      EXPECT_EQ(actual.box, expected.box);
+      EXPECT_EQ(actual.classId, expected.classId);
+      EXPECT_EQ(actual.trackId, expected.trackId);
+    }
+  }
+  EXPECT_EQ(i, 40u);
+  std::remove(path.c_str());
+}
+
+/**
+ * @brief Test case for finding the blocks of a frame range from the index.
+ */
+TEST(StorageTest, FindsBlocksByFrame) {
+  std::string path = cv::tempfile(".acmelog");
+  writeLog(path, 40);  // Blocks hold frames 0-7, 8-15 and 16-19
+
+  LogReader reader(path);
+  EXPECT_EQ(reader.findBlocks(0, 3), BlockRange(0, 1));
+  EXPECT_EQ(reader.findBlocks(7, 8), BlockRange(0, 2));
+  EXPECT_EQ(reader.findBlocks(17, 100), BlockRange(2, 3));
+  EXPECT_EQ(reader.findBlocks(50, 60), BlockRange(3, 3));
+  std::remove(path.c_str());
+}
+
+/**
+ * @brief Test case for reading a log whose footer was never written.
+ */
+TEST(StorageTest, RecoversWithoutFooter) {
+  std::string path = cv::tempfile(".acmelog");
+  writeLog(path, 40);
+  std::string bytes;
+  {
+    std::ifstream in(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in),
+                 std::istreambuf_iterator<char>());
+  }
+  // Drop the index entries and the trailer, as after a crash
+  bytes.resize(bytes.size() - 3 * sizeof(Storage::BlockIndexEntry) - 24);
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size());
+  }
+
+  LogReader reader(path);
+  EXPECT_TRUE(reader.recovered());
+  EXPECT_EQ(reader.blockCount(), 3u);
+  EXPECT_EQ(reader.rows(), 40u);
+  std::remove(path.c_str());
+}
+
+/**
+ * @brief Test case for refusing an index whose row count does not fit its
+ * block, instead of reading past the block.
+ */
+TEST(StorageTest, RejectsCorruptIndex) {
+  std::string path = cv::tempfile(".acmelog");
+  writeLog(path, 40);
+  std::string bytes;
+  {
+    std::ifstream in(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in),
+                 std::istreambuf_iterator<char>());
+  }
+  // Rows of the last index entry, which sits just before the trailer
+  const uint32_t rows = 1000;
+  std::memcpy(&bytes[bytes.size() - 24 - sizeof(Storage::BlockIndexEntry) +
+                     offsetof(Storage::BlockIndexEntry, rows)],
+              &rows, sizeof(rows));
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size());
+  }
+
+  EXPECT_THROW(LogReader reader(path), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+/**
+ * @brief Test case for rejecting bad input.
+ */
+TEST(StorageTest, RejectsInvalidUse) {
+  std::string path = cv::tempfile(".acmelog");
+  EXPECT_THROW(LogWriter(path, 10), std::runtime_error);
+
+  LogWriter writer(path, 16);
+  writer.append(makeRecord(10));
+  EXPECT_THROW(writer.append(makeRecord(0)), std::runtime_error);
+  writer.close();
+  EXPECT_THROW(writer.append(makeRecord(20)), std::runtime_error);
+  EXPECT_THROW(LogReader("config/yolov3.cfg"), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+/**
+ * @brief Test case for CSV and JSON export and frame appends.
+ */
+TEST(StorageTest, ExportsRows) {
+  std::string path = cv::tempfile(".acmelog");
+  {
+    LogWriter writer(path, 16);
+    Detector::Detections detections(2);
+    detections[0].box = cv::Rect(1, 2, 3, 4);
+    detections[0].classId = 7;
+    std::vector<Tracker::Track> tracks(1);
+    tracks[0].id = 5;
+    writer.appendFrame(3, 100, detections, tracks);
+  }  // The destructor closes the log
+
+  LogReader reader(path);
+  std::ostringstream csv;
+  Storage::exportCsv(reader, csv);
+  std::istringstream lines(csv.str());
+  std::string line;
+  std::vector<std::string> rows;
+  while (std::getline(lines, line)) {
+    rows.push_back(line);
+  }
+  ASSERT_EQ(rows.size(), 4u);
+  EXPECT_EQ(rows[0], "frame,timestamp_us,x,y,width,height,score,class,track");
+  EXPECT_EQ(rows[1].substr(0, 16), "3,100,1,2,3,4,0,");
+  EXPECT_EQ(rows[3].substr(rows[3].size() - 5), ",-1,5");
+
+  std::ostringstream json;
+  Storage::exportJson(reader, json);
+  EXPECT_EQ(json.str().find("{\"frame\":3,\"timestamp_us\":100,"), 0u);
+  std::remove(path.c_str());
+}
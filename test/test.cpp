@@ -113,21 +113,123 @@ TEST_F(YOLODetectorTest, LoadClassNames) {
 /**
  * @brief Test case for post-processing of valid detections.
  *
- * Tests if post-processing with a valid detection data does not throw an
- * exception.
+ * Decodes one row with objectness and class score above the threshold and
+ * checks the box is mapped back to the frame with the expected class.
  */
 TEST_F(YOLODetectorTest, PostProcessValidDetection) {
   Mat frame(416, 416, CV_8UC3, Scalar(0, 0, 0));  // Dummy frame
   std::vector<Mat> dummyOutput(
       1, Mat(1, 85, CV_32F, Scalar(0)));  // Dummy output matrix
 
+  dummyOutput[0].at<float>(0, 0) = 0.25f;  // Center x
+  dummyOutput[0].at<float>(0, 1) = 0.75f;  // Center y
+  dummyOutput[0].at<float>(0, 2) = 0.25f;  // Width
+  dummyOutput[0].at<float>(0, 3) = 0.5f;   // Height
+  dummyOutput[0].at<float>(0, 4) = 0.9f;   // Objectness
+  dummyOutput[0].at<float>(0, 5) = 0.9f;   // Confidence
+
+  Detector::Detections detections;
+  ASSERT_NO_THROW(detections = detector->postprocess(frame, dummyOutput));
+  ASSERT_EQ(detections.size(), 1u);
+  EXPECT_EQ(detections[0].classId, 0);
+  EXPECT_EQ(detections[0].box, cv::Rect(52, 208, 104, 208));
+}
+
+/**
+ * @brief Test case for post-processing of a row without objectness.
+ *
+ * A confident class score must not produce a detection when the row's
+ * objectness is below the threshold.
+ */
+TEST_F(YOLODetectorTest, PostProcessIgnoresZeroObjectness) {
+  Mat frame(416, 416, CV_8UC3, Scalar(0, 0, 0));  // Dummy frame
+  std::vector<Mat> dummyOutput(1, Mat(1, 85, CV_32F, Scalar(0)));
+
+  dummyOutput[0].at<float>(0, 0) = 0.5f;
+  dummyOutput[0].at<float>(0, 1) = 0.5f;
+  dummyOutput[0].at<float>(0, 2) = 0.5f;
+  dummyOutput[0].at<float>(0, 3) = 0.5f;
+  dummyOutput[0].at<float>(0, 5) = 0.9f;  // Confidence, objectness is 0
+
+  EXPECT_TRUE(detector->postprocess(frame, dummyOutput).empty());
+}
+
+/**
+ * @brief Test case for the structured output of post-processing.
+ *
+ * Verifies that the decoded detection carries the expected box, score and
+ * class, and that post-processing leaves the frame untouched.
+ */
+TEST_F(YOLODetectorTest, PostProcessReturnsDetections) {
+  Mat frame(416, 416, CV_8UC3, Scalar(0, 0, 0));  // Dummy frame
+  std::vector<Mat> dummyOutput(1, Mat(1, 85, CV_32F, Scalar(0)));
+
   dummyOutput[0].at<float>(0, 0) = 0.5f;
   dummyOutput[0].at<float>(0, 1) = 0.5f;
   dummyOutput[0].at<float>(0, 2) = 0.5f;
   dummyOutput[0].at<float>(0, 3) = 0.5f;
+  dummyOutput[0].at<float>(0, 4) = 0.9f;  // Objectness
   dummyOutput[0].at<float>(0, 5) = 0.9f;  // Confidence
 
-  EXPECT_NO_THROW(detector->postprocess(frame, dummyOutput));
+  Detector::Detections detections = detector->postprocess(frame, dummyOutput);
+  ASSERT_EQ(detections.size(), 1u);
+  EXPECT_EQ(detections[0].classId, 0);
+  EXPECT_FLOAT_EQ(detections[0].score, 0.9f);
+  EXPECT_EQ(detections[0].box, cv::Rect(104, 104, 208, 208));
+
+  Mat grayFrame;
+  cv::cvtColor(frame, grayFrame, cv::COLOR_BGR2GRAY);
+  EXPECT_EQ(cv::countNonZero(grayFrame), 0)
+      << "Post-processing should not draw on the frame";
+}
+
+/**
+ * @brief Test case for splitting a batched forward pass into per-frame
+ * results.
+ *
+ * The network returns [N, rows, cols] outputs for a batch; each frame must
+ * get the detections it gets when run on its own.
+ */
+TEST_F(YOLODetectorTest, DetectBatchMatchesSingleFrames) {
+  detector->setInputSize(cv::Size(320, 320));
+  Mat person(480, 640, CV_8UC3, Scalar::all(90));
+  cv::rectangle(person, cv::Rect(280, 120, 80, 240), Scalar(30, 60, 200),
+                cv::FILLED);
+  Mat blank(600, 800, CV_8UC3, Scalar::all(90));
+
+  std::vector<Detector::Detections> results =
+      detector->detectBatch({person, blank});
+  ASSERT_EQ(results.size(), 2u);
+  const std::vector<Mat> frames = {person, blank};
+  for (size_t b = 0; b < frames.size(); ++b) {
+    const Detector::Detections expected = detector->detect(frames[b]);
+    ASSERT_EQ(results[b].size(), expected.size()) << "Frame " << b;
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(results[b][i].box, expected[i].box);
+      EXPECT_EQ(results[b][i].classId, expected[i].classId);
+      EXPECT_NEAR(results[b][i].score, expected[i].score, 1e-4f);
+    }
+  }
+}
+
+/**
+ * @brief Test case for rendering detections as a separate step.
+ *
+ * Verifies that render() draws the detections it is given.
+ */
+TEST_F(YOLODetectorTest, RenderDrawsDetections) {
+  Mat frame(416, 416, CV_8UC3, Scalar(0, 0, 0));  // Black frame
+  Detector::Detection detection;
+  detection.box = cv::Rect(100, 50, 100, 100);
+  detection.score = 0.75f;
+  detection.classId = 0;
+
+  detector->render(frame, {detection});
+
+  Mat grayFrame;
+  cv::cvtColor(frame, grayFrame, cv::COLOR_BGR2GRAY);
+  EXPECT_GT(cv::countNonZero(grayFrame), 0)
+      << "Frame should have non-zero pixels after rendering";
 }
 
 /**
@@ -146,6 +248,24 @@ TEST_F(YOLODetectorTest, DrawPredictionOutOfBounds) {
       detector->drawPred(classId, confidence, left, top, right, bottom, frame));
 }
 
+/**
+ * @brief Test case for the input size read from the config and changed at
+ * run time.
+ */
+TEST_F(YOLODetectorTest, InputSizeFromConfigAndOverride) {
+  EXPECT_EQ(detector->getInputSize(), cv::Size(416, 416));
+
+  detector->setInputSize(cv::Size(320, 320));
+  Mat frame(480, 640, CV_8UC3, Scalar(0, 0, 0));
+  Mat blob = detector->preprocess(frame);
+  EXPECT_EQ(blob.size[2], 320);
+  EXPECT_EQ(blob.size[3], 320);
+
+  EXPECT_THROW(detector->setInputSize(cv::Size(300, 300)),
+               std::runtime_error);
+  EXPECT_EQ(detector->getInputSize(), cv::Size(320, 320));
+}
+
 /**
  * @brief Test case for video stream initialization.
  *
@@ -154,3 +274,13 @@ TEST_F(YOLODetectorTest, DrawPredictionOutOfBounds) {
 TEST_F(YOLODetectorTest, VideoStreamInitialization) {
   detector->videoStream(true);  // Run videoStream in test mode to limit frames
 }
+
+/**
+ * @brief Test case for the video stream reading the capture it is given
+ * and returning when that capture cannot be opened.
+ */
+TEST_F(YOLODetectorTest, VideoStreamReadsGivenCapture) {
+  cv::VideoCapture cap("missing_video.avi");
+  detector->videoStream(cap, true);
+  EXPECT_FALSE(cap.isOpened());
+}
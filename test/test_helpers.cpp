@@ -0,0 +1,28 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#include "test_helpers.hpp"
+
+namespace Testing {
+
+/**
+ * @brief Creates the YOLOv3 detector the tests run.
+ * @return A detector at a 320x320 input, small to keep the tests fast.
+ */
+std::unique_ptr<Detector::YOLODetector> makeDetector() {
+  std::unique_ptr<Detector::YOLODetector> detector(
+      new Detector::YOLODetector(kConfigPath, kWeightsPath, kLabelsPath));
+  detector->setInputSize(cv::Size(320, 320));
+  return detector;
+}
+
+/**
+ * @brief Gets the model files makeDetector() loads.
+ * @return The Darknet configuration and weights.
+ */
+Detector::ModelFiles makeModelFiles() {
+  Detector::ModelFiles files;
+  files.config = kConfigPath;
+  files.weights = kWeightsPath;
+  return files;
+}
+
+}  // namespace Testing
@@ -0,0 +1,34 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+#pragma once
+
+/**
+ * @file test_helpers.hpp
+ * @brief Model paths and detector setup shared by the unit tests.
+ */
+
+#include <memory>
+
+#include "detector.hpp"
+
+namespace Testing {
+
+/**< Darknet configuration every test loads */
+constexpr const char* kConfigPath = "config/yolov3.cfg";
+/**< Darknet weights every test loads */
+constexpr const char* kWeightsPath = "model/yolov3.weights";
+/**< Class names every test loads */
+constexpr const char* kLabelsPath = "labels/coco.names";
+
+/**
+ * @brief Creates the YOLOv3 detector the tests run.
+ * @return A detector at a 320x320 input, small to keep the tests fast.
+ */
+std::unique_ptr<Detector::YOLODetector> makeDetector();
+
+/**
+ * @brief Gets the model files makeDetector() loads.
+ * @return The Darknet configuration and weights.
+ */
+Detector::ModelFiles makeModelFiles();
+
+}  // namespace Testing
@@ -0,0 +1,125 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file tiling_test.cpp
+ * @brief Unit tests for the tile grid, seam merging and tiled detection.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "tiling.hpp"
+#include "test_helpers.hpp"
+
+using Detector::Detection;
+using Detector::Detections;
+
+namespace {
+
+/**
+ * @brief Builds a detection.
+ * @param box The box.
+ * @param score The score.
+ * @param classId The class.
+ * @return The detection.
+ */
+Detection makeDetection(const cv::Rect& box, float score, int classId = 0) {
+  Detection detection;
+  detection.box = box;
+  detection.score = score;
+  detection.classId = classId;
+  return detection;
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for tiles covering a 4K frame with the requested overlap.
+ */
+TEST(TilingTest, GridCoversFrame) {
+  const cv::Size frameSize(3840, 2160);
+  std::vector<cv::Rect> tiles = Pipeline::makeTileGrid(frameSize, 832, 0.25f);
+  ASSERT_EQ(tiles.size(), 6u * 4u);
+
+  cv::Mat covered(frameSize, CV_8U, cv::Scalar(0));
+  for (const cv::Rect& tile : tiles) {
+    EXPECT_EQ(tile.size(), cv::Size(832, 832));
+    EXPECT_EQ(tile & cv::Rect(cv::Point(), frameSize), tile);
+    covered(tile).setTo(1);
+  }
+  EXPECT_EQ(cv::countNonZero(covered), frameSize.area());
+  EXPECT_GE((tiles[0] & tiles[1]).width, 208) << "At least 25% shared";
+  EXPECT_EQ(tiles.back().br(), cv::Point(3840, 2160));
+
+  tiles = Pipeline::makeTileGrid(cv::Size(640, 480), 832, 0.25f);
+  ASSERT_EQ(tiles.size(), 1u);
+  EXPECT_EQ(tiles[0], cv::Rect(0, 0, 640, 480));
+  EXPECT_THROW(Pipeline::makeTileGrid(frameSize, 0, 0.25f),
+               std::runtime_error);
+}
+
+/**
+ * @brief Test case for halves of a person cut by a seam becoming one box.
+ */
+TEST(TilingTest, MergeJoinsSeams) {
+  Detections detections = {
+      makeDetection(cv::Rect(600, 100, 60, 160), 0.9f),     // Full person
+      makeDetection(cv::Rect(600, 100, 40, 160), 0.7f),     // Left part
+      makeDetection(cv::Rect(620, 100, 42, 158), 0.6f),     // Right part
+      makeDetection(cv::Rect(605, 110, 50, 100), 0.8f, 7),  // Other class
+      makeDetection(cv::Rect(1000, 100, 60, 160), 0.55f)};  // Other person
+  Detections merged = Pipeline::mergeDetections(detections, 0.5f);
+  ASSERT_EQ(merged.size(), 3u);
+  EXPECT_EQ(merged[0].box, cv::Rect(600, 100, 62, 160));
+  EXPECT_FLOAT_EQ(merged[0].score, 0.9f);
+  EXPECT_EQ(merged[1].classId, 7);
+  EXPECT_EQ(merged[2].box, cv::Rect(1000, 100, 60, 160));
+}
+
+/**
+ * @brief Test case for region-of-interest tile selection and batching.
+ */
+TEST(TilingTest, RegionsSelectTiles) {
+  std::unique_ptr<Detector::YOLODetector> detector = Testing::makeDetector();
+  Pipeline::TilingConfig config;
+  config.scanInterval = 5;
+  config.maxBatch = 4;
+  config.roiMargin = 0;
+  Pipeline::TiledDetector tiled(*detector, config);
+  cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar::all(90));
+  // People in tiles of different batches, so misplaced rows would show
+  for (int x : {150, 620, 1100}) {
+    cv::rectangle(frame, cv::Rect(x, 300, 60, 180), cv::Scalar(30, 60, 200),
+                  cv::FILLED);
+  }
+
+  const Detections batched = tiled.detect(frame, {cv::Rect(10, 10, 20, 20)});
+  const size_t gridTiles = tiled.lastTiles().size();
+  EXPECT_EQ(gridTiles, 5u * 3u) << "First frame scans every tile";
+  EXPECT_EQ(tiled.stats().batches, 4u) << "15 tiles and the full frame";
+
+  // Batches of four must match the tiles run one at a time
+  Pipeline::TilingConfig singleConfig = config;
+  singleConfig.maxBatch = 1;
+  Pipeline::TiledDetector single(*detector, singleConfig);
+  const Detections expected = single.detect(frame);
+  EXPECT_EQ(single.stats().batches, 16u);
+  ASSERT_EQ(batched.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(batched[i].box, expected[i].box);
+    EXPECT_EQ(batched[i].classId, expected[i].classId);
+    EXPECT_NEAR(batched[i].score, expected[i].score, 1e-4f);
+  }
+
+  tiled.detect(frame, {cv::Rect(10, 10, 20, 20)});
+  ASSERT_EQ(tiled.lastTiles().size(), 1u);
+  EXPECT_EQ(tiled.lastTiles()[0].tl(), cv::Point(0, 0));
+
+  tiled.detect(frame, {});
+  EXPECT_TRUE(tiled.lastTiles().empty());
+  EXPECT_EQ(tiled.stats().frames, 3u);
+  EXPECT_EQ(tiled.stats().tiles, gridTiles + 1);
+}
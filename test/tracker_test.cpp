@@ -0,0 +1,208 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file tracker_test.cpp
+ * @brief Unit tests for the KalmanBank filters and the MultiTracker
+ * association and track lifecycle.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "kalman_bank.hpp"
+#include "multi_tracker.hpp"
+#include "tracker.hpp"
+
+using Tracker::AssignmentSolver;
+using Tracker::MultiTracker;
+using Tracker::MultiTrackerConfig;
+
+/**
+ * @brief Test case comparing the filter bank with per-track cv::KalmanFilter
+ * instances, with enough tracks to cover the vector body and its tail.
+ */
+TEST(KalmanBankTest, MatchesKalmanFilter) {
+  const int count = 11;
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> start(0.f, 500.f);
+  std::uniform_real_distribution<float> speed(-3.f, 3.f);
+  std::normal_distribution<float> noise(0.f, 0.5f);
+
+  Tracker::KalmanBank bank;
+  std::vector<Tracker::Tracker> filters(count);
+  std::vector<cv::Point2f> positions, velocities;
+  for (int i = 0; i < count; ++i) {
+    positions.emplace_back(start(rng), start(rng));
+    velocities.emplace_back(speed(rng), speed(rng));
+    bank.add(positions[i]);
+    filters[i].initialize(positions[i]);
+  }
+
+  for (int step = 0; step < 60; ++step) {
+    bank.predict();
+    for (int i = 0; i < count; ++i) {
+      filters[i].predict();
+      positions[i] += velocities[i];
+      if (rng() % 10 < 7) {  // Some frames miss their detection
+        cv::Point2f measurement(positions[i].x + noise(rng),
+                                positions[i].y + noise(rng));
+        bank.setMeasurement(i, measurement);
+        filters[i].correct(measurement);
+      }
+    }
+    bank.correct();
+
+    for (int i = 0; i < count; ++i) {
+      cv::Point2f velocity = filters[i].getVelocity();
+      EXPECT_NEAR(bank.getVelocity(i).x, velocity.x, 1e-3);
+      EXPECT_NEAR(bank.getVelocity(i).y, velocity.y, 1e-3);
+    }
+  }
+  // Tracker::predict() returns the prior, so compare positions one step on
+  bank.predict();
+  for (int i = 0; i < count; ++i) {
+    cv::Point2f predicted = filters[i].predict();
+    EXPECT_NEAR(bank.getPosition(i).x, predicted.x, 1e-2);
+    EXPECT_NEAR(bank.getPosition(i).y, predicted.y, 1e-2);
+  }
+}
+
+/**
+ * @brief Test case comparing the Hungarian solver with brute force.
+ */
+TEST(MultiTrackerTest, HungarianIsOptimal) {
+  std::mt19937 rng(7);
+  for (int trial = 0; trial < 50; ++trial) {
+    int rows = 1 + static_cast<int>(rng() % 5);
+    int cols = rows + static_cast<int>(rng() % 2);
+    std::vector<float> cost(rows * cols);
+    for (float& value : cost) {
+      value = static_cast<float>(rng() % 100);
+    }
+
+    std::vector<int> assignment = Tracker::solveHungarian(cost, rows, cols);
+    ASSERT_EQ(assignment.size(), static_cast<size_t>(rows));
+    float total = 0.f;
+    for (int r = 0; r < rows; ++r) {
+      ASSERT_GE(assignment[r], 0);
+      total += cost[r * cols + assignment[r]];
+    }
+
+    std::vector<int> perm(cols);
+    for (int c = 0; c < cols; ++c) {
+      perm[c] = c;
+    }
+    float best = 1e9f;
+    do {
+      float sum = 0.f;
+      for (int r = 0; r < rows; ++r) {
+        sum += cost[r * cols + perm[r]];
+      }
+      best = std::min(best, sum);
+    } while (std::next_permutation(perm.begin(), perm.end()));
+    EXPECT_FLOAT_EQ(total, best);
+  }
+}
+
+/**
+ * @brief Test case for track birth, confirmation and death.
+ */
+TEST(MultiTrackerTest, Lifecycle) {
+  MultiTrackerConfig config;
+  config.confirmHits = 3;
+  config.maxMisses = 2;
+  MultiTracker tracker(config);
+  std::vector<cv::Rect2f> one = {cv::Rect2f(100, 100, 40, 80)};
+
+  tracker.update(one);
+  EXPECT_EQ(tracker.getTracks().size(), 1u);
+  EXPECT_TRUE(tracker.getConfirmedTracks().empty()) << "Born tentative";
+  tracker.update(one);
+  tracker.update(one);
+  ASSERT_EQ(tracker.getConfirmedTracks().size(), 1u);
+  int id = tracker.getConfirmedTracks()[0].id;
+
+  tracker.update({});
+  tracker.update({});
+  EXPECT_EQ(tracker.getTracks().size(), 1u) << "Coasts through misses";
+  tracker.update(one);
+  ASSERT_EQ(tracker.getConfirmedTracks().size(), 1u);
+  EXPECT_EQ(tracker.getConfirmedTracks()[0].id, id) << "Keeps its ID";
+
+  for (int i = 0; i <= config.maxMisses; ++i) {
+    tracker.update({});
+  }
+  EXPECT_TRUE(tracker.getTracks().empty());
+
+  // A tentative track dies on its first miss
+  tracker.update(one);
+  tracker.update({});
+  EXPECT_TRUE(tracker.getTracks().empty());
+}
+
+/**
+ * @brief Test case keeping IDs stable for many moving targets with both
+ * solvers.
+ */
+TEST(MultiTrackerTest, StableIdsForManyTargets) {
+  for (AssignmentSolver solver :
+       {AssignmentSolver::kGreedy, AssignmentSolver::kHungarian}) {
+    MultiTrackerConfig config;
+    config.solver = solver;
+    MultiTracker tracker(config);
+
+    const int count = 500;
+    std::vector<cv::Rect2f> boxes;
+    std::vector<cv::Point2f> velocities;
+    for (int i = 0; i < count; ++i) {
+      boxes.emplace_back((i % 50) * 60.f, (i / 50) * 120.f, 40.f, 100.f);
+      velocities.emplace_back(static_cast<float>(i % 5 - 2),
+                              static_cast<float>(i % 3 - 1));
+    }
+
+    std::vector<int> firstIds;
+    for (int frame = 0; frame < 20; ++frame) {
+      for (int i = 0; i < count; ++i) {
+        boxes[i].x += velocities[i].x;
+        boxes[i].y += velocities[i].y;
+      }
+      tracker.update(boxes);
+      if (frame == config.confirmHits - 1) {
+        for (const Tracker::Track& track : tracker.getTracks()) {
+          firstIds.push_back(track.id);
+        }
+      }
+    }
+
+    std::vector<int> lastIds;
+    for (const Tracker::Track& track : tracker.getConfirmedTracks()) {
+      lastIds.push_back(track.id);
+    }
+    EXPECT_EQ(lastIds.size(), static_cast<size_t>(count));
+    std::sort(firstIds.begin(), firstIds.end());
+    std::sort(lastIds.begin(), lastIds.end());
+    EXPECT_EQ(firstIds, lastIds) << "No track should be replaced";
+  }
+}
+
+/**
+ * @brief Test case for the centroid metric distance gate.
+ */
+TEST(MultiTrackerTest, CentroidGate) {
+  MultiTrackerConfig config;
+  config.metric = Tracker::AssociationMetric::kCentroid;
+  config.maxDistance = 20.f;
+  MultiTracker tracker(config);
+
+  tracker.update({cv::Rect2f(0, 0, 10, 10)});
+  tracker.update({cv::Rect2f(5, 0, 10, 10)});
+  ASSERT_EQ(tracker.getTracks().size(), 1u) << "Near detection matches";
+  EXPECT_EQ(tracker.getTracks()[0].hits, 2);
+
+  tracker.update({cv::Rect2f(200, 200, 10, 10)});
+  ASSERT_EQ(tracker.getTracks().size(), 1u);
+  EXPECT_EQ(tracker.getTracks()[0].hits, 1) << "Far detection starts anew";
+}
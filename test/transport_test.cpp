@@ -0,0 +1,251 @@
+// Copyright [2024] Abhey Sharma, Prathinav K V, Sarang Nair
+
+/**
+ * @file transport_test.cpp
+ * @brief Unit tests for the shared memory detection ring, read from this
+ * process and from reader processes.
+ */
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "publisher.hpp"
+#include "subscriber.hpp"
+
+namespace {
+
+/**
+ * @brief Builds a shared memory name no other test process uses.
+ * @param test Distinguishes the tests of one process.
+ * @return The name.
+ */
+std::string ringName(const std::string& test) {
+  return "/acme_test_" + std::to_string(::getpid()) + "_" + test;
+}
+
+/**
+ * @brief Builds detections that encode their frame, so a reader can tell a
+ * message mixed from two frames.
+ * @param frame The frame index.
+ * @param count Number of detections.
+ * @return The detections.
+ */
+Detector::Detections frameDetections(uint64_t frame, size_t count) {
+  Detector::Detections detections(count);
+  for (size_t i = 0; i < count; ++i) {
+    detections[i].box = cv::Rect(static_cast<int>(frame), static_cast<int>(i),
+                                 20, 40);
+    detections[i].score = static_cast<float>(frame);
+    detections[i].classId = 0;
+  }
+  return detections;
+}
+
+/**
+ * @brief Checks that every part of a message belongs to its frame.
+ * @param message The message.
+ * @return True if nothing in it comes from another frame.
+ */
+bool consistent(const Transport::Message& message) {
+  for (const Detector::Detection& detection : message.detections) {
+    if (detection.box.x != static_cast<int>(message.frame) ||
+        detection.score != static_cast<float>(message.frame)) {
+      return false;
+    }
+  }
+  for (const Tracker::Track& track : message.tracks) {
+    if (track.id != static_cast<int>(message.frame)) {
+      return false;
+    }
+  }
+  const unsigned char value = static_cast<unsigned char>(message.frame);
+  return message.image.empty() ||
+         cv::countNonZero(message.image.reshape(1) != value) == 0;
+}
+
+}  // namespace
+
+/**
+ * @brief Test case for a message arriving intact, including what does not
+ * fit the slot.
+ */
+TEST(TransportTest, RoundTrip) {
+  Transport::PublisherConfig config;
+  config.name = ringName("roundtrip");
+  config.maxDetections = 4;
+  config.frameBytes = 64 * 48 * 3;
+  Transport::Publisher publisher(config);
+  Transport::Subscriber subscriber(config.name);
+  Transport::Message message;
+  EXPECT_FALSE(subscriber.poll(&message));
+
+  std::vector<Tracker::Track> tracks(1);
+  tracks[0].id = 7;
+  tracks[0].box = cv::Rect2f(1.5f, 2.5f, 30.f, 60.f);
+  tracks[0].velocity = cv::Point2f(0.5f, -1.f);
+  tracks[0].state = Tracker::TrackState::kConfirmed;
+  tracks[0].hits = 12;
+  tracks[0].age = 15;
+  cv::Mat image(48, 64, CV_8UC3, cv::Scalar(1, 2, 3));
+  EXPECT_EQ(publisher.publish(9, 1234, frameDetections(9, 6), tracks, image),
+            0u);
+  ASSERT_TRUE(subscriber.poll(&message));
+  EXPECT_EQ(message.sequence, 0u);
+  EXPECT_EQ(message.frame, 9u);
+  EXPECT_EQ(message.timestampUs, 1234);
+  EXPECT_GT(message.publishedUs, 0);
+  EXPECT_EQ(message.flags, Transport::kTruncated);
+  ASSERT_EQ(message.detections.size(), 4u);
+  EXPECT_EQ(message.detections[3].box, cv::Rect(9, 3, 20, 40));
+  ASSERT_EQ(message.tracks.size(), 1u);
+  EXPECT_EQ(message.tracks[0].id, 7);
+  EXPECT_EQ(message.tracks[0].box, tracks[0].box);
+  EXPECT_EQ(message.tracks[0].velocity, tracks[0].velocity);
+  EXPECT_EQ(message.tracks[0].state, Tracker::TrackState::kConfirmed);
+  EXPECT_EQ(message.tracks[0].hits, 12);
+  EXPECT_EQ(message.tracks[0].age, 15);
+  ASSERT_EQ(message.image.size(), image.size());
+  EXPECT_EQ(cv::norm(message.image, image, cv::NORM_INF), 0);
+  EXPECT_FALSE(subscriber.poll(&message));
+
+  // Too big for the slot: the results still go out, without the frame
+  publisher.publish(10, 0, frameDetections(10, 1), {},
+                    cv::Mat(480, 640, CV_8UC3));
+  ASSERT_TRUE(subscriber.poll(&message));
+  EXPECT_EQ(message.flags, Transport::kFrameSkipped);
+  EXPECT_TRUE(message.image.empty());
+  EXPECT_EQ(message.detections.size(), 1u);
+  EXPECT_FALSE(subscriber.closed());
+}
+
+/**
+ * @brief Test case for a reader the publisher laps: it resumes at the
+ * oldest intact message and counts the ones it lost.
+ */
+TEST(TransportTest, LappedReaderSkipsAhead) {
+  Transport::PublisherConfig config;
+  config.name = ringName("lapped");
+  config.slots = 4;
+  Transport::Publisher publisher(config);
+  Transport::Subscriber subscriber(config.name);
+  for (uint64_t frame = 0; frame < 10; ++frame) {
+    publisher.publish(frame, 0, frameDetections(frame, 2));
+  }
+  Transport::Message message;
+  ASSERT_TRUE(subscriber.poll(&message));
+  EXPECT_EQ(message.sequence, 7u);
+  EXPECT_EQ(subscriber.missed(), 7u);
+  EXPECT_TRUE(consistent(message));
+
+  Transport::Subscriber late(config.name, true);
+  ASSERT_TRUE(late.poll(&message));
+  EXPECT_EQ(message.sequence, 7u);
+  EXPECT_EQ(late.missed(), 0u);
+  late.seekLatest();
+  ASSERT_TRUE(late.poll(&message));
+  EXPECT_EQ(message.sequence, 9u);
+  EXPECT_FALSE(late.poll(&message));
+}
+
+/**
+ * @brief Test case for bad names and for opening a ring nobody publishes.
+ */
+TEST(TransportTest, RejectsBadNames) {
+  Transport::PublisherConfig config;
+  config.name = "no_slash";
+  EXPECT_THROW(Transport::Publisher publisher(config), std::runtime_error);
+  config.name = ringName("slots");
+  config.slots = 1;
+  EXPECT_THROW(Transport::Publisher publisher(config), std::runtime_error);
+  EXPECT_THROW(Transport::Subscriber subscriber(ringName("missing")),
+               std::runtime_error);
+}
+
+/**
+ * @brief Test case for reader processes following a publisher that never
+ * waits for them: each sees whole messages in order, accounts for every
+ * message, and sees the stream close.
+ */
+TEST(TransportTest, ReaderProcesses) {
+  Transport::PublisherConfig config;
+  config.name = ringName("processes");
+  config.slots = 8;
+  config.frameBytes = 64 * 48 * 3;
+  const uint64_t messages = 20000;
+  std::unique_ptr<Transport::Publisher> publisher(
+      new Transport::Publisher(config));
+
+  // Each reader reports on the pipe once it has attached
+  int attached[2];
+  ASSERT_EQ(::pipe(attached), 0);
+  std::vector<pid_t> readers;
+  for (int i = 0; i < 3; ++i) {
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      // Exit codes only: the child must not run the rest of the tests
+      int status = 0;
+      try {
+        Transport::Subscriber subscriber(config.name);
+        const char ready = 1;
+        if (::write(attached[1], &ready, 1) != 1) {
+          ::_exit(1);
+        }
+        Transport::Message message;
+        int64_t last = -1;
+        while (subscriber.wait(&message, std::chrono::seconds(10))) {
+          if (!consistent(message)) {
+            status = 2;
+          } else if (static_cast<int64_t>(message.sequence) <= last) {
+            status = 3;
+          }
+          last = static_cast<int64_t>(message.sequence);
+        }
+        if (!subscriber.closed() ||
+            subscriber.received() + subscriber.missed() != messages) {
+          status = 4;
+        }
+      } catch (const std::exception&) {
+        status = 1;
+      }
+      ::_exit(status);
+    }
+    readers.push_back(pid);
+  }
+  for (size_t i = 0; i < readers.size(); ++i) {
+    char ready = 0;
+    ASSERT_EQ(::read(attached[0], &ready, 1), 1);
+  }
+  ::close(attached[0]);
+  ::close(attached[1]);
+
+  cv::Mat image(48, 64, CV_8UC3);
+  for (uint64_t frame = 0; frame < messages; ++frame) {
+    image.setTo(cv::Scalar::all(static_cast<double>(frame % 256)));
+    std::vector<Tracker::Track> tracks(3);
+    for (Tracker::Track& track : tracks) {
+      track.id = static_cast<int>(frame);
+    }
+    publisher->publish(frame, 0, frameDetections(frame, 5), tracks, image);
+    if (frame % 64 == 0) {
+      // Pause now and then, as a camera would, so the readers catch up
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+  publisher.reset();
+
+  for (pid_t pid : readers) {
+    int status = -1;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+  }
+}